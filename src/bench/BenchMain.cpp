@@ -0,0 +1,97 @@
+//=================================================================================
+// BenchMain.cpp
+// Entry point of the benchmark builds (env:uno_bench and env:native_bench).
+// Responsibilities:
+// - Build the same object graph as main.cpp and start it, without the scheduler.
+// - Run the microbenchmarks of src/bench/Benchmarks.h and print the CSV report.
+//
+// On the Uno the report goes to Serial at boot, and again whenever a byte is received.
+// On the host it goes to stdout:
+//   .pio/build/native_bench/program > after.csv
+//   tools/bench_compare.py before.csv after.csv
+// ============================================================================================
+
+#include "Benchmarks.h"
+#include "../controllers/ActuatorController.h"
+#include "../sensors/SensorManager.h"
+#include "../sensors/DebouncedButton.h"
+#include "../display/DisplayManager.h"
+#include "../core/SystemState.h"
+#include "../diagnostics/Telemetry.h"
+
+#ifndef ARDUINO
+#include "../sim/ChamberSimulator.h"
+#endif
+
+// PIN DEFINITIONS (same wiring as main.cpp)
+constexpr byte TRANSISTOR_PIN = 2;
+constexpr byte EMERGENCY_BUTTON_PIN = 3;
+constexpr byte GREEN_LED_PIN = 10;
+constexpr byte ACKNOWLEDGE_BUTTON_PIN = 11;
+constexpr byte RED_LED_PIN = 12;
+constexpr byte PIEZO_PIN = 13;
+constexpr byte TEMPERATURE_SENSOR_PIN = A0;
+constexpr byte GAS_SENSOR_PIN = A2;
+constexpr byte POTENTIOMETER_PIN = A3;
+constexpr byte I2C_ADDRESS = 0x27;
+
+#ifdef ARDUINO
+
+// OBJECT DEFINITIONS
+ActuatorController actuatorController(TRANSISTOR_PIN, GREEN_LED_PIN, RED_LED_PIN, PIEZO_PIN);
+SensorManager sensorManager(TEMPERATURE_SENSOR_PIN, GAS_SENSOR_PIN, POTENTIOMETER_PIN);
+DisplayManager lcd(I2C_ADDRESS);
+DebouncedButton acknowledgeButton(ACKNOWLEDGE_BUTTON_PIN);
+SystemState systemState(sensorManager, actuatorController, lcd, acknowledgeButton, EMERGENCY_BUTTON_PIN);
+Benchmarks benchmarks({sensorManager, lcd, systemState});
+
+void setup() {
+  Serial.begin(TELEMETRY_BAUD);
+  actuatorController.begin();
+  sensorManager.begin();
+  lcd.begin();
+  acknowledgeButton.begin();
+  systemState.begin();
+  benchmarks.run();
+  benchmarks.report();
+}
+
+void loop() {
+  if (Serial.available() > 0) {
+    while (Serial.available() > 0) {
+      Serial.read();
+    }
+    benchmarks.run();
+    benchmarks.report();
+  }
+}
+
+#else
+
+int main()
+{
+    const ChamberPins pins{TRANSISTOR_PIN, GREEN_LED_PIN, RED_LED_PIN, PIEZO_PIN,
+                           TEMPERATURE_SENSOR_PIN, GAS_SENSOR_PIN, POTENTIOMETER_PIN};
+    static ChamberSimulator sim(pins, ChamberModel());
+    NativeBoard::install(sim);
+
+    static ActuatorController actuatorController(TRANSISTOR_PIN, GREEN_LED_PIN, RED_LED_PIN, PIEZO_PIN);
+    static SensorManager sensorManager(TEMPERATURE_SENSOR_PIN, GAS_SENSOR_PIN, POTENTIOMETER_PIN);
+    static DisplayManager lcd(I2C_ADDRESS);
+    static DebouncedButton acknowledgeButton(ACKNOWLEDGE_BUTTON_PIN);
+    static SystemState systemState(sensorManager, actuatorController, lcd, acknowledgeButton, EMERGENCY_BUTTON_PIN);
+
+    Hal::serial().begin(TELEMETRY_BAUD);
+    actuatorController.begin();
+    sensorManager.begin();
+    lcd.begin();
+    acknowledgeButton.begin();
+    systemState.begin();
+
+    static Benchmarks benchmarks({sensorManager, lcd, systemState});
+    benchmarks.run();
+    benchmarks.report();
+    return 0;
+}
+
+#endif
@@ -0,0 +1,172 @@
+#include "Benchmarks.h"
+#include "../core/SystemState.h"
+
+#ifndef ARDUINO
+#include <chrono>
+#include <cstdio>
+#endif
+
+namespace
+{
+    // Inputs of the formatting case: a typical status screen
+    constexpr Temperature BENCH_TEMPERATURE = celsius(29.7);
+    constexpr Temperature BENCH_SETPOINT = celsius(30.0);
+    constexpr int BENCH_GAS_VALUE = 312;
+
+#ifdef ARDUINO
+    constexpr const char *BENCH_UNIT = "cycles";
+#else
+    constexpr const char *BENCH_UNIT = "ns";
+#endif
+
+    // Results the compiler must not optimize away are written here
+    volatile Temperature temperatureSink;
+    volatile int32_t sink;
+}
+
+const Benchmarks::Case Benchmarks::CASES[BENCH_CASE_COUNT] = {
+    {"sensor_temperature", &Benchmarks::sensorTemperature},
+    {"sensor_setpoint", &Benchmarks::sensorSetpoint},
+    {"state_lookup", &Benchmarks::stateLookup},
+    {"display_change_check", &Benchmarks::displayChangeCheck},
+    {"display_status", &Benchmarks::displayStatus},
+    {"fsm_update", &Benchmarks::fsmUpdate},
+};
+
+// === CONSTRUCTOR ===
+Benchmarks::Benchmarks(const BenchFixture &fixture)
+    : _fixture(fixture),
+      _results{},
+      _overhead(0),
+      _round(0)
+{
+}
+
+// === RUNNER ===
+void Benchmarks::run()
+{
+#ifdef ARDUINO
+    // Timer1 free-running at the CPU clock, without interrupts. The scheduler tick
+    // is not started in the benchmark build, so the timer is ours.
+    TCCR1A = 0;
+    TCCR1B = _BV(CS10);
+    TIMSK1 = 0;
+#endif
+    _overhead = 0;
+    _overhead = measure({"empty", &Benchmarks::empty}).min;
+    for (uint8_t i = 0; i < BENCH_CASE_COUNT; i++)
+    {
+        _results[i] = measure(CASES[i]);
+    }
+}
+
+BenchResult Benchmarks::measure(const Case &benchCase)
+{
+    BenchResult result{benchCase.name, 0, 0, 0};
+    BenchTime total = 0;
+    for (uint16_t i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        _round++;
+#ifdef ARDUINO
+        uint32_t cycles;
+        {
+            Hal::InterruptLock lock;
+            TIFR1 = _BV(TOV1);
+            TCNT1 = 0;
+            benchCase.call(*this);
+            cycles = TCNT1;
+            if (TIFR1 & _BV(TOV1))
+            {
+                cycles += 0x10000UL;
+            }
+        }
+        BenchTime time = cycles > _overhead ? cycles - _overhead : 0;
+#else
+        auto start = std::chrono::steady_clock::now();
+        for (uint16_t call = 0; call < BENCH_BATCH_CALLS; call++)
+        {
+            benchCase.call(*this);
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        BenchTime perCall = elapsed.count() / BENCH_BATCH_CALLS;
+        BenchTime time = perCall > _overhead ? perCall - _overhead : 0;
+#endif
+        result.min = (i == 0 || time < result.min) ? time : result.min;
+        result.max = time > result.max ? time : result.max;
+        total += time;
+    }
+    result.mean = total / BENCH_ITERATIONS;
+    return result;
+}
+
+void Benchmarks::report() const
+{
+#ifdef ARDUINO
+    Hal::SerialPort &port = Hal::serial();
+    port.println("# Bio-Logic Controller benchmarks");
+    port.print("# overhead_cycles ");
+    port.println(_overhead);
+    port.println("name,unit,iterations,min,mean,max");
+    for (const BenchResult &result : _results)
+    {
+        port.print(result.name);
+        port.print(',');
+        port.print(BENCH_UNIT);
+        port.print(',');
+        port.print(BENCH_ITERATIONS);
+        port.print(',');
+        port.print(result.min);
+        port.print(',');
+        port.print(result.mean);
+        port.print(',');
+        port.println(result.max);
+    }
+#else
+    printf("# Bio-Logic Controller benchmarks\n");
+    printf("# overhead_ns %.2f\n", _overhead);
+    printf("name,unit,iterations,min,mean,max\n");
+    for (const BenchResult &result : _results)
+    {
+        printf("%s,%s,%u,%.2f,%.2f,%.2f\n", result.name, BENCH_UNIT, static_cast<unsigned>(BENCH_ITERATIONS),
+               result.min, result.mean, result.max);
+    }
+#endif
+}
+
+// === CASES ===
+void Benchmarks::empty(Benchmarks &self)
+{
+}
+
+void Benchmarks::sensorTemperature(Benchmarks &self)
+{
+    temperatureSink = self._fixture.sensorManager.getTemperature();
+}
+
+void Benchmarks::sensorSetpoint(Benchmarks &self)
+{
+    temperatureSink = self._fixture.sensorManager.getSetpoint();
+}
+
+void Benchmarks::stateLookup(Benchmarks &self)
+{
+    sink = pgm_read_byte(&States::descriptor(static_cast<States::Type>(self._round % States::COUNT))->outputs);
+}
+
+void Benchmarks::displayChangeCheck(Benchmarks &self)
+{
+    // Same values as last drawn: the check rejects the redraw, as on most FSM passes
+    SystemState &systemState = self._fixture.systemState;
+    systemState.updateDisplay(systemState._previousLabelPrinted, systemState._previousTemperaturePrinted,
+                              systemState._previousSetpointPrinted, systemState._previousGasValuePrinted);
+}
+
+void Benchmarks::displayStatus(Benchmarks &self)
+{
+    self._fixture.displayManager.displayStatus(States::label(States::Type::MAINTAINING), BENCH_TEMPERATURE, BENCH_SETPOINT, BENCH_GAS_VALUE);
+}
+
+void Benchmarks::fsmUpdate(Benchmarks &self)
+{
+    self._fixture.systemState.update();
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "../hal/Hal.h"
+
+class SensorManager;
+class DisplayManager;
+class SystemState;
+
+/**
+ * @file Benchmarks.h
+ * @brief Microbenchmarks of the firmware hot paths (env:uno_bench, env:native_bench).
+ *
+ * @details Each case calls one hot path of the control core on the real objects:
+ *          the sensor getters, the state descriptor lookup, the change detection of
+ *          `SystemState::updateDisplay()`, the `DisplayManager::displayStatus()`
+ *          formatting and a whole `SystemState::update()` pass.
+ *
+ *          - On the Uno every call is timed on its own with Timer1 counting CPU
+ *            cycles, interrupts disabled, minus the cost of timing an empty call.
+ *            Calls up to 131071 cycles (8 ms) are measured exactly.
+ *          - On the host, batches of calls are timed with the wall clock and the
+ *            result is the time per call, in nanoseconds. The HAL calls a case makes
+ *            go to the chamber simulator, so they include its bookkeeping.
+ *
+ *          The report is CSV, `name,unit,iterations,min,mean,max`, after `#` comment
+ *          lines; `tools/bench_compare.py` compares two of them.
+ */
+
+#ifdef ARDUINO
+using BenchTime = uint32_t; // CPU cycles
+constexpr uint16_t BENCH_ITERATIONS = 256; // Timed calls per case
+#else
+using BenchTime = double; // Nanoseconds per call
+constexpr uint16_t BENCH_ITERATIONS = 200;  // Timed batches per case
+constexpr uint16_t BENCH_BATCH_CALLS = 1000; // Calls per batch
+#endif
+
+constexpr uint8_t BENCH_CASE_COUNT = 6;
+
+/**
+ * @brief The firmware objects the cases run against, already started.
+ */
+struct BenchFixture
+{
+    SensorManager &sensorManager;
+    DisplayManager &displayManager;
+    SystemState &systemState;
+};
+
+/**
+ * @brief The timings of one case.
+ */
+struct BenchResult
+{
+    const char *name;
+    BenchTime min;
+    BenchTime mean;
+    BenchTime max;
+};
+
+/**
+ * @class Benchmarks
+ * @brief Runs every case and prints the report.
+ */
+class Benchmarks
+{
+public:
+    explicit Benchmarks(const BenchFixture &fixture);
+
+    /**
+     * @brief Times every case, BENCH_ITERATIONS times each.
+     */
+    void run();
+
+    /**
+     * @brief Prints the report: over Serial on the Uno, on stdout on the host.
+     */
+    void report() const;
+
+private:
+    struct Case
+    {
+        const char *name;
+        void (*call)(Benchmarks &self);
+    };
+
+    static const Case CASES[BENCH_CASE_COUNT];
+
+    BenchFixture _fixture;
+    BenchResult _results[BENCH_CASE_COUNT];
+    BenchTime _overhead; // Cost of timing an empty call
+    uint16_t _round;     // Varies the inputs of the cases that must not see the same values twice
+
+    BenchResult measure(const Case &benchCase);
+
+    // --- Cases ---
+    static void empty(Benchmarks &self);
+    static void sensorTemperature(Benchmarks &self);
+    static void sensorSetpoint(Benchmarks &self);
+    static void stateLookup(Benchmarks &self);
+    static void displayChangeCheck(Benchmarks &self);
+    static void displayStatus(Benchmarks &self);
+    static void fsmUpdate(Benchmarks &self);
+};
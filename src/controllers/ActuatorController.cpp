@@ -1,93 +1,143 @@
 #include "ActuatorController.h"
+#include "../diagnostics/LoopProfiler.h"
 
 ActuatorController::ActuatorController(byte heaterPin, byte greenLedPin, byte redLedPin, byte piezoPin)
-    : _heaterPin(heaterPin),
-      _greenLedPin(greenLedPin),
+    : _greenLedPin(greenLedPin),
       _redLedPin(redLedPin),
-      _piezoPin(piezoPin),
-      _isSirenActive(false),
-      _lastSirenUpdateTime(0),
-      _currentSirenFrequency(SIREN_MIN_FREQUENCY),
-      _isSirenSweepingUp(true)
+      _greenLed{},
+      _redLed{},
+      _requested(0),
+      _committed(0),
+      _latched(false),
+      _ledRequests(0),
+      _ledWrites(0),
+      _heater(heaterPin),
+      _siren(piezoPin)
 {
 }
 
 void ActuatorController::begin()
 {
-    pinMode(_heaterPin, OUTPUT);
-    pinMode(_greenLedPin, OUTPUT);
-    pinMode(_redLedPin, OUTPUT);
-    pinMode(_piezoPin, OUTPUT);
+    Hal::pinMode(_greenLedPin, OUTPUT);
+    Hal::pinMode(_redLedPin, OUTPUT);
+    _greenLed = Hal::fastPin(_greenLedPin);
+    _redLed = Hal::fastPin(_redLedPin);
+    Hal::fastWrite(_greenLed, false);
+    Hal::fastWrite(_redLed, false);
+    _requested = 0;
+    _committed = 0;
+    _heater.begin();
+    _siren.begin();
 }
 
-void ActuatorController::setSirenState(bool active)
+void ActuatorController::registerTasks(Scheduler &scheduler)
 {
-    _isSirenActive = active;
-    if (!_isSirenActive)
-    {
-        noTone(_piezoPin);
-    }
+    scheduler.addTickHook<HeaterDriver, &HeaterDriver::onTick>(_heater);
 }
 
-void ActuatorController::update()
+void ActuatorController::setSirenState(bool active, SirenPattern pattern)
 {
-    updateSirenTone();
+    PROFILE_PHASE(ACTUATORS);
+    if (active)
+    {
+        _siren.play(pattern);
+    }
+    else
+    {
+        _siren.stop();
+    }
 }
 
-void ActuatorController::updateSirenTone()
+void ActuatorController::setHeaterDuty(uint8_t percent)
 {
-    // If the siren is not active, exit immediately.
-    if (!_isSirenActive)
+    PROFILE_PHASE(ACTUATORS);
+    if (percent != _heater.duty())
     {
-        return;
+        _heater.setDuty(percent);
     }
+}
 
-    // Get the current time in milliseconds.
-    unsigned long currentTime = millis();
-    // Calculate how much time has passed since the last tone update.
-    unsigned long timeElapsed = currentTime - _lastSirenUpdateTime;
-
-    // Check if it's time to update the siren's tone.
-    if (timeElapsed >= SIREN_UPDATE_INTERVAL_MS)
+void ActuatorController::releaseHeater()
+{
+    if (!_latched)
     {
-        // Record the time of this update.
-        _lastSirenUpdateTime = currentTime;
-
-        // Play the current tone. This will continue until a new tone or noTone is called.
-        tone(_piezoPin, _currentSirenFrequency);
-
-        // Determine the next frequency by adjusting up or down.
-        if (_isSirenSweepingUp)
-        {
-            // Increase the frequency for an upward sweep.
-            _currentSirenFrequency += SIREN_FREQUENCY_STEP;
+        _heater.release();
+    }
+}
 
-            // If the maximum frequency is reached, change direction.
-            if (_currentSirenFrequency >= SIREN_MAX_FREQUENCY)
-            {
-                _isSirenSweepingUp = false;
-            }
-        }
-        else
-        {
-            // Decrease the frequency for a downward sweep.
-            _currentSirenFrequency -= SIREN_FREQUENCY_STEP;
+void ActuatorController::releaseEmergencyOutputs()
+{
+    Hal::InterruptLock lock;
+    _latched = false;
+    _heater.release();
+}
 
-            // If the minimum frequency is reached, change direction.
-            if (_currentSirenFrequency <= SIREN_MIN_FREQUENCY)
-            {
-                _isSirenSweepingUp = true;
-            }
-        }
-    }
+void ActuatorController::setHeaterWindow(uint16_t windowMs)
+{
+    _heater.setWindow(windowMs);
 }
 
 void ActuatorController::setStatusHeater(bool activate) {
-  digitalWrite(_heaterPin, activate ? HIGH : LOW);
+  setHeaterDuty(activate ? HEATER_MAX_DUTY : 0);
 }
 void ActuatorController::setStatusGreenLED(bool active) {
-    digitalWrite(_greenLedPin, active);
+    _requested = active ? (_requested | LED_GREEN) : (_requested & ~LED_GREEN);
+    _ledRequests++;
 }
 void ActuatorController::setStatusRedLED(bool active) {
-    digitalWrite(_redLedPin, active);
-}
\ No newline at end of file
+    _requested = active ? (_requested | LED_RED) : (_requested & ~LED_RED);
+    _ledRequests++;
+}
+
+void ActuatorController::commitOutputs()
+{
+    PROFILE_PHASE(ACTUATORS);
+    // The emergency interrupt writes the red LED and _committed too.
+    Hal::InterruptLock lock;
+    uint8_t requested = _latched ? (_requested | LED_RED) : _requested;
+    uint8_t changed = requested ^ _committed;
+    if (changed == 0)
+    {
+        return;
+    }
+    if (changed & LED_GREEN)
+    {
+        Hal::fastWrite(_greenLed, requested & LED_GREEN);
+        _ledWrites++;
+    }
+    if (changed & LED_RED)
+    {
+        Hal::fastWrite(_redLed, requested & LED_RED);
+        _ledWrites++;
+    }
+    _committed = requested;
+}
+
+void ActuatorController::reportOutputs(Hal::SerialPort &port) const
+{
+    uint32_t switches = _heater.switchCount();
+    uint32_t uptimeS = Hal::millis() / 1000;
+
+    port.println("window_ms,duty_pct,switches,switches_per_hour,led_writes,led_writes_avoided");
+    port.print(static_cast<unsigned int>(_heater.windowMs()));
+    port.print(",");
+    port.print(static_cast<unsigned int>(_heater.duty()));
+    port.print(",");
+    port.print(switches);
+    port.print(",");
+    port.print(uptimeS > 0 ? switches * 3600UL / uptimeS : 0UL);
+    port.print(",");
+    port.print(getLedWriteCount());
+    port.print(",");
+    port.println(getLedWritesAvoided());
+}
+
+// === INTERRUPT CONTEXT ===
+void ActuatorController::latchEmergencyOutputs()
+{
+    Hal::InterruptLock lock;
+    _heater.forceOff();
+    Hal::fastWrite(_redLed, true);
+    _committed |= LED_RED;
+    _latched = true;
+}
@@ -1,18 +1,27 @@
 #pragma once
 
-#include <Arduino.h>
-
-// --- constexprants to configure the siren sound ---
-constexpr int SIREN_MIN_FREQUENCY = 500;  // The lowest tone of the siren (in Hz)
-constexpr int SIREN_MAX_FREQUENCY = 1500; // The highest tone of the siren (in Hz)
-constexpr int SIREN_FREQUENCY_STEP = 25;  // How much to change the frequency on each step
-constexpr int SIREN_UPDATE_INTERVAL_MS = 15; // Time between frequency changes (in milliseconds)
+#include "../hal/Hal.h"
+#include "Siren.h"
+#include "HeaterDriver.h"
+#include "../core/Scheduler.h"
 
 /**
  * @brief Manages all output actuators for the fermentation chamber.
  * @details This class provides a high-level interface to control physical
  *          outputs like the heating element (via a transistor) and the status LEDs.
- *          It abstracts away the low-level digitalWrite calls.
+ *          It abstracts away the low-level pin writes. The heater is driven
+ *          with a duty cycle (see HeaterDriver).
+ *
+ *          The LED setters only change a shadow copy of the outputs in RAM.
+ *          `commitOutputs()`, called once at the end of each FSM pass, writes the bits
+ *          that differ from what the pins show with direct PORT writes. A state that
+ *          sets an LED twice in a pass never makes it glitch. Setter calls that needed
+ *          no pin write are counted.
+ *
+ *          `latchEmergencyOutputs()` bypasses all of this from the emergency button
+ *          interrupt: the heater and the red LED are written at once, and stay so
+ *          whatever the FSM requests until the stop is acknowledged
+ *          (`releaseEmergencyOutputs()`).
  */
 class ActuatorController
 {
@@ -32,52 +41,122 @@ public:
     void begin();
 
     /**
-     * @brief Turns the heating element on or off.
+     * @brief Hooks the heater's slow PWM onto the scheduler tick. Must be called before
+     *        the scheduler's `begin()`.
+     */
+    void registerTasks(Scheduler &scheduler);
+
+    /**
+     * @brief Sets the heater duty cycle.
+     * @param percent 0 (off) to 100 (always on).
+     */
+    void setHeaterDuty(uint8_t percent);
+
+    /**
+     * @brief Sets the length of the heater's PWM window.
+     * @details Longer windows mean fewer relay cycles and a coarser heat delivery.
+     */
+    void setHeaterWindow(uint16_t windowMs);
+
+    /**
+     * @brief Turns the heating element fully on or off (duty 100 or 0).
      * @param active Set to true to activate the heater, false to deactivate it.
      */
     void setStatusHeater(bool active);
 
+    /**
+     * @brief Opens the heater relay at once and holds it open until `releaseHeater()`.
+     * @details ISR-safe: used by the gas trip, ahead of the FSM pass that handles it.
+     */
+    void forceHeaterOff() { _heater.forceOff(); }
+
+    /**
+     * @brief Gives the heater back to its duty cycle after `forceHeaterOff()`, unless
+     *        the emergency outputs are latched.
+     */
+    void releaseHeater();
+
+    /**
+     * @brief Opens the heater relay and lights the red LED with direct PORT writes, and
+     *        latches both until `releaseEmergencyOutputs()`. ISR-safe: called by the
+     *        emergency stop interrupt.
+     */
+    void latchEmergencyOutputs();
+
+    /**
+     * @brief Ends the latch: the heater follows its duty and the red LED the FSM again.
+     * @details Called when the operator acknowledges the emergency stop.
+     */
+    void releaseEmergencyOutputs();
+
+    bool isEmergencyLatched() const { return _latched; }
+
+    uint8_t getHeaterDuty() const { return _heater.duty(); }
+    bool isHeaterOn() const { return _heater.isOn(); }
+    uint32_t getHeaterSwitchCount() const { return _heater.switchCount(); }
+    bool isGreenLedOn() const { return _committed & LED_GREEN; } // As the pins show it
+    bool isRedLedOn() const { return _committed & LED_RED; }
+    bool isSirenOn() const { return _siren.isPlaying(); }
+
+    /**
+     * @brief Returns the number of LED pin writes since `begin()`.
+     */
+    uint32_t getLedWriteCount() const { return _ledWrites; }
+
+    /**
+     * @brief Returns the number of LED setter calls that needed no pin write.
+     */
+    uint32_t getLedWritesAvoided() const { return _ledRequests - _ledWrites; }
+
+    /**
+     * @brief Writes the output statistics as CSV to the given port.
+     * @details Format: `window_ms,duty_pct,switches,switches_per_hour,led_writes,led_writes_avoided`.
+     */
+    void reportOutputs(Hal::SerialPort &port) const;
+
 
     /**
-     * @brief Sets the state of the green LED.
+     * @brief Sets the state of the green LED, from the next `commitOutputs()`.
      * @param active Set to true to turn on the green LED, false to turn it off.
      */
     void setStatusGreenLED(bool active);
 
     /**
-     * @brief Sets the state of the red LED.
+     * @brief Sets the state of the red LED, from the next `commitOutputs()`.
      * @param active Set to true to turn on the red LED, false to turn it off.
      */
     void setStatusRedLED(bool active);
 
     /**
-     * @brief Sets the state of the piezo buzzer.
-     * @param active Set to true to turn on the piezo buzzer, false to turn it off.
+     * @brief Writes the LED outputs that changed since the last commit to their pins.
      */
-    void setSirenState(bool active);
+    void commitOutputs();
 
     /**
-     * @brief Updates the state of time-based actuators, like the siren.
-     * @note This is a non-blocking function that must be called on every iteration
-     *       of the main Arduino loop(). It manages the frequency sweep of the siren
-     *       without using any delay(), allowing other code to run concurrently.
+     * @brief Sets the state of the piezo buzzer.
+     * @details The alarm pattern plays from the tone timer interrupt (see Siren) and needs
+     *          no further calls; repeating the current request has no effect.
+     * @param active Set to true to turn on the piezo buzzer, false to turn it off.
+     * @param pattern The alarm to play while active.
      */
-    void update();
-
+    void setSirenState(bool active, SirenPattern pattern = SirenPattern::GAS_WARNING);
 
 private:
-    byte _heaterPin;
+    // Bits of the shadow output state
+    static constexpr uint8_t LED_GREEN = 0x01;
+    static constexpr uint8_t LED_RED = 0x02;
+
     byte _greenLedPin;
     byte _redLedPin;
-    byte _piezoPin;
-
-    // State variables for the siren
-    bool _isSirenActive;
-    unsigned long _lastSirenUpdateTime;
-    int _currentSirenFrequency;
-    bool _isSirenSweepingUp;
+    Hal::FastPin _greenLed; // Resolved by begin()
+    Hal::FastPin _redLed;
 
-    // pivate methods for internal logic
-    void updateSirenTone();
+    uint8_t _requested; // LED_* bits set by the setters
+    uint8_t _committed; // LED_* bits the pins show
+    volatile bool _latched; // Set by latchEmergencyOutputs(), cleared by releaseEmergencyOutputs()
+    uint32_t _ledRequests;
+    uint32_t _ledWrites;
 
+    HeaterDriver _heater; // Time-proportional output on the heater pin
+    Siren _siren;         // Interrupt-driven alarm generator on the piezo pin
 };
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "HeaterDriver.h"
+
+HeaterDriver::HeaterDriver(uint8_t pin)
+    : _pin(pin),
+      _output{},
+      _duty(0),
+      _windowTicks(HeaterWindow::windowTicks(HEATER_DEFAULT_WINDOW_MS)),
+      _requestedOnTicks(0),
+      _window{},
+      _on(false),
+      _inhibited(false),
+      _switches(0)
+{
+}
+
+void HeaterDriver::begin()
+{
+    Hal::pinMode(_pin, OUTPUT);
+    _output = Hal::fastPin(_pin);
+    Hal::fastWrite(_output, false);
+
+    Hal::InterruptLock lock;
+    _on = false;
+    _inhibited = false;
+    _switches = 0;
+    _window.reset(_windowTicks); // The next tick opens a window
+}
+
+void HeaterDriver::setDuty(uint8_t percent)
+{
+    _duty = percent > HEATER_MAX_DUTY ? HEATER_MAX_DUTY : percent;
+    updateRequestedOnTicks();
+}
+
+void HeaterDriver::setWindow(uint16_t windowMs)
+{
+    uint16_t windowTicks = HeaterWindow::windowTicks(windowMs);
+    {
+        Hal::InterruptLock lock;
+        _windowTicks = windowTicks;
+    }
+    updateRequestedOnTicks();
+}
+
+uint16_t HeaterDriver::windowMs() const
+{
+    Hal::InterruptLock lock;
+    return HeaterWindow::windowMs(_windowTicks);
+}
+
+uint32_t HeaterDriver::switchCount() const
+{
+    Hal::InterruptLock lock;
+    return _switches;
+}
+
+void HeaterDriver::updateRequestedOnTicks()
+{
+    // The division happens here, never in the tick hook.
+    Hal::InterruptLock lock;
+    _requestedOnTicks = HeaterWindow::onTicks(_windowTicks, _duty);
+}
+
+void HeaterDriver::forceOff()
+{
+    // The lock restores the previous state, so this also runs inside an interrupt handler
+    Hal::InterruptLock lock;
+    _inhibited = true;
+    if (_on)
+    {
+        drive(false);
+    }
+}
+
+// === INTERRUPT CONTEXT ===
+void HeaterDriver::onTick()
+{
+    bool on = _window.tick(_windowTicks, _requestedOnTicks, _on) && !_inhibited;
+    if (on != _on)
+    {
+        drive(on);
+    }
+}
+
+void HeaterDriver::drive(bool on)
+{
+    Hal::fastWrite(_output, on);
+    _on = on;
+    _switches++;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "../hal/Hal.h"
+#include "HeaterWindow.h"
+
+/**
+ * @class HeaterDriver
+ * @brief Time-proportional (slow PWM) output for the heater relay.
+ *
+ * @details The heater can only be on or off, so a duty cycle is produced over a window
+ *          of several seconds: the relay closes at the start of each window and opens
+ *          after `duty` percent of it. The edges are placed by the 1 ms tick interrupt
+ *          (see Scheduler::addTickHook()), so their timing does not depend on how busy
+ *          the main loop is.
+ *
+ *          To spare the relay, a new duty never adds an extra cycle inside a window:
+ *          a lower duty takes effect at once (the relay may open early), a higher one
+ *          only stretches a pulse that is still running, otherwise it waits for the next
+ *          window (see HeaterWindow). Every relay transition is counted.
+ *
+ *          `forceOff()` opens the relay at once, from any context, and holds it open
+ *          whatever the duty until `release()`.
+ */
+class HeaterDriver
+{
+public:
+    /**
+     * @brief Constructs the driver.
+     * @param pin The digital pin connected to the heater transistor.
+     */
+    explicit HeaterDriver(uint8_t pin);
+
+    /**
+     * @brief Configures the pin and opens the relay. The first window starts on the next tick.
+     */
+    void begin();
+
+    /**
+     * @brief Requests a duty cycle.
+     * @param percent 0 (off) to HEATER_MAX_DUTY (always on); larger values are clamped.
+     */
+    void setDuty(uint8_t percent);
+
+    /**
+     * @brief Changes the window length. Takes effect from the next window.
+     * @param windowMs Clamped to HEATER_MIN_WINDOW_MS..HEATER_MAX_WINDOW_MS.
+     */
+    void setWindow(uint16_t windowMs);
+
+    /**
+     * @brief Opens the relay now and keeps it open until `release()`. ISR-safe.
+     */
+    void forceOff();
+
+    /**
+     * @brief Lets the duty drive the relay again, from the next tick.
+     */
+    void release() { _inhibited = false; }
+
+    bool isInhibited() const { return _inhibited; }
+    uint8_t duty() const { return _duty; }
+    uint16_t windowMs() const;
+    bool isOn() const { return _on; }
+
+    /**
+     * @brief Returns the number of relay transitions (on and off) since `begin()`.
+     */
+    uint32_t switchCount() const;
+
+    /**
+     * @brief The tick hook: advances the window and moves the relay. Interrupt context.
+     */
+    void onTick();
+
+private:
+    uint8_t _pin;
+    Hal::FastPin _output; // Written from the tick interrupt without digitalWrite()'s lookups
+    uint8_t _duty;
+
+    // Written with interrupts off, read by the tick hook
+    volatile uint16_t _windowTicks;
+    volatile uint16_t _requestedOnTicks; // On time of `_duty` over the current window length
+
+    // Owned by the tick hook
+    HeaterWindow _window;
+    volatile bool _on;
+    volatile bool _inhibited; // Set by forceOff(), cleared by release()
+    volatile uint32_t _switches;
+
+    /**
+     * @brief Moves the relay and counts the transition. Interrupts must be off.
+     */
+    void drive(bool on);
+
+    void updateRequestedOnTicks();
+};
@@ -0,0 +1,26 @@
+#include "HeaterWindow.h"
+
+constexpr uint16_t TICKS_PER_MS = 1000 / Hal::TICK_PERIOD_US;
+
+uint16_t HeaterWindow::windowTicks(uint16_t windowMs)
+{
+    if (windowMs < HEATER_MIN_WINDOW_MS)
+    {
+        windowMs = HEATER_MIN_WINDOW_MS;
+    }
+    else if (windowMs > HEATER_MAX_WINDOW_MS)
+    {
+        windowMs = HEATER_MAX_WINDOW_MS;
+    }
+    return windowMs * TICKS_PER_MS;
+}
+
+uint16_t HeaterWindow::onTicks(uint16_t windowTicks, uint8_t duty)
+{
+    return static_cast<uint16_t>(static_cast<uint32_t>(windowTicks) * duty / HEATER_MAX_DUTY);
+}
+
+uint16_t HeaterWindow::windowMs(uint16_t windowTicks)
+{
+    return windowTicks / TICKS_PER_MS;
+}
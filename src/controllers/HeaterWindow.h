@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../hal/Hal.h"
+
+// --- Constants of the time-proportional heater output ---
+constexpr uint16_t HEATER_DEFAULT_WINDOW_MS = 20000; // One relay cycle at most per window
+constexpr uint16_t HEATER_MIN_WINDOW_MS = 1000;      // 10 ms per duty step, well above relay bounce
+constexpr uint16_t HEATER_MAX_WINDOW_MS = 60000;
+constexpr uint8_t HEATER_MAX_DUTY = 100; // Duty is expressed in percent
+
+/**
+ * @class HeaterWindow
+ * @brief The window and pulse of one time-proportional heater output, advanced by the
+ *        tick interrupt.
+ *
+ * @details Holds the pulse rules every heater output follows, whether it has a
+ *          HeaterDriver of its own or is one of the batched chambers of a
+ *          MultiChamberController. The relay closes at the start of each window and
+ *          opens after the requested on time. A shorter on time takes effect at once,
+ *          a longer one only stretches the pulse still running: a new duty never adds
+ *          a relay cycle inside a window.
+ *
+ *          The window length and the requested on time are kept by the owner, which
+ *          may share them between several windows.
+ */
+class HeaterWindow
+{
+public:
+    /**
+     * @brief Converts a window length to ticks.
+     * @param windowMs Clamped to HEATER_MIN_WINDOW_MS..HEATER_MAX_WINDOW_MS.
+     */
+    static uint16_t windowTicks(uint16_t windowMs);
+
+    /**
+     * @brief Returns the on time of `duty` percent of a window, in ticks.
+     * @details Divides: called when the duty changes, never from the tick hook.
+     */
+    static uint16_t onTicks(uint16_t windowTicks, uint8_t duty);
+
+    /**
+     * @brief Returns the window length of a tick count, in milliseconds.
+     */
+    static uint16_t windowMs(uint16_t windowTicks);
+
+    /**
+     * @brief Opens the relay's pulse and makes a tick `delayTicks` after the next one
+     *        open a window.
+     * @param delayTicks Less than `windowTicks`, e.g. to stagger several windows.
+     */
+    void reset(uint16_t windowTicks, uint16_t delayTicks = 0)
+    {
+        _phase = windowTicks - 1 - delayTicks;
+        _onTicks = 0;
+    }
+
+    /**
+     * @brief Advances the window by one tick. Interrupt context.
+     * @param windowTicks The window length; a new one takes effect from the next window.
+     * @param requestedOnTicks The on time of the current duty over that length.
+     * @param on Whether the relay is closed now.
+     * @return Whether the relay should be closed for this tick.
+     */
+    bool tick(uint16_t windowTicks, uint16_t requestedOnTicks, bool on)
+    {
+        if (++_phase >= windowTicks)
+        {
+            _phase = 0;
+            _onTicks = requestedOnTicks;
+        }
+        else if (requestedOnTicks < _onTicks || on)
+        {
+            // Cut the pulse short, or stretch the one still running.
+            _onTicks = requestedOnTicks;
+        }
+        return _phase < _onTicks;
+    }
+
+private:
+    uint16_t _phase;   // Ticks elapsed in the current window
+    uint16_t _onTicks; // On time of the current window
+};
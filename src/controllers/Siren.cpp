@@ -0,0 +1,157 @@
+#include "Siren.h"
+
+// === COMPILE-TIME TABLES ===
+namespace
+{
+    constexpr uint8_t SWEEP_STEP_COUNT = 2 * (SIREN_TONE_COUNT - 1); // Up, then down, without repeating the ends
+    constexpr uint8_t HARDWARE_STOP_SLOTS = 16;                      // 240 ms per tone
+
+    struct ToneTable
+    {
+        SirenTone tones[SIREN_TONE_COUNT];
+    };
+
+    struct SweepTable
+    {
+        SirenStep steps[SWEEP_STEP_COUNT];
+    };
+
+    constexpr long roundToLong(float value)
+    {
+        return static_cast<long>(value + 0.5f);
+    }
+
+    constexpr uint8_t toneIndex(int frequency)
+    {
+        return static_cast<uint8_t>((frequency - SIREN_MIN_FREQUENCY) / SIREN_FREQUENCY_STEP);
+    }
+
+    constexpr ToneTable makeToneTable()
+    {
+        ToneTable table{};
+        for (uint8_t i = 0; i < SIREN_TONE_COUNT; i++)
+        {
+            float frequency = SIREN_MIN_FREQUENCY + i * SIREN_FREQUENCY_STEP;
+            // The pin toggles twice per period, every compare + 1 timer clocks.
+            table.tones[i].compare = static_cast<uint8_t>(roundToLong(Hal::TONE_TIMER_CLOCK_HZ / (2 * frequency)) - 1);
+            table.tones[i].togglesPerSlot = static_cast<uint8_t>(roundToLong(2 * frequency * SIREN_UPDATE_INTERVAL_MS / 1000.0f));
+        }
+        return table;
+    }
+
+    constexpr SweepTable makeSweep()
+    {
+        SweepTable table{};
+        for (uint8_t i = 0; i < SWEEP_STEP_COUNT; i++)
+        {
+            uint8_t tone = i < SIREN_TONE_COUNT ? i : SWEEP_STEP_COUNT - i;
+            table.steps[i] = SirenStep{tone, 1};
+        }
+        return table;
+    }
+
+    static_assert(Hal::TONE_TIMER_CLOCK_HZ / (2 * SIREN_MIN_FREQUENCY) <= 256, "Lowest tone needs a compare value above 255");
+    static_assert(2L * SIREN_MAX_FREQUENCY * SIREN_UPDATE_INTERVAL_MS / 1000 <= 255, "Slot too long for an 8-bit toggle count");
+}
+
+const ToneTable TONE_TABLE PROGMEM = makeToneTable();
+
+// GAS_WARNING: the classic siren sweep, one table step per slot (1.2 s per cycle).
+const SweepTable GAS_WARNING_STEPS PROGMEM = makeSweep();
+
+// HARDWARE_STOP: a high-low alternation that cannot be mistaken for the gas sweep.
+const SirenStep HARDWARE_STOP_STEPS[] PROGMEM = {
+    {toneIndex(SIREN_MAX_FREQUENCY), HARDWARE_STOP_SLOTS},
+    {toneIndex(1000), HARDWARE_STOP_SLOTS},
+};
+
+// === SIREN ===
+Siren *Siren::_instance = nullptr;
+
+Siren::Siren(uint8_t pin)
+    : _pin(pin),
+      _playing(false),
+      _pattern(SirenPattern::GAS_WARNING),
+      _steps(nullptr),
+      _stepCount(0),
+      _stepIndex(0),
+      _slotsLeft(0),
+      _togglesLeft(0),
+      _togglesPerSlot(0)
+{
+}
+
+void Siren::begin()
+{
+    _instance = this;
+    _playing = false;
+    Hal::toneTimerBegin(_pin, &Siren::onToggle);
+}
+
+void Siren::play(SirenPattern pattern)
+{
+    if (_playing && _pattern == pattern)
+    {
+        return;
+    }
+
+    Hal::InterruptLock lock;
+    switch (pattern)
+    {
+    case SirenPattern::HARDWARE_STOP:
+        _steps = HARDWARE_STOP_STEPS;
+        _stepCount = sizeof(HARDWARE_STOP_STEPS) / sizeof(HARDWARE_STOP_STEPS[0]);
+        break;
+    case SirenPattern::GAS_WARNING:
+    default:
+        _steps = GAS_WARNING_STEPS.steps;
+        _stepCount = SWEEP_STEP_COUNT;
+        break;
+    }
+    _pattern = pattern;
+    _stepIndex = 0;
+    uint8_t compare = loadStep();
+    _playing = true;
+    Hal::toneTimerStart(compare);
+}
+
+void Siren::stop()
+{
+    if (!_playing)
+    {
+        return;
+    }
+    Hal::toneTimerStop();
+    _playing = false;
+}
+
+uint8_t Siren::loadStep()
+{
+    uint8_t tone = pgm_read_byte(&_steps[_stepIndex].tone);
+    _slotsLeft = pgm_read_byte(&_steps[_stepIndex].slots);
+    _togglesPerSlot = pgm_read_byte(&TONE_TABLE.tones[tone].togglesPerSlot);
+    _togglesLeft = _togglesPerSlot;
+    return pgm_read_byte(&TONE_TABLE.tones[tone].compare);
+}
+
+// === INTERRUPT CONTEXT ===
+void Siren::onToggle()
+{
+    Siren &self = *_instance;
+    if (--self._togglesLeft != 0)
+    {
+        return;
+    }
+
+    if (--self._slotsLeft == 0)
+    {
+        // Next step of the pattern, looping forever.
+        if (++self._stepIndex == self._stepCount)
+        {
+            self._stepIndex = 0;
+        }
+        Hal::toneTimerSetCompare(self.loadStep());
+        return;
+    }
+    self._togglesLeft = self._togglesPerSlot;
+}
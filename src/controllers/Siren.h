@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../hal/Hal.h"
+
+// --- constexprants to configure the siren sound ---
+constexpr int SIREN_MIN_FREQUENCY = 500;     // The lowest tone of the siren (in Hz)
+constexpr int SIREN_MAX_FREQUENCY = 1500;    // The highest tone of the siren (in Hz)
+constexpr int SIREN_FREQUENCY_STEP = 25;     // Frequency difference between two table entries
+constexpr int SIREN_UPDATE_INTERVAL_MS = 15; // Duration of one pattern slot (in milliseconds)
+
+constexpr uint8_t SIREN_TONE_COUNT = (SIREN_MAX_FREQUENCY - SIREN_MIN_FREQUENCY) / SIREN_FREQUENCY_STEP + 1;
+
+/**
+ * @brief The alarm sounds the siren can play.
+ */
+enum class SirenPattern : uint8_t
+{
+    GAS_WARNING,   // Continuous up/down sweep over the whole frequency range
+    HARDWARE_STOP, // Two-tone alternation, clearly distinct from the gas warning
+    COUNT
+};
+
+/**
+ * @brief One entry of the frequency table.
+ */
+struct SirenTone
+{
+    uint8_t compare;       // Timer compare value giving this frequency
+    uint8_t togglesPerSlot; // Pin toggles (half periods) lasting one slot
+};
+
+/**
+ * @brief One step of a pattern: a tone held for a number of slots.
+ */
+struct SirenStep
+{
+    uint8_t tone;  // Index into the frequency table
+    uint8_t slots; // Duration, in SIREN_UPDATE_INTERVAL_MS units
+};
+
+/**
+ * @class Siren
+ * @brief Interrupt-driven alarm generator on the piezo buzzer.
+ *
+ * @details The tone timer toggles the piezo pin at twice the tone frequency and calls
+ *          the siren on every toggle. The siren counts the toggles of the current slot
+ *          and, at the end of a slot, moves to the next step of the pattern, loading the
+ *          next compare value from a frequency table generated at compile time in
+ *          PROGMEM. Slot boundaries are therefore counted in the tone's own periods:
+ *          the sweep keeps its rhythm whatever the main loop is doing, and once started
+ *          a pattern costs the main loop nothing.
+ */
+class Siren
+{
+public:
+    /**
+     * @brief Constructs the siren.
+     * @param pin The digital pin connected to the piezo buzzer.
+     */
+    explicit Siren(uint8_t pin);
+
+    /**
+     * @brief Takes ownership of the tone timer. The siren starts silent.
+     * @attention Only one siren may be active, since it owns the tone timer interrupt.
+     */
+    void begin();
+
+    /**
+     * @brief Starts a pattern from its first step. Playing the pattern that is already
+     *        playing does nothing, so this can be called on every FSM pass.
+     */
+    void play(SirenPattern pattern);
+
+    /**
+     * @brief Silences the siren.
+     */
+    void stop();
+
+    /**
+     * @brief Returns true while a pattern is playing.
+     */
+    bool isPlaying() const { return _playing; }
+
+private:
+    static Siren *_instance; // The siren served by the tone timer interrupt
+
+    uint8_t _pin;
+    bool _playing;
+    SirenPattern _pattern;
+
+    // Owned by the interrupt handler while playing
+    const SirenStep *_steps; // Pattern being played (PROGMEM)
+    uint8_t _stepCount;
+    uint8_t _stepIndex;
+    uint8_t _slotsLeft;      // Slots left in the current step
+    uint8_t _togglesLeft;    // Toggles left in the current slot
+    uint8_t _togglesPerSlot; // Of the current tone
+
+    /**
+     * @brief The body of the tone timer interrupt.
+     */
+    static void onToggle();
+
+    /**
+     * @brief Loads step `_stepIndex` and returns the compare value of its tone.
+     */
+    uint8_t loadStep();
+};
@@ -0,0 +1,231 @@
+#include "Autotuner.h"
+#include "../controllers/HeaterDriver.h"
+
+namespace
+{
+    constexpr uint8_t Q8_8_SHIFT = 16; // From Q8.24
+    constexpr uint32_t PI_THOUSANDTHS = 3142;
+
+    inline int16_t toQ8_8(Temperature value)
+    {
+        return static_cast<int16_t>(TemperatureMath::toQ8_24(value) >> Q8_8_SHIFT);
+    }
+
+    uint16_t squareRoot(uint32_t value)
+    {
+        uint32_t root = 0;
+        uint32_t bit = 1UL << 30;
+        while (bit > value)
+        {
+            bit >>= 2;
+        }
+        while (bit != 0)
+        {
+            if (value >= root + bit)
+            {
+                value -= root + bit;
+                root = (root >> 1) + bit;
+            }
+            else
+            {
+                root >>= 1;
+            }
+            bit >>= 2;
+        }
+        return static_cast<uint16_t>(root);
+    }
+
+    int16_t clampGain(uint32_t value, int16_t max, bool &clamped)
+    {
+        clamped = clamped || value > static_cast<uint32_t>(max);
+        return value > static_cast<uint32_t>(max) ? max : static_cast<int16_t>(value);
+    }
+}
+
+// === CONSTRUCTOR ===
+Autotuner::Autotuner()
+    : _status(Status::IDLE),
+      _setpoint(0),
+      _high(false),
+      _bias(0),
+      _steps(0),
+      _switchStep(0),
+      _highSteps(0),
+      _cycleOpen(false),
+      _peak(0),
+      _trough(0),
+      _cycles(0),
+      _periodSteps(0),
+      _swing(0),
+      _result{}
+{
+}
+
+void Autotuner::begin(Temperature setpoint, uint8_t bias)
+{
+    _status = Status::RUNNING;
+    _setpoint = toQ8_8(setpoint);
+    _high = true; // A cold chamber warms up through the first half cycle; a warm one switches at once
+    setBias(bias);
+    _steps = 0;
+    _switchStep = 0;
+    _highSteps = 0;
+    _cycleOpen = false;
+    _peak = _setpoint;
+    _trough = _setpoint;
+    _cycles = 0;
+    _periodSteps = 0;
+    _swing = 0;
+}
+
+void Autotuner::abort()
+{
+    if (_status == Status::RUNNING)
+    {
+        _status = Status::FAILED;
+    }
+}
+
+// === EXPERIMENT ===
+uint8_t Autotuner::duty(Temperature temperature)
+{
+    if (_status != Status::RUNNING)
+    {
+        return 0;
+    }
+
+    int16_t now = toQ8_8(temperature);
+    _steps++;
+    if (_steps > AUTOTUNE_TIMEOUT_STEPS || now > _setpoint + toQ8_8(AUTOTUNE_MAX_EXCURSION))
+    {
+        _status = Status::FAILED;
+        return 0;
+    }
+
+    _peak = now > _peak ? now : _peak;
+    _trough = now < _trough ? now : _trough;
+
+    if (static_cast<uint16_t>(_steps - _switchStep) > AUTOTUNE_MAX_HALF_STEPS)
+    {
+        // Stuck on one side of the setpoint: the halves measured so far no longer tell the bias.
+        setBias(static_cast<int16_t>(_bias) + (_high ? AUTOTUNE_BIAS_STEP : -AUTOTUNE_BIAS_STEP));
+        _switchStep = _steps;
+        _highSteps = 0;
+        _cycleOpen = false;
+    }
+
+    int16_t hysteresis = toQ8_8(AUTOTUNE_HYSTERESIS);
+    if (_high && now >= _setpoint + hysteresis)
+    {
+        // Only a half that started on a switch counts: the warm-up does not.
+        _highSteps = _cycleOpen ? _steps - _switchStep : 0;
+        _switchStep = _steps;
+        _high = false;
+    }
+    else if (!_high && now <= _setpoint - hysteresis)
+    {
+        uint16_t lowSteps = _steps - _switchStep;
+        _switchStep = _steps;
+        _high = true;
+        if (_highSteps > 0)
+        {
+            finishCycle(lowSteps);
+        }
+        _cycleOpen = true;
+        _peak = now;
+        _trough = now;
+        if (_status != Status::RUNNING)
+        {
+            return 0;
+        }
+    }
+
+    return _high ? _bias + AUTOTUNE_RELAY_AMPLITUDE : _bias - AUTOTUNE_RELAY_AMPLITUDE;
+}
+
+void Autotuner::finishCycle(uint16_t lowSteps)
+{
+    uint16_t periodSteps = _highSteps + lowSteps;
+
+    // A longer high half means the bias is below the holding duty: move it by the imbalance.
+    int16_t correction = static_cast<int16_t>(
+        (static_cast<int32_t>(_highSteps) - lowSteps) * AUTOTUNE_RELAY_AMPLITUDE / periodSteps);
+    setBias(static_cast<int16_t>(_bias) + correction);
+
+    _cycles++;
+    if (_cycles > AUTOTUNE_SETTLE_CYCLES)
+    {
+        _periodSteps += periodSteps;
+        _swing += static_cast<uint16_t>(_peak - _trough);
+    }
+    if (_cycles == AUTOTUNE_CYCLES)
+    {
+        finish();
+    }
+}
+
+void Autotuner::setBias(int16_t bias)
+{
+    bias = bias < AUTOTUNE_RELAY_AMPLITUDE ? AUTOTUNE_RELAY_AMPLITUDE : bias;
+    bias = bias > HEATER_MAX_DUTY - AUTOTUNE_RELAY_AMPLITUDE ? HEATER_MAX_DUTY - AUTOTUNE_RELAY_AMPLITUDE : bias;
+    _bias = static_cast<uint8_t>(bias);
+}
+
+void Autotuner::finish()
+{
+    uint32_t periodMs = _periodSteps * HEATER_CONTROL_PERIOD_MS / AUTOTUNE_MEASURE_CYCLES;
+    uint32_t amplitude = _swing / (2 * AUTOTUNE_MEASURE_CYCLES); // Q8.8 °C
+    uint32_t hysteresis = toQ8_8(AUTOTUNE_HYSTERESIS);
+    if (periodMs < 1000 || amplitude <= hysteresis)
+    {
+        _status = Status::FAILED;
+        return;
+    }
+
+    // Ku = 4 d / (pi sqrt(a^2 - e^2)), in percent per °C
+    uint32_t effective = squareRoot(amplitude * amplitude - hysteresis * hysteresis);
+    uint32_t ultimateGain = (4UL * AUTOTUNE_RELAY_AMPLITUDE * 256 * 1000 + PI_THOUSANDTHS * effective / 2) /
+                            (PI_THOUSANDTHS * effective);
+
+    // Kp = Ku / 3, Td = Tu / 3 (kd = Kp Td), Ti = Tu / 2 (ki = 256 Kp T / Ti)
+    _result.ultimatePeriodS = static_cast<uint16_t>(periodMs / 1000);
+    _result.amplitude = TemperatureMath::fromFixed(static_cast<int16_t>(amplitude));
+    _result.ultimateGain = static_cast<uint16_t>(ultimateGain);
+    _result.bias = _bias;
+    _result.clamped = false;
+    _result.proportionalGain = clampGain((ultimateGain + 1) / 3, HEATER_MAX_PROPORTIONAL_GAIN, _result.clamped);
+    _result.derivativeGain =
+        clampGain(ultimateGain * _result.ultimatePeriodS / 9, HEATER_MAX_DERIVATIVE_GAIN, _result.clamped);
+    _result.integralGain = clampGain(ultimateGain * 512 * AUTOTUNE_MEASURE_CYCLES / (3 * _periodSteps),
+                                     HEATER_MAX_INTEGRAL_GAIN, _result.clamped);
+    _status = Status::DONE;
+}
+
+// === REPORTING ===
+void Autotuner::report(Hal::SerialPort &port) const
+{
+    static const char *const STATUS_NAMES[] = {"idle", "running", "done", "failed"};
+    char amplitude[8];
+    TemperatureMath::format(amplitude, _result.amplitude);
+
+    port.println("status,cycles,period_s,amplitude_c,ultimate_gain,bias,kp,kd,ki,clamped");
+    port.print(STATUS_NAMES[static_cast<uint8_t>(_status)]);
+    port.print(",");
+    port.print(static_cast<unsigned int>(_cycles));
+    port.print(",");
+    port.print(static_cast<unsigned int>(_result.ultimatePeriodS));
+    port.print(",");
+    port.print(amplitude);
+    port.print(",");
+    port.print(static_cast<unsigned int>(_result.ultimateGain));
+    port.print(",");
+    port.print(static_cast<unsigned int>(_result.bias));
+    port.print(",");
+    port.print(_result.proportionalGain);
+    port.print(",");
+    port.print(_result.derivativeGain);
+    port.print(",");
+    port.print(_result.integralGain);
+    port.print(",");
+    port.println(_result.clamped ? 1 : 0);
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "../hal/Hal.h"
+#include "Temperature.h"
+#include "HeaterControl.h"
+
+// --- Relay experiment (durations in control periods, HEATER_CONTROL_PERIOD_MS) ---
+constexpr uint8_t AUTOTUNE_RELAY_AMPLITUDE = 25;              // Duty swing either side of the bias, percent
+constexpr uint8_t AUTOTUNE_BIAS_STEP = 5;                     // Bias change when a half cycle outlasts its bound, percent
+constexpr Temperature AUTOTUNE_HYSTERESIS = celsius(0.1);     // The relay switches this far past the setpoint
+constexpr Temperature AUTOTUNE_MAX_EXCURSION = celsius(3.0);  // Above the setpoint, the experiment is abandoned
+constexpr uint8_t AUTOTUNE_SETTLE_CYCLES = 2;                 // Cycles run before measuring, while the bias settles
+constexpr uint8_t AUTOTUNE_MEASURE_CYCLES = 3;                // Cycles averaged for the period and amplitude
+constexpr uint8_t AUTOTUNE_CYCLES = AUTOTUNE_SETTLE_CYCLES + AUTOTUNE_MEASURE_CYCLES;
+constexpr uint16_t AUTOTUNE_MAX_HALF_STEPS = 300;             // 10 minutes without crossing the setpoint
+constexpr uint16_t AUTOTUNE_TIMEOUT_STEPS = 7200;             // 4 hours
+
+static_assert(AUTOTUNE_CYCLES <= 9, "The LCD shows the cycles as one digit");
+
+/**
+ * @brief What the relay experiment measured, and the gains derived from it.
+ */
+struct AutotuneResult
+{
+    uint16_t ultimatePeriodS;  // Period of the oscillation
+    Temperature amplitude;     // Half its peak-to-peak swing
+    uint16_t ultimateGain;     // Percent of duty per °C
+    uint8_t bias;              // Duty the relay settled around, percent (about the holding duty)
+    int16_t proportionalGain;  // kp, as in ParameterStore
+    int16_t derivativeGain;    // kd
+    int16_t integralGain;      // ki
+    bool clamped;              // A gain was cut to its HEATER_MAX_* limit
+};
+
+/**
+ * @class Autotuner
+ * @brief Measures the chamber with a relay feedback experiment and derives the gains of
+ *        the PID law (HeaterControl::duty()).
+ *
+ * @details The heater is switched between two duties, the bias plus and minus
+ *          AUTOTUNE_RELAY_AMPLITUDE, as the temperature crosses the setpoint (with
+ *          AUTOTUNE_HYSTERESIS). The chamber then oscillates at its ultimate period, the
+ *          period where its lag reaches half a cycle. The bias starts from the duty that
+ *          holds the chamber when the experiment begins. After each cycle it moves
+ *          toward the holding duty, by how much longer one half lasted than the other,
+ *          so that the oscillation is symmetric. A half cycle longer than
+ *          AUTOTUNE_MAX_HALF_STEPS means the relay cannot cross the setpoint from that
+ *          bias: the bias moves AUTOTUNE_BIAS_STEP its way, and the cycle in progress
+ *          is not measured.
+ *
+ *          Everything is measured on the fly, without keeping the trace: the steps
+ *          between switches, and the highest and lowest temperature since the cycle
+ *          began. The first AUTOTUNE_SETTLE_CYCLES cycles are dropped; the next
+ *          AUTOTUNE_MEASURE_CYCLES are summed. The ultimate gain then follows from the
+ *          describing function of a relay with hysteresis:
+ *          Ku = 4 d / (pi sqrt(a^2 - e^2)), for a swing d and an amplitude a. The gains
+ *          are those of the Ziegler-Nichols "some overshoot" rule: Kp = Ku / 3,
+ *          Ti = Tu / 2, Td = Tu / 3.
+ *
+ *          The experiment is abandoned, and the heater left off, if the temperature goes
+ *          AUTOTUNE_MAX_EXCURSION above the setpoint or the cycles are not done within
+ *          AUTOTUNE_TIMEOUT_STEPS.
+ */
+class Autotuner
+{
+public:
+    enum class Status : uint8_t
+    {
+        IDLE,
+        RUNNING,
+        DONE,
+        FAILED,
+    };
+
+    Autotuner();
+
+    /**
+     * @brief Starts an experiment around the given setpoint.
+     * @param bias The duty that holds the chamber at the setpoint, as far as known,
+     *        percent. Kept AUTOTUNE_RELAY_AMPLITUDE away from 0 and HEATER_MAX_DUTY.
+     */
+    void begin(Temperature setpoint, uint8_t bias);
+
+    /**
+     * @brief Stops an experiment in progress, as failed.
+     */
+    void abort();
+
+    /**
+     * @brief One step of the experiment, run every HEATER_CONTROL_PERIOD_MS.
+     * @return The heater duty for the coming period, 0 once the experiment is over.
+     */
+    uint8_t duty(Temperature temperature);
+
+    Status status() const { return _status; }
+    bool isRunning() const { return _status == Status::RUNNING; }
+
+    /**
+     * @brief Returns the cycles completed, 0 to AUTOTUNE_CYCLES.
+     */
+    uint8_t cycles() const { return _cycles; }
+
+    /**
+     * @brief Returns the result of the last experiment, valid once status() is DONE.
+     */
+    const AutotuneResult &result() const { return _result; }
+
+    /**
+     * @brief Writes the status and the last result as CSV to the given port.
+     * @details Format: `status,cycles,period_s,amplitude_c,ultimate_gain,bias,kp,kd,ki,clamped`.
+     */
+    void report(Hal::SerialPort &port) const;
+
+private:
+    Status _status;
+    int16_t _setpoint;       // Q8.8 °C
+    bool _high;              // The relay is at the bias plus the swing
+    uint8_t _bias;           // Percent
+    uint16_t _steps;         // Since begin()
+    uint16_t _switchStep;    // When the relay last switched
+    uint16_t _highSteps;     // Length of the high half of the cycle in progress, 0 before the first
+    bool _cycleOpen;         // A switch to high started the cycle in progress (the warm-up does not count)
+    int16_t _peak;           // Since the cycle began, Q8.8 °C
+    int16_t _trough;
+    uint8_t _cycles;
+    uint32_t _periodSteps;   // Summed over the measured cycles
+    uint32_t _swing;         // Peak-to-peak, summed over the measured cycles, Q8.8 °C
+    AutotuneResult _result;
+
+    /**
+     * @brief Accounts for a full cycle, ended by the relay switching high.
+     */
+    void finishCycle(uint16_t lowSteps);
+
+    /**
+     * @brief Sets the bias, kept AUTOTUNE_RELAY_AMPLITUDE away from both ends.
+     */
+    void setBias(int16_t bias);
+
+    /**
+     * @brief Derives the result from the sums.
+     */
+    void finish();
+};
@@ -0,0 +1,36 @@
+#include "HeaterControl.h"
+#include "../controllers/HeaterDriver.h"
+#include "../storage/ParameterStore.h"
+
+// Heater control law: duty (%) = P * error + I - D * derivative, clamped to 0-100 %
+const int32_t DUTY_INTEGRAL_SCALE = 256; // The integral is kept in 1/256 percent
+const int16_t LOOKAHEAD_RESOLUTION = 16; // The error and its prediction are compared in 1/16 °C
+
+static int32_t clamp(int32_t value, int32_t max)
+{
+    return value < 0 ? 0 : (value > max ? max : value);
+}
+
+uint8_t HeaterControl::duty(Temperature error, TemperatureRate rate, int32_t &integral)
+{
+    int32_t duty = TemperatureMath::scaled(error, parameters.heaterProportionalGain)
+                 - TemperatureMath::scaled(rate, parameters.heaterDerivativeGain)
+                 + integral / DUTY_INTEGRAL_SCALE;
+
+    int32_t integralStep = TemperatureMath::scaled(error, parameters.heaterIntegralGain);
+    bool saturated = (integralStep > 0 && duty >= HEATER_MAX_DUTY) || (integralStep < 0 && duty <= 0);
+
+    // The error the current rate leaves after the look-ahead: past the setpoint, the
+    // chamber gets there without help, and learning now would only wind the integral up.
+    int32_t now = TemperatureMath::scaled(error, LOOKAHEAD_RESOLUTION);
+    int32_t ahead = now - TemperatureMath::scaled(
+        rate, static_cast<int16_t>(LOOKAHEAD_RESOLUTION * parameters.heaterIntegralLookaheadS));
+    bool closing = (now > 0 && ahead <= 0) || (now < 0 && ahead >= 0);
+    if (!saturated && !closing)
+    {
+        integral += integralStep;
+        integral = clamp(integral, HEATER_MAX_DUTY * DUTY_INTEGRAL_SCALE);
+    }
+
+    return static_cast<uint8_t>(clamp(duty, HEATER_MAX_DUTY));
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../hal/Hal.h"
+#include "Temperature.h"
+
+constexpr uint16_t HEATER_CONTROL_PERIOD_MS = 2000; // Duty update period
+
+/**
+ * @brief The control law computing the heater duty (the ctl_mode parameter).
+ */
+enum class HeaterControlMode : uint8_t
+{
+    PID,        // HeaterControl::duty()
+    PREDICTIVE, // PredictiveControl
+};
+
+constexpr HeaterControlMode HEATER_DEFAULT_CONTROL_MODE = HeaterControlMode::PREDICTIVE;
+
+// Defaults of the control law gains (see ParameterStore)
+constexpr int16_t HEATER_PROPORTIONAL_GAIN = 40;  // Percent per °C below the setpoint
+constexpr int16_t HEATER_DERIVATIVE_GAIN = 400;   // Percent per °C/s of warming (a 10 s look-ahead)
+constexpr int16_t HEATER_INTEGRAL_GAIN = 256;     // 1/256 percent per °C of error, every period
+constexpr uint16_t HEATER_INTEGRAL_LOOKAHEAD_S = 120; // Integrate only while the rate would not close the error by then
+constexpr int16_t HEATER_MAX_PROPORTIONAL_GAIN = 1000;
+constexpr int16_t HEATER_MAX_DERIVATIVE_GAIN = 10000; // Twice an autotuned reference chamber (Ku Tu / 9)
+constexpr int16_t HEATER_MAX_INTEGRAL_GAIN = 4096;
+constexpr uint16_t HEATER_MAX_INTEGRAL_LOOKAHEAD_S = 1800;
+
+/**
+ * @brief The heater control law, shared by every controller that closes a loop on a
+ *        chamber temperature.
+ */
+namespace HeaterControl
+{
+    /**
+     * @brief One control step, run every HEATER_CONTROL_PERIOD_MS.
+     * @details The duty is the distance of the estimated temperature to the setpoint
+     *          (proportional), its integral, minus the estimated rate of change, which
+     *          anticipates the heat still stored in the element. The integral learns the
+     *          holding duty unless the output is saturated in the same direction, or the
+     *          chamber is already closing the error by itself: its rate, extrapolated over
+     *          the look-ahead, would reach the setpoint. A chamber the proportional term
+     *          leaves short of the setpoint stops moving, so the integral then learns
+     *          however far off it stopped, while a warm-up does not wind it up. The gains
+     *          and the look-ahead are the live `parameters`.
+     * @param error The setpoint minus the estimated temperature.
+     * @param rate The estimated rate of change.
+     * @param integral The chamber's integral term, in 1/256 percent; updated in place.
+     *        Start it at 0.
+     * @return The duty, 0 to HEATER_MAX_DUTY percent.
+     */
+    uint8_t duty(Temperature error, TemperatureRate rate, int32_t &integral);
+}
@@ -0,0 +1,243 @@
+#include "PredictiveControl.h"
+#include "TemperatureEstimator.h"
+#include "../controllers/HeaterDriver.h"
+
+// === FIXED POINT ===
+namespace
+{
+    constexpr uint8_t Q24_SHIFT = 24;
+    constexpr int32_t Q24_ONE = 1L << Q24_SHIFT;
+    constexpr uint8_t Q8_8_SHIFT = 16; // From Q8.24
+    constexpr float CONTROL_PERIOD_S = HEATER_CONTROL_PERIOD_MS / 1000.0f;
+
+    // Every impulse entry must fit 16 bits: at most 0.0039 °C per percent and period.
+    constexpr int32_t MAX_FULL_POWER_RATE = static_cast<int32_t>(UINT16_MAX) * HEATER_MAX_DUTY;
+
+    constexpr FopdtModel DEFAULT_MODEL = {
+        static_cast<uint8_t>(ELEMENT_TIME_CONSTANT_S / CONTROL_PERIOD_S + 0.5f),
+        static_cast<uint16_t>(PREDICTIVE_DEFAULT_TIME_CONSTANT_S / CONTROL_PERIOD_S + 0.5f),
+        static_cast<int32_t>(CHAMBER_FULL_POWER_RATE_C_PER_S * CONTROL_PERIOD_S * Q24_ONE + 0.5f)};
+
+    static_assert(DEFAULT_MODEL.deadSteps >= 1 && DEFAULT_MODEL.deadSteps <= PREDICTIVE_MAX_DEAD_STEPS,
+                  "The default dead time must fit the tables");
+    static_assert(DEFAULT_MODEL.fullPowerRate < MAX_FULL_POWER_RATE, "The default rate must fit the tables");
+
+    inline int32_t multiplyQ24(int32_t value, int32_t q24)
+    {
+        return static_cast<int32_t>((static_cast<int64_t>(value) * q24) >> Q24_SHIFT);
+    }
+
+    inline int16_t toQ8_8(Temperature value)
+    {
+        return static_cast<int16_t>(TemperatureMath::toQ8_24(value) >> Q8_8_SHIFT);
+    }
+}
+
+// === CONSTRUCTOR ===
+PredictiveControl::PredictiveControl()
+    : _model{},
+      _identified(false),
+      _decay(0),
+      _gain(0),
+      _freeDecay(0),
+      _stepResponse(0),
+      _impulse{},
+      _output(0),
+      _history{},
+      _historyIndex(0),
+      _collecting(false),
+      _collectedSteps(0),
+      _startTemperature(0),
+      _window{},
+      _steepestSlope(0),
+      _steepestStep(0),
+      _steepestTemperature(0),
+      _lastSlope(0)
+{
+    setModel(DEFAULT_MODEL);
+}
+
+void PredictiveControl::reset()
+{
+    _output = 0;
+    for (uint8_t &duty : _history)
+    {
+        duty = 0;
+    }
+    _historyIndex = 0;
+    _collecting = false;
+}
+
+// === MODEL ===
+bool PredictiveControl::setModel(const FopdtModel &model)
+{
+    if (model.deadSteps < 1 || model.deadSteps > PREDICTIVE_MAX_DEAD_STEPS ||
+        model.timeConstantSteps < PREDICTIVE_MIN_TIME_CONSTANT_STEPS ||
+        model.timeConstantSteps > PREDICTIVE_MAX_TIME_CONSTANT_STEPS ||
+        model.fullPowerRate <= 0 || model.fullPowerRate >= MAX_FULL_POWER_RATE)
+    {
+        return false;
+    }
+
+    // exp(-1 / time constant), by its series: the omitted terms are below 1e-8.
+    int32_t x = Q24_ONE / model.timeConstantSteps;
+    int32_t x2 = multiplyQ24(x, x);
+    _decay = Q24_ONE - x + x2 / 2 - multiplyQ24(x2, x) / 6;
+
+    // Warming per percent and period, at ambient: the rate through one period of the lag
+    _gain = multiplyQ24(model.fullPowerRate, static_cast<int32_t>(model.timeConstantSteps) * (Q24_ONE - _decay)) /
+            HEATER_MAX_DUTY;
+
+    // Step response at the coincidence point: gain * (1 + decay + ... + decay^(P-1))
+    int32_t power = Q24_ONE;
+    _stepResponse = 0;
+    for (uint8_t i = 0; i < PREDICTIVE_COINCIDENCE_STEPS; i++)
+    {
+        _stepResponse += multiplyQ24(_gain, power);
+        power = multiplyQ24(power, _decay);
+    }
+    // Impulse response of the duties in flight, from decay^P (the newest) on
+    for (uint8_t i = 0; i < model.deadSteps; i++)
+    {
+        _impulse[i] = static_cast<uint16_t>(multiplyQ24(_gain, power));
+        power = multiplyQ24(power, _decay);
+    }
+    _freeDecay = power;
+
+    // The duties in flight keep their order; a longer dead time starts with the heater off.
+    uint8_t previous[PREDICTIVE_MAX_DEAD_STEPS];
+    uint8_t previousSteps = _model.deadSteps;
+    for (uint8_t i = 0; i < previousSteps; i++)
+    {
+        previous[i] = _history[(_historyIndex + i) % previousSteps];
+    }
+    for (uint8_t i = 0; i < model.deadSteps; i++)
+    {
+        int16_t from = static_cast<int16_t>(previousSteps) - model.deadSteps + i;
+        _history[i] = from >= 0 ? previous[from] : 0;
+    }
+    _historyIndex = 0;
+    _model = model;
+    return true;
+}
+
+// === CONTROL ===
+uint8_t PredictiveControl::duty(Temperature setpoint, Temperature temperature) const
+{
+    // Free response: the modelled rise decays, and the duties in flight arrive, oldest first.
+    int32_t free = multiplyQ24(_output, _freeDecay);
+    uint8_t steps = _model.deadSteps;
+    for (uint8_t i = 0; i < steps; i++)
+    {
+        uint8_t index = _historyIndex + i;
+        index = index >= steps ? index - steps : index;
+        free += static_cast<int32_t>(static_cast<uint32_t>(_history[index]) * _impulse[steps - 1 - i]);
+    }
+
+    // measured + (predicted - modelled now) = setpoint, solved for the duty
+    int32_t needed = TemperatureMath::toQ8_24(setpoint) - TemperatureMath::toQ8_24(temperature) + _output - free;
+    if (needed <= 0)
+    {
+        return 0;
+    }
+    int32_t percent = (needed + _stepResponse / 2) / _stepResponse;
+    return percent > HEATER_MAX_DUTY ? HEATER_MAX_DUTY : static_cast<uint8_t>(percent);
+}
+
+void PredictiveControl::update(Temperature temperature, uint8_t duty, bool identifying)
+{
+    // The oldest duty in flight reaches the air and is replaced by the new one.
+    uint8_t arriving = _history[_historyIndex];
+    _output = multiplyQ24(_output, _decay) + _gain * arriving;
+    _history[_historyIndex] = duty;
+    _historyIndex = _historyIndex + 1 >= _model.deadSteps ? 0 : _historyIndex + 1;
+
+    // === IDENTIFICATION ===
+    bool fullPower = identifying && duty >= HEATER_MAX_DUTY;
+    if (_collecting && !fullPower)
+    {
+        _collecting = false;
+        finishIdentification();
+    }
+    if (!fullPower)
+    {
+        return;
+    }
+
+    int16_t now = toQ8_8(temperature);
+    if (!_collecting)
+    {
+        _collecting = true;
+        _collectedSteps = 0;
+        _startTemperature = now;
+        _steepestSlope = 0;
+        _steepestStep = 0;
+        _steepestTemperature = now;
+        _lastSlope = 0;
+    }
+    uint8_t slot = _collectedSteps % PREDICTIVE_SLOPE_STEPS;
+    if (_collectedSteps >= PREDICTIVE_SLOPE_STEPS)
+    {
+        int16_t then = _window[slot];
+        _lastSlope = now - then;
+        if (_lastSlope > _steepestSlope)
+        {
+            _steepestSlope = _lastSlope;
+            _steepestStep = _collectedSteps - PREDICTIVE_SLOPE_STEPS / 2;
+            _steepestTemperature = static_cast<int16_t>((static_cast<int32_t>(now) + then) / 2);
+        }
+    }
+    _window[slot] = now;
+    if (_collectedSteps < UINT16_MAX)
+    {
+        _collectedSteps++;
+    }
+}
+
+void PredictiveControl::finishIdentification()
+{
+    int16_t last = _window[(_collectedSteps - 1) % PREDICTIVE_SLOPE_STEPS];
+    int32_t rise = static_cast<int32_t>(_steepestTemperature) - _startTemperature;
+    if (_collectedSteps < 2 * PREDICTIVE_SLOPE_STEPS || _steepestSlope <= 0 ||
+        last - _startTemperature < toQ8_8(PREDICTIVE_MIN_RISE))
+    {
+        return;
+    }
+
+    // The tangent at the steepest point crosses the starting temperature after the dead time.
+    int32_t tangentSteps = rise * PREDICTIVE_SLOPE_STEPS / _steepestSlope;
+    int32_t deadSteps = static_cast<int32_t>(_steepestStep) - tangentSteps;
+
+    // Past the steepest point, the losses grow with the rise: rate lost = rise / time constant.
+    FopdtModel model = _model;
+    int32_t lossRise = static_cast<int32_t>(last) - _steepestTemperature;
+    if (lossRise >= toQ8_8(PREDICTIVE_MIN_LOSS_RISE) && _lastSlope < _steepestSlope)
+    {
+        int32_t timeConstant = lossRise * PREDICTIVE_SLOPE_STEPS / (_steepestSlope - _lastSlope);
+        model.timeConstantSteps = timeConstant > UINT16_MAX ? UINT16_MAX : static_cast<uint16_t>(timeConstant);
+    }
+
+    // The steepest rate, plus what the losses already took from it there
+    model.deadSteps = deadSteps < 1 ? 0 : (deadSteps > UINT8_MAX ? UINT8_MAX : static_cast<uint8_t>(deadSteps));
+    model.fullPowerRate = (static_cast<int32_t>(_steepestSlope) << Q8_8_SHIFT) / PREDICTIVE_SLOPE_STEPS +
+                          (rise << Q8_8_SHIFT) / model.timeConstantSteps;
+    if (setModel(model))
+    {
+        _identified = true;
+    }
+}
+
+// === REPORTING ===
+void PredictiveControl::report(Hal::SerialPort &port) const
+{
+    port.println("identified,dead_time_s,time_constant_s,full_power_rate_uc_s");
+    port.print(_identified ? 1 : 0);
+    port.print(",");
+    port.print(static_cast<unsigned long>(_model.deadSteps) * HEATER_CONTROL_PERIOD_MS / 1000);
+    port.print(",");
+    port.print(static_cast<unsigned long>(_model.timeConstantSteps) * HEATER_CONTROL_PERIOD_MS / 1000);
+    port.print(",");
+    // Q8.24 °C per period to millionths of a degree per second
+    port.println(static_cast<unsigned long>((static_cast<int64_t>(_model.fullPowerRate) * 1000000 * 1000 /
+                                             HEATER_CONTROL_PERIOD_MS) >> Q24_SHIFT));
+}
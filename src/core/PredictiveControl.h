@@ -0,0 +1,132 @@
+#pragma once
+
+#include "../hal/Hal.h"
+#include "Temperature.h"
+#include "HeaterControl.h"
+
+// --- Horizon (in control periods, HEATER_CONTROL_PERIOD_MS) ---
+constexpr uint8_t PREDICTIVE_MAX_DEAD_STEPS = 40;    // Longest dead time the tables cover (80 s)
+constexpr uint8_t PREDICTIVE_COINCIDENCE_STEPS = 10; // The prediction is matched this far past the dead time
+
+// --- Identification (see PredictiveControl::update()) ---
+constexpr uint8_t PREDICTIVE_SLOPE_STEPS = 8;               // Window of the warming rate estimate
+constexpr Temperature PREDICTIVE_MIN_RISE = celsius(1.0);   // Least rise at full power for a dead time and rate
+constexpr Temperature PREDICTIVE_MIN_LOSS_RISE = celsius(2.0); // Least rise past the steepest point for a time constant
+constexpr uint16_t PREDICTIVE_MIN_TIME_CONSTANT_STEPS = 100;   // 200 s
+constexpr uint16_t PREDICTIVE_MAX_TIME_CONSTANT_STEPS = 5000;  // About 3 hours
+
+// --- Default model: the reference chamber (see TemperatureEstimator.h) ---
+constexpr uint16_t PREDICTIVE_DEFAULT_TIME_CONSTANT_S = 1333; // 2000 J/K over 1.5 W/K of losses
+
+/**
+ * @brief A first-order-plus-dead-time model of the chamber: at constant duty, the
+ *        temperature follows a first-order response with a time constant, which starts
+ *        a dead time after the duty changed.
+ */
+struct FopdtModel
+{
+    uint8_t deadSteps;          // Dead time, in control periods (1 to PREDICTIVE_MAX_DEAD_STEPS)
+    uint16_t timeConstantSteps; // Time constant, in control periods
+    int32_t fullPowerRate;      // Warming per control period at 100 % and ambient, Q8.24 °C
+};
+
+/**
+ * @class PredictiveControl
+ * @brief Predictive heater control on a first-order-plus-dead-time (FOPDT) model,
+ *        identified from the warm-up.
+ *
+ * @details Each control period the model predicts the temperature
+ *          PREDICTIVE_COINCIDENCE_STEPS past the dead time. The prediction sums the free
+ *          response (the model state decaying, plus the duties already commanded but
+ *          not yet felt) and the step response of a constant duty from now on. The duty
+ *          makes the prediction meet the setpoint. The heat still on its way, which keeps
+ *          the air warming after the relay opened, is thus counted before it arrives.
+ *
+ *          The prediction is anchored on the measured temperature: only the change the
+ *          model predicts is added to it. A wrong gain or ambient temperature then only
+ *          slows the approach, and leaves no steady-state error.
+ *
+ *          The responses are fixed-point tables (Q8.24 °C per percent of duty), rebuilt
+ *          when the model changes. A decision is then a dot product of the duty history
+ *          with the impulse response, PREDICTIVE_MAX_DEAD_STEPS multiply-adds at most,
+ *          and one division.
+ *
+ *          Identification runs while PREHEATING holds the heater at 100 %, as after
+ *          power-up (the reaction curve method). The steepest warming rate over
+ *          PREDICTIVE_SLOPE_STEPS gives the rate, and where its tangent crosses the
+ *          starting temperature gives the dead time. If the warm-up is long enough, the
+ *          rate lost since the steepest point gives the time constant. The model is
+ *          replaced only when every figure is in range; until then the defaults of the
+ *          reference chamber apply.
+ */
+class PredictiveControl
+{
+public:
+    PredictiveControl();
+
+    /**
+     * @brief Restarts from a chamber at ambient, with no duty in flight. Keeps the model.
+     */
+    void reset();
+
+    /**
+     * @brief Returns the duty that brings the predicted temperature to the setpoint.
+     * @return 0 to HEATER_MAX_DUTY percent.
+     */
+    uint8_t duty(Temperature setpoint, Temperature temperature) const;
+
+    /**
+     * @brief Records the duty applied for the period starting now and advances the model.
+     *        Call every HEATER_CONTROL_PERIOD_MS, heater off included.
+     * @param identifying True while PREHEATING: a run at 100 % from here on is
+     *        a reaction curve.
+     */
+    void update(Temperature temperature, uint8_t duty, bool identifying);
+
+    /**
+     * @brief Replaces the model and rebuilds the response tables.
+     * @return False, and nothing changes, if a figure is out of range.
+     */
+    bool setModel(const FopdtModel &model);
+
+    const FopdtModel &model() const { return _model; }
+
+    /**
+     * @brief Returns true once a warm-up replaced the default model.
+     */
+    bool isIdentified() const { return _identified; }
+
+    /**
+     * @brief Writes the model as CSV to the given port.
+     * @details Format: `identified,dead_time_s,time_constant_s,full_power_rate_uc_s`.
+     */
+    void report(Hal::SerialPort &port) const;
+
+private:
+    FopdtModel _model;
+    bool _identified;
+
+    // --- Response tables (Q8.24 °C per percent) ---
+    int32_t _decay;                                 // One period of the time constant, Q8.24
+    int32_t _gain;                                  // Warming per percent over one period
+    int32_t _freeDecay;                             // Over the dead time and the coincidence steps
+    int32_t _stepResponse;                          // Of a constant duty, at the coincidence point
+    uint16_t _impulse[PREDICTIVE_MAX_DEAD_STEPS];   // Of a duty still in flight, newest first
+
+    // --- Model state ---
+    int32_t _output;                              // Modelled rise over ambient, Q8.24 °C
+    uint8_t _history[PREDICTIVE_MAX_DEAD_STEPS];  // Duties in flight, a ring of _model.deadSteps
+    uint8_t _historyIndex;                        // Oldest duty
+
+    // --- Identification ---
+    bool _collecting;
+    uint16_t _collectedSteps;
+    int16_t _startTemperature;                    // Q8.8 °C
+    int16_t _window[PREDICTIVE_SLOPE_STEPS];       // Latest temperatures, Q8.8 °C
+    int16_t _steepestSlope;                       // Largest rise over the window
+    uint16_t _steepestStep;                       // Where (the middle of the window)
+    int16_t _steepestTemperature;                 // At what temperature
+    int16_t _lastSlope;
+
+    void finishIdentification();
+};
@@ -0,0 +1,206 @@
+#include "Scheduler.h"
+
+constexpr uint16_t SCHEDULER_MAX_IDLE_TICKS = 1000; // Re-check at least once a second
+
+Scheduler *Scheduler::_instance = nullptr;
+
+// Saturating counters: a report showing 65535 means "at least that much".
+static uint16_t saturate(uint32_t value)
+{
+    return value > UINT16_MAX ? UINT16_MAX : static_cast<uint16_t>(value);
+}
+
+// Signed distance between two tick counts, robust to the counter wrapping.
+static int32_t ticksUntil(uint32_t tick, uint32_t now)
+{
+    return static_cast<int32_t>(tick - now);
+}
+
+Scheduler::Scheduler()
+    : _tasks{},
+      _taskCount(0),
+      _tickHooks{},
+      _tickHookCount(0),
+      _ticks(0),
+      _nextRelease(0),
+      _running(SCHEDULER_NO_TASK),
+      _runningDeadline(0)
+{
+}
+
+void Scheduler::begin()
+{
+    _instance = this;
+    {
+        Hal::InterruptLock lock;
+        _ticks = 0;
+    }
+    updateNextRelease(0);
+    Hal::tickBegin(&Scheduler::onTick);
+}
+
+// === TASK TABLE ===
+TaskId Scheduler::add(const char *name, TaskFunction function, void *context,
+                      uint16_t periodMs, uint16_t phaseMs, uint16_t deadlineMs)
+{
+    if (_taskCount >= SCHEDULER_MAX_TASKS)
+    {
+        return SCHEDULER_NO_TASK;
+    }
+    Task &task = _tasks[_taskCount];
+    task.name = name;
+    task.function = function;
+    task.context = context;
+    task.period = periodMs > 0 ? periodMs / SCHEDULER_TICK_MS : 1;
+    task.deadline = deadlineMs / SCHEDULER_TICK_MS;
+    task.nextRelease = phaseMs / SCHEDULER_TICK_MS;
+    task.suspended = false;
+    task.stats = TaskStats{};
+    return _taskCount++;
+}
+
+bool Scheduler::addTickHook(TaskFunction hook, void *context)
+{
+    if (_tickHookCount >= SCHEDULER_MAX_TICK_HOOKS)
+    {
+        return false;
+    }
+    _tickHooks[_tickHookCount++] = TickHook{hook, context};
+    return true;
+}
+
+void Scheduler::suspend(TaskId id)
+{
+    _tasks[id].suspended = true;
+}
+
+void Scheduler::resume(TaskId id)
+{
+    Task &task = _tasks[id];
+    if (!task.suspended)
+    {
+        return;
+    }
+    uint32_t now = ticks();
+    task.suspended = false;
+    task.nextRelease = now;
+    _nextRelease = now;
+}
+
+void Scheduler::restart(TaskId id)
+{
+    _tasks[id].nextRelease = ticks() + _tasks[id].period;
+}
+
+uint32_t Scheduler::ticks() const
+{
+    // A 32-bit load takes four instructions on the AVR: keep the tick out of the middle.
+    Hal::InterruptLock lock;
+    return _ticks;
+}
+
+// === DISPATCH ===
+void Scheduler::dispatch()
+{
+    for (uint8_t i = 0; i < _taskCount; i++)
+    {
+        Task &task = _tasks[i];
+        uint32_t now = ticks();
+        if (task.suspended || ticksUntil(task.nextRelease, now) > 0)
+        {
+            continue;
+        }
+
+        // A release that is late by whole periods is dropped, not run in a burst.
+        uint32_t lateness = now - task.nextRelease;
+        if (lateness >= task.period)
+        {
+            uint32_t skipped = lateness / task.period;
+            task.stats.overruns = saturate(task.stats.overruns + skipped);
+            task.nextRelease += skipped * task.period;
+            lateness -= skipped * task.period;
+        }
+        uint32_t release = task.nextRelease;
+        task.nextRelease += task.period;
+
+        _runningDeadline = release + task.deadline;
+        _running = i;
+        uint32_t startUs = Hal::micros();
+        task.function(task.context);
+        uint32_t runUs = Hal::micros() - startUs;
+        _running = SCHEDULER_NO_TASK;
+
+        task.stats.runs++;
+        if (ticks() - release > task.deadline)
+        {
+            task.stats.overruns = saturate(task.stats.overruns + 1UL);
+        }
+        if (lateness > task.stats.maxLatenessTicks)
+        {
+            task.stats.maxLatenessTicks = saturate(lateness);
+        }
+        if (runUs > task.stats.maxRunUs)
+        {
+            task.stats.maxRunUs = saturate(runUs);
+        }
+    }
+    updateNextRelease(ticks());
+}
+
+void Scheduler::updateNextRelease(uint32_t now)
+{
+    uint32_t next = now + SCHEDULER_MAX_IDLE_TICKS;
+    for (uint8_t i = 0; i < _taskCount; i++)
+    {
+        const Task &task = _tasks[i];
+        if (!task.suspended && ticksUntil(task.nextRelease, next) < 0)
+        {
+            next = task.nextRelease;
+        }
+    }
+    _nextRelease = next;
+}
+
+void Scheduler::idle()
+{
+    // Checking and sleeping happen with interrupts off: a tick arriving in between
+    // cannot be lost, it wakes the CPU as soon as Hal::idle() re-enables interrupts.
+    Hal::InterruptLock lock;
+    int32_t remaining;
+    while ((remaining = ticksUntil(_nextRelease, _ticks)) > 0)
+    {
+        Hal::idle(static_cast<uint32_t>(remaining) * SCHEDULER_TICK_MS * 1000UL);
+    }
+}
+
+// === INTERRUPT CONTEXT ===
+void Scheduler::onTick()
+{
+    Scheduler &self = *_instance;
+    self._ticks++;
+    for (uint8_t i = 0; i < self._tickHookCount; i++)
+    {
+        self._tickHooks[i].function(self._tickHooks[i].context);
+    }
+}
+
+// === REPORTING ===
+void Scheduler::report(Hal::SerialPort &port) const
+{
+    port.println("task,period_ms,runs,overruns,max_lateness_ms,max_run_us");
+    for (uint8_t i = 0; i < _taskCount; i++)
+    {
+        const Task &task = _tasks[i];
+        port.print(task.name);
+        port.print(",");
+        port.print(static_cast<unsigned int>(task.period * SCHEDULER_TICK_MS));
+        port.print(",");
+        port.print(task.stats.runs);
+        port.print(",");
+        port.print(static_cast<unsigned int>(task.stats.overruns));
+        port.print(",");
+        port.print(static_cast<unsigned int>(task.stats.maxLatenessTicks * SCHEDULER_TICK_MS));
+        port.print(",");
+        port.println(static_cast<unsigned int>(task.stats.maxRunUs));
+    }
+}
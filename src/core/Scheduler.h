@@ -0,0 +1,196 @@
+#pragma once
+
+#include "../hal/Hal.h"
+
+constexpr uint8_t SCHEDULER_MAX_TASKS = 9;                         // Size of the static task table
+constexpr uint16_t SCHEDULER_TICK_MS = Hal::TICK_PERIOD_US / 1000; // One tick per Hal tick interrupt
+constexpr uint8_t SCHEDULER_NO_TASK = SCHEDULER_MAX_TASKS;         // Returned when the table is full
+constexpr uint8_t SCHEDULER_MAX_TICK_HOOKS = 2;                    // Functions run inside the tick interrupt
+
+using TaskId = uint8_t;
+
+/**
+ * @brief Timing statistics of one task, accumulated since start-up.
+ */
+struct TaskStats
+{
+    uint32_t runs;             // Completed releases
+    uint16_t overruns;         // Releases finished after their deadline or skipped entirely
+    uint16_t maxLatenessTicks; // Worst delay between release and start
+    uint16_t maxRunUs;         // Worst execution time
+};
+
+/**
+ * @class Scheduler
+ * @brief Time-triggered cooperative scheduler driven by the 1 ms Hal tick.
+ *
+ * @details Every periodic activity of the firmware is a task in a static table, with a
+ *          period, a phase (offset of its first release, so tasks with a common period
+ *          do not pile up on the same tick) and a deadline measured from the release.
+ *          The tick interrupt only counts; `dispatch()` runs from `loop()` and starts
+ *          every task whose release time has come, in table order. Tasks run to
+ *          completion and never block.
+ *
+ *          Between releases `idle()` puts the MCU to sleep: the CPU wakes on any
+ *          interrupt (tick, ADC, UART) and goes back to sleep until a release is due,
+ *          so the main loop no longer spins re-reading `millis()`.
+ *
+ *          A task finishing after its deadline counts as an overrun, as does every
+ *          release it skips because it was still late by a whole period. The task being
+ *          run and its deadline are published for tick hooks, so a supervisor can
+ *          catch a task that never completes.
+ *
+ *          Outputs whose edges must not jitter with the main loop (the heater's slow
+ *          PWM) register a tick hook instead: a short function run from the tick
+ *          interrupt itself, every tick.
+ */
+class Scheduler
+{
+public:
+    using TaskFunction = void (*)(void *context);
+
+    Scheduler();
+
+    /**
+     * @brief Starts the tick interrupt. Tasks are released from now on.
+     * @attention Only one scheduler may be active, since it owns the tick interrupt.
+     */
+    void begin();
+
+    /**
+     * @brief Adds a task to the table. Must be called before `begin()`.
+     * @param name A short label for reports (a string literal).
+     * @param function The task body.
+     * @param context Passed to `function` on every run.
+     * @param periodMs Time between two releases.
+     * @param phaseMs Time of the first release after `begin()`.
+     * @param deadlineMs Maximum time from release to completion.
+     * @return The task's id, or SCHEDULER_NO_TASK if the table is full.
+     */
+    TaskId add(const char *name, TaskFunction function, void *context,
+               uint16_t periodMs, uint16_t phaseMs, uint16_t deadlineMs);
+
+    /**
+     * @brief Adds a member function of an object as a task.
+     */
+    template <class T, void (T::*Method)()>
+    TaskId add(const char *name, T &object, uint16_t periodMs, uint16_t phaseMs, uint16_t deadlineMs)
+    {
+        return add(name, &invoke<T, Method>, &object, periodMs, phaseMs, deadlineMs);
+    }
+
+    /**
+     * @brief Adds a function to run from the tick interrupt on every tick. Must be
+     *        called before `begin()`.
+     * @details Hooks run with interrupts disabled: they must take a few microseconds
+     *          at most and never wait.
+     * @return False if all SCHEDULER_MAX_TICK_HOOKS slots are taken.
+     */
+    bool addTickHook(TaskFunction hook, void *context);
+
+    /**
+     * @brief Adds a member function of an object as a tick hook.
+     */
+    template <class T, void (T::*Method)()>
+    bool addTickHook(T &object)
+    {
+        return addTickHook(&invoke<T, Method>, &object);
+    }
+
+    /**
+     * @brief Stops releasing a task until `resume()`.
+     */
+    void suspend(TaskId id);
+
+    /**
+     * @brief Releases a suspended task on the current tick and periodically from there.
+     *        Has no effect on a task that is not suspended.
+     */
+    void resume(TaskId id);
+
+    /**
+     * @brief Moves the next release of a task one full period from now.
+     */
+    void restart(TaskId id);
+
+    /**
+     * @brief Runs every task whose release is due. Called from `loop()`.
+     */
+    void dispatch();
+
+    /**
+     * @brief Sleeps until the next release is due.
+     */
+    void idle();
+
+    /**
+     * @brief Returns the number of ticks since `begin()`.
+     */
+    uint32_t ticks() const;
+
+    /**
+     * @brief Returns the task `dispatch()` is running, or SCHEDULER_NO_TASK between tasks.
+     * @details Safe to call from interrupt context, together with `runningDeadline()`.
+     */
+    TaskId runningTask() const { return _running; }
+
+    /**
+     * @brief Returns the tick by which the running task must complete.
+     * @details Only meaningful while `runningTask()` is not SCHEDULER_NO_TASK.
+     */
+    uint32_t runningDeadline() const { return _runningDeadline; }
+
+    uint8_t taskCount() const { return _taskCount; }
+    const char *taskName(TaskId id) const { return _tasks[id].name; }
+    uint16_t taskPeriodMs(TaskId id) const { return _tasks[id].period * SCHEDULER_TICK_MS; }
+    const TaskStats &taskStats(TaskId id) const { return _tasks[id].stats; }
+
+    /**
+     * @brief Writes the task statistics as CSV lines to the given port.
+     * @details Format: `task,period_ms,runs,overruns,max_lateness_ms,max_run_us`.
+     */
+    void report(Hal::SerialPort &port) const;
+
+private:
+    struct Task
+    {
+        const char *name;
+        TaskFunction function;
+        void *context;
+        uint16_t period;      // Ticks
+        uint16_t deadline;    // Ticks after the release
+        uint32_t nextRelease; // Tick of the next release
+        bool suspended;
+        TaskStats stats;
+    };
+
+    struct TickHook
+    {
+        TaskFunction function;
+        void *context;
+    };
+
+    static Scheduler *_instance; // The scheduler served by the tick interrupt
+
+    Task _tasks[SCHEDULER_MAX_TASKS];
+    uint8_t _taskCount;
+    TickHook _tickHooks[SCHEDULER_MAX_TICK_HOOKS];
+    uint8_t _tickHookCount;
+    volatile uint32_t _ticks; // Incremented by the tick interrupt
+    uint32_t _nextRelease;    // Earliest release over the tasks that are not suspended
+    volatile TaskId _running;           // Task being run by dispatch(), read by tick hooks
+    volatile uint32_t _runningDeadline; // Written before _running, so a hook never sees it half-updated
+
+    template <class T, void (T::*Method)()>
+    static void invoke(void *object)
+    {
+        (static_cast<T *>(object)->*Method)();
+    }
+
+    /**
+     * @brief The body of the tick interrupt.
+     */
+    static void onTick();
+
+    void updateNextRelease(uint32_t now);
+};
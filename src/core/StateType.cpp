@@ -1,15 +1,65 @@
 #include "StateType.h"
-#include <Arduino.h>
+#include "../storage/ParameterStore.h"
 
+using States::Action;
+using States::Guard;
+using States::Type;
 
-const String States::toString(States::Type state)
+// Outputs of every state, as driven by SystemState on each FSM pass
+const States::Descriptor States::DESCRIPTORS[States::COUNT] PROGMEM = {
+    {"STANDBY", OUTPUT_STATUS_SCREEN, SirenPattern::GAS_WARNING, Action::NONE, Action::NONE},
+    {"PREHEATING", OUTPUT_RED_LED | OUTPUT_HEATER_CONTROL | OUTPUT_STATUS_SCREEN, SirenPattern::GAS_WARNING,
+     Action::NONE, Action::NONE},
+    {"MAINTAINING", OUTPUT_GREEN_LED | OUTPUT_HEATER_CONTROL | OUTPUT_STATUS_SCREEN, SirenPattern::GAS_WARNING,
+     Action::NONE, Action::NONE},
+    {"EMERGENCY STOP", OUTPUT_RED_LED | OUTPUT_SIREN, SirenPattern::HARDWARE_STOP,
+     Action::SHOW_EMERGENCY_SCREEN, Action::RESTORE_STATUS_SCREEN},
+    {"TUNE", OUTPUT_RED_LED | OUTPUT_GREEN_LED | OUTPUT_HEATER_CONTROL | OUTPUT_STATUS_SCREEN | OUTPUT_TUNING_PROGRESS,
+     SirenPattern::GAS_WARNING, Action::START_AUTOTUNE, Action::STOP_AUTOTUNE},
+};
+
+const States::Descriptor States::GAS_WARNING PROGMEM =
+    {"GAS WARNING!", OUTPUT_RED_LED | OUTPUT_SIREN | OUTPUT_STATUS_SCREEN, SirenPattern::GAS_WARNING,
+     Action::NONE, Action::NONE};
+
+const States::Descriptor States::GAS_WARNING_ACKNOWLEDGED PROGMEM =
+    {"GAS ACK", OUTPUT_RED_LED | OUTPUT_STATUS_SCREEN, SirenPattern::GAS_WARNING, Action::NONE, Action::NONE};
+
+const char States::EMERGENCY_MESSAGE[] PROGMEM = "HW STOP ACTIVATED";
+
+// EMERGENCY_STOP is entered from the button interrupt, and AUTOTUNE on request, never
+// through this table; AUTOTUNE is left once the experiment is over, and EMERGENCY_STOP
+// once acknowledged (SystemState).
+const States::Transition States::TRANSITIONS[States::TRANSITION_COUNT] PROGMEM = {
+    {Type::STANDBY, Guard::BELOW_SETPOINT, Type::PREHEATING},
+    {Type::PREHEATING, Guard::AT_SETPOINT, Type::MAINTAINING},
+    {Type::MAINTAINING, Guard::BELOW_HYSTERESIS_BAND, Type::PREHEATING},
+};
+
+bool States::guardHolds(Guard guard, Temperature temperature, Temperature setpoint)
+{
+    switch (guard)
+    {
+    case Guard::BELOW_SETPOINT:
+        return temperature < setpoint;
+    case Guard::AT_SETPOINT:
+        return temperature >= setpoint;
+    case Guard::BELOW_HYSTERESIS_BAND:
+        return temperature < setpoint - parameters.temperatureHysteresis;
+    }
+    return false;
+}
+
+Type States::nextState(Type state, Temperature temperature, Temperature setpoint)
 {
-    switch (state)
+    for (uint8_t i = 0; i < TRANSITION_COUNT; i++)
     {
-        case States::Type::STANDBY:         return "STANDBY";
-        case States::Type::PREHEATING:      return "PREHEATING";
-        case States::Type::MAINTAINING:     return "MAINTAINING";
-        case States::Type::EMERGENCY_STOP:  return "EMERGENCY STOP";
-        default:                            return "UNKNOWN";
+        const Transition &transition = TRANSITIONS[i];
+        if (static_cast<Type>(pgm_read_byte(&transition.from)) == state &&
+            guardHolds(static_cast<Guard>(pgm_read_byte(&transition.guard)), temperature, setpoint))
+        {
+            return static_cast<Type>(pgm_read_byte(&transition.to));
+        }
     }
-}
\ No newline at end of file
+    return state;
+}
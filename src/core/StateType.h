@@ -1,10 +1,19 @@
 #pragma once
 
-#include <Arduino.h>
+#include "../hal/Hal.h"
+#include "../controllers/Siren.h"
+#include "Temperature.h"
 
 /**
  * @file StateType.h
- * @brief Defines the system's operational states and related utilities within a dedicated namespace.
+ * @brief Defines the system's operational states and their flash-resident descriptor tables.
+ *
+ * @details Everything the FSM knows about a state lives in two constexpr tables in
+ *          PROGMEM: a descriptor per state (LCD label, actuator outputs, siren pattern,
+ *          entry and exit actions) and the list of guarded transitions. `SystemState`
+ *          reads them field by field with `pgm_read_byte()`, and refers to labels by
+ *          their flash address, so comparing two states or two labels is an integer
+ *          compare and the FSM never touches the heap.
  */
 namespace States
 {
@@ -14,9 +23,10 @@ namespace States
      * @brief Represents the discrete operational states of the Finite State Machine (FSM).
      *
      * Using a strongly-typed 'enum class' prevents name collisions and implicit conversions
-     * to integers, thereby increasing type safety and code robustness.
+     * to integers, thereby increasing type safety and code robustness. The values index
+     * the descriptor table.
      */
-    enum class Type
+    enum class Type : uint8_t
     {
         /**
          * @brief The idle state. The system is powered on but is not performing any active control.
@@ -39,17 +49,128 @@ namespace States
         MAINTAINING,
 
         /**
-         * @brief The emergency stop state. This is a terminal state triggered by an external
-         * interrupt (the emergency button). In this state, all critical actuators are immediately
-         * deactivated, and the system remains locked until a manual reset.
+         * @brief The emergency stop state, triggered by an external interrupt (the emergency
+         * button). In this state, all critical actuators are immediately deactivated, and the
+         * system remains locked until the operator holds the acknowledge button
+         * (ButtonEvent::LONG_PRESS), which returns it to STANDBY.
          */
-        EMERGENCY_STOP
+        EMERGENCY_STOP,
+
+        /**
+         * @brief The auto-tuning state. Entered on request only (SystemState::requestAutotune()),
+         * it runs the relay experiment of `Autotuner` around the setpoint, then returns to STANDBY.
+         */
+        AUTOTUNE
+    };
+
+    constexpr uint8_t COUNT = 5;
+    constexpr uint8_t LABEL_CAPACITY = 16; // Longest label plus its terminator
+    constexpr Temperature TEMPERATURE_HYSTERESIS = celsius(0.5); // Default width of Guard::BELOW_HYSTERESIS_BAND (hyst_c10)
+
+    // --- Actuator outputs of a state (Descriptor::outputs) ---
+    constexpr uint8_t OUTPUT_GREEN_LED = 0x01;
+    constexpr uint8_t OUTPUT_RED_LED = 0x02;
+    constexpr uint8_t OUTPUT_HEATER_CONTROL = 0x04; // The duty follows the control law; otherwise the heater is off
+    constexpr uint8_t OUTPUT_SIREN = 0x08;          // Plays Descriptor::sirenPattern
+    constexpr uint8_t OUTPUT_STATUS_SCREEN = 0x10;  // The LCD shows the label with the readings
+    constexpr uint8_t OUTPUT_TUNING_PROGRESS = 0x20; // The status screen adds the autotune cycles after the label
+
+    /**
+     * @enum Action
+     * @brief One-shot work done by `SystemState` when a state is entered or left.
+     */
+    enum class Action : uint8_t
+    {
+        NONE,
+        SHOW_EMERGENCY_SCREEN, // Replace the status screen with the emergency message
+        START_AUTOTUNE,        // Start the relay experiment around the current setpoint
+        STOP_AUTOTUNE,         // Abort the experiment if it is still running
+        RESTORE_STATUS_SCREEN, // Redraw the status screen over the emergency message
+    };
+
+    /**
+     * @enum Guard
+     * @brief The condition of a transition, evaluated by `nextState()` on the estimated
+     *        temperature and the setpoint.
+     */
+    enum class Guard : uint8_t
+    {
+        BELOW_SETPOINT,          // temperature < setpoint
+        AT_SETPOINT,             // temperature >= setpoint
+        BELOW_HYSTERESIS_BAND,   // temperature < setpoint - hysteresis
+    };
+
+    /**
+     * @brief What the FSM does while in a state.
+     */
+    struct Descriptor
+    {
+        char label[LABEL_CAPACITY]; // Shown on the LCD
+        uint8_t outputs;            // OUTPUT_* bits
+        SirenPattern sirenPattern;  // With OUTPUT_SIREN
+        Action onEnter;
+        Action onExit;
+    };
+
+    /**
+     * @brief A transition, taken on the first FSM pass where its guard holds.
+     */
+    struct Transition
+    {
+        Type from;
+        Guard guard;
+        Type to;
     };
 
     /**
-     * @brief Converts a States::Type enum value to its string representation.
-     * @param state The state to convert.
-     * @return A const String pointing to the string literal in read-only memory.
+     * @brief The descriptors, indexed by Type (PROGMEM).
+     */
+    extern const Descriptor DESCRIPTORS[COUNT] PROGMEM;
+
+    /**
+     * @brief The gas warning overrides the outputs and the label of any non-terminal
+     *        state without leaving it (PROGMEM).
+     */
+    extern const Descriptor GAS_WARNING PROGMEM;
+
+    /**
+     * @brief The gas warning once acknowledged with the button: the siren is silenced
+     *        until the warning ends (PROGMEM).
+     */
+    extern const Descriptor GAS_WARNING_ACKNOWLEDGED PROGMEM;
+
+    /**
+     * @brief The second line of the screen shown by Action::SHOW_EMERGENCY_SCREEN (PROGMEM).
+     */
+    extern const char EMERGENCY_MESSAGE[] PROGMEM;
+
+    constexpr uint8_t TRANSITION_COUNT = 3;
+
+    /**
+     * @brief The transition table, in priority order (PROGMEM).
+     */
+    extern const Transition TRANSITIONS[TRANSITION_COUNT] PROGMEM;
+
+    /**
+     * @brief Returns the descriptor of a state, in flash.
+     */
+    inline const Descriptor *descriptor(Type state) { return &DESCRIPTORS[static_cast<uint8_t>(state)]; }
+
+    /**
+     * @brief Returns the label of a state, in flash.
+     * @details The address identifies the label: two labels are equal if their
+     *          addresses are.
+     */
+    inline const char *label(Type state) { return descriptor(state)->label; }
+
+    /**
+     * @brief Returns true if a guard holds for the given readings.
+     */
+    bool guardHolds(Guard guard, Temperature temperature, Temperature setpoint);
+
+    /**
+     * @brief Returns the target of the first transition out of `state` whose guard
+     *        holds, or `state` itself if none does.
      */
-    const String toString(Type state);
-}
\ No newline at end of file
+    Type nextState(Type state, Temperature temperature, Temperature setpoint);
+}
@@ -0,0 +1,171 @@
+#include "Supervisor.h"
+#include "../controllers/ActuatorController.h"
+
+#include <stddef.h>
+
+constexpr uint8_t SUPERVISOR_CHECK_SEED = 0xA5;
+
+Supervisor *Supervisor::_instance = nullptr;
+
+// Left alone by the C runtime, so the restart cause outlives the reset. Random after a
+// power-up: the checksum tells.
+static SupervisorRecord persisted HAL_NOINIT;
+
+static uint8_t checksum(const SupervisorRecord &record)
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&record);
+    uint8_t sum = SUPERVISOR_CHECK_SEED;
+    for (uint8_t i = 0; i < offsetof(SupervisorRecord, check); i++)
+    {
+        sum = static_cast<uint8_t>((sum << 1) | (sum >> 7)) ^ bytes[i];
+    }
+    return sum;
+}
+
+static void seal(SupervisorRecord &record)
+{
+    record.check = checksum(record);
+}
+
+Supervisor::Supervisor(Scheduler &scheduler, ActuatorController &actuators)
+    : _scheduler(scheduler),
+      _actuators(actuators),
+      _previous{},
+      _hasPrevious(false)
+{
+}
+
+void Supervisor::registerTasks(Scheduler &scheduler)
+{
+    scheduler.addTickHook<Supervisor, &Supervisor::onTick>(*this);
+}
+
+void Supervisor::begin()
+{
+    _instance = this;
+    _hasPrevious = loadPersisted(_previous);
+
+    SupervisorRecord fresh{};
+    fresh.magic = SUPERVISOR_RECORD_MAGIC;
+    fresh.cause = RestartCause::NONE;
+    fresh.task = SCHEDULER_NO_TASK;
+    fresh.lastOverrunTask = SCHEDULER_NO_TASK;
+    fresh.restarts = _hasPrevious ? _previous.restarts : 0;
+    seal(fresh);
+    {
+        Hal::InterruptLock lock;
+        persisted = fresh;
+    }
+    Hal::watchdogBegin(&Supervisor::onWatchdog);
+}
+
+bool Supervisor::loadPersisted(SupervisorRecord &record)
+{
+    {
+        Hal::InterruptLock lock;
+        record = persisted;
+    }
+    return record.magic == SUPERVISOR_RECORD_MAGIC && record.check == checksum(record);
+}
+
+// === REPORTING ===
+const char *Supervisor::causeName(RestartCause cause)
+{
+    switch (cause)
+    {
+    case RestartCause::NONE:
+        return "none";
+    case RestartCause::DEADLINE:
+        return "deadline";
+    case RestartCause::WATCHDOG:
+        return "watchdog";
+    }
+    return "?";
+}
+
+void Supervisor::report(Hal::SerialPort &port) const
+{
+    port.println("run,cause,task,overrun_ms,uptime_ms,last_overrun_task,last_overrun_ms,restarts");
+    if (_hasPrevious)
+    {
+        printRecord(port, "previous", _previous);
+    }
+    SupervisorRecord current;
+    loadPersisted(current);
+    printRecord(port, "current", current);
+}
+
+void Supervisor::printRecord(Hal::SerialPort &port, const char *run, const SupervisorRecord &record) const
+{
+    // Task ids are table indexes, the same from one run to the next
+    auto taskName = [this](TaskId id) { return id < _scheduler.taskCount() ? _scheduler.taskName(id) : "-"; };
+    port.print(run);
+    port.print(",");
+    port.print(causeName(record.cause));
+    port.print(",");
+    port.print(taskName(record.task));
+    port.print(",");
+    port.print(static_cast<unsigned int>(record.overrunMs));
+    port.print(",");
+    port.print(static_cast<unsigned long>(record.uptimeMs));
+    port.print(",");
+    port.print(taskName(record.lastOverrunTask));
+    port.print(",");
+    port.print(static_cast<unsigned int>(record.lastOverrunMs));
+    port.print(",");
+    port.println(static_cast<unsigned int>(record.restarts));
+}
+
+// === INTERRUPT CONTEXT ===
+uint16_t Supervisor::runningOverrunMs() const
+{
+    int32_t late = static_cast<int32_t>(_scheduler.ticks() - _scheduler.runningDeadline());
+    if (late <= 0)
+    {
+        return 0;
+    }
+    uint32_t ms = static_cast<uint32_t>(late) * SCHEDULER_TICK_MS;
+    return ms > UINT16_MAX ? UINT16_MAX : static_cast<uint16_t>(ms);
+}
+
+void Supervisor::onTick()
+{
+    TaskId task = _scheduler.runningTask();
+    if (task == SCHEDULER_NO_TASK)
+    {
+        return;
+    }
+    uint16_t overrunMs = runningOverrunMs();
+    if (overrunMs == 0)
+    {
+        return;
+    }
+    persisted.lastOverrunTask = task;
+    persisted.lastOverrunMs = overrunMs;
+    seal(persisted);
+    if (overrunMs >= SUPERVISOR_HANG_MS)
+    {
+        restart(RestartCause::DEADLINE, task, overrunMs);
+    }
+}
+
+void Supervisor::onWatchdog()
+{
+    Supervisor &self = *_instance;
+    TaskId task = self._scheduler.runningTask();
+    self.restart(RestartCause::WATCHDOG, task, task != SCHEDULER_NO_TASK ? self.runningOverrunMs() : 0);
+}
+
+void Supervisor::restart(RestartCause cause, TaskId task, uint16_t overrunMs)
+{
+    // The heater first: whatever hung may have left it on.
+    _actuators.forceHeaterOff();
+
+    persisted.cause = cause;
+    persisted.task = task;
+    persisted.overrunMs = overrunMs;
+    persisted.uptimeMs = Hal::millis();
+    persisted.restarts = persisted.restarts < UINT16_MAX ? persisted.restarts + 1 : UINT16_MAX;
+    seal(persisted);
+    Hal::watchdogExpire();
+}
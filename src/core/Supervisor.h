@@ -0,0 +1,128 @@
+#pragma once
+
+#include "../hal/Hal.h"
+#include "Scheduler.h"
+
+class ActuatorController;
+
+constexpr uint16_t SUPERVISOR_HANG_MS = 100;        // A task this far past its deadline is hung
+constexpr uint16_t SUPERVISOR_RECORD_MAGIC = 0x5356; // "SV": the record was written by this firmware
+
+/**
+ * @brief Why the supervisor restarted the board.
+ */
+enum class RestartCause : uint8_t
+{
+    NONE,     // Power-up or reset button
+    DEADLINE, // A task ran SUPERVISOR_HANG_MS past its deadline
+    WATCHDOG, // loop() stopped feeding the hardware watchdog
+};
+
+/**
+ * @brief What the supervisor knows of a run, kept in RAM that survives the reset.
+ */
+struct SupervisorRecord
+{
+    uint16_t magic;         // SUPERVISOR_RECORD_MAGIC
+    RestartCause cause;     // Why the run ended
+    TaskId task;            // The task running then, SCHEDULER_NO_TASK if none
+    uint16_t overrunMs;     // How far past its deadline it was
+    uint32_t uptimeMs;      // millis() at the restart
+    TaskId lastOverrunTask; // Latest task seen past its deadline, SCHEDULER_NO_TASK if none
+    uint16_t lastOverrunMs; // How far past its deadline it got
+    uint16_t restarts;      // Restarts forced since the last power-up
+    uint8_t check;          // Checksum of the fields above
+};
+
+/**
+ * @class Supervisor
+ * @brief Bounds how long the control loop may stall before the heater is cut and the
+ *        board restarts.
+ *
+ * @details Two monitors, both ending the same way: heater off, cause recorded, reset.
+ *
+ *          - A tick hook watches the task `Scheduler::dispatch()` is running. Every
+ *            tick past its deadline is recorded as the latest overrun, and a task still
+ *            running SUPERVISOR_HANG_MS past its deadline (a `Wire` transfer waiting on a
+ *            stuck bus, say) is declared hung.
+ *          - The hardware watchdog catches the rest: `loop()` feeds it after every
+ *            dispatch, at least every 50 ms with the serial task, and
+ *            Hal::WATCHDOG_TIMEOUT_MS without a feed raises its interrupt. If interrupts
+ *            are off for good, the reset comes one period later and releases the heater
+ *            pin by itself.
+ *
+ *          The record lives in `.noinit` RAM, checked by a magic number and a checksum,
+ *          so the next run can report why the previous one ended.
+ */
+class Supervisor
+{
+public:
+    Supervisor(Scheduler &scheduler, ActuatorController &actuators);
+
+    /**
+     * @brief Hooks the deadline monitor onto the scheduler tick. Must be called before
+     *        the scheduler's `begin()`.
+     */
+    void registerTasks(Scheduler &scheduler);
+
+    /**
+     * @brief Picks up the record of the previous run and starts the watchdog. Called
+     *        last in `setup()`.
+     */
+    void begin();
+
+    /**
+     * @brief Feeds the watchdog. Called from `loop()` after every dispatch.
+     */
+    void pet() { Hal::watchdogReset(); }
+
+    /**
+     * @brief The deadline monitor. Interrupt context, every tick.
+     */
+    void onTick();
+
+    /**
+     * @brief Returns true if the previous run left a valid record, copied to `previous()`.
+     */
+    bool hasPrevious() const { return _hasPrevious; }
+    const SupervisorRecord &previous() const { return _previous; }
+
+    /**
+     * @brief Copies the persisted record, as the next start-up would read it.
+     * @return False if it is not valid (after a power-up).
+     */
+    static bool loadPersisted(SupervisorRecord &record);
+
+    /**
+     * @brief Writes the previous and the current run's records as CSV to the given port.
+     * @details Format: `run,cause,task,overrun_ms,uptime_ms,last_overrun_task,last_overrun_ms,restarts`.
+     */
+    void report(Hal::SerialPort &port) const;
+
+    static const char *causeName(RestartCause cause);
+
+private:
+    static Supervisor *_instance; // The supervisor served by the watchdog interrupt
+
+    Scheduler &_scheduler;
+    ActuatorController &_actuators;
+    SupervisorRecord _previous;
+    bool _hasPrevious;
+
+    /**
+     * @brief Cuts the heater, records the cause and resets the board. Interrupt context.
+     */
+    void restart(RestartCause cause, TaskId task, uint16_t overrunMs);
+
+    /**
+     * @brief Returns how far the running task is past its deadline, 0 if it is not.
+     */
+    uint16_t runningOverrunMs() const;
+
+    /**
+     * @brief The body of the watchdog interrupt.
+     */
+    static void onWatchdog();
+
+    void printRecord(Hal::SerialPort &port, const char *run, const SupervisorRecord &record) const;
+};
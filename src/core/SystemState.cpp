@@ -1,220 +1,425 @@
 #include "SystemState.h"
+#include "../diagnostics/LoopProfiler.h"
+#include "../diagnostics/LatencyProbe.h"
+#include "../storage/ParameterStore.h"
 
-// === CONSTANTS ===
-const int LOW_EMERGENCY_GAS_THRESHOLD = 400;
-const int HIGH_EMERGENCY_GAS_THRESHOLD = 700;
-const float TEMPERATURE_HYSTERESIS = 0.5;
-const float PREDICTIVE_DERIVATIVE_THRESHOLD = -0.05;
-const unsigned long HEATING_PULSE_DURATION_MS = 2000;
-const float DERIVATIVE_CALCULATION_INTERVAL_S = 2.0;
+// === TASKS (period, phase, deadline in ms) ===
+const uint16_t FSM_TASK_PERIOD_MS = 10;
+const uint16_t FSM_TASK_PHASE_MS = 2;
+const uint16_t FSM_TASK_DEADLINE_MS = 5;
+const uint16_t ESTIMATOR_TASK_PHASE_MS = 5;
+const uint16_t ESTIMATOR_TASK_DEADLINE_MS = 10;
+const uint16_t HEATER_TASK_PHASE_MS = 7;
+const uint16_t HEATER_TASK_DEADLINE_MS = 10;
+
+const uint8_t SECONDS_PER_MINUTE = 60; // The heater screen shows the rate per minute
+
+// The autotune bias starts from the mean duty that held the chamber, or mid-range before it
+// was ever maintaining: the duty of a warm-up says nothing of the holding duty.
+const uint16_t HOLDING_DUTY_SCALE = 16;
+const uint16_t UNKNOWN_HOLDING_DUTY = HEATER_MAX_DUTY / 2 * HOLDING_DUTY_SCALE;
 
 // === CONSTRUCTOR ===
-SystemState::SystemState(SensorManager &sm, ActuatorController &ac, DisplayManager &dm)
+SystemState::SystemState(SensorManager &sm, ActuatorController &ac, DisplayManager &dm, DebouncedButton &button,
+                         uint8_t emergencyStopPin)
     : sensorManager(sm),
       actuatorController(ac),
       displayManager(dm),
+      acknowledgeButton(button),
+      _emergencyStopPin(emergencyStopPin),
       _currentState(States::Type::STANDBY),
+      _enteredState(States::Type::STANDBY),
       _stateBeforeEmergency(States::Type::STANDBY),
-      _sirenShouldBeActive(false),
-      _hwEmergencyMessageDisplayed(false)
+      _wasInGasEmergency(false),
+      _gasTripPending(false),
+      _gasWarningMs(0),
+      _gasTrip{},
+      _gasAcknowledged(false),
+      _screen(Screen::STATUS),
+      _dutyIntegral(0),
+      _holdingDuty(UNKNOWN_HOLDING_DUTY),
+      _autotuneRequested(false),
+      _onAutotuned(nullptr)
 {
-    // The acknowledgeButton has been removed from the initializer list.
 }
 
 // === BEGIN ===
 void SystemState::begin()
 {
     _currentState = States::Type::STANDBY;
+    _enteredState = States::Type::STANDBY;
     _stateBeforeEmergency = States::Type::STANDBY;
-    _lastUpdateTime = millis();
-    _lastTemperature = sensorManager.getTemperature();
-    _sirenShouldBeActive = false;
-    _hwEmergencyMessageDisplayed = false; 
+    _wasInGasEmergency = false;
+    _gasTripPending = false;
+    _gasAcknowledged = false;
+    _screen = Screen::STATUS;
+    _dutyIntegral = 0;
+    _holdingDuty = UNKNOWN_HOLDING_DUTY;
+    _autotuneRequested = false;
+    _predictive.reset();
+    _estimator.reset(sensorManager.getTemperature());
+}
+
+void SystemState::registerTasks(Scheduler &scheduler)
+{
+    scheduler.add<SystemState, &SystemState::update>(
+        "fsm", *this, FSM_TASK_PERIOD_MS, FSM_TASK_PHASE_MS, FSM_TASK_DEADLINE_MS);
+    scheduler.add<SystemState, &SystemState::updateEstimate>(
+        "estimate", *this, ESTIMATOR_PERIOD_MS, ESTIMATOR_TASK_PHASE_MS, ESTIMATOR_TASK_DEADLINE_MS);
+    scheduler.add<SystemState, &SystemState::updateHeaterDuty>(
+        "heater", *this, HEATER_CONTROL_PERIOD_MS, HEATER_TASK_PHASE_MS, HEATER_TASK_DEADLINE_MS);
 }
 
 // === HARDWARE EMERGENCY TRIGGER (ISR-SAFE) ===
 void SystemState::triggerEmergencyStop()
 {
+    // The outputs are cut here, not on the next FSM pass: the LCD may be mid-redraw.
+    LATENCY_INPUT_EDGE();
+    actuatorController.latchEmergencyOutputs();
+    LATENCY_OUTPUT_EDGE();
     _currentState = States::Type::EMERGENCY_STOP;
 }
 
+// === GAS TRIP (ISR-SAFE) ===
+void SystemState::triggerGasTrip()
+{
+    // Called from the ADC interrupt: the heater goes first, everything else waits for the FSM.
+    unsigned long trippedUs = Hal::micros();
+    actuatorController.forceHeaterOff();
+    uint16_t heaterOffUs = static_cast<uint16_t>(Hal::micros() - trippedUs);
+
+    Hal::InterruptLock lock;
+    _gasTrip.trips++;
+    _gasTrip.lastTripUs = trippedUs;
+    _gasTrip.heaterOffUs = heaterOffUs;
+    _gasTrip.maxHeaterOffUs = heaterOffUs > _gasTrip.maxHeaterOffUs ? heaterOffUs : _gasTrip.maxHeaterOffUs;
+    _gasTripPending = true;
+}
+
+GasTripStats SystemState::getGasTripStats() const
+{
+    Hal::InterruptLock lock;
+    return _gasTrip;
+}
+
+void SystemState::reportGasTrip(Hal::SerialPort &port) const
+{
+    GasTripStats stats = getGasTripStats();
+    port.println("trips,heater_off_us,max_heater_off_us,response_us,max_response_us");
+    port.print(static_cast<unsigned int>(stats.trips));
+    port.print(",");
+    port.print(static_cast<unsigned int>(stats.heaterOffUs));
+    port.print(",");
+    port.print(static_cast<unsigned int>(stats.maxHeaterOffUs));
+    port.print(",");
+    port.print(stats.responseUs);
+    port.print(",");
+    port.println(stats.maxResponseUs);
+}
+
 // === UPDATE (THE CORE LOGIC LOOP) ===
 void SystemState::update()
 {
-    // 1. HANDLE UNRECOVERABLE LOCK STATE (HIGHEST PRIORITY)
+    PROFILE_PHASE(FSM);
+    runStateMachine();
+
+    // 4. FINAL ACTUATOR UPDATE: the LEDs change once per pass, whatever the path taken
+    actuatorController.commitOutputs();
+}
+
+void SystemState::runStateMachine()
+{
+    // 1. HANDLE THE EMERGENCY STOP LOCK (HIGHEST PRIORITY)
+    // The interrupt only sets the state: the outputs are forced here, then the entry
+    // action runs once. Only the acknowledge button's long press leaves it.
+    if (_currentState == States::Type::EMERGENCY_STOP)
+    {
+        _autotuneRequested = false;
+        applyOutputs(States::descriptor(States::Type::EMERGENCY_STOP));
+        if (_enteredState != States::Type::EMERGENCY_STOP)
+        {
+            changeState(States::Type::EMERGENCY_STOP);
+            // A press made before the stop acknowledges nothing.
+            acknowledgeButton.clear();
+            return;
+        }
+    }
+    handleButton();
     if (_currentState == States::Type::EMERGENCY_STOP)
     {
-        handleEmergencyStop();
         return; // Halts all further execution.
     }
 
-    // The user input check for the acknowledge button has been removed.
-
     // 2. CHECK FOR GAS EMERGENCY (SECOND PRIORITY)
+    // The heater was already cut by triggerGasTrip() if the sampler's trip fired.
     _gasValue = sensorManager.getGasValue();
-    bool isGasEmergency = (_gasValue >= HIGH_EMERGENCY_GAS_THRESHOLD);
-
-    static bool wasInEmergency = false;
+    bool tripped = _gasTripPending;
+    if (tripped)
+    {
+        _gasTripPending = false;
+        _gasWarningMs = Hal::millis();
+    }
+    bool isGasEmergency = tripped || checkGasEmergency();
 
     if (isGasEmergency)
     {
-        if (!wasInEmergency)
+        if (!_wasInGasEmergency)
         {
             _stateBeforeEmergency = _currentState;
-            wasInEmergency = true;
+            _wasInGasEmergency = true;
+            _gasAcknowledged = false;
+            _screen = Screen::STATUS;
+            // The heater is off from now on: the oscillation being measured is lost.
+            _autotuner.abort();
         }
 
-        // Override normal operation for the emergency.
-        actuatorController.setStatusHeater(false);
-        actuatorController.setStatusGreenLED(false);
-        actuatorController.setStatusRedLED(true);
-
-        // Siren is activated if the gas level is high. It will remain active
-        // until the gas level drops.
-        if (_gasValue >= HIGH_EMERGENCY_GAS_THRESHOLD)
+        // Override normal operation for the emergency, without leaving the state.
+        // The siren remains active until the gas level drops, or the button silences it.
+        applyOutputs(_gasAcknowledged ? &States::GAS_WARNING_ACKNOWLEDGED : &States::GAS_WARNING);
+        if (tripped)
         {
-            _sirenShouldBeActive = true;
+            uint32_t respondedUs = Hal::micros();
+            Hal::InterruptLock lock;
+            _gasTrip.responseUs = respondedUs - _gasTrip.lastTripUs;
+            _gasTrip.maxResponseUs =
+                _gasTrip.responseUs > _gasTrip.maxResponseUs ? _gasTrip.responseUs : _gasTrip.maxResponseUs;
         }
+        return;
+    }
 
-        updateDisplay("GAS WARNING!", sensorManager.getTemperature(), sensorManager.getSetpoint(), _gasValue);
+    // 3. NORMAL OPERATING LOGIC (THIRD PRIORITY)
+    if (_wasInGasEmergency)
+    {
+        _currentState = _stateBeforeEmergency;
+        _wasInGasEmergency = false;
+        _gasAcknowledged = false;
+        // The heater follows its duty again, and the next crossing trips again.
+        actuatorController.releaseHeater();
+        sensorManager.rearmGasTrip();
     }
-    else
+    if (_autotuneRequested)
     {
-        // 3. NORMAL OPERATING LOGIC (THIRD PRIORITY)
-        if (wasInEmergency)
+        _autotuneRequested = false;
+        changeState(_currentState == States::Type::AUTOTUNE ? States::Type::STANDBY : States::Type::AUTOTUNE);
+    }
+    if (_currentState == States::Type::AUTOTUNE && !_autotuner.isRunning())
+    {
+        if (_autotuner.status() == Autotuner::Status::DONE && _onAutotuned != nullptr)
         {
-            _currentState = _stateBeforeEmergency;
-            wasInEmergency = false;
+            _onAutotuned(_autotuner.result());
         }
+        changeState(States::Type::STANDBY);
+    }
+    applyOutputs(States::descriptor(_currentState));
+    takeTransition();
+}
 
-        // This section only runs if there are no active gas emergencies.
-        actuatorController.setStatusGreenLED(true);
-        actuatorController.setStatusRedLED(false);
-        _sirenShouldBeActive = false; // Reset the siren request when conditions are normal.
-
-        switch (_currentState)
+// === ACKNOWLEDGE BUTTON ===
+void SystemState::handleButton()
+{
+    // Every queued event is taken, however long the loop was held up.
+    ButtonEvent event;
+    while ((event = acknowledgeButton.next()) != ButtonEvent::NONE)
+    {
+        if (_currentState == States::Type::EMERGENCY_STOP)
+        {
+            // Held, not tapped: brushing against the button does not end the stop. The stop
+            // interrupt only fires on the falling edge, so a stop button still held down
+            // could not stop again: the latch stays until it is let go.
+            if (event == ButtonEvent::LONG_PRESS && Hal::digitalRead(_emergencyStopPin))
+            {
+                acknowledgeEmergencyStop();
+            }
+        }
+        else if (_wasInGasEmergency)
+        {
+            _gasAcknowledged = _gasAcknowledged || event == ButtonEvent::PRESS;
+        }
+        else if (event == ButtonEvent::PRESS)
+        {
+            _screen = _screen == Screen::STATUS ? Screen::HEATER : Screen::STATUS;
+        }
+        else if (event == ButtonEvent::LONG_PRESS)
         {
-        case States::Type::STANDBY:
-            handleStandby();
-            break;
-        case States::Type::PREHEATING:
-            handlePreheating();
-            break;
-        case States::Type::MAINTAINING:
-            handleMaintaining();
-            break;
-        case States::Type::EMERGENCY_STOP:
-            handleEmergencyStop();
-            break;
+            _screen = Screen::STATUS;
         }
     }
-
-    // 4. FINAL ACTUATOR UPDATE
-    actuatorController.setSirenState(_sirenShouldBeActive);
-    actuatorController.update();
 }
 
-// === STATE HANDLERS ===
-// These remain unchanged from the previous version, as they were already correct.
-
-void SystemState::handleStandby()
+void SystemState::acknowledgeEmergencyStop()
 {
-    actuatorController.setStatusGreenLED(false);
-    actuatorController.setStatusRedLED(false);
-    actuatorController.setStatusHeater(false);
-    _lastTemperature = sensorManager.getTemperature();
-    _setpoint = sensorManager.getSetpoint();
-    updateDisplay(States::toString(States::Type::STANDBY), _lastTemperature, _setpoint, _gasValue);
-
-    if (_lastTemperature < _setpoint)
     {
-        _currentState = States::Type::PREHEATING;
+        // The stop button may fire again at any time: the state it writes must win.
+        Hal::InterruptLock lock;
+        actuatorController.releaseEmergencyOutputs();
+        _currentState = States::Type::STANDBY;
     }
+    // As changeState(), without writing _currentState again
+    runAction(static_cast<States::Action>(pgm_read_byte(&States::descriptor(_enteredState)->onExit)));
+    _enteredState = States::Type::STANDBY;
+    runAction(static_cast<States::Action>(pgm_read_byte(&States::descriptor(_enteredState)->onEnter)));
+
+    // Whatever ran before the stop starts over from STANDBY, a gas warning included.
+    _stateBeforeEmergency = States::Type::STANDBY;
+    _screen = Screen::STATUS;
+    _dutyIntegral = 0;
 }
 
-void SystemState::handlePreheating()
+bool SystemState::checkGasEmergency()
 {
-    actuatorController.setStatusGreenLED(false);
-    actuatorController.setStatusRedLED(true);
-    actuatorController.setStatusHeater(true);
-    float currentTemperature = sensorManager.getTemperature();
-    float setpoint = sensorManager.getSetpoint();
-    updateDisplay(States::toString(States::Type::PREHEATING), currentTemperature, setpoint, _gasValue);
-
-    if (currentTemperature >= setpoint)
+    if (!_wasInGasEmergency)
     {
-        _currentState = States::Type::MAINTAINING;
-        _lastUpdateTime = millis();
-        _lastTemperature = currentTemperature;
-        actuatorController.setStatusHeater(false);
+        return _gasValue >= parameters.gasHighThreshold;
     }
+    // A trip also holds for gasTripHoldMs: the filtered reading lags the raw
+    // conversions that tripped it by a few sampler rounds.
+    return _gasValue >= parameters.gasLowThreshold || Hal::millis() - _gasWarningMs < parameters.gasTripHoldMs;
 }
 
-void SystemState::handleMaintaining()
+// === TABLE INTERPRETATION ===
+void SystemState::applyOutputs(const States::Descriptor *descriptor)
 {
-    actuatorController.setStatusGreenLED(true);
-    actuatorController.setStatusRedLED(false);
+    uint8_t outputs = pgm_read_byte(&descriptor->outputs);
 
-    unsigned long now = millis();
-    if (_heatingPulseStartTime > 0)
+    actuatorController.setStatusGreenLED(outputs & States::OUTPUT_GREEN_LED);
+    actuatorController.setStatusRedLED(outputs & States::OUTPUT_RED_LED);
+    if (!(outputs & States::OUTPUT_HEATER_CONTROL))
     {
-        if (now - _heatingPulseStartTime >= HEATING_PULSE_DURATION_MS)
-        {
-            actuatorController.setStatusHeater(false);
-            _heatingPulseStartTime = 0;
-        }
+        actuatorController.setStatusHeater(false); // Otherwise the duty is set by updateHeaterDuty()
     }
-    else
+    // The siren pattern itself plays from its timer interrupt
+    actuatorController.setSirenState(outputs & States::OUTPUT_SIREN,
+                                     static_cast<SirenPattern>(pgm_read_byte(&descriptor->sirenPattern)));
+
+    if ((outputs & States::OUTPUT_STATUS_SCREEN) && _screen == Screen::HEATER)
     {
-        if (now - _lastUpdateTime >= (DERIVATIVE_CALCULATION_INTERVAL_S * 1000))
-        {
-            float dt_seconds = (now - _lastUpdateTime) / 1000.0f;
-            float currentTemperature = sensorManager.getTemperature();
-            _temperatureDerivative = (currentTemperature - _lastTemperature) / dt_seconds;
-            _lastUpdateTime = now;
-            _lastTemperature = currentTemperature;
+        updateHeaterScreen();
+    }
+    else if (outputs & States::OUTPUT_STATUS_SCREEN)
+    {
+        updateDisplay(descriptor->label, _estimator.temperature(), sensorManager.getSetpoint(), _gasValue,
+                      (outputs & States::OUTPUT_TUNING_PROGRESS) ? _autotuner.cycles() : DISPLAY_NO_PROGRESS);
+    }
+}
 
-            if (_temperatureDerivative < PREDICTIVE_DERIVATIVE_THRESHOLD && currentTemperature < sensorManager.getSetpoint())
-            {
-                actuatorController.setStatusHeater(true);
-                _heatingPulseStartTime = now;
-            }
-        }
+void SystemState::takeTransition()
+{
+    States::Type next = States::nextState(_currentState, _estimator.temperature(), sensorManager.getSetpoint());
+    if (next != _currentState)
+    {
+        changeState(next);
     }
+}
+
+void SystemState::changeState(States::Type state)
+{
+    runAction(static_cast<States::Action>(pgm_read_byte(&States::descriptor(_enteredState)->onExit)));
+    _currentState = state;
+    _enteredState = state;
+    runAction(static_cast<States::Action>(pgm_read_byte(&States::descriptor(state)->onEnter)));
+}
 
-    if (sensorManager.getTemperature() < sensorManager.getSetpoint() - TEMPERATURE_HYSTERESIS)
+void SystemState::runAction(States::Action action)
+{
+    switch (action)
     {
-        _currentState = States::Type::PREHEATING;
+    case States::Action::NONE:
+        break;
+    case States::Action::SHOW_EMERGENCY_SCREEN:
+        displayManager.displayEmergency(States::EMERGENCY_MESSAGE);
+        break;
+    case States::Action::START_AUTOTUNE:
+        _autotuner.begin(sensorManager.getSetpoint(), _holdingDuty / HOLDING_DUTY_SCALE);
+        break;
+    case States::Action::STOP_AUTOTUNE:
+        _autotuner.abort();
+        break;
+    case States::Action::RESTORE_STATUS_SCREEN:
+        _previousLabelPrinted = nullptr;
+        _previousDutyPrinted = DISPLAY_NO_PROGRESS;
+        break;
     }
+}
 
-    updateDisplay(States::toString(States::Type::MAINTAINING), sensorManager.getTemperature(), sensorManager.getSetpoint(), _gasValue);
+void SystemState::updateEstimate()
+{
+    PROFILE_PHASE(FSM);
+    _estimator.update(sensorManager.getTemperature(), actuatorController.isHeaterOn());
 }
 
-void SystemState::handleEmergencyStop()
+void SystemState::updateHeaterDuty()
 {
-    actuatorController.setStatusHeater(false);
-    actuatorController.setStatusGreenLED(false);
-    actuatorController.setStatusRedLED(true);
-    actuatorController.setSirenState(true);
+    PROFILE_PHASE(FSM);
+
+    // The duty is only under closed-loop control while heating up or maintaining,
+    // outside any emergency (the other states force the heater off).
+    bool controlling = _currentState == States::Type::PREHEATING || _currentState == States::Type::MAINTAINING ||
+                       _currentState == States::Type::AUTOTUNE;
+    Temperature temperature = _estimator.temperature();
+    if (!controlling || _wasInGasEmergency)
+    {
+        _predictive.update(temperature, 0, false);
+        return;
+    }
 
-    if (!_hwEmergencyMessageDisplayed)
+    Temperature setpoint = sensorManager.getSetpoint();
+    uint8_t duty;
+    if (_currentState == States::Type::AUTOTUNE)
+    {
+        duty = _autotuner.duty(temperature);
+    }
+    else
     {
-        displayManager.displayEmergency("HW STOP ACTIVATED");
-        _hwEmergencyMessageDisplayed = true;
+        duty = parameters.heaterControlMode == HeaterControlMode::PREDICTIVE
+                   ? _predictive.duty(setpoint, temperature)
+                   : HeaterControl::duty(setpoint - temperature, _estimator.rate(), _dutyIntegral);
+    }
+    _predictive.update(temperature, duty, _currentState == States::Type::PREHEATING);
+    actuatorController.setHeaterDuty(duty);
+    if (_currentState == States::Type::MAINTAINING)
+    {
+        // About the last HOLDING_DUTY_SCALE periods, whichever law is in use
+        _holdingDuty += duty - _holdingDuty / HOLDING_DUTY_SCALE;
     }
 }
 
-void SystemState::updateDisplay(String state, float currentTemp, float setpoint, int gasValue)
+void SystemState::updateDisplay(const char *label, Temperature currentTemp, Temperature setpoint, int gasValue,
+                                uint8_t progress)
 {
     if (_previousTemperaturePrinted != currentTemp ||
         _previousSetpointPrinted != setpoint ||
         _previousGasValuePrinted != gasValue ||
-        _previousStatePrinted != state)
+        _previousLabelPrinted != label ||
+        _previousProgressPrinted != progress)
     {
         _previousTemperaturePrinted = currentTemp;
         _previousSetpointPrinted = setpoint;
         _previousGasValuePrinted = gasValue;
-        _previousStatePrinted = state;
-        displayManager.displayStatus(state, currentTemp, setpoint, gasValue);
+        _previousLabelPrinted = label;
+        _previousProgressPrinted = progress;
+        _previousDutyPrinted = DISPLAY_NO_PROGRESS;
+        if (progress == DISPLAY_NO_PROGRESS)
+        {
+            displayManager.displayStatus(label, currentTemp, setpoint, gasValue);
+        }
+        else
+        {
+            displayManager.displayProgress(label, progress, AUTOTUNE_CYCLES, currentTemp, setpoint, gasValue);
+        }
     }
-}
\ No newline at end of file
+}
+
+void SystemState::updateHeaterScreen()
+{
+    uint8_t duty = actuatorController.getHeaterDuty();
+    Temperature ratePerMinute = static_cast<Temperature>(_estimator.rate() * SECONDS_PER_MINUTE);
+    int16_t rateTenths = TemperatureMath::toTenths(ratePerMinute);
+    if (_previousDutyPrinted != duty || _previousRatePrinted != rateTenths)
+    {
+        _previousDutyPrinted = duty;
+        _previousRatePrinted = rateTenths;
+        _previousLabelPrinted = nullptr; // The status screen is redrawn in full when paged back to
+        displayManager.displayHeater(duty, parameters.heaterControlMode == HeaterControlMode::PREDICTIVE,
+                                     ratePerMinute);
+    }
+}
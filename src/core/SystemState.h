@@ -2,8 +2,28 @@
 
 #include "StateType.h"
 #include "../sensors/SensorManager.h"
+#include "../sensors/DebouncedButton.h"
 #include "../controllers/ActuatorController.h"
 #include "../display/DisplayManager.h"
+#include "Scheduler.h"
+#include "TemperatureEstimator.h"
+#include "HeaterControl.h"
+#include "PredictiveControl.h"
+#include "Autotuner.h"
+
+/**
+ * @brief Latency record of the ISR-level gas trip (see SystemState::triggerGasTrip()).
+ */
+struct GasTripStats
+{
+    uint16_t trips;
+    unsigned long lastTripUs;  // micros() when the last trip fired
+    uint16_t heaterOffUs;      // From the trip to the heater pin written low, last trip
+    uint16_t maxHeaterOffUs;
+    uint32_t responseUs;       // From the trip to the FSM pass showing the warning, last trip
+    uint32_t maxResponseUs;
+};
+
 /**
  * @class SystemState
  * @brief Manages the main logic and state machine of the fermentation chamber.
@@ -14,13 +34,22 @@
 class SystemState
 {
 public:
+    /**
+     * @brief Called when an autotune experiment succeeded, to keep its gains (e.g. in
+     *        the ParameterStore).
+     */
+    using AutotuneHandler = void (*)(const AutotuneResult &result);
+
     /**
      * @brief Constructs the SystemState manager.
      * @param sm A reference to the SensorManager instance.
      * @param ac A reference to the ActuatorController instance.
      * @param dm A reference to the DisplayManager instance.
+     * @param button A reference to the acknowledge button.
+     * @param emergencyStopPin The emergency stop input, low while the button is held.
      */
-    SystemState(SensorManager &sm, ActuatorController &ac, DisplayManager &dm);
+    SystemState(SensorManager &sm, ActuatorController &ac, DisplayManager &dm, DebouncedButton &button,
+                uint8_t emergencyStopPin);
 
     /**
      * @brief Initializes the system state and dependent components.
@@ -28,54 +57,190 @@ public:
     void begin();
 
     /**
-     * @brief The main update loop for the system logic.
+     * @brief Adds the FSM, state estimator and heater control tasks to the scheduler.
+     */
+    void registerTasks(Scheduler &scheduler);
+
+    /**
+     * @brief The FSM step: emergency checks, the acknowledge button's events, then the
+     *        outputs and transitions of the current state from the tables in StateType.h,
+     *        then one commit of the LED outputs. Runs as a scheduler task.
+     * @details A long press acknowledges an emergency stop, back to STANDBY, once the
+     *          stop button has been let go; a press
+     *          silences a gas warning. Otherwise a press pages between the status and
+     *          heater screens, and a long press goes back to the status screen.
      */
     void update();
 
+    /**
+     * @brief Feeds the latest sensor reading and relay state to the temperature
+     *        estimator. Runs as a scheduler task every ESTIMATOR_PERIOD_MS.
+     */
+    void updateEstimate();
+
+    /**
+     * @brief The heater control step. Runs as a scheduler task every HEATER_CONTROL_PERIOD_MS.
+     * @details In PREHEATING and MAINTAINING, commands the heater duty computed from the
+     *          estimated temperature by the law the ctl_mode parameter selects:
+     *          `PredictiveControl` or `HeaterControl::duty()`. The duty is applied by the
+     *          heater's slow PWM. In AUTOTUNE the duty is the relay of `Autotuner`.
+     *          The predictive model follows the duty in every state, and identifies the
+     *          chamber while PREHEATING runs at full power.
+     */
+    void updateHeaterDuty();
+
+    /**
+     * @brief Asks the FSM to start an autotune experiment on its next pass, or to abort
+     *        the one running. Ignored in EMERGENCY_STOP; held during a gas warning.
+     */
+    void requestAutotune() { _autotuneRequested = true; }
+
+    /**
+     * @brief Sets the function given the result of a successful experiment.
+     */
+    void setAutotuneHandler(AutotuneHandler handler) { _onAutotuned = handler; }
+
     /**
      * @brief An ISR-safe method to trigger the hardware emergency stop.
+     * @details Opens the heater relay and lights the red LED before returning, and
+     *          latches them (see ActuatorController::latchEmergencyOutputs()); the siren
+     *          and the emergency screen follow on the next FSM pass.
      */
     void triggerEmergencyStop();
 
+    /**
+     * @brief An ISR-safe method called by the sampler's gas trip (SensorManager::watchGas()).
+     * @details Opens the heater relay at once, then leaves the siren and the display to
+     *          the next FSM pass, which holds the gas warning until the filtered reading
+     *          falls below the gas_low parameter.
+     */
+    void triggerGasTrip();
+
+    /**
+     * @brief Prints the gas trip count and latencies as CSV.
+     */
+    void reportGasTrip(Hal::SerialPort &port) const;
+
+    /**
+     * @brief Returns the gas trip latencies (a copy, taken with interrupts off).
+     */
+    GasTripStats getGasTripStats() const;
+
+    /**
+     * @brief Returns the current state of the FSM (read-only, for diagnostics and simulation).
+     */
+    States::Type getState() const { return _currentState; }
+
+    /**
+     * @brief Returns the temperature estimator (read-only, for diagnostics and simulation).
+     */
+    const TemperatureEstimator &getEstimator() const { return _estimator; }
+    const PredictiveControl &getPredictiveControl() const { return _predictive; }
+    const Autotuner &getAutotuner() const { return _autotuner; }
+
 private:
+    friend class Benchmarks; // Times the display change detection (src/bench/)
+
     // --- Component References ---
     SensorManager &sensorManager;
     ActuatorController &actuatorController;
     DisplayManager &displayManager;
-    // The DebouncedButton reference has been removed.
+    DebouncedButton &acknowledgeButton;
+    uint8_t _emergencyStopPin;
 
     // --- State Machine ---
     States::Type _currentState;
+    States::Type _enteredState; // The state whose entry action has run
     States::Type _stateBeforeEmergency;
-    
+    bool _wasInGasEmergency;
+    volatile bool _gasTripPending;  // Set by triggerGasTrip(), consumed by the FSM
+    unsigned long _gasWarningMs;    // millis() when the FSM took the last trip
+    GasTripStats _gasTrip;          // Written by triggerGasTrip() and the FSM
+
+    /**
+     * @brief The body of `update()`, before the actuator outputs are committed.
+     */
+    void runStateMachine();
+
+    /**
+     * @brief Takes the events the acknowledge button queued, and acts on each.
+     */
+    void handleButton();
+
+    /**
+     * @brief Leaves EMERGENCY_STOP for STANDBY: ends the output latch and redraws the
+     *        status screen.
+     */
+    void acknowledgeEmergencyStop();
+
+    /**
+     * @brief Decides whether the gas warning is on, with hysteresis: it starts on a
+     *        trip or at the gas_high parameter and ends below gas_low (see ParameterStore).
+     */
+    bool checkGasEmergency();
 
-    // --- State Handlers (Private Methods) ---
-    void handleStandby();
-    void handlePreheating();
-    void handleMaintaining();
-    void handleEmergencyStop();
+    // --- Table Interpretation (see StateType.h) ---
+    /**
+     * @brief Drives the LEDs, the heater and the siren from a descriptor's outputs,
+     *        and shows its status screen.
+     */
+    void applyOutputs(const States::Descriptor *descriptor);
+
+    /**
+     * @brief Takes the first transition out of the current state whose guard holds.
+     */
+    void takeTransition();
+
+    /**
+     * @brief Moves to a state, running the exit action of the last one entered and the
+     *        entry action of the new one.
+     */
+    void changeState(States::Type state);
+    void runAction(States::Action action);
 
     // --- Display Management ---
-    void updateDisplay(String state, float currentTemp, float setpoint, int gasValue);
+    /**
+     * @brief Redraws the status screen when the label or a reading changed.
+     * @param label A state label in flash; labels are compared by address.
+     * @param progress Autotune cycles to show after the label, or DISPLAY_NO_PROGRESS.
+     */
+    void updateDisplay(const char *label, Temperature currentTemp, Temperature setpoint, int gasValue,
+                       uint8_t progress = DISPLAY_NO_PROGRESS);
+
+    /**
+     * @brief Redraws the heater screen when the duty or the shown rate changed.
+     */
+    void updateHeaterScreen();
 
     // --- Member Variables ---
-    float _setpoint;
     int _gasValue;
+    bool _gasAcknowledged; // The button silenced the gas warning in progress
 
-    // Predictive Control & Timing
-    unsigned long _lastUpdateTime;
-    float _lastTemperature;
-    float _temperatureDerivative;
-    unsigned long _heatingPulseStartTime;
-
-    // Siren Management
-    bool _sirenShouldBeActive;
+    /**
+     * @brief The screens the button pages through outside the emergencies.
+     */
+    enum class Screen : uint8_t
+    {
+        STATUS, // The state label and the readings
+        HEATER, // DisplayManager::displayHeater()
+    };
+    Screen _screen;
 
-    bool _hwEmergencyMessageDisplayed; // Flag to prevent LCD flickering
+    // State Estimation & Heater Control
+    TemperatureEstimator _estimator; // Filtered temperature and rate, read instead of the raw sensor
+    int32_t _dutyIntegral;           // Integral term (see HeaterControl::duty())
+    uint16_t _holdingDuty;           // Running mean of the duty in MAINTAINING, 1/16 percent
+    PredictiveControl _predictive;   // Identified chamber model and predictive duty
+    Autotuner _autotuner;            // Relay experiment run in AUTOTUNE
+    bool _autotuneRequested;         // Set by requestAutotune(), consumed by the FSM
+    AutotuneHandler _onAutotuned;
 
     // Previous Display State (for optimization)
-    float _previousTemperaturePrinted = 0.0;
-    float _previousSetpointPrinted = 0.0;
+    Temperature _previousTemperaturePrinted = 0;
+    Temperature _previousSetpointPrinted = 0;
     int _previousGasValuePrinted = 0;
-    String _previousStatePrinted = "";
+    const char *_previousLabelPrinted = nullptr;
+    uint8_t _previousProgressPrinted = DISPLAY_NO_PROGRESS;
+    uint8_t _previousDutyPrinted = DISPLAY_NO_PROGRESS; // DISPLAY_NO_PROGRESS while the heater screen is not shown
+    int16_t _previousRatePrinted = 0;                   // Tenths of a degree per minute
 };
@@ -0,0 +1,31 @@
+#include "Temperature.h"
+
+char *TemperatureMath::format(char *buffer, Temperature value)
+{
+    int16_t tenths = toTenths(value);
+    char *out = buffer;
+    if (tenths < 0)
+    {
+        *out++ = '-';
+        tenths = -tenths;
+    }
+
+    // Integer part, most significant digit first
+    char digits[5];
+    uint8_t count = 0;
+    int16_t whole = tenths / 10;
+    do
+    {
+        digits[count++] = static_cast<char>('0' + whole % 10);
+        whole /= 10;
+    } while (whole > 0);
+    while (count > 0)
+    {
+        *out++ = digits[--count];
+    }
+
+    *out++ = '.';
+    *out++ = static_cast<char>('0' + tenths % 10);
+    *out = '\0';
+    return out;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "../hal/Hal.h"
+
+/**
+ * @file Temperature.h
+ * @brief Numeric representation of temperatures and heating rates on the control path.
+ *
+ * @details The ATmega328P has no FPU, so every float operation is a call into the
+ *          soft-float library. Building with `-DBIOLOGIC_FIXED_POINT` switches the whole
+ *          pipeline (sensor conversion, setpoint mapping, estimation, comparisons and
+ *          display formatting) to signed Q8.8 integers: 1/256 °C resolution over
+ *          ±128 °C, which comfortably covers the 20-40 °C range of the chamber.
+ *
+ *          Without the flag the original float path is used. Code outside this file
+ *          only ever uses `Temperature`, `TemperatureRate`, `celsius()` and the helpers
+ *          below, so both builds share a single control implementation.
+ */
+
+#ifdef BIOLOGIC_FIXED_POINT
+
+using Temperature = int16_t;     // Q8.8 degrees Celsius
+using TemperatureRate = int16_t; // Q8.8 degrees Celsius per second
+
+constexpr uint8_t TEMPERATURE_FRACTION_BITS = 8;
+
+/**
+ * @brief Converts a Celsius literal to a Temperature at compile time.
+ */
+constexpr Temperature celsius(float value)
+{
+    return static_cast<Temperature>(value * (1 << TEMPERATURE_FRACTION_BITS) + (value >= 0 ? 0.5f : -0.5f));
+}
+
+#else
+
+using Temperature = float;     // Degrees Celsius
+using TemperatureRate = float; // Degrees Celsius per second
+
+constexpr Temperature celsius(float value) { return value; }
+
+#endif
+
+namespace TemperatureMath
+{
+    /**
+     * @brief Converts a Q8.8 value (e.g. a calibration table entry) to a Temperature.
+     */
+    inline Temperature fromFixed(int16_t q8_8)
+    {
+#ifdef BIOLOGIC_FIXED_POINT
+        return q8_8;
+#else
+        return q8_8 / 256.0f;
+#endif
+    }
+
+    /**
+     * @brief Converts a temperature to Q8.24, the working precision of the state estimator.
+     */
+    inline int32_t toQ8_24(Temperature value)
+    {
+#ifdef BIOLOGIC_FIXED_POINT
+        return static_cast<int32_t>(value) << (24 - TEMPERATURE_FRACTION_BITS);
+#else
+        return static_cast<int32_t>(value * 16777216.0f);
+#endif
+    }
+
+    /**
+     * @brief Converts a Q8.24 value back to a Temperature (truncating in the fixed-point build).
+     */
+    inline Temperature fromQ8_24(int32_t q8_24)
+    {
+#ifdef BIOLOGIC_FIXED_POINT
+        return static_cast<Temperature>(q8_24 >> (24 - TEMPERATURE_FRACTION_BITS));
+#else
+        return q8_24 / 16777216.0f;
+#endif
+    }
+
+    /**
+     * @brief Multiplies a temperature (or rate) by an integer gain per degree.
+     * @details Used by the heater control law, e.g. `scaled(error, 40)` is the duty in
+     *          percent of a 40 %/°C proportional term. The result is truncated.
+     */
+    inline int32_t scaled(Temperature value, int16_t gainPerDegree)
+    {
+#ifdef BIOLOGIC_FIXED_POINT
+        return static_cast<int32_t>(value) * gainPerDegree / (1 << TEMPERATURE_FRACTION_BITS);
+#else
+        return static_cast<int32_t>(value * gainPerDegree);
+#endif
+    }
+
+    /**
+     * @brief Rounds a temperature to tenths of a degree (e.g. 29.66 °C -> 297).
+     */
+    constexpr int16_t toTenths(Temperature value)
+    {
+#ifdef BIOLOGIC_FIXED_POINT
+        int32_t scaled = static_cast<int32_t>(value) * 10;
+        int32_t half = 1 << (TEMPERATURE_FRACTION_BITS - 1);
+        return static_cast<int16_t>((scaled >= 0 ? scaled + half : scaled - half) / (1 << TEMPERATURE_FRACTION_BITS));
+#else
+        return static_cast<int16_t>(value * 10.0f + (value >= 0 ? 0.5f : -0.5f));
+#endif
+    }
+
+    /**
+     * @brief Converts tenths of a degree to a temperature (e.g. 5 -> 0.5 °C).
+     */
+    inline Temperature fromTenths(int16_t tenths)
+    {
+#ifdef BIOLOGIC_FIXED_POINT
+        int32_t scaled = static_cast<int32_t>(tenths) << TEMPERATURE_FRACTION_BITS;
+        return static_cast<Temperature>((scaled >= 0 ? scaled + 5 : scaled - 5) / 10);
+#else
+        return tenths / 10.0f;
+#endif
+    }
+
+    /**
+     * @brief Converts a temperature to float, for host-side reporting only.
+     */
+    inline float toFloat(Temperature value)
+    {
+#ifdef BIOLOGIC_FIXED_POINT
+        return value / static_cast<float>(1 << TEMPERATURE_FRACTION_BITS);
+#else
+        return value;
+#endif
+    }
+
+    /**
+     * @brief Formats a temperature with one decimal place (e.g. "29.7", "-3.5").
+     * @details Integer-only in both builds, so the display never pulls in the float
+     *          printing code.
+     * @param buffer Destination, at least 7 characters.
+     * @return A pointer to the terminating null character, for appending.
+     */
+    char *format(char *buffer, Temperature value);
+}
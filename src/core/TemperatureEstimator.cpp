@@ -0,0 +1,143 @@
+#include "TemperatureEstimator.h"
+
+// === COMPILE-TIME GAINS ===
+namespace
+{
+    constexpr uint8_t STATE_COUNT = 3; // Temperature, heating, loss
+    constexpr uint8_t Q24_SHIFT = 24;
+    constexpr float Q24_ONE = 16777216.0f;
+    constexpr uint16_t RICCATI_ITERATIONS = 4000; // Far past convergence
+
+    constexpr float STEP_S = ESTIMATOR_PERIOD_MS / 1000.0f;
+    constexpr uint8_t STEPS_PER_SECOND = 1000 / ESTIMATOR_PERIOD_MS;
+    static_assert(1000 % ESTIMATOR_PERIOD_MS == 0, "The rate conversion needs a whole number of steps per second");
+
+    // heating' = DECAY * heating + (1 - DECAY) * full-power warming per step, while the relay is closed
+    constexpr float DECAY = 1.0f - STEP_S / ELEMENT_TIME_CONSTANT_S;
+    constexpr float HEATER_INPUT = (1.0f - DECAY) * CHAMBER_FULL_POWER_RATE_C_PER_S * STEP_S;
+
+    struct Matrix
+    {
+        float m[STATE_COUNT][STATE_COUNT];
+    };
+
+    struct Gains
+    {
+        float k[STATE_COUNT];
+    };
+
+    constexpr Matrix multiply(const Matrix &a, const Matrix &b)
+    {
+        Matrix result{};
+        for (uint8_t i = 0; i < STATE_COUNT; i++)
+            for (uint8_t j = 0; j < STATE_COUNT; j++)
+                for (uint8_t n = 0; n < STATE_COUNT; n++)
+                    result.m[i][j] += a.m[i][n] * b.m[n][j];
+        return result;
+    }
+
+    constexpr Matrix transpose(const Matrix &a)
+    {
+        Matrix result{};
+        for (uint8_t i = 0; i < STATE_COUNT; i++)
+            for (uint8_t j = 0; j < STATE_COUNT; j++)
+                result.m[i][j] = a.m[j][i];
+        return result;
+    }
+
+    // Steady-state gain of the filter measuring the temperature only.
+    constexpr Gains steadyStateGains()
+    {
+        // temperature' = temperature + heating - loss
+        const Matrix transition{{{1, 1, -1}, {0, DECAY, 0}, {0, 0, 1}}};
+        const Matrix transitionT = transpose(transition);
+        const float processNoise[STATE_COUNT] = {
+            ESTIMATOR_TEMPERATURE_NOISE_C * ESTIMATOR_TEMPERATURE_NOISE_C,
+            ESTIMATOR_HEATING_NOISE_C * ESTIMATOR_HEATING_NOISE_C,
+            ESTIMATOR_LOSS_NOISE_C * ESTIMATOR_LOSS_NOISE_C};
+        const float sensorNoise = ESTIMATOR_SENSOR_NOISE_C * ESTIMATOR_SENSOR_NOISE_C;
+
+        Matrix covariance{{{sensorNoise, 0, 0}, {0, 0, 0}, {0, 0, 0}}};
+        Gains gains{};
+        for (uint16_t iteration = 0; iteration < RICCATI_ITERATIONS; iteration++)
+        {
+            // Predict
+            covariance = multiply(multiply(transition, covariance), transitionT);
+            for (uint8_t i = 0; i < STATE_COUNT; i++)
+            {
+                covariance.m[i][i] += processNoise[i];
+            }
+
+            // Correct: the measurement picks the first state
+            float innovationVariance = covariance.m[0][0] + sensorNoise;
+            for (uint8_t i = 0; i < STATE_COUNT; i++)
+            {
+                gains.k[i] = covariance.m[i][0] / innovationVariance;
+            }
+            Matrix corrected = covariance;
+            for (uint8_t i = 0; i < STATE_COUNT; i++)
+                for (uint8_t j = 0; j < STATE_COUNT; j++)
+                    corrected.m[i][j] -= gains.k[i] * covariance.m[0][j];
+            covariance = corrected;
+        }
+        return gains;
+    }
+
+    constexpr int32_t toQ24(float value)
+    {
+        return static_cast<int32_t>(value * Q24_ONE + (value >= 0 ? 0.5f : -0.5f));
+    }
+
+    constexpr Gains GAINS = steadyStateGains();
+    constexpr int32_t TEMPERATURE_GAIN = toQ24(GAINS.k[0]);
+    constexpr int32_t HEATING_GAIN = toQ24(GAINS.k[1]);
+    constexpr int32_t LOSS_GAIN = toQ24(GAINS.k[2]);
+    constexpr int32_t DECAY_Q24 = toQ24(DECAY);
+    constexpr int32_t HEATER_INPUT_Q24 = toQ24(HEATER_INPUT);
+
+    static_assert(HEATER_INPUT_Q24 > 100, "Heater input below the Q8.24 resolution");
+    static_assert(LOSS_GAIN != 0, "Loss gain below the Q8.24 resolution");
+
+    inline int32_t multiplyQ24(int32_t value, int32_t q24)
+    {
+        return static_cast<int32_t>((static_cast<int64_t>(value) * q24) >> Q24_SHIFT);
+    }
+}
+
+// === ESTIMATOR ===
+TemperatureEstimator::TemperatureEstimator()
+    : _temperature(0),
+      _heating(0),
+      _loss(0)
+{
+}
+
+void TemperatureEstimator::reset(Temperature measured)
+{
+    _temperature = TemperatureMath::toQ8_24(measured);
+    _heating = 0;
+    _loss = 0;
+}
+
+void TemperatureEstimator::update(Temperature measured, bool heaterOn)
+{
+    // Predict from the model and the known heater input
+    _temperature += _heating - _loss;
+    _heating = multiplyQ24(_heating, DECAY_Q24) + (heaterOn ? HEATER_INPUT_Q24 : 0);
+
+    // Correct with the measurement
+    int32_t innovation = TemperatureMath::toQ8_24(measured) - _temperature;
+    _temperature += multiplyQ24(innovation, TEMPERATURE_GAIN);
+    _heating += multiplyQ24(innovation, HEATING_GAIN);
+    _loss += multiplyQ24(innovation, LOSS_GAIN);
+}
+
+Temperature TemperatureEstimator::temperature() const
+{
+    return TemperatureMath::fromQ8_24(_temperature);
+}
+
+TemperatureRate TemperatureEstimator::rate() const
+{
+    return TemperatureMath::fromQ8_24((_heating - _loss) * STEPS_PER_SECOND);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "../hal/Hal.h"
+#include "Temperature.h"
+
+// --- Sampling ---
+constexpr uint16_t ESTIMATOR_PERIOD_MS = 250; // One filter step per period
+
+// --- Chamber model (the reference chamber: 60 W element, 2000 J/K of air and contents) ---
+constexpr float CHAMBER_FULL_POWER_RATE_C_PER_S = 0.03f; // Warming rate with a hot element and no losses
+constexpr float ELEMENT_TIME_CONSTANT_S = 50.0f;         // Lag between the relay and the heat reaching the air
+
+// --- Noise model (standard deviations, per filter step) ---
+constexpr float ESTIMATOR_SENSOR_NOISE_C = 0.05f;      // Oversampled TMP36 reading
+constexpr float ESTIMATOR_TEMPERATURE_NOISE_C = 0.001f; // Unmodelled disturbances (door, contents)
+constexpr float ESTIMATOR_HEATING_NOISE_C = 0.0001f;   // Error of the element model
+constexpr float ESTIMATOR_LOSS_NOISE_C = 0.00002f;     // Drift of the heat loss (ambient, temperature)
+
+/**
+ * @class TemperatureEstimator
+ * @brief Kalman filter estimating the chamber temperature and its rate of change.
+ *
+ * @details A two-point difference of the TMP36 reading is dominated by quantization
+ *          noise. The filter instead tracks three states, in degrees per filter step:
+ *
+ *          - the chamber temperature,
+ *          - the warming brought by the element, which follows the relay state (the
+ *            known input) with the element's first-order lag,
+ *          - the warming lost to the ambient, a slow random walk.
+ *
+ *          The rate of change is their difference, so a heater switching on is seen in
+ *          the rate before the sensor can resolve it. The model is time-invariant, so
+ *          the Kalman gains converge to constants: they are computed by the compiler
+ *          (the Riccati recursion runs in constexpr) and the runtime step is a handful
+ *          of Q8.24 multiply-adds, O(1) and float-free.
+ */
+class TemperatureEstimator
+{
+public:
+    TemperatureEstimator();
+
+    /**
+     * @brief Restarts the filter from a measurement, with the heater off and no losses.
+     */
+    void reset(Temperature measured);
+
+    /**
+     * @brief One filter step. Call every ESTIMATOR_PERIOD_MS.
+     * @param measured The latest sensor temperature.
+     * @param heaterOn The relay state over the step that just ended.
+     */
+    void update(Temperature measured, bool heaterOn);
+
+    /**
+     * @brief Returns the filtered chamber temperature.
+     */
+    Temperature temperature() const;
+
+    /**
+     * @brief Returns the estimated rate of change, per second.
+     */
+    TemperatureRate rate() const;
+
+private:
+    // Q8.24 degrees Celsius (per filter step for the two warming terms)
+    int32_t _temperature;
+    int32_t _heating;
+    int32_t _loss;
+};
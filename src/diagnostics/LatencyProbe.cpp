@@ -0,0 +1,45 @@
+#include "LatencyProbe.h"
+
+#ifdef BIOLOGIC_LATENCY_PROBE
+
+// === STATIC STORAGE ===
+uint32_t LatencyProbe::_edgeUs = 0;
+uint16_t LatencyProbe::_edges = 0;
+uint16_t LatencyProbe::_lastUs = 0;
+uint16_t LatencyProbe::_maxUs = 0;
+uint16_t LatencyProbe::_overBound = 0;
+
+// === INTERRUPT CONTEXT ===
+void LatencyProbe::outputEdge()
+{
+    uint16_t us = static_cast<uint16_t>(Hal::micros() - _edgeUs);
+    _edges++;
+    _lastUs = us;
+    _maxUs = us > _maxUs ? us : _maxUs;
+    _overBound += us > LATENCY_BOUND_US ? 1 : 0;
+}
+
+// === REPORT ===
+void LatencyProbe::dump(Hal::SerialPort &port)
+{
+    uint16_t edges, lastUs, maxUs, overBound;
+    {
+        Hal::InterruptLock lock;
+        edges = _edges;
+        lastUs = _lastUs;
+        maxUs = _maxUs;
+        overBound = _overBound;
+    }
+    port.println("edges,last_us,max_us,bound_us,over_bound");
+    port.print(static_cast<unsigned int>(edges));
+    port.print(",");
+    port.print(static_cast<unsigned int>(lastUs));
+    port.print(",");
+    port.print(static_cast<unsigned int>(maxUs));
+    port.print(",");
+    port.print(static_cast<unsigned int>(LATENCY_BOUND_US));
+    port.print(",");
+    port.println(static_cast<unsigned int>(overBound));
+}
+
+#endif
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../hal/Hal.h"
+
+/**
+ * @file LatencyProbe.h
+ * @brief Input-edge to output-edge latency of the emergency stop interrupt.
+ *
+ * @details Enabled by building with `-DBIOLOGIC_LATENCY_PROBE` (see `env:uno_latency`).
+ *          The emergency stop ISR stamps `micros()` on entry, as the first sign of the
+ *          button edge software can see, and again once the heater and red LED pins
+ *          are written. Every edge is recorded, including presses after the latch, so
+ *          repeated presses build up a worst case to hold against LATENCY_BOUND_US.
+ *
+ *          The stamps leave out the time from the edge to the ISR entry: at most the
+ *          longest stretch with interrupts off, plus the vector dispatch. A scope on the
+ *          button and heater pins measures the whole path.
+ *
+ *          When the flag is not defined, the `LATENCY_*` macros expand to nothing and
+ *          the probe is not compiled at all.
+ */
+
+constexpr uint16_t LATENCY_BOUND_US = 20; // Required of the emergency stop, ISR entry to outputs
+
+#ifdef BIOLOGIC_LATENCY_PROBE
+
+/**
+ * @class LatencyProbe
+ * @brief Static-storage record of the emergency stop latency.
+ */
+class LatencyProbe
+{
+public:
+    /**
+     * @brief Stamps the input edge. Interrupt context.
+     */
+    static void inputEdge() { _edgeUs = Hal::micros(); }
+
+    /**
+     * @brief Stamps the output edge and records the latency since the input edge.
+     *        Interrupt context.
+     */
+    static void outputEdge();
+
+    /**
+     * @brief Writes the record as CSV to the given port.
+     * @details Format: `edges,last_us,max_us,bound_us,over_bound`. The resolution is
+     *          that of `micros()`, 4 us on a 16 MHz Uno.
+     */
+    static void dump(Hal::SerialPort &port);
+
+private:
+    static uint32_t _edgeUs;
+    static uint16_t _edges;
+    static uint16_t _lastUs;
+    static uint16_t _maxUs;
+    static uint16_t _overBound; // Edges slower than LATENCY_BOUND_US
+};
+
+#define LATENCY_INPUT_EDGE() LatencyProbe::inputEdge()
+#define LATENCY_OUTPUT_EDGE() LatencyProbe::outputEdge()
+
+#else
+
+#define LATENCY_INPUT_EDGE() ((void)0)
+#define LATENCY_OUTPUT_EDGE() ((void)0)
+
+#endif
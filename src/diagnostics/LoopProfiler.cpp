@@ -0,0 +1,153 @@
+#include "LoopProfiler.h"
+
+#ifdef BIOLOGIC_PROFILING
+
+// Column labels of the dump, in Profiler::Phase order.
+static const char *const PHASE_NAMES[LoopProfiler::PHASE_COUNT] = {"sensors", "fsm", "display", "actuators", "loop"};
+
+// === STATIC STORAGE ===
+LoopProfiler::Histogram LoopProfiler::_histograms[PHASE_COUNT];
+uint32_t LoopProfiler::_passUs[PHASE_COUNT];
+Profiler::Phase LoopProfiler::_stack[MAX_NESTING];
+uint8_t LoopProfiler::_depth = 0;
+uint32_t LoopProfiler::_markUs = 0;
+uint32_t LoopProfiler::_passStartUs = 0;
+
+// === PASS BOUNDARIES ===
+void LoopProfiler::beginPass()
+{
+    for (uint8_t i = 0; i < PHASE_COUNT; i++)
+    {
+        _passUs[i] = 0;
+    }
+    _depth = 0;
+    _passStartUs = Hal::micros();
+}
+
+void LoopProfiler::endPass()
+{
+    _passUs[static_cast<uint8_t>(Profiler::Phase::LOOP)] = Hal::micros() - _passStartUs;
+    for (uint8_t i = 0; i < PHASE_COUNT; i++)
+    {
+        record(_histograms[i], _passUs[i]);
+    }
+}
+
+// === PHASE NESTING ===
+void LoopProfiler::enter(Profiler::Phase phase)
+{
+    uint32_t now = Hal::micros();
+    if (_depth > 0)
+    {
+        _passUs[static_cast<uint8_t>(_stack[_depth - 1])] += now - _markUs;
+    }
+    if (_depth < MAX_NESTING)
+    {
+        _stack[_depth] = phase;
+    }
+    _depth++;
+    _markUs = now;
+}
+
+void LoopProfiler::exit()
+{
+    uint32_t now = Hal::micros();
+    if (_depth == 0)
+    {
+        return;
+    }
+    _depth--;
+    if (_depth < MAX_NESTING)
+    {
+        _passUs[static_cast<uint8_t>(_stack[_depth])] += now - _markUs;
+    }
+    _markUs = now;
+}
+
+// === HISTOGRAMS ===
+void LoopProfiler::record(Histogram &histogram, uint32_t us)
+{
+    uint8_t bucket = 0;
+    for (uint32_t bound = 8; us >= bound && bucket < BUCKET_COUNT - 1; bound <<= 1)
+    {
+        bucket++;
+    }
+
+    // A saturating bucket halves the whole histogram: the shape (and so the p99) is
+    // preserved while old passes gradually lose weight.
+    if (histogram.buckets[bucket] == UINT16_MAX)
+    {
+        for (uint8_t i = 0; i < BUCKET_COUNT; i++)
+        {
+            histogram.buckets[i] >>= 1;
+        }
+    }
+    histogram.buckets[bucket]++;
+
+    if (histogram.count == 0 || us < histogram.minUs)
+    {
+        histogram.minUs = us;
+    }
+    if (us > histogram.maxUs)
+    {
+        histogram.maxUs = us;
+    }
+    histogram.count++;
+}
+
+uint32_t LoopProfiler::percentile99(const Histogram &histogram)
+{
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < BUCKET_COUNT; i++)
+    {
+        total += histogram.buckets[i];
+    }
+
+    uint32_t target = total - total / 100; // Samples at or below the 99th percentile
+    uint32_t cumulative = 0;
+    for (uint8_t i = 0; i < BUCKET_COUNT; i++)
+    {
+        cumulative += histogram.buckets[i];
+        if (cumulative >= target)
+        {
+            uint32_t upperBound = (8UL << i) - 1;
+            return upperBound < histogram.maxUs ? upperBound : histogram.maxUs;
+        }
+    }
+    return histogram.maxUs;
+}
+
+void LoopProfiler::reset()
+{
+    for (uint8_t i = 0; i < PHASE_COUNT; i++)
+    {
+        _histograms[i] = Histogram{};
+    }
+}
+
+// === EXPORT ===
+void LoopProfiler::dump(Hal::SerialPort &port)
+{
+    port.println("phase,count,min_us,max_us,p99_us,b0,b1,b2,b3,b4,b5,b6,b7,b8,b9,b10,b11,b12,b13,b14,b15");
+    for (uint8_t i = 0; i < PHASE_COUNT; i++)
+    {
+        const Histogram &histogram = _histograms[i];
+        port.print(PHASE_NAMES[i]);
+        port.print(",");
+        port.print(histogram.count);
+        port.print(",");
+        port.print(histogram.minUs);
+        port.print(",");
+        port.print(histogram.maxUs);
+        port.print(",");
+        port.print(percentile99(histogram));
+        for (uint8_t b = 0; b < BUCKET_COUNT; b++)
+        {
+            port.print(",");
+            port.print(histogram.buckets[b]);
+        }
+        port.println();
+    }
+}
+
+#endif
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "../hal/Hal.h"
+
+/**
+ * @file LoopProfiler.h
+ * @brief Per-iteration latency profiler for the main loop.
+ *
+ * @details Enabled by building with `-DBIOLOGIC_PROFILING` (see `env:uno_profile`).
+ *          Every pass of `loop()` is split into phases; each phase accumulates the time
+ *          spent inside it (nested phases are excluded from their parent, so a sensor
+ *          read inside the FSM handler counts as SENSORS, not FSM). At the end of the
+ *          pass the per-phase totals are binned into fixed log2 histograms kept in
+ *          static RAM, from which min/max/p99 are reported.
+ *
+ *          When the flag is not defined, the `PROFILE_*` macros expand to nothing and
+ *          the profiler is not compiled at all.
+ */
+
+#ifdef BIOLOGIC_PROFILING
+
+namespace Profiler
+{
+    /**
+     * @enum Phase
+     * @brief The parts of a loop pass that are timed separately.
+     */
+    enum class Phase : uint8_t
+    {
+        SENSORS,   // ADC conversions and sensor scaling
+        FSM,       // SystemState logic, excluding the nested phases below
+        DISPLAY,   // LCD formatting and I2C traffic
+        ACTUATORS, // Pin writes and siren requests
+        LOOP,      // The whole pass, including glue code not covered by any phase
+        COUNT
+    };
+}
+
+/**
+ * @class LoopProfiler
+ * @brief Static-storage histograms of the time spent in each phase of a loop pass.
+ */
+class LoopProfiler
+{
+public:
+    static constexpr uint8_t PHASE_COUNT = static_cast<uint8_t>(Profiler::Phase::COUNT);
+    static constexpr uint8_t BUCKET_COUNT = 16;   // Bucket 0: < 8 us, bucket i: [2^(i+2), 2^(i+3)) us
+    static constexpr uint8_t MAX_NESTING = 4;
+
+    /**
+     * @brief Marks the start of a loop pass.
+     */
+    static void beginPass();
+
+    /**
+     * @brief Marks the end of a loop pass and records every phase into its histogram.
+     */
+    static void endPass();
+
+    /**
+     * @brief Starts timing a phase, pausing the phase currently being timed (if any).
+     */
+    static void enter(Profiler::Phase phase);
+
+    /**
+     * @brief Stops timing the innermost phase and resumes its parent.
+     */
+    static void exit();
+
+    /**
+     * @brief Writes all histograms as CSV lines to the given port.
+     * @details Format: `phase,count,min_us,max_us,p99_us,b0,...,b15`. The p99 is the
+     *          upper bound of the bucket holding the 99th percentile, clipped to max.
+     */
+    static void dump(Hal::SerialPort &port);
+
+    /**
+     * @brief Clears all histograms.
+     */
+    static void reset();
+
+private:
+    struct Histogram
+    {
+        uint16_t buckets[BUCKET_COUNT];
+        uint32_t count;
+        uint32_t minUs;
+        uint32_t maxUs;
+    };
+
+    static Histogram _histograms[PHASE_COUNT];
+    static uint32_t _passUs[PHASE_COUNT];
+    static Profiler::Phase _stack[MAX_NESTING];
+    static uint8_t _depth;
+    static uint32_t _markUs;
+    static uint32_t _passStartUs;
+
+    static void record(Histogram &histogram, uint32_t us);
+    static uint32_t percentile99(const Histogram &histogram);
+};
+
+/**
+ * @class ProfileScope
+ * @brief RAII helper timing the enclosing block as the given phase.
+ */
+class ProfileScope
+{
+public:
+    explicit ProfileScope(Profiler::Phase phase) { LoopProfiler::enter(phase); }
+    ~ProfileScope() { LoopProfiler::exit(); }
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+#define PROFILE_PHASE(phase) ProfileScope _profileScope(Profiler::Phase::phase)
+#define PROFILE_PASS_BEGIN() LoopProfiler::beginPass()
+#define PROFILE_PASS_END() LoopProfiler::endPass()
+
+#else
+
+#define PROFILE_PHASE(phase) ((void)0)
+#define PROFILE_PASS_BEGIN() ((void)0)
+#define PROFILE_PASS_END() ((void)0)
+
+#endif
@@ -0,0 +1,227 @@
+#include "Telemetry.h"
+#include "../core/SystemState.h"
+#include "../sensors/SensorManager.h"
+#include "../controllers/ActuatorController.h"
+
+namespace
+{
+    constexpr uint8_t RING_MASK = TELEMETRY_RING_SIZE - 1;
+    constexpr uint8_t PACKET_SIZE = TELEMETRY_RECORD_SIZE + TELEMETRY_CRC_SIZE; // Before COBS
+    constexpr uint16_t CRC_INITIAL = 0xFFFF;
+    constexpr uint16_t CRC_POLYNOMIAL = 0x1021;
+    constexpr int32_t INT16_LIMIT = 32767;
+
+    uint16_t crc16(uint16_t crc, uint8_t value)
+    {
+        crc ^= static_cast<uint16_t>(value) << 8;
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ CRC_POLYNOMIAL) : static_cast<uint16_t>(crc << 1);
+        }
+        return crc;
+    }
+
+    int16_t saturate(int32_t value)
+    {
+        if (value > INT16_LIMIT)
+            return INT16_LIMIT;
+        if (value < -INT16_LIMIT)
+            return -INT16_LIMIT;
+        return static_cast<int16_t>(value);
+    }
+
+    uint8_t *put8(uint8_t *out, uint8_t value)
+    {
+        *out = value;
+        return out + 1;
+    }
+
+    uint8_t *put16(uint8_t *out, uint16_t value)
+    {
+        out[0] = static_cast<uint8_t>(value);
+        out[1] = static_cast<uint8_t>(value >> 8);
+        return out + 2;
+    }
+
+    uint8_t *put32(uint8_t *out, uint32_t value)
+    {
+        return put16(put16(out, static_cast<uint16_t>(value)), static_cast<uint16_t>(value >> 16));
+    }
+}
+
+// === CONSTRUCTOR ===
+Telemetry::Telemetry(SystemState &ss, SensorManager &sm, ActuatorController &ac, const Scheduler &scheduler)
+    : systemState(ss),
+      sensorManager(sm),
+      actuatorController(ac),
+      _scheduler(scheduler),
+      _port(nullptr),
+      _enabled(true),
+      _periodMs(TELEMETRY_DEFAULT_PERIOD_MS),
+      _nextRecordMs(0),
+      _sequence(0),
+      _records(0),
+      _dropped(0),
+      _ring{},
+      _head(0),
+      _tail(0)
+{
+}
+
+void Telemetry::begin(Hal::SerialPort &port)
+{
+    _port = &port;
+    _nextRecordMs = Hal::millis();
+}
+
+void Telemetry::registerTasks(Scheduler &scheduler)
+{
+    scheduler.add<Telemetry, &Telemetry::service>(
+        "telem", *this, TELEMETRY_TASK_PERIOD_MS, TELEMETRY_TASK_PHASE_MS, TELEMETRY_TASK_DEADLINE_MS);
+}
+
+void Telemetry::setPeriod(uint16_t periodMs)
+{
+    _periodMs = periodMs < TELEMETRY_MIN_PERIOD_MS ? TELEMETRY_MIN_PERIOD_MS : periodMs;
+}
+
+// === TASK ===
+void Telemetry::service()
+{
+    if (_port == nullptr)
+    {
+        return;
+    }
+    drain();
+
+    uint32_t now = Hal::millis();
+    if (!_enabled || static_cast<int32_t>(now - _nextRecordMs) < 0)
+    {
+        return;
+    }
+    _nextRecordMs += _periodMs;
+    if (static_cast<int32_t>(now - _nextRecordMs) >= 0)
+    {
+        _nextRecordMs = now + _periodMs; // Late by a whole period: do not send a burst
+    }
+
+    if (freeSpace() < TELEMETRY_FRAME_SIZE)
+    {
+        _dropped++;
+        return;
+    }
+    queueFrame(takeRecord());
+    drain();
+}
+
+TelemetryRecord Telemetry::takeRecord()
+{
+    TelemetryRecord record;
+    record.type = TELEMETRY_RECORD_STATUS;
+    record.sequence = _sequence++;
+    record.timeMs = Hal::millis();
+    record.state = static_cast<uint8_t>(systemState.getState());
+    record.temperatureCenti = saturate(TemperatureMath::scaled(sensorManager.getTemperature(), 100));
+    record.estimateCenti = saturate(TemperatureMath::scaled(systemState.getEstimator().temperature(), 100));
+    record.setpointCenti = saturate(TemperatureMath::scaled(sensorManager.getSetpoint(), 100));
+    record.rateMilli = saturate(TemperatureMath::scaled(systemState.getEstimator().rate(), 1000));
+    record.gas = static_cast<uint16_t>(sensorManager.getGasValue());
+    record.heaterDuty = actuatorController.getHeaterDuty();
+    record.outputs = (actuatorController.isHeaterOn() ? TELEMETRY_HEATER_ON : 0) |
+                     (actuatorController.isGreenLedOn() ? TELEMETRY_GREEN_LED_ON : 0) |
+                     (actuatorController.isRedLedOn() ? TELEMETRY_RED_LED_ON : 0) |
+                     (actuatorController.isSirenOn() ? TELEMETRY_SIREN_ON : 0);
+
+    uint32_t overruns = 0;
+    uint16_t maxLateness = 0;
+    uint16_t maxRunUs = 0;
+    for (TaskId id = 0; id < _scheduler.taskCount(); id++)
+    {
+        const TaskStats &stats = _scheduler.taskStats(id);
+        overruns += stats.overruns;
+        maxLateness = stats.maxLatenessTicks > maxLateness ? stats.maxLatenessTicks : maxLateness;
+        maxRunUs = stats.maxRunUs > maxRunUs ? stats.maxRunUs : maxRunUs;
+    }
+    record.overruns = overruns > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(overruns);
+    record.maxLatenessMs = maxLateness * SCHEDULER_TICK_MS;
+    record.maxRunUs = maxRunUs;
+    record.dropped = static_cast<uint16_t>(_dropped);
+    return record;
+}
+
+// === FRAMING ===
+void Telemetry::queueFrame(const TelemetryRecord &record)
+{
+    uint8_t packet[PACKET_SIZE];
+    uint8_t *out = packet;
+    out = put8(out, record.type);
+    out = put8(out, record.sequence);
+    out = put32(out, record.timeMs);
+    out = put8(out, record.state);
+    out = put16(out, static_cast<uint16_t>(record.temperatureCenti));
+    out = put16(out, static_cast<uint16_t>(record.estimateCenti));
+    out = put16(out, static_cast<uint16_t>(record.setpointCenti));
+    out = put16(out, static_cast<uint16_t>(record.rateMilli));
+    out = put16(out, record.gas);
+    out = put8(out, record.heaterDuty);
+    out = put8(out, record.outputs);
+    out = put16(out, record.overruns);
+    out = put16(out, record.maxLatenessMs);
+    out = put16(out, record.maxRunUs);
+    out = put16(out, record.dropped);
+
+    uint16_t crc = CRC_INITIAL;
+    for (uint8_t i = 0; i < TELEMETRY_RECORD_SIZE; i++)
+    {
+        crc = crc16(crc, packet[i]);
+    }
+    put16(out, crc);
+
+    // COBS: each zero is replaced by the distance to the next one, starting with a
+    // code byte in front; the packet is shorter than 254 bytes so one block suffices.
+    uint8_t codeIndex = _head;
+    uint8_t code = 1;
+    _head = (_head + 1) & RING_MASK;
+    for (uint8_t i = 0; i < PACKET_SIZE; i++)
+    {
+        if (packet[i] == 0)
+        {
+            _ring[codeIndex] = code;
+            codeIndex = _head;
+            code = 1;
+        }
+        else
+        {
+            _ring[_head] = packet[i];
+            code++;
+        }
+        _head = (_head + 1) & RING_MASK;
+    }
+    _ring[codeIndex] = code;
+    _ring[_head] = 0; // Frame delimiter
+    _head = (_head + 1) & RING_MASK;
+    _records++;
+}
+
+uint8_t Telemetry::freeSpace() const
+{
+    return RING_MASK - ((_head - _tail) & RING_MASK);
+}
+
+void Telemetry::drain()
+{
+    int room = _port->availableForWrite();
+    while (room > 0 && _tail != _head)
+    {
+        // Up to the write position or the end of the array, whichever comes first
+        uint8_t end = _head > _tail ? _head : TELEMETRY_RING_SIZE;
+        uint8_t count = end - _tail;
+        if (count > room)
+        {
+            count = static_cast<uint8_t>(room);
+        }
+        _port->write(&_ring[_tail], count);
+        _tail = (_tail + count) & RING_MASK;
+        room -= count;
+    }
+}
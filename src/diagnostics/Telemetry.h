@@ -0,0 +1,143 @@
+#pragma once
+
+#include "../hal/Hal.h"
+#include "../core/Scheduler.h"
+
+class SystemState;
+class SensorManager;
+class ActuatorController;
+
+// --- Link ---
+#ifndef BIOLOGIC_SERIAL_BAUD
+#define BIOLOGIC_SERIAL_BAUD 115200 // 250000 and 500000 are exact on a 16 MHz Uno
+#endif
+constexpr uint32_t TELEMETRY_BAUD = BIOLOGIC_SERIAL_BAUD;
+
+// --- Cadence ---
+constexpr uint16_t TELEMETRY_DEFAULT_PERIOD_MS = 100; // About 310 bytes/s, under 3 % of 115200 baud
+constexpr uint16_t TELEMETRY_MIN_PERIOD_MS = 20;
+
+// --- Task (period, phase, deadline in ms) ---
+constexpr uint16_t TELEMETRY_TASK_PERIOD_MS = 5; // Refills the UART buffer before it runs dry at 115200 baud
+constexpr uint16_t TELEMETRY_TASK_PHASE_MS = 1;
+constexpr uint16_t TELEMETRY_TASK_DEADLINE_MS = 5;
+
+// --- Framing ---
+constexpr uint8_t TELEMETRY_RECORD_STATUS = 1; // Record type of TelemetryRecord
+constexpr uint8_t TELEMETRY_RECORD_SIZE = 27;  // Serialized TelemetryRecord
+constexpr uint8_t TELEMETRY_CRC_SIZE = 2;
+constexpr uint8_t TELEMETRY_FRAME_SIZE = TELEMETRY_RECORD_SIZE + TELEMETRY_CRC_SIZE + 2; // COBS overhead and delimiter
+constexpr uint8_t TELEMETRY_RING_SIZE = 64; // Two frames; a power of two
+static_assert((TELEMETRY_RING_SIZE & (TELEMETRY_RING_SIZE - 1)) == 0, "The ring index wraps with a mask");
+
+// --- Output bits of TelemetryRecord::outputs ---
+constexpr uint8_t TELEMETRY_HEATER_ON = 0x01;
+constexpr uint8_t TELEMETRY_GREEN_LED_ON = 0x02;
+constexpr uint8_t TELEMETRY_RED_LED_ON = 0x04;
+constexpr uint8_t TELEMETRY_SIREN_ON = 0x08;
+
+/**
+ * @brief One status snapshot, serialized little endian in this field order.
+ */
+struct TelemetryRecord
+{
+    uint8_t type;                // TELEMETRY_RECORD_STATUS
+    uint8_t sequence;            // Wraps; a gap means lost records
+    uint32_t timeMs;             // Since boot
+    uint8_t state;               // States::Type
+    int16_t temperatureCenti;    // Sensor reading, hundredths of a degree
+    int16_t estimateCenti;       // Estimated chamber temperature
+    int16_t setpointCenti;
+    int16_t rateMilli;           // Estimated rate, thousandths of a degree per second
+    uint16_t gas;                // 0-1023
+    uint8_t heaterDuty;          // Percent
+    uint8_t outputs;             // TELEMETRY_*_ON bits
+    uint16_t overruns;           // Summed over all tasks
+    uint16_t maxLatenessMs;      // Worst over all tasks
+    uint16_t maxRunUs;           // Worst over all tasks
+    uint16_t dropped;            // Records not sent because the link was saturated; wraps
+};
+
+/**
+ * @class Telemetry
+ * @brief Binary status stream over Serial, framed for a host-side decoder.
+ *
+ * @details Every period a TelemetryRecord is serialized, followed by a CRC-16/CCITT
+ *          (polynomial 0x1021, initial value 0xFFFF, little endian), COBS-encoded so the
+ *          frame contains no zero byte, and terminated by a zero. A receiver resyncs on
+ *          the next zero after any corruption, and text printed by the diagnostic
+ *          commands fails the CRC and is skipped.
+ *
+ *          Frames go into a small RAM ring that the task drains into the UART buffer
+ *          only as far as `availableForWrite()` allows, so a write never waits for the
+ *          line. When the ring has no room for a whole frame the record is dropped and
+ *          counted: the next one carries fresher values anyway.
+ *          `tools/telemetry_decode.py` turns the stream into CSV.
+ */
+class Telemetry
+{
+public:
+    /**
+     * @brief Constructs the stream.
+     * @param ss The FSM, for the state and the estimator.
+     * @param sm The sensors.
+     * @param ac The actuators.
+     * @param scheduler The task table, for the loop statistics.
+     */
+    Telemetry(SystemState &ss, SensorManager &sm, ActuatorController &ac, const Scheduler &scheduler);
+
+    /**
+     * @brief Sets the output port. The port must already be open.
+     */
+    void begin(Hal::SerialPort &port);
+
+    /**
+     * @brief Adds the telemetry task to the scheduler.
+     */
+    void registerTasks(Scheduler &scheduler);
+
+    /**
+     * @brief Sets the time between two records.
+     * @param periodMs At least TELEMETRY_MIN_PERIOD_MS.
+     */
+    void setPeriod(uint16_t periodMs);
+
+    /**
+     * @brief Starts or stops the stream. Frames already queued are still sent.
+     */
+    void setEnabled(bool enabled) { _enabled = enabled; }
+    bool isEnabled() const { return _enabled; }
+
+    uint32_t getRecordCount() const { return _records; }
+    uint32_t getDroppedCount() const { return _dropped; }
+
+    /**
+     * @brief The telemetry task: drains the ring, then queues a record when one is due.
+     */
+    void service();
+
+private:
+    // --- Component References ---
+    SystemState &systemState;
+    SensorManager &sensorManager;
+    ActuatorController &actuatorController;
+    const Scheduler &_scheduler;
+
+    Hal::SerialPort *_port; // Null before begin()
+    bool _enabled;
+    uint16_t _periodMs;
+    uint32_t _nextRecordMs;
+    uint8_t _sequence;
+    uint32_t _records;
+    uint32_t _dropped;
+
+    // --- TX ring ---
+    uint8_t _ring[TELEMETRY_RING_SIZE];
+    uint8_t _head; // Next byte to queue
+    uint8_t _tail; // Next byte to send
+
+    TelemetryRecord takeRecord();
+    void queueFrame(const TelemetryRecord &record);
+    void drain();
+    uint8_t freeSpace() const;
+};
@@ -1,7 +1,37 @@
 #include "DisplayManager.h"
+#include "../diagnostics/LoopProfiler.h"
+
+#include <string.h>
+
+// PCF8574 pin assignment of the common LCD backpack (same as LiquidCrystal_I2C)
+constexpr uint8_t EXPANDER_RS = 0x01;
+constexpr uint8_t EXPANDER_EN = 0x04;
+constexpr uint8_t EXPANDER_BACKLIGHT = 0x08;
+
+// HD44780 instruction and DDRAM layout
+constexpr uint8_t LCD_SET_DDRAM_ADDR = 0x80;
+constexpr uint8_t LCD_ROW_OFFSETS[DISPLAY_ROWS] = {0x00, 0x40};
+
+// Status screen layout
+constexpr uint8_t STATE_LABEL_COLS = 9;  // The state label is cut to leave room for the gas value
+constexpr uint8_t GAS_TEXT_CAPACITY = 8; // "G:" and up to 5 digits
+
+// Heater screen layout
+constexpr uint8_t HEATER_DUTY_END_COL = 9; // Last digit of the duty, before the '%'
+constexpr uint8_t HEATER_LAW_COL = 12;
 
 DisplayManager::DisplayManager(uint8_t i2cAddr, uint8_t cols, uint8_t rows)
-    : _lcd(i2cAddr, cols, rows)
+    : _lcd(i2cAddr, cols, rows),
+      _i2cAddr(i2cAddr),
+      _cols(cols < DISPLAY_COLS ? cols : DISPLAY_COLS),
+      _rows(rows < DISPLAY_ROWS ? rows : DISPLAY_ROWS),
+      _queueHead(0),
+      _queueCount(0),
+      _cursorRow(0),
+      _cursorCol(0),
+      _cursorValid(false),
+      _scheduler(nullptr),
+      _serviceTask(SCHEDULER_NO_TASK)
 {}
 
 void DisplayManager::begin()
@@ -10,8 +40,25 @@ void DisplayManager::begin()
     _lcd.init();
     // Turn on the backlight to make the text visible
     _lcd.backlight();
-    // Clear any leftover characters from a previous run
+    // Clear any leftover characters from a previous run. This is the only hardware
+    // clear: from now on the shadow copy tells us exactly what the glass shows.
     _lcd.clear();
+    memset(_frame, ' ', sizeof(_frame));
+    memset(_shown, ' ', sizeof(_shown));
+
+    // The library initialization above is blocking but happens once; every later
+    // write goes through the nibble queue.
+    Hal::i2cSetClock(DISPLAY_I2C_CLOCK_HZ);
+    _queueHead = 0;
+    _queueCount = 0;
+    _cursorValid = false;
+}
+
+void DisplayManager::registerTasks(Scheduler &scheduler)
+{
+    _scheduler = &scheduler;
+    _serviceTask = scheduler.add<DisplayManager, &DisplayManager::serviceTask>(
+        "display", *this, DISPLAY_TASK_PERIOD_MS, 0, DISPLAY_TASK_DEADLINE_MS);
 }
 
 /**
@@ -19,57 +66,275 @@ void DisplayManager::begin()
  */
 void DisplayManager::clear()
 {
-    _lcd.clear();
+    memset(_frame, ' ', sizeof(_frame));
+    wake();
 }
 
 void DisplayManager::print(const String &line1, const String &line2)
 {
-    // Clear the screen first to prevent text from overlapping
-    _lcd.clear();
+    PROFILE_PHASE(DISPLAY);
+    // Each line is padded with blanks, which overwrites any previous text
+    renderLine(0, line1.c_str());
+    renderLine(1, line2.c_str());
+}
 
-    // Set the cursor to the beginning of the first line (column 0, row 0)
-    _lcd.setCursor(0, 0);
-    _lcd.print(line1);
+void DisplayManager::displayStatus(const char *state, Temperature currentTemp, Temperature setpoint, int gasValue)
+{
+    PROFILE_PHASE(DISPLAY);
+    renderStatus('\0', state, currentTemp, setpoint, gasValue);
+}
 
-    // Set the cursor to the beginning of the second line (column 0, row 1)
-    _lcd.setCursor(0, 1);
-    _lcd.print(line2);
+void DisplayManager::displayChamberStatus(uint8_t chamber, const char *state, Temperature currentTemp,
+                                          Temperature setpoint, int gasValue)
+{
+    PROFILE_PHASE(DISPLAY);
+    char tag = chamber < 9 ? static_cast<char>('1' + chamber) : static_cast<char>('A' + chamber - 9);
+    renderStatus(tag, state, currentTemp, setpoint, gasValue);
 }
 
-void DisplayManager::displayStatus(String state, float currentTemp, float setpoint, int gasValue)
+void DisplayManager::displayProgress(const char *state, uint8_t done, uint8_t total, Temperature currentTemp,
+                                     Temperature setpoint, int gasValue)
 {
-    _lcd.clear();
+    PROFILE_PHASE(DISPLAY);
+    renderStatus('\0', state, currentTemp, setpoint, gasValue);
 
+    // After the label, which short labels leave room for: " 2/5"
+    char label[STATE_LABEL_COLS];
+    uint8_t length = copyFlash(label, state, STATE_LABEL_COLS);
+    char progress[] = {' ', static_cast<char>('0' + done), '/', static_cast<char>('0' + total), '\0'};
+    renderText(length, 1, progress);
+}
+
+void DisplayManager::renderStatus(char tag, const char *state, Temperature currentTemp, Temperature setpoint,
+                                  int gasValue)
+{
     // --- First Line: Temperature and Setpoint ---
-    _lcd.setCursor(0, 0);
-    // String(float, precision) approximate the float with precision decimal palces
-    String tempStr = "T:" + String(currentTemp, 1); // Format temperature to 1 decimal place
-    String setpointStr = "S:" + String(setpoint, 1); // Format setpoint to 1 decimal place
-    _lcd.print(tempStr + " " + setpointStr);
+    // Both values are formatted to 1 decimal place with integer arithmetic only
+    char line[DISPLAY_COLS + 1];
+    char *cursor = line;
+    *cursor++ = 'T';
+    *cursor++ = ':';
+    cursor = TemperatureMath::format(cursor, currentTemp);
+    *cursor++ = ' ';
+    *cursor++ = 'S';
+    *cursor++ = ':';
+    TemperatureMath::format(cursor, setpoint);
+    renderLine(0, line);
 
     // --- Second Line: System State and Gas Value ---
-    _lcd.setCursor(0, 1);
-    String stateStr = state;
-    // Truncate the state string if it's too long to fit
-    if (stateStr.length() > 9)
+    // Truncate the state label (and its chamber tag) if it's too long to fit
+    uint8_t length = 0;
+    if (tag != '\0')
     {
-        stateStr = stateStr.substring(0, 9);
+        line[length++] = tag;
+        line[length++] = ':';
     }
-    _lcd.print(stateStr);
+    length += copyFlash(line + length, state, STATE_LABEL_COLS - length);
+    line[length] = '\0';
+    renderLine(1, line);
 
-    // Format the gas value string
-    String gasStr = "G:" + String(gasValue);
-    // Calculate the starting position to right-align the text
-    int gasCursorPos = 16 - gasStr.length();
-    _lcd.setCursor(gasCursorPos, 1);
-    _lcd.print(gasStr);
+    // Format the gas value right to left, then right-align it
+    char gasText[GAS_TEXT_CAPACITY];
+    char *start = gasText + sizeof(gasText) - 1;
+    *start = '\0';
+    unsigned int value = gasValue < 0 ? 0 : gasValue;
+    do
+    {
+        *--start = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    *--start = ':';
+    *--start = 'G';
+    int gasCursorPos = _cols - static_cast<int>(gasText + sizeof(gasText) - 1 - start);
+    renderText(gasCursorPos, 1, start);
 }
 
-void DisplayManager::displayEmergency(const String &message)
+void DisplayManager::displayHeater(uint8_t duty, bool predictive, Temperature ratePerMinute)
 {
-    _lcd.clear();
-    _lcd.setCursor(0, 0);
-    _lcd.print("!EMERGENCY STOP!");
-    _lcd.setCursor(0, 1);
-    _lcd.print(message); // Print the emergency message on the second line
-}
\ No newline at end of file
+    PROFILE_PHASE(DISPLAY);
+
+    // --- First Line: Duty, right-aligned in 3 digits, and the control law ---
+    char line[DISPLAY_COLS + 1] = "HEATER   0% PID";
+    uint8_t col = HEATER_DUTY_END_COL;
+    do
+    {
+        line[col--] = static_cast<char>('0' + duty % 10);
+        duty /= 10;
+    } while (duty > 0);
+    if (predictive)
+    {
+        memcpy(&line[HEATER_LAW_COL], "MPC", 3);
+    }
+    renderLine(0, line);
+
+    // --- Second Line: Estimated warming rate ---
+    char *cursor = line;
+    memcpy(cursor, "RATE ", 5);
+    cursor = TemperatureMath::format(cursor + 5, ratePerMinute);
+    memcpy(cursor, "C/MIN", 6);
+    renderLine(1, line);
+}
+
+void DisplayManager::displayEmergency(const char *message)
+{
+    PROFILE_PHASE(DISPLAY);
+    dropQueue(); // The old screen's cells would only delay this one
+    renderLine(0, "!EMERGENCY STOP!");
+    renderFlashLine(1, message); // Print the emergency message on the second line
+}
+
+// === FRAMEBUFFER ===
+void DisplayManager::renderLine(uint8_t row, const char *text, uint8_t maxLength)
+{
+    if (row >= _rows)
+    {
+        return;
+    }
+    uint8_t col = 0;
+    while (col < _cols && col < maxLength && text[col] != '\0')
+    {
+        _frame[row][col] = text[col];
+        col++;
+    }
+    memset(&_frame[row][col], ' ', _cols - col);
+    wake();
+}
+
+void DisplayManager::renderFlashLine(uint8_t row, const char *text, uint8_t maxLength)
+{
+    char line[DISPLAY_COLS + 1];
+    uint8_t length = copyFlash(line, text, maxLength < DISPLAY_COLS ? maxLength : DISPLAY_COLS);
+    line[length] = '\0';
+    renderLine(row, line);
+}
+
+uint8_t DisplayManager::copyFlash(char *out, const char *text, uint8_t maxLength)
+{
+    uint8_t length = 0;
+    while (length < maxLength && (out[length] = pgm_read_byte(&text[length])) != '\0')
+    {
+        length++;
+    }
+    return length;
+}
+
+void DisplayManager::renderText(uint8_t col, uint8_t row, const char *text)
+{
+    if (row >= _rows)
+    {
+        return;
+    }
+    while (col < _cols && *text != '\0')
+    {
+        _frame[row][col++] = *text++;
+    }
+    wake();
+}
+
+void DisplayManager::wake()
+{
+    if (_scheduler != nullptr && _serviceTask != SCHEDULER_NO_TASK)
+    {
+        _scheduler->resume(_serviceTask);
+    }
+}
+
+bool DisplayManager::isIdle() const
+{
+    return _queueCount == 0 && memcmp(_frame, _shown, sizeof(_frame)) == 0;
+}
+
+// === ASYNCHRONOUS FLUSH ===
+void DisplayManager::service(uint16_t budgetUs)
+{
+    PROFILE_PHASE(DISPLAY);
+    unsigned long start = Hal::micros();
+    do
+    {
+        if (_queueCount == 0 && !fillQueue())
+        {
+            return;
+        }
+        sendNextNibble();
+    } while (Hal::micros() - start < budgetUs);
+}
+
+void DisplayManager::serviceTask()
+{
+    service();
+    if (isIdle())
+    {
+        _scheduler->suspend(_serviceTask);
+    }
+}
+
+bool DisplayManager::fillQueue()
+{
+    bool queued = false;
+    for (uint8_t row = 0; row < _rows; row++)
+    {
+        for (uint8_t col = 0; col < _cols; col++)
+        {
+            if (_frame[row][col] == _shown[row][col])
+            {
+                continue;
+            }
+            // Worst case for one cell: a cursor move plus the character, two nibbles each.
+            if (DISPLAY_QUEUE_CAPACITY - _queueCount < 4)
+            {
+                return queued;
+            }
+            // The HD44780 advances its address after every character, so a cursor move
+            // is only needed when this cell is not the one right after the last written.
+            if (!_cursorValid || _cursorRow != row || _cursorCol != col)
+            {
+                enqueueByte(false, LCD_SET_DDRAM_ADDR | (LCD_ROW_OFFSETS[row] + col));
+                _cursorRow = row;
+                _cursorCol = col;
+                _cursorValid = true;
+            }
+            enqueueByte(true, static_cast<uint8_t>(_frame[row][col]));
+            _shown[row][col] = _frame[row][col];
+            _cursorCol++;
+            queued = true;
+        }
+    }
+    return queued;
+}
+
+void DisplayManager::dropQueue()
+{
+    // Nibbles go out in pairs: an odd count means the head is the low half of a byte
+    // the HD44780 has begun, and it must follow or every later byte would be misread.
+    uint8_t keep = _queueCount & 1;
+    if (_queueCount == keep)
+    {
+        return;
+    }
+    _queueCount = keep;
+    // No frame cell is ever '\0', so every cell differs and is queued again.
+    memset(_shown, '\0', sizeof(_shown));
+    _cursorValid = false;
+}
+
+void DisplayManager::enqueueByte(bool isData, uint8_t value)
+{
+    uint8_t flags = EXPANDER_BACKLIGHT | (isData ? EXPANDER_RS : 0);
+    uint8_t tail = (_queueHead + _queueCount) & (DISPLAY_QUEUE_CAPACITY - 1);
+    _queue[tail] = (value & 0xF0) | flags;
+    tail = (tail + 1) & (DISPLAY_QUEUE_CAPACITY - 1);
+    _queue[tail] = static_cast<uint8_t>(value << 4) | flags;
+    _queueCount += 2;
+}
+
+void DisplayManager::sendNextNibble()
+{
+    uint8_t pins = _queue[_queueHead];
+    _queueHead = (_queueHead + 1) & (DISPLAY_QUEUE_CAPACITY - 1);
+    _queueCount--;
+
+    // Data and RS settle first, then the falling edge of EN latches the nibble.
+    // The HD44780 needs 37 us per instruction, far less than one I2C transaction.
+    const uint8_t sequence[] = {pins, static_cast<uint8_t>(pins | EXPANDER_EN), pins};
+    Hal::i2cWrite(_i2cAddr, sequence, sizeof(sequence));
+}
@@ -1,7 +1,18 @@
 #pragma once
 
-#include <Arduino.h>
-#include <LiquidCrystal_I2C.h>
+#include "../hal/Hal.h"
+#include "../core/Temperature.h"
+#include "../core/Scheduler.h"
+
+constexpr uint8_t DISPLAY_COLS = 16; // Width of the shadow framebuffer
+constexpr uint8_t DISPLAY_ROWS = 2;  // Height of the shadow framebuffer
+constexpr uint8_t DISPLAY_QUEUE_CAPACITY = 16;        // Pending nibble writes (power of two)
+constexpr uint16_t DISPLAY_SERVICE_BUDGET_US = 500;   // Default bus time granted per service() call
+constexpr uint32_t DISPLAY_I2C_CLOCK_HZ = 100000;     // PCF8574 is specified up to 100 kHz
+constexpr uint16_t DISPLAY_TASK_PERIOD_MS = 1;        // service() runs on every tick while there is work
+constexpr uint16_t DISPLAY_TASK_DEADLINE_MS = 1;
+constexpr uint8_t DISPLAY_NO_PROGRESS = 0xFF;         // No progress to show after the state label
+static_assert((DISPLAY_QUEUE_CAPACITY & (DISPLAY_QUEUE_CAPACITY - 1)) == 0, "Queue capacity must be a power of two");
 
 /**
  * @class DisplayManager
@@ -12,6 +23,16 @@
  *          clean, high-level interface for other parts of the firmware to print
  *          status messages, sensor data, and alerts without needing to know
  *          about cursor positions or I2C addresses.
+ *
+ *          All drawing goes into a RAM framebuffer first and returns immediately.
+ *          `service()`, run by a scheduler task on every tick, compares the framebuffer with a
+ *          shadow copy of what the LCD shows, turns the changed cells into HD44780 nibble
+ *          writes in a small bounded queue, and sends them to the PCF8574 one I2C
+ *          transaction at a time until its microsecond budget is spent. A status update
+ *          therefore never holds up the control logic: it trickles out over the next
+ *          few ticks. The task suspends itself once the LCD is up to date and drawing
+ *          resumes it. Because cells are only queued when the bus is ready for them,
+ *          content that is redrawn before it was sent is simply superseded.
  */
 class DisplayManager
 {
@@ -36,8 +57,14 @@ public:
      */
     void begin();
 
+    /**
+     * @brief Adds the LCD service task to the scheduler.
+     */
+    void registerTasks(Scheduler &scheduler);
+
     /**
      * @brief Clears all content from the LCD screen.
+     * @details Blanks the framebuffer; no (slow) hardware clear is issued.
      */
     void clear();
 
@@ -60,27 +87,161 @@ public:
      *          and gas sensor reading. It handles formatting, truncation, and
      *          alignment to fit neatly on the 16x2 display.
      *
-     * @param state A string representing the current system state (e.g., "MAINTAINING").
+     * @param state The label of the current system state (e.g., "MAINTAINING"), in flash.
      * @param currentTemp The current measured temperature.
      * @param setpoint The target temperature set by the user.
      * @param gasValue The value from the gas sensor.
      */
-    void displayStatus(String state, float currentTemp, float setpoint, int gasValue);
+    void displayStatus(const char *state, Temperature currentTemp, Temperature setpoint, int gasValue);
+
+    /**
+     * @brief Same as `displayStatus()` for one chamber of a multi-chamber controller.
+     * @details The state label is prefixed with the chamber's number, from 1 ('1:PREHEAT');
+     *          chambers past the ninth are numbered 'A', 'B' and so on.
+     *
+     * @param chamber The chamber index, from 0.
+     */
+    void displayChamberStatus(uint8_t chamber, const char *state, Temperature currentTemp, Temperature setpoint,
+                              int gasValue);
+
+    /**
+     * @brief Same as `displayStatus()`, with the progress of a long operation after the
+     *        state label ('TUNE 2/5').
+     *
+     * @param done Steps done, 0 to 9.
+     * @param total Steps in all, 1 to 9.
+     */
+    void displayProgress(const char *state, uint8_t done, uint8_t total, Temperature currentTemp,
+                         Temperature setpoint, int gasValue);
+
+    /**
+     * @brief Displays the heater screen, paged to with the acknowledge button.
+     *
+     * @details 'HEATER  45% MPC' over 'RATE 1.8C/MIN': the duty in the heater's PWM
+     *          window, the control law (MPC for the predictive one, PID) and the
+     *          estimated warming rate.
+     *
+     * @param duty The heater duty, in percent.
+     * @param predictive True if the predictive control law is in use.
+     * @param ratePerMinute The estimated warming rate, per minute.
+     */
+    void displayHeater(uint8_t duty, bool predictive, Temperature ratePerMinute);
 
     /**
      * @brief Displays a critical emergency message, overriding any other content.
      *
-     * @param message A short message describing the reason for the emergency state.
+     * @details The writes still queued for the previous screen are dropped, so the
+     *          emergency screen is the next thing sent to the LCD.
+     *
+     * @param message A short message describing the reason for the emergency state, in flash.
+     */
+    void displayEmergency(const char *message);
+
+    /**
+     * @brief Sends pending changes to the LCD, within a bus-time budget.
+     *
+     * @details Runs from the display task while changes are pending. Each I2C transaction
+     *          carries one nibble; at least one is sent per call so the display always
+     *          makes progress. Cursor moves are issued only when the next changed cell is
+     *          not adjacent to the last one written.
+     *
+     * @param budgetUs Bus time (in microseconds) this call may use.
+     */
+    void service(uint16_t budgetUs = DISPLAY_SERVICE_BUDGET_US);
+
+    /**
+     * @brief Returns true when the LCD shows exactly the framebuffer contents.
      */
-    void displayEmergency(const String &message);
+    bool isIdle() const;
 
 private:
     // --- Member Variables ---
 
     /**
-     * @brief The instance of the LiquidCrystal_I2C library.
+     * @brief The LCD driver (the LiquidCrystal_I2C library on the target).
      * @details This private member variable is the actual object that communicates
      *          with the physical LCD hardware.
      */
-    LiquidCrystal_I2C _lcd;
+    Hal::Lcd _lcd;
+
+    uint8_t _i2cAddr;
+    uint8_t _cols; // Usable columns (at most DISPLAY_COLS)
+    uint8_t _rows; // Usable rows (at most DISPLAY_ROWS)
+
+    char _frame[DISPLAY_ROWS][DISPLAY_COLS]; // What the screen should show
+    char _shown[DISPLAY_ROWS][DISPLAY_COLS]; // What the screen shows once the queue drains
+
+    // Pending expander writes: one entry per nibble, already carrying RS and backlight
+    uint8_t _queue[DISPLAY_QUEUE_CAPACITY];
+    uint8_t _queueHead;
+    uint8_t _queueCount;
+
+    // HD44780 address counter after the last queued byte
+    uint8_t _cursorRow;
+    uint8_t _cursorCol;
+    bool _cursorValid;
+
+    Scheduler *_scheduler; // Set by registerTasks()
+    TaskId _serviceTask;
+
+    /**
+     * @brief The display task: services the LCD and suspends itself once idle.
+     */
+    void serviceTask();
+
+    /**
+     * @brief Resumes the display task after the framebuffer has been drawn into.
+     */
+    void wake();
+
+    /**
+     * @brief Queues the next changed cells, as long as the queue can hold a cursor
+     *        move plus a character.
+     * @return true if anything was queued.
+     */
+    bool fillQueue();
+
+    /**
+     * @brief Drops the queued writes, except the second half of a byte already begun.
+     * @details The cells they carried are no longer known to be on the LCD, so the
+     *          whole shadow copy is invalidated and the framebuffer is sent again.
+     */
+    void dropQueue();
+
+    /**
+     * @brief Queues one HD44780 byte as two nibble writes.
+     */
+    void enqueueByte(bool isData, uint8_t value);
+
+    /**
+     * @brief Sends the oldest queued nibble to the expander, toggling EN around it.
+     */
+    void sendNextNibble();
+
+    /**
+     * @brief Draws the status screen, with a chamber tag before the label unless `tag` is '\0'.
+     */
+    void renderStatus(char tag, const char *state, Temperature currentTemp, Temperature setpoint, int gasValue);
+
+    /**
+     * @brief Writes a whole row into the framebuffer, padding it with blanks.
+     * @param maxLength Characters of text beyond this length are dropped.
+     */
+    void renderLine(uint8_t row, const char *text, uint8_t maxLength = DISPLAY_COLS);
+
+    /**
+     * @brief Same as `renderLine()`, for text stored in flash.
+     */
+    void renderFlashLine(uint8_t row, const char *text, uint8_t maxLength = DISPLAY_COLS);
+
+    /**
+     * @brief Copies at most `maxLength` characters of a flash string to `out`.
+     * @return The number of characters copied; `out` is not terminated.
+     */
+    static uint8_t copyFlash(char *out, const char *text, uint8_t maxLength);
+
+    /**
+     * @brief Writes text into the framebuffer at the given position, clipped to the row.
+     */
+    void renderText(uint8_t col, uint8_t row, const char *text);
 };
\ No newline at end of file
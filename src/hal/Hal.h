@@ -0,0 +1,363 @@
+#pragma once
+
+/**
+ * @file Hal.h
+ * @brief Hardware Abstraction Layer used by every firmware module.
+ *
+ * @details The core classes (`SensorManager`, `ActuatorController`, `DisplayManager`
+ *          and `SystemState`) never talk to the Arduino core directly: every pin,
+ *          clock, timer and LCD access goes through the `Hal` namespace.
+ *
+ *          - On the Arduino target (`ARDUINO` defined) every function is an inline
+ *            forward to the Arduino core and `Hal::Lcd` is the `LiquidCrystal_I2C`
+ *            class itself, so the abstraction costs neither flash nor cycles.
+ *          - On the native (host) target the same calls are routed to a simulated
+ *            board implementing `NativeBoard` (see `hal/native/`), which lets the
+ *            unmodified core run against the chamber simulator in `sim/`.
+ */
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <LiquidCrystal_I2C.h>
+#include <Wire.h>
+#include <avr/eeprom.h>
+#include <avr/wdt.h>
+#else
+#include "native/NativeArduino.h"
+#endif
+
+/**
+ * @brief Places a variable in RAM the C runtime leaves alone at start-up, so its value
+ *        survives a watchdog reset (it is random after a power-up). No-op on the host.
+ */
+#ifdef ARDUINO
+#define HAL_NOINIT __attribute__((section(".noinit")))
+#else
+#define HAL_NOINIT
+#endif
+
+namespace Hal
+{
+    /**
+     * @brief Handler invoked from the ADC conversion-complete interrupt.
+     * @param raw The 10-bit conversion result.
+     */
+    using AdcHandler = void (*)(uint16_t raw);
+
+    /**
+     * @brief Handler invoked from the periodic tick interrupt.
+     */
+    using TickHandler = void (*)();
+
+    /**
+     * @brief Handler invoked from the tone timer interrupt, after each pin toggle.
+     */
+    using ToneHandler = void (*)();
+
+    /**
+     * @brief Handler invoked from the watchdog interrupt, one period before the reset.
+     */
+    using WatchdogHandler = void (*)();
+
+    /**
+     * @brief Handler invoked from the pin-change interrupt.
+     * @param level The level of the pin after the change.
+     */
+    using PinChangeHandler = void (*)(bool level);
+
+    constexpr uint16_t TICK_PERIOD_US = 1000;       // Period of the tick interrupt
+    constexpr uint32_t TONE_TIMER_CLOCK_HZ = 250000; // Tone timer clock (16 MHz / 64)
+    constexpr uint16_t EEPROM_SIZE = 1024;            // ATmega328P EEPROM, in bytes
+    constexpr uint16_t WATCHDOG_TIMEOUT_MS = 250;     // Watchdog period, from its 128 kHz oscillator
+    constexpr uint16_t WATCHDOG_EXPIRE_MS = 16;       // Shortest watchdog period, used by watchdogExpire()
+
+#ifdef ARDUINO
+
+    /**
+     * @brief The LCD driver. On the target it is the real I2C library class.
+     */
+    using Lcd = LiquidCrystal_I2C;
+
+    /**
+     * @brief The serial port. On the target it is the hardware UART driver.
+     */
+    using SerialPort = HardwareSerial;
+    inline SerialPort &serial() { return Serial; }
+
+    inline void pinMode(uint8_t pin, uint8_t mode) { ::pinMode(pin, mode); }
+    inline void digitalWrite(uint8_t pin, bool level) { ::digitalWrite(pin, level ? HIGH : LOW); }
+    inline bool digitalRead(uint8_t pin) { return ::digitalRead(pin) == HIGH; }
+    inline int analogRead(uint8_t pin) { return ::analogRead(pin); }
+    inline unsigned long millis() { return ::millis(); }
+    inline unsigned long micros() { return ::micros(); }
+
+    /**
+     * @brief Sends one I2C write transaction (blocking for its duration on the bus).
+     */
+    inline void i2cWrite(uint8_t address, const uint8_t *data, uint8_t length)
+    {
+        Wire.beginTransmission(address);
+        Wire.write(data, length);
+        Wire.endTransmission();
+    }
+    inline void i2cSetClock(uint32_t hz) { Wire.setClock(hz); }
+
+    inline void delayMicroseconds(unsigned int us) { ::delayMicroseconds(us); }
+
+    /**
+     * @brief Enables the ADC in interrupt mode (125 kHz ADC clock, AVcc reference).
+     * @details From now on every conversion started with `adcStart()` ends with a call
+     *          to `onComplete` from interrupt context. `analogRead()` must not be used.
+     */
+    void adcBegin(AdcHandler onComplete);
+
+    /**
+     * @brief Starts one conversion on an analog pin. Safe to call from the ADC handler.
+     */
+    inline void adcStart(uint8_t pin)
+    {
+        uint8_t channel = pin >= A0 ? pin - A0 : pin;
+#ifdef MUX5
+        // Channels 8-15 of the larger AVRs (Mega)
+        ADCSRB = (ADCSRB & ~_BV(MUX5)) | ((channel & 0x08) ? _BV(MUX5) : 0);
+#endif
+        ADMUX = _BV(REFS0) | (channel & 0x07);
+        ADCSRA |= _BV(ADSC);
+    }
+
+    /**
+     * @brief Makes a pin an input with its pull-up, and calls `onChange` from the
+     *        pin-change interrupt on every level change, bounces included.
+     * @details Any digital pin can be watched; the CPU does nothing until it changes.
+     * @attention Only one pin may be watched, since its handler serves every
+     *            pin-change vector.
+     */
+    void pinChangeBegin(uint8_t pin, PinChangeHandler onChange);
+
+    /**
+     * @brief Starts the 1 ms tick interrupt (Timer1 in CTC mode).
+     * @details Timer0 keeps serving `millis()`/`micros()`.
+     */
+    void tickBegin(TickHandler onTick);
+
+    /**
+     * @brief Binds the tone timer (Timer2 in CTC mode) to an output pin.
+     * @details While running, the timer interrupt toggles the pin every `compare + 1`
+     *          timer clocks, i.e. at TONE_TIMER_CLOCK_HZ / (2 * (compare + 1)) Hz, then
+     *          calls `onToggle`. Replaces the Arduino `tone()`, which must not be used.
+     */
+    void toneTimerBegin(uint8_t pin, ToneHandler onToggle);
+
+    /**
+     * @brief Starts toggling the pin, from a low level.
+     */
+    void toneTimerStart(uint8_t compare);
+
+    /**
+     * @brief Changes the toggle period. Meant to be called from the tone handler.
+     */
+    inline void toneTimerSetCompare(uint8_t compare) { OCR2A = compare; }
+
+    /**
+     * @brief Stops the timer and drives the pin low.
+     */
+    void toneTimerStop();
+
+    /**
+     * @brief Reads one EEPROM byte.
+     */
+    inline uint8_t eepromRead(uint16_t address) { return eeprom_read_byte(reinterpret_cast<const uint8_t *>(address)); }
+
+    /**
+     * @brief Returns true when no EEPROM write is in progress.
+     */
+    inline bool eepromReady() { return eeprom_is_ready(); }
+
+    /**
+     * @brief Starts writing one EEPROM byte; the write completes in the background (3.4 ms).
+     * @details Waits for the previous write to finish first: callers that must not
+     *          block check `eepromReady()` before calling.
+     */
+    inline void eepromWrite(uint16_t address, uint8_t value) { eeprom_write_byte(reinterpret_cast<uint8_t *>(address), value); }
+
+    /**
+     * @brief Starts the hardware watchdog in interrupt-and-reset mode.
+     * @details WATCHDOG_TIMEOUT_MS without `watchdogReset()` calls `onTimeout` from the
+     *          watchdog interrupt; the MCU resets one period later, whether the handler
+     *          returns or not, and even if interrupts stay disabled.
+     */
+    void watchdogBegin(WatchdogHandler onTimeout);
+
+    /**
+     * @brief Restarts the watchdog period.
+     */
+    inline void watchdogReset() { wdt_reset(); }
+
+    /**
+     * @brief Resets the MCU within WATCHDOG_EXPIRE_MS, with interrupts disabled until
+     *        then. Never returns on the target; the native board records the reset and
+     *        returns.
+     */
+    void watchdogExpire();
+
+    /**
+     * @brief Sleeps (idle mode) until the next interrupt has been serviced.
+     * @details Must be called with interrupts disabled: they are re-enabled atomically
+     *          with the sleep instruction, so an interrupt that became pending after the
+     *          caller's last check still wakes the CPU, and they are disabled again on
+     *          return. Timers, ADC and UART keep running while asleep.
+     * @param maxUs Upper bound of the sleep. The MCU wakes at the first interrupt anyway;
+     *              the native board uses the bound to jump its clock forward.
+     */
+    void idle(uint32_t maxUs);
+
+    /**
+     * @class InterruptLock
+     * @brief Disables interrupts for its lifetime, restoring the previous state.
+     */
+    class InterruptLock
+    {
+    public:
+        InterruptLock() : _sreg(SREG) { cli(); }
+        ~InterruptLock() { SREG = _sreg; }
+
+    private:
+        uint8_t _sreg;
+    };
+
+    /**
+     * @brief A digital output resolved once to its PORT register and bit.
+     */
+    struct FastPin
+    {
+        volatile uint8_t *port;
+        uint8_t mask;
+    };
+
+    /**
+     * @brief Resolves an output pin, so later writes skip the pin table lookups of
+     *        `digitalWrite()`. The pin must not be used for PWM.
+     */
+    inline FastPin fastPin(uint8_t pin) { return {portOutputRegister(digitalPinToPort(pin)), digitalPinToBitMask(pin)}; }
+
+    /**
+     * @brief Drives a resolved output with a direct PORT write, a few cycles.
+     * @details The read-modify-write runs with interrupts off: other bits of the port
+     *          may be driven from interrupts (the tone timer toggles the piezo pin).
+     */
+    inline void fastWrite(const FastPin &pin, bool level)
+    {
+        InterruptLock lock;
+        if (level)
+        {
+            *pin.port |= pin.mask;
+        }
+        else
+        {
+            *pin.port &= ~pin.mask;
+        }
+    }
+
+#else
+
+    /**
+     * @class Lcd
+     * @brief Host stand-in for `LiquidCrystal_I2C` exposing the subset of its API used
+     *        by `DisplayManager`.
+     *
+     * @details Every call is translated into the HD44780 command/data bytes the real
+     *          library would send and handed to the active `NativeBoard`, which models
+     *          the display contents, the I2C traffic and the time spent on the bus.
+     */
+    class Lcd
+    {
+    public:
+        Lcd(uint8_t i2cAddr, uint8_t cols, uint8_t rows);
+
+        void init();
+        void backlight();
+        void clear();
+        void setCursor(uint8_t col, uint8_t row);
+        size_t write(uint8_t value);
+        size_t print(const char *text);
+        size_t print(const String &text);
+
+    private:
+        uint8_t _i2cAddr;
+        uint8_t _cols;
+        uint8_t _rows;
+    };
+
+    /**
+     * @class SerialPort
+     * @brief Host stand-in for `HardwareSerial`, backed by the active `NativeBoard`.
+     */
+    class SerialPort
+    {
+    public:
+        void begin(unsigned long baud);
+        int available();
+        int read();
+        int availableForWrite();
+        size_t write(uint8_t value);
+        size_t write(const uint8_t *buffer, size_t size);
+        size_t print(const char *text);
+        size_t print(const String &text);
+        size_t print(long value);
+        size_t print(unsigned long value);
+        size_t print(int value) { return print(static_cast<long>(value)); }
+        size_t print(unsigned int value) { return print(static_cast<unsigned long>(value)); }
+        size_t println();
+        template <typename T>
+        size_t println(const T &value) { return print(value) + println(); }
+    };
+    SerialPort &serial();
+
+    void pinMode(uint8_t pin, uint8_t mode);
+    void digitalWrite(uint8_t pin, bool level);
+    bool digitalRead(uint8_t pin);
+    int analogRead(uint8_t pin);
+    unsigned long millis();
+    unsigned long micros();
+    void i2cWrite(uint8_t address, const uint8_t *data, uint8_t length);
+    void i2cSetClock(uint32_t hz);
+    void delayMicroseconds(unsigned int us);
+    void adcBegin(AdcHandler onComplete);
+    void adcStart(uint8_t pin);
+    void pinChangeBegin(uint8_t pin, PinChangeHandler onChange);
+    void tickBegin(TickHandler onTick);
+    void idle(uint32_t maxUs);
+    void toneTimerBegin(uint8_t pin, ToneHandler onToggle);
+    void toneTimerStart(uint8_t compare);
+    void toneTimerSetCompare(uint8_t compare);
+    void toneTimerStop();
+    uint8_t eepromRead(uint16_t address);
+    bool eepromReady();
+    void eepromWrite(uint16_t address, uint8_t value);
+    void watchdogBegin(WatchdogHandler onTimeout);
+    void watchdogReset();
+    void watchdogExpire();
+
+    /**
+     * @brief On the host a resolved output is just its pin number; the board charges
+     *        a PORT write instead of a `digitalWrite()`.
+     */
+    struct FastPin
+    {
+        uint8_t pin;
+    };
+    inline FastPin fastPin(uint8_t pin) { return {pin}; }
+    void fastWrite(const FastPin &pin, bool level);
+
+    /**
+     * @brief On the host, simulated interrupts only fire inside HAL calls, so there is
+     *        nothing to mask.
+     */
+    class InterruptLock
+    {
+    public:
+        InterruptLock() {}
+    };
+
+#endif
+}
@@ -0,0 +1,192 @@
+#include "Hal.h"
+
+#ifdef ARDUINO
+
+#include <avr/sleep.h>
+
+constexpr uint16_t TICK_TIMER_PRESCALER = 64; // 16 MHz / 64 = 250 kHz timer clock
+static_assert(F_CPU / 64 == Hal::TONE_TIMER_CLOCK_HZ, "Timer2 runs at clk/64");
+static_assert(Hal::WATCHDOG_TIMEOUT_MS == 250 && Hal::WATCHDOG_EXPIRE_MS == 16, "WDTCSR prescalers below");
+
+// === ADC ===
+static volatile Hal::AdcHandler adcHandler = nullptr;
+
+void Hal::adcBegin(AdcHandler onComplete)
+{
+    adcHandler = onComplete;
+    // Enable the ADC and its interrupt; prescaler 128 gives the 125 kHz ADC clock
+    // the 10-bit conversion is specified for at 16 MHz.
+    ADCSRA = _BV(ADEN) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+}
+
+ISR(ADC_vect)
+{
+    uint16_t raw = ADC;
+    Hal::AdcHandler handler = adcHandler;
+    if (handler != nullptr)
+    {
+        handler(raw);
+    }
+}
+
+// === PIN CHANGE ===
+static volatile Hal::PinChangeHandler pinChangeHandler = nullptr;
+static volatile uint8_t *pinChangeInput = nullptr;
+static uint8_t pinChangeMask = 0;
+
+void Hal::pinChangeBegin(uint8_t pin, PinChangeHandler onChange)
+{
+    ::pinMode(pin, INPUT_PULLUP);
+    InterruptLock lock;
+    pinChangeHandler = onChange;
+    pinChangeInput = portInputRegister(digitalPinToPort(pin));
+    pinChangeMask = digitalPinToBitMask(pin);
+    // Only this pin is unmasked, so whichever vector fires, it is this pin that changed.
+    *digitalPinToPCMSK(pin) |= _BV(digitalPinToPCMSKbit(pin));
+    PCIFR = _BV(digitalPinToPCICRbit(pin));
+    *digitalPinToPCICR(pin) |= _BV(digitalPinToPCICRbit(pin));
+}
+
+ISR(PCINT0_vect)
+{
+    bool level = *pinChangeInput & pinChangeMask;
+    Hal::PinChangeHandler handler = pinChangeHandler;
+    if (handler != nullptr)
+    {
+        handler(level);
+    }
+}
+#ifdef PCINT1_vect
+ISR(PCINT1_vect, ISR_ALIASOF(PCINT0_vect));
+#endif
+#ifdef PCINT2_vect
+ISR(PCINT2_vect, ISR_ALIASOF(PCINT0_vect));
+#endif
+
+// === TICK ===
+static volatile Hal::TickHandler tickHandler = nullptr;
+
+void Hal::tickBegin(TickHandler onTick)
+{
+    InterruptLock lock;
+    tickHandler = onTick;
+    // CTC mode on OCR1A: the counter restarts every TICK_PERIOD_US exactly.
+    TCCR1A = 0;
+    TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10);
+    OCR1A = F_CPU / TICK_TIMER_PRESCALER * TICK_PERIOD_US / 1000000UL - 1;
+    TCNT1 = 0;
+    TIMSK1 = _BV(OCIE1A);
+}
+
+ISR(TIMER1_COMPA_vect)
+{
+    Hal::TickHandler handler = tickHandler;
+    if (handler != nullptr)
+    {
+        handler();
+    }
+}
+
+// === TONE TIMER ===
+static volatile Hal::ToneHandler toneHandler = nullptr;
+static volatile uint8_t *tonePort = nullptr;
+static uint8_t toneMask = 0;
+
+void Hal::toneTimerBegin(uint8_t pin, ToneHandler onToggle)
+{
+    toneTimerStop();
+    ::pinMode(pin, OUTPUT);
+    InterruptLock lock;
+    toneHandler = onToggle;
+    tonePort = portOutputRegister(digitalPinToPort(pin));
+    toneMask = digitalPinToBitMask(pin);
+    *tonePort &= ~toneMask;
+}
+
+void Hal::toneTimerStart(uint8_t compare)
+{
+    InterruptLock lock;
+    *tonePort &= ~toneMask;
+    TCCR2A = _BV(WGM21); // CTC on OCR2A
+    TCCR2B = _BV(CS22);  // clk/64
+    OCR2A = compare;
+    TCNT2 = 0;
+    TIFR2 = _BV(OCF2A);
+    TIMSK2 = _BV(OCIE2A);
+}
+
+void Hal::toneTimerStop()
+{
+    InterruptLock lock;
+    TIMSK2 = 0;
+    TCCR2B = 0;
+    if (tonePort != nullptr)
+    {
+        *tonePort &= ~toneMask;
+    }
+}
+
+ISR(TIMER2_COMPA_vect)
+{
+    *tonePort ^= toneMask;
+    Hal::ToneHandler handler = toneHandler;
+    if (handler != nullptr)
+    {
+        handler();
+    }
+}
+
+// === WATCHDOG ===
+static volatile Hal::WatchdogHandler watchdogHandler = nullptr;
+
+// A watchdog reset leaves the watchdog running at its shortest period: it must be
+// stopped before the C runtime initialises RAM, or the board resets again in setup().
+// Runs from .init3, with no stack frame: registers only.
+void disableWatchdogAtBoot() __attribute__((naked, used, section(".init3")));
+void disableWatchdogAtBoot()
+{
+    MCUSR = 0; // WDRF forces WDE on
+    wdt_disable();
+}
+
+void Hal::watchdogBegin(WatchdogHandler onTimeout)
+{
+    InterruptLock lock;
+    watchdogHandler = onTimeout;
+    wdt_reset();
+    // Timed sequence: interrupt and system reset mode, WDP2 = 0.25 s
+    WDTCSR = _BV(WDCE) | _BV(WDE);
+    WDTCSR = _BV(WDIE) | _BV(WDE) | _BV(WDP2);
+}
+
+void Hal::watchdogExpire()
+{
+    cli();
+    wdt_enable(WDTO_15MS); // Reset mode only: WDIE is cleared
+    for (;;)
+    {
+    }
+}
+
+ISR(WDT_vect)
+{
+    // The hardware clears WDIE on entry, so the next timeout resets the MCU.
+    Hal::WatchdogHandler handler = watchdogHandler;
+    if (handler != nullptr)
+    {
+        handler();
+    }
+}
+
+// === SLEEP ===
+void Hal::idle(uint32_t)
+{
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_enable();
+    sei(); // The instruction following SEI always executes: no wake-up can slip in here
+    sleep_cpu();
+    sleep_disable();
+    cli();
+}
+
+#endif
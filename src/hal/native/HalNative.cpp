@@ -0,0 +1,171 @@
+#include "../Hal.h"
+#include "NativeBoard.h"
+
+#include <cstdlib>
+#include <cstring>
+
+// HD44780 instructions emitted by the LCD stand-in, as LiquidCrystal_I2C sends them.
+constexpr uint8_t LCD_CMD_CLEAR = 0x01;
+constexpr uint8_t LCD_CMD_SET_DDRAM_ADDR = 0x80;
+constexpr uint8_t LCD_ROW_OFFSETS[] = {0x00, 0x40, 0x14, 0x54};
+
+namespace
+{
+    NativeBoard *installedBoard = nullptr;
+}
+
+// === BOARD REGISTRY ===
+void NativeBoard::install(NativeBoard &board)
+{
+    installedBoard = &board;
+}
+
+NativeBoard &NativeBoard::active()
+{
+    if (installedBoard == nullptr)
+    {
+        fprintf(stderr, "Hal: no NativeBoard installed\n");
+        abort();
+    }
+    return *installedBoard;
+}
+
+// === HAL FUNCTIONS ===
+void Hal::pinMode(uint8_t pin, uint8_t mode) { NativeBoard::active().pinMode(pin, mode); }
+void Hal::digitalWrite(uint8_t pin, bool level) { NativeBoard::active().digitalWrite(pin, level); }
+bool Hal::digitalRead(uint8_t pin) { return NativeBoard::active().digitalRead(pin); }
+void Hal::fastWrite(const FastPin &pin, bool level) { NativeBoard::active().fastWrite(pin.pin, level); }
+int Hal::analogRead(uint8_t pin) { return NativeBoard::active().analogRead(pin); }
+unsigned long Hal::millis() { return static_cast<uint32_t>(NativeBoard::active().nowMicros() / 1000); }
+unsigned long Hal::micros() { return static_cast<uint32_t>(NativeBoard::active().nowMicros()); }
+void Hal::i2cWrite(uint8_t address, const uint8_t *data, uint8_t length) { NativeBoard::active().i2cWrite(address, data, length); }
+void Hal::i2cSetClock(uint32_t hz) { NativeBoard::active().i2cSetClock(hz); }
+void Hal::delayMicroseconds(unsigned int us) { NativeBoard::active().delayMicroseconds(us); }
+void Hal::adcBegin(AdcHandler onComplete) { NativeBoard::active().adcBegin(onComplete); }
+void Hal::adcStart(uint8_t pin) { NativeBoard::active().adcStart(pin); }
+void Hal::pinChangeBegin(uint8_t pin, PinChangeHandler onChange) { NativeBoard::active().pinChangeBegin(pin, onChange); }
+void Hal::tickBegin(TickHandler onTick) { NativeBoard::active().tickBegin(onTick, TICK_PERIOD_US); }
+void Hal::idle(uint32_t maxUs) { NativeBoard::active().idle(maxUs); }
+void Hal::toneTimerBegin(uint8_t pin, ToneHandler onToggle) { NativeBoard::active().toneTimerBegin(pin, onToggle); }
+void Hal::toneTimerStart(uint8_t compare) { NativeBoard::active().toneTimerStart(compare); }
+void Hal::toneTimerSetCompare(uint8_t compare) { NativeBoard::active().toneTimerSetCompare(compare); }
+void Hal::toneTimerStop() { NativeBoard::active().toneTimerStop(); }
+uint8_t Hal::eepromRead(uint16_t address) { return NativeBoard::active().eepromRead(address); }
+bool Hal::eepromReady() { return NativeBoard::active().eepromReady(); }
+void Hal::eepromWrite(uint16_t address, uint8_t value) { NativeBoard::active().eepromWrite(address, value); }
+void Hal::watchdogBegin(WatchdogHandler onTimeout) { NativeBoard::active().watchdogBegin(onTimeout, WATCHDOG_TIMEOUT_MS * 1000UL); }
+void Hal::watchdogReset() { NativeBoard::active().watchdogReset(); }
+void Hal::watchdogExpire() { NativeBoard::active().watchdogExpire(WATCHDOG_EXPIRE_MS * 1000UL); }
+
+// === LCD STAND-IN ===
+Hal::Lcd::Lcd(uint8_t i2cAddr, uint8_t cols, uint8_t rows)
+    : _i2cAddr(i2cAddr), _cols(cols), _rows(rows)
+{
+}
+
+void Hal::Lcd::init()
+{
+    clear();
+}
+
+void Hal::Lcd::backlight()
+{
+    // The backlight bit rides along with every expander write; nothing to model.
+}
+
+void Hal::Lcd::clear()
+{
+    NativeBoard::active().lcdTransfer(false, LCD_CMD_CLEAR);
+}
+
+void Hal::Lcd::setCursor(uint8_t col, uint8_t row)
+{
+    if (row >= _rows)
+    {
+        row = _rows - 1;
+    }
+    NativeBoard::active().lcdTransfer(false, LCD_CMD_SET_DDRAM_ADDR | (col + LCD_ROW_OFFSETS[row]));
+}
+
+size_t Hal::Lcd::write(uint8_t value)
+{
+    NativeBoard::active().lcdTransfer(true, value);
+    return 1;
+}
+
+size_t Hal::Lcd::print(const char *text)
+{
+    size_t written = 0;
+    while (*text != '\0')
+    {
+        written += write(static_cast<uint8_t>(*text++));
+    }
+    return written;
+}
+
+size_t Hal::Lcd::print(const String &text)
+{
+    return print(text.c_str());
+}
+
+// === SERIAL STAND-IN ===
+Hal::SerialPort &Hal::serial()
+{
+    static SerialPort port;
+    return port;
+}
+
+void Hal::SerialPort::begin(unsigned long baud)
+{
+    NativeBoard::active().serialBegin(baud);
+}
+
+int Hal::SerialPort::available()
+{
+    return NativeBoard::active().serialAvailable();
+}
+
+int Hal::SerialPort::read()
+{
+    return NativeBoard::active().serialRead();
+}
+
+int Hal::SerialPort::availableForWrite()
+{
+    return NativeBoard::active().serialAvailableForWrite();
+}
+
+size_t Hal::SerialPort::write(uint8_t value)
+{
+    return write(&value, 1);
+}
+
+size_t Hal::SerialPort::write(const uint8_t *buffer, size_t size)
+{
+    return NativeBoard::active().serialWrite(buffer, size);
+}
+
+size_t Hal::SerialPort::print(const char *text)
+{
+    return write(reinterpret_cast<const uint8_t *>(text), strlen(text));
+}
+
+size_t Hal::SerialPort::print(const String &text)
+{
+    return print(text.c_str());
+}
+
+size_t Hal::SerialPort::print(long value)
+{
+    return print(String(value));
+}
+
+size_t Hal::SerialPort::print(unsigned long value)
+{
+    return print(String(value));
+}
+
+size_t Hal::SerialPort::println()
+{
+    return print("\r\n");
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+/**
+ * @file NativeArduino.h
+ * @brief Minimal host replacements for the Arduino core types used by the firmware.
+ *
+ * @details Only what the core actually needs is provided: the `byte` type, the pin
+ *          level/mode constants, the analog pin aliases of the Uno, `map()`, the PROGMEM
+ *          accessors (flash and RAM are the same address space on the host) and a
+ *          small `String` class with the same semantics as the Arduino one for the
+ *          operations the display code performs. Hardware access itself lives in
+ *          `NativeBoard`, never here.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+typedef uint8_t byte;
+
+constexpr uint8_t LOW = 0;
+constexpr uint8_t HIGH = 1;
+constexpr uint8_t INPUT = 0;
+constexpr uint8_t OUTPUT = 1;
+constexpr uint8_t INPUT_PULLUP = 2;
+
+// Analog pin aliases, numbered as on the Arduino Uno.
+constexpr uint8_t A0 = 14;
+constexpr uint8_t A1 = 15;
+constexpr uint8_t A2 = 16;
+constexpr uint8_t A3 = 17;
+constexpr uint8_t A4 = 18;
+constexpr uint8_t A5 = 19;
+
+/**
+ * @brief Re-maps a number from one range to another, exactly like Arduino's `map()`.
+ */
+inline long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// Flash-resident data is ordinary const data on the host.
+#define PROGMEM
+#define pgm_read_byte(address) (*reinterpret_cast<const uint8_t *>(address))
+#define pgm_read_word(address) (*reinterpret_cast<const uint16_t *>(address))
+
+/**
+ * @class String
+ * @brief Host implementation of the Arduino `String` subset used by the firmware.
+ */
+class String
+{
+public:
+    String(const char *text = "") : _text(text ? text : "") {}
+    String(const std::string &text) : _text(text) {}
+
+    explicit String(int value) : _text(std::to_string(value)) {}
+    explicit String(unsigned int value) : _text(std::to_string(value)) {}
+    explicit String(long value) : _text(std::to_string(value)) {}
+    explicit String(unsigned long value) : _text(std::to_string(value)) {}
+    explicit String(float value, unsigned char decimalPlaces = 2) : String(static_cast<double>(value), decimalPlaces) {}
+    explicit String(double value, unsigned char decimalPlaces = 2)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+        _text = buffer;
+    }
+
+    unsigned int length() const { return static_cast<unsigned int>(_text.size()); }
+    const char *c_str() const { return _text.c_str(); }
+
+    String substring(unsigned int from) const { return substring(from, length()); }
+    String substring(unsigned int from, unsigned int to) const
+    {
+        if (from > length())
+        {
+            return String();
+        }
+        if (to > length())
+        {
+            to = length();
+        }
+        return String(_text.substr(from, to > from ? to - from : 0));
+    }
+
+    String &operator+=(const String &other)
+    {
+        _text += other._text;
+        return *this;
+    }
+
+    friend String operator+(const String &lhs, const String &rhs) { return String(lhs._text + rhs._text); }
+    friend bool operator==(const String &lhs, const String &rhs) { return lhs._text == rhs._text; }
+    friend bool operator!=(const String &lhs, const String &rhs) { return lhs._text != rhs._text; }
+
+private:
+    std::string _text;
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @class NativeBoard
+ * @brief The hardware seen by the firmware when it runs on the host.
+ *
+ * @details The native `Hal` functions forward every call to the board installed
+ *          with `NativeBoard::install()`. A board owns the virtual clock: it decides
+ *          how much simulated time every hardware access costs, so the firmware
+ *          observes realistic timing while the host runs as fast as the CPU allows.
+ */
+class NativeBoard
+{
+public:
+    virtual ~NativeBoard() = default;
+
+    // --- Clock ---
+    virtual uint64_t nowMicros() const = 0;
+    virtual void delayMicroseconds(uint32_t us) = 0;
+
+    // --- Digital and analog I/O ---
+    virtual void pinMode(uint8_t pin, uint8_t mode) {}
+    virtual void digitalWrite(uint8_t pin, bool level) = 0;
+
+    /**
+     * @brief Drives an output with a direct PORT write (`Hal::fastWrite()`).
+     */
+    virtual void fastWrite(uint8_t pin, bool level) { digitalWrite(pin, level); }
+    virtual int analogRead(uint8_t pin) = 0;
+
+    /**
+     * @brief Reads an input. Unconnected inputs read high, as with their pull-up.
+     */
+    virtual bool digitalRead(uint8_t pin) { return true; }
+
+    // --- Pin-change interrupt ---
+    /**
+     * @brief Registers the handler the board calls on every level change of the pin.
+     */
+    virtual void pinChangeBegin(uint8_t pin, void (*onChange)(bool level)) {}
+
+    // --- Interrupt-driven ADC ---
+    /**
+     * @brief Registers the handler the board calls when a conversion completes.
+     */
+    virtual void adcBegin(void (*onComplete)(uint16_t raw)) {}
+
+    /**
+     * @brief Starts a conversion; the board calls the handler when it completes.
+     */
+    virtual void adcStart(uint8_t pin) {}
+
+    // --- Tick interrupt and sleep ---
+    /**
+     * @brief Registers the handler the board calls every `periodUs` of virtual time.
+     */
+    virtual void tickBegin(void (*onTick)(), uint32_t periodUs) {}
+
+    /**
+     * @brief Lets virtual time pass until an interrupt wakes the firmware, at most `maxUs`.
+     */
+    virtual void idle(uint32_t maxUs) { delayMicroseconds(maxUs); }
+
+    // --- Tone timer ---
+    /**
+     * @brief Binds the tone timer to a pin; the board calls the handler after each toggle.
+     */
+    virtual void toneTimerBegin(uint8_t pin, void (*onToggle)()) {}
+    virtual void toneTimerStart(uint8_t compare) {}
+    virtual void toneTimerSetCompare(uint8_t compare) {}
+    virtual void toneTimerStop() {}
+
+    // --- EEPROM ---
+    /**
+     * @brief Reads one byte. An erased (or absent) EEPROM reads 0xFF.
+     */
+    virtual uint8_t eepromRead(uint16_t address) { return 0xFF; }
+    virtual bool eepromReady() { return true; }
+
+    /**
+     * @brief Starts a byte write, waiting for the previous one to complete first.
+     */
+    virtual void eepromWrite(uint16_t address, uint8_t value) {}
+
+    // --- Watchdog ---
+    /**
+     * @brief Starts the watchdog: `timeoutUs` without `watchdogReset()` calls the
+     *        handler, and as much again resets the board.
+     */
+    virtual void watchdogBegin(void (*onTimeout)(), uint32_t timeoutUs) {}
+    virtual void watchdogReset() {}
+
+    /**
+     * @brief Resets the board after `expireUs`, running no firmware code until then.
+     *        Unlike on the target, the call returns.
+     */
+    virtual void watchdogExpire(uint32_t expireUs) {}
+
+    // --- HD44780 over PCF8574 ---
+    /**
+     * @brief Receives one byte sent to the LCD controller.
+     * @param isData true for a character (RS high), false for a command.
+     * @param value The byte as seen by the HD44780.
+     */
+    virtual void lcdTransfer(bool isData, uint8_t value) {}
+
+    /**
+     * @brief Receives one raw I2C write transaction (e.g. PCF8574 expander bytes).
+     */
+    virtual void i2cWrite(uint8_t address, const uint8_t *data, uint8_t length) {}
+    virtual void i2cSetClock(uint32_t hz) {}
+
+    // --- UART ---
+    virtual void serialBegin(unsigned long baud) {}
+    virtual int serialAvailable() { return 0; }
+    virtual int serialRead() { return -1; }
+    virtual int serialAvailableForWrite() { return 64; }
+    virtual size_t serialWrite(const uint8_t *buffer, size_t size) { return size; }
+
+    /**
+     * @brief Makes this board the one used by the native `Hal` functions.
+     */
+    static void install(NativeBoard &board);
+
+    /**
+     * @brief Returns the installed board. Calling any `Hal` function before a board
+     *        has been installed is a programming error and aborts the process.
+     */
+    static NativeBoard &active();
+};
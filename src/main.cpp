@@ -13,8 +13,16 @@
 #include <Arduino.h>
 #include "controllers/ActuatorController.h"
 #include "sensors/SensorManager.h"
+#include "sensors/DebouncedButton.h"
 #include "display/DisplayManager.h"
 #include "core/SystemState.h"
+#include "core/Scheduler.h"
+#include "core/Supervisor.h"
+#include "storage/RunLog.h"
+#include "storage/ParameterStore.h"
+#include "diagnostics/LoopProfiler.h"
+#include "diagnostics/LatencyProbe.h"
+#include "diagnostics/Telemetry.h"
 
 //  PIN AND COSTANT DEFINITIONS
 
@@ -31,6 +39,23 @@ constexpr byte TEMPERATURE_SENSOR_PIN = A0; // Pin for the temperature sensor
 constexpr byte GAS_SENSOR_PIN = A2; // Pin for the gas sensor
 constexpr byte POTENTIOMETER_PIN = A3; // Pin for the potentiometer
 
+// SERIAL COMMANDS
+constexpr char TASK_REPORT_COMMAND = 't';  // Send this character over Serial to dump the task statistics
+constexpr char HEATER_REPORT_COMMAND = 'h'; // Dump the heater window, duty, relay switching rate and LED writes
+constexpr char LOG_DUMP_COMMAND = 'd';    // Dump the EEPROM run log as hex (decode with tools/runlog_decode.py)
+constexpr char TELEMETRY_TOGGLE_COMMAND = 'b'; // Pause or resume the binary telemetry stream
+constexpr char GAS_TRIP_REPORT_COMMAND = 'g'; // Dump the gas trip count and latencies
+constexpr char SUPERVISOR_REPORT_COMMAND = 'w'; // Dump the last overrun and why the previous run was restarted
+constexpr char AUTOTUNE_COMMAND = 'a';         // Start an autotune experiment, or abort the one running
+constexpr char AUTOTUNE_REPORT_COMMAND = 'k';  // Dump the autotune progress and the gains it found
+constexpr char MODEL_REPORT_COMMAND = 'm';      // Dump the chamber model of the predictive heater control
+constexpr char PARAMETER_COMMAND = ':';       // Start a parameter command line, e.g. `:kp=50` (see ParameterStore)
+constexpr char PROFILE_DUMP_COMMAND = 'p'; // Dump the loop histograms (only with -DBIOLOGIC_PROFILING)
+constexpr char LATENCY_DUMP_COMMAND = 'l'; // Dump the emergency stop latency (only with -DBIOLOGIC_LATENCY_PROBE)
+constexpr uint16_t SERIAL_TASK_PERIOD_MS = 50;
+constexpr uint16_t SERIAL_TASK_PHASE_MS = 4;
+constexpr uint16_t SERIAL_TASK_DEADLINE_MS = 10;
+
 // I2C ADDRESS
 constexpr byte I2C_ADDRESS= 0x27; 
 
@@ -38,12 +63,19 @@ constexpr byte I2C_ADDRESS= 0x27;
 ActuatorController actuatorController(TRANSISTOR_PIN, GREEN_LED_PIN, RED_LED_PIN, PIEZO_PIN);
 SensorManager sensorManager(TEMPERATURE_SENSOR_PIN, GAS_SENSOR_PIN, POTENTIOMETER_PIN);
 DisplayManager lcd(I2C_ADDRESS);
-SystemState systemState(sensorManager, actuatorController, lcd);
+DebouncedButton acknowledgeButton(ACKNOWLEDGE_BUTTON_PIN);
+SystemState systemState(sensorManager, actuatorController, lcd, acknowledgeButton, EMERGENCY_BUTTON_PIN);
+RunLog runLog(systemState, sensorManager, actuatorController);
+ParameterStore parameterStore;
+Scheduler scheduler;
+Supervisor supervisor(scheduler, actuatorController);
+Telemetry telemetry(systemState, sensorManager, actuatorController, scheduler);
 
 
 /**
  * @brief This function is called by hardware when the emergency stop button is pressed.
- * It must be extremely fast. It delegates the work to the SystemState object.
+ * It must be extremely fast. It delegates the work to the SystemState object, which
+ * cuts the heater and lights the red LED before returning.
  * The 'volatile' keyword is not strictly needed here as we are calling a method,
  * but it's good practice to be aware of it for ISRs that modify global flags.
  */
@@ -51,18 +83,121 @@ void emergencyStopISR() {
     systemState.triggerEmergencyStop();
 }
 
+/**
+ * @brief Called from the ADC interrupt when the raw gas conversions cross the alarm level.
+ * It cuts the heater at once and leaves the siren and the display to the FSM.
+ */
+void gasTripISR(void *) {
+    systemState.triggerGasTrip();
+}
+
+/**
+ * @brief Pushes the parameters that objects keep a copy of, after a load or a change.
+ */
+void applyParameters() {
+  actuatorController.setHeaterWindow(parameters.heaterWindowMs);
+  runLog.setInterval(parameters.logIntervalS);
+  telemetry.setPeriod(parameters.telemetryPeriodMs);
+  sensorManager.setGasTripLevel(parameters.gasHighThreshold);
+}
+
+/**
+ * @brief Keeps the gains found by an autotune experiment, in EEPROM.
+ */
+void saveAutotuneGains(const AutotuneResult &result) {
+  parameterStore.set(ParameterId::PROPORTIONAL_GAIN, result.proportionalGain);
+  parameterStore.set(ParameterId::DERIVATIVE_GAIN, result.derivativeGain);
+  parameterStore.set(ParameterId::INTEGRAL_GAIN, result.integralGain);
+  parameterStore.save();
+}
+
+/**
+ * @brief Scheduler task answering the diagnostic commands received over Serial.
+ */
+void serialCommandTask(void *) {
+  // A parameter command line holds the port until its end
+  if (parameterStore.serviceCommand(Serial)) {
+    return;
+  }
+  int command = Serial.read();
+  if (command == PARAMETER_COMMAND) {
+    parameterStore.openCommand();
+    parameterStore.serviceCommand(Serial);
+  }
+  if (command == TASK_REPORT_COMMAND) {
+    scheduler.report(Serial);
+  }
+  if (command == HEATER_REPORT_COMMAND) {
+    actuatorController.reportOutputs(Serial);
+  }
+  if (command == GAS_TRIP_REPORT_COMMAND) {
+    systemState.reportGasTrip(Serial);
+  }
+  if (command == SUPERVISOR_REPORT_COMMAND) {
+    supervisor.report(Serial);
+  }
+  if (command == AUTOTUNE_COMMAND) {
+    systemState.requestAutotune();
+  }
+  if (command == AUTOTUNE_REPORT_COMMAND) {
+    systemState.getAutotuner().report(Serial);
+  }
+  if (command == MODEL_REPORT_COMMAND) {
+    systemState.getPredictiveControl().report(Serial);
+  }
+  if (command == LOG_DUMP_COMMAND) {
+    runLog.startDump(Serial);
+  }
+  if (command == TELEMETRY_TOGGLE_COMMAND) {
+    telemetry.setEnabled(!telemetry.isEnabled());
+  }
+#ifdef BIOLOGIC_PROFILING
+  if (command == PROFILE_DUMP_COMMAND) {
+    LoopProfiler::dump(Serial);
+  }
+#endif
+#ifdef BIOLOGIC_LATENCY_PROBE
+  if (command == LATENCY_DUMP_COMMAND) {
+    LatencyProbe::dump(Serial);
+  }
+#endif
+}
+
 void setup() {
-  Serial.begin(9600);
+  Serial.begin(TELEMETRY_BAUD);
+  parameterStore.begin(applyParameters);
   actuatorController.begin();
   sensorManager.begin();
   lcd.begin();
+  acknowledgeButton.begin();
   systemState.begin();
+  systemState.setAutotuneHandler(saveAutotuneGains);
+  sensorManager.watchGas(gasTripISR, nullptr);
+  runLog.begin();
+  telemetry.begin(Serial);
   pinMode(EMERGENCY_BUTTON_PIN, INPUT_PULLUP);
   attachInterrupt(digitalPinToInterrupt(EMERGENCY_BUTTON_PIN),  emergencyStopISR, FALLING);
+
+  // Task table, in priority order within a tick
+  actuatorController.registerTasks(scheduler);
+  systemState.registerTasks(scheduler);
+  sensorManager.registerTasks(scheduler);
+  lcd.registerTasks(scheduler);
+  runLog.registerTasks(scheduler);
+  parameterStore.registerTasks(scheduler);
+  telemetry.registerTasks(scheduler);
+  scheduler.add("serial", serialCommandTask, nullptr, SERIAL_TASK_PERIOD_MS, SERIAL_TASK_PHASE_MS, SERIAL_TASK_DEADLINE_MS);
+  supervisor.registerTasks(scheduler);
+  scheduler.begin();
+  supervisor.begin();
 }
 
 void loop() {
-  actuatorController.update();
-  systemState.update();
+  // Sleep until the next task release, then run everything that is due
+  scheduler.idle();
+  PROFILE_PASS_BEGIN();
+  scheduler.dispatch();
+  PROFILE_PASS_END();
+  supervisor.pet();
 }
 
@@ -0,0 +1,113 @@
+#include "ChamberCost.h"
+
+static const char *const STEP_NAMES[ChamberCost::STEP_COUNT] = {"fsm", "estimate", "heater", "tick"};
+
+// The LCD's I2C bus takes A4 and A5 on the Uno, pins 20 and 21 on the Mega.
+static const ChamberBoard BOARDS[] = {
+    {"uno", 4, 2048},
+    {"mega", 16, 8192},
+};
+
+constexpr uint32_t PPM = 1000000;
+constexpr uint16_t STACK_RESERVE_BYTES = 256; // Kept free for the deepest call chain plus an interrupt
+
+#ifdef ARDUINO
+extern char __heap_start;
+extern char *__brkval;
+
+// Bytes between the top of the heap and the stack, as of this call.
+static uint16_t freeRam()
+{
+    char top;
+    return &top - (__brkval == nullptr ? &__heap_start : __brkval);
+}
+#endif
+
+// Prints a non-negative value with one decimal.
+static void printTenths(Hal::SerialPort &port, float value)
+{
+    unsigned long tenths = static_cast<unsigned long>(value * 10.0f + 0.5f);
+    port.print(tenths / 10);
+    port.print(".");
+    port.print(tenths % 10);
+}
+
+ChamberCost::ChamberCost()
+    : _totalUs{},
+      _runs{}
+{
+}
+
+void ChamberCost::add(Step step, uint16_t us)
+{
+    Hal::InterruptLock lock;
+    _totalUs[step] += us;
+    _runs[step]++;
+}
+
+void ChamberCost::report(Hal::SerialPort &port, uint8_t chambers, uint16_t bytesPerChamber,
+                         const uint16_t (&periodMs)[STEP_COUNT]) const
+{
+    port.println("step,period_ms,runs,mean_us,mean_us_per_chamber,load_ppm_per_chamber");
+    uint32_t loadPpm = 0;
+    for (uint8_t step = 0; step < STEP_COUNT; step++)
+    {
+        uint32_t totalUs;
+        uint32_t runs;
+        {
+            Hal::InterruptLock lock;
+            totalUs = _totalUs[step];
+            runs = _runs[step];
+        }
+        float meanUs = runs > 0 ? static_cast<float>(totalUs) / runs : 0.0f;
+        uint32_t stepPpm = static_cast<uint32_t>(meanUs * 1000.0f / periodMs[step] / chambers + 0.5f);
+        loadPpm += stepPpm;
+
+        port.print(STEP_NAMES[step]);
+        port.print(",");
+        port.print(periodMs[step]);
+        port.print(",");
+        port.print(runs);
+        port.print(",");
+        printTenths(port, meanUs);
+        port.print(",");
+        printTenths(port, meanUs / chambers);
+        port.print(",");
+        port.println(stepPpm);
+    }
+    port.print("chambers,");
+    port.println(static_cast<unsigned int>(chambers));
+    port.print("load_ppm_per_chamber,");
+    port.println(loadPpm);
+    port.print("ram_bytes_per_chamber,");
+    port.println(bytesPerChamber);
+
+    // A chamber needs a TMP36 input; the gas sensor takes one more.
+    uint32_t cpuFit = loadPpm > 0 ? CHAMBER_COST_CPU_BUDGET_PCT * (PPM / 100) / loadPpm : UINT32_MAX;
+    port.println("board,fit_analog,fit_cpu,fit_ram,fit");
+    for (const ChamberBoard &board : BOARDS)
+    {
+        uint16_t fit = board.analogInputs - 1;
+        port.print(board.name);
+        port.print(",");
+        port.print(fit);
+        port.print(",");
+        if (loadPpm > 0)
+        {
+            port.print(cpuFit);
+            fit = cpuFit < fit ? static_cast<uint16_t>(cpuFit) : fit;
+        }
+        port.print(",");
+#ifdef ARDUINO
+        // What is free here, plus what the other board has in addition.
+        int32_t freeBytes = static_cast<int32_t>(freeRam()) - STACK_RESERVE_BYTES
+                          + board.ramBytes - (RAMEND + 1 - RAMSTART);
+        int32_t extra = freeBytes / static_cast<int32_t>(bytesPerChamber);
+        uint16_t ramFit = extra + chambers > 0 ? static_cast<uint16_t>(extra + chambers) : 0;
+        port.print(ramFit);
+        fit = ramFit < fit ? ramFit : fit;
+#endif
+        port.print(",");
+        port.println(fit);
+    }
+}
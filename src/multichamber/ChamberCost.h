@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../hal/Hal.h"
+
+constexpr uint8_t CHAMBER_COST_CPU_BUDGET_PCT = 50; // CPU share the chambers may take; the rest is left
+                                                    // to the LCD, the serial port and the interrupts
+
+/**
+ * @brief A board the multi-chamber controller may run on.
+ */
+struct ChamberBoard
+{
+    const char *name;
+    uint8_t analogInputs; // Free for sensors: one per chamber, plus the gas sensor
+    uint16_t ramBytes;
+};
+
+/**
+ * @class ChamberCost
+ * @brief Execution time accounting of the multi-chamber controller's batched work.
+ *
+ * @details Every batched step (the FSM pass, the estimator step, the heater control step
+ *          and the heater tick hook) adds its execution time here. The report divides
+ *          the totals by the number of chambers and by each step's period, which gives
+ *          the CPU load one chamber adds, and from it, the RAM one chamber takes and the
+ *          analog inputs, the number of chambers that fit on an Uno and on a Mega.
+ */
+class ChamberCost
+{
+public:
+    /**
+     * @brief The batched steps, in report order.
+     */
+    enum Step : uint8_t
+    {
+        FSM,
+        ESTIMATE,
+        HEATER,
+        TICK,
+        STEP_COUNT
+    };
+
+    ChamberCost();
+
+    /**
+     * @brief Adds one run of a step. May be called from an interrupt.
+     */
+    void add(Step step, uint16_t us);
+
+    /**
+     * @brief Writes the cost report as CSV to the given port.
+     * @details Per step: `step,period_ms,runs,mean_us,mean_us_per_chamber,load_ppm_per_chamber`.
+     *          Then the totals, and per board:
+     *          `board,fit_analog,fit_cpu,fit_ram,fit`. fit_cpu is empty until
+     *          a step has been timed, and fit_ram on the host.
+     * @param chambers The number of chambers the steps ran for.
+     * @param bytesPerChamber The RAM each extra chamber takes.
+     * @param periodMs The period of each step.
+     */
+    void report(Hal::SerialPort &port, uint8_t chambers, uint16_t bytesPerChamber,
+                const uint16_t (&periodMs)[STEP_COUNT]) const;
+
+private:
+    // Written by the tasks and the tick hook; read with interrupts off
+    uint32_t _totalUs[STEP_COUNT];
+    uint32_t _runs[STEP_COUNT];
+};
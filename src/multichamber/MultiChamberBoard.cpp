@@ -0,0 +1,60 @@
+#include "MultiChamberBoard.h"
+
+MultiChamberBoard::MultiChamberBoard(const ChamberPins &pins, const ChamberModel &model)
+    : ChamberSimulator(pins, model),
+      _plantPins(pins)
+{
+}
+
+void MultiChamberBoard::addChamber(uint8_t temperaturePin, uint8_t heaterPin, const ChamberModel &model)
+{
+    Plant plant{temperaturePin, heaterPin, std::make_unique<ChamberSimulator>(_plantPins, model)};
+    plant.sim->advance(nowMicros());
+    _plants.push_back(std::move(plant));
+}
+
+void MultiChamberBoard::fastWrite(uint8_t pin, bool level)
+{
+    for (Plant &plant : _plants)
+    {
+        if (pin == plant.heaterPin)
+        {
+            sync(plant).fastWrite(_plantPins.heater, level);
+        }
+    }
+    ChamberSimulator::fastWrite(pin, level);
+}
+
+float MultiChamberBoard::plantTemperature(uint8_t chamber)
+{
+    return chamber == 0 ? chamberTemperature() : sync(_plants[chamber - 1]).chamberTemperature();
+}
+
+const ChamberStats &MultiChamberBoard::plantStats(uint8_t chamber)
+{
+    return chamber == 0 ? stats() : sync(_plants[chamber - 1]).stats();
+}
+
+int MultiChamberBoard::sampleAnalog(uint8_t pin)
+{
+    for (Plant &plant : _plants)
+    {
+        if (pin == plant.temperaturePin)
+        {
+            return sync(plant).analogRead(_plantPins.temperatureSensor);
+        }
+    }
+    return ChamberSimulator::sampleAnalog(pin);
+}
+
+ChamberSimulator &MultiChamberBoard::sync(Plant &plant)
+{
+    // A plant's own HAL calls (analogRead(), fastWrite()) may have taken it a few
+    // microseconds ahead; it waits for the board to catch up.
+    uint64_t now = nowMicros();
+    if (plant.sim->nowMicros() < now)
+    {
+        plant.sim->advance(now - plant.sim->nowMicros());
+    }
+    return *plant.sim;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "../sim/ChamberSimulator.h"
+
+#include <memory>
+#include <vector>
+
+/**
+ * @class MultiChamberBoard
+ * @brief A simulated board wired to several chambers (host harness of src/multichamber/).
+ *
+ * @details Chamber 0 is the simulator's own: its TMP36, heater, gas sensor, LCD, clock
+ *          and interrupts are the base class's. Every chamber added with `addChamber()`
+ *          is a plant of its own, a ChamberSimulator that is never installed and only
+ *          serves its TMP36 reading and follows its heater pin: it is advanced to the
+ *          board's clock before each access, so its physics, noise and statistics are
+ *          the same as chamber 0's.
+ */
+class MultiChamberBoard : public ChamberSimulator
+{
+public:
+    MultiChamberBoard(const ChamberPins &pins, const ChamberModel &model);
+
+    /**
+     * @brief Wires one more chamber to the board.
+     * @param temperaturePin The analog pin its TMP36 is read on.
+     * @param heaterPin The digital pin driving its heater.
+     * @param model The chamber's physics.
+     */
+    void addChamber(uint8_t temperaturePin, uint8_t heaterPin, const ChamberModel &model);
+
+    void fastWrite(uint8_t pin, bool level) override;
+
+    /**
+     * @brief Returns the air temperature of a chamber (0 is the base simulator's).
+     */
+    float plantTemperature(uint8_t chamber);
+
+    /**
+     * @brief Returns the counters of a chamber's plant (heater time, switches, energy).
+     */
+    const ChamberStats &plantStats(uint8_t chamber);
+
+protected:
+    int sampleAnalog(uint8_t pin) override;
+
+private:
+    struct Plant
+    {
+        uint8_t temperaturePin;
+        uint8_t heaterPin;
+        std::unique_ptr<ChamberSimulator> sim;
+    };
+
+    ChamberPins _plantPins; // The wiring every added plant is simulated with
+    std::vector<Plant> _plants;
+
+    /**
+     * @brief Advances a plant to the board's clock.
+     */
+    ChamberSimulator &sync(Plant &plant);
+};
@@ -0,0 +1,602 @@
+#pragma once
+
+#include "../hal/Hal.h"
+#include "../core/StateType.h"
+#include "../core/Scheduler.h"
+#include "../core/TemperatureEstimator.h"
+#include "../core/HeaterControl.h"
+#include "../sensors/SensorManager.h"
+#include "../controllers/HeaterWindow.h"
+#include "../controllers/Siren.h"
+#include "../display/DisplayManager.h"
+#include "../diagnostics/LatencyProbe.h"
+#include "../storage/ParameterStore.h"
+#include "ChamberCost.h"
+
+constexpr uint8_t MULTICHAMBER_MAX_CHAMBERS = ADC_MAX_CHANNELS - 1; // The gas sensor takes one input
+constexpr uint16_t MULTICHAMBER_ROTATION_MS = 3000;                 // Time each chamber stays on the LCD
+
+// === TASKS (period, phase, deadline in ms) ===
+constexpr uint16_t MULTICHAMBER_FSM_PERIOD_MS = 10;
+constexpr uint16_t MULTICHAMBER_FSM_PHASE_MS = 2;
+constexpr uint16_t MULTICHAMBER_FSM_DEADLINE_MS = 5;
+constexpr uint16_t MULTICHAMBER_ESTIMATOR_PHASE_MS = 5;
+constexpr uint16_t MULTICHAMBER_ESTIMATOR_DEADLINE_MS = 10;
+constexpr uint16_t MULTICHAMBER_HEATER_PHASE_MS = 7;
+constexpr uint16_t MULTICHAMBER_HEATER_DEADLINE_MS = 10;
+
+/**
+ * @brief The wiring of one chamber.
+ */
+struct ChamberConfig
+{
+    uint8_t temperaturePin; // TMP36 (analog)
+    uint8_t heaterPin;      // Heater transistor
+    Temperature setpoint;
+};
+
+/**
+ * @brief The outputs and sensors all chambers share.
+ */
+struct MultiChamberPins
+{
+    uint8_t gasSensor; // MQ-3 (analog)
+    uint8_t greenLed;  // On while every chamber is MAINTAINING
+    uint8_t redLed;    // On while any chamber is PREHEATING, and in any emergency
+    uint8_t piezo;
+};
+
+/**
+ * @class MultiChamberController
+ * @brief One controller instance driving CHAMBERS chambers from the same board.
+ * @tparam CHAMBERS The number of chambers, fixed at compile time (1 to MULTICHAMBER_MAX_CHAMBERS).
+ *
+ * @details Each chamber has its own TMP36, heater and setpoint, and runs the state
+ *          machine of StateType.h and the control law of HeaterControl.h on its own
+ *          temperature estimate, as `SystemState` does for a single chamber. The
+ *          chambers always use that PID law, whatever the ctl_mode parameter: a
+ *          PredictiveControl per chamber would take about four times the RAM a chamber
+ *          takes now.
+ *          The gas sensor, the emergency button, the LEDs, the siren and the LCD are
+ *          shared: a gas alarm or an emergency stop holds every heater off. The gas
+ *          input is watched by the sampler: its trip opens every relay from the ADC
+ *          interrupt, and the alarm clears below the gas_low parameter. The gas levels and
+ *          hold time and the heater window are the live `parameters`, as for one chamber.
+ *
+ *          The per-chamber state is kept as one array per field (state, setpoint,
+ *          estimator, integral, duty, PWM counters) rather than one object per chamber,
+ *          and every step is batched across the chambers: one FSM task, one estimator
+ *          task and one heater control task loop over all of them, and one tick hook
+ *          advances every heater's slow PWM (one HeaterWindow each, the rules of
+ *          HeaterDriver) and then writes the heater pins that changed.
+ *          The sampler scans the TMP36 inputs followed by the gas sensor in a single
+ *          interrupt chain.
+ *
+ *          The heater windows are staggered by 1/CHAMBERS of a window, so the relays do
+ *          not all close on the same tick. The LEDs summarize the chambers and the LCD
+ *          rotates through them every MULTICHAMBER_ROTATION_MS.
+ *
+ *          Each batched step is timed; `reportCost()` turns the totals into the load
+ *          and the RAM of one chamber (see ChamberCost).
+ */
+template <uint8_t CHAMBERS>
+class MultiChamberController
+{
+    static_assert(CHAMBERS > 0 && CHAMBERS <= MULTICHAMBER_MAX_CHAMBERS, "One analog input per chamber, plus the gas sensor");
+
+public:
+    /**
+     * @brief Constructs the controller.
+     * @param pins The shared sensor and outputs.
+     * @param chambers The wiring and initial setpoint of each chamber.
+     * @param display The LCD.
+     */
+    MultiChamberController(const MultiChamberPins &pins, const ChamberConfig (&chambers)[CHAMBERS],
+                           DisplayManager &display)
+        : _display(display),
+          _sampler(samplerPins(pins, chambers).pins),
+          _siren(pins.piezo),
+          _greenLedPin(pins.greenLed),
+          _redLedPin(pins.redLed),
+          _greenLed{},
+          _redLed{},
+          _ledsShown(0),
+          _heater{},
+          _state{},
+          _dutyIntegral{},
+          _duty{},
+          _windowTicks(HeaterWindow::windowTicks(HEATER_DEFAULT_WINDOW_MS)),
+          _requestedOnTicks{},
+          _window{},
+          _heatersOn(0),
+          _switches(0),
+          _stopRequested(false),
+          _gasTripped(false),
+          _stopped(false),
+          _gasAlarm(false),
+          _gasAlarmMs(0),
+          _gasValue(0),
+          _shownChamber(0),
+          _rotationPasses(0),
+          _previousChamberPrinted(CHAMBERS),
+          _previousLabelPrinted(nullptr),
+          _previousTemperaturePrinted(0),
+          _previousSetpointPrinted(0),
+          _previousGasValuePrinted(0)
+    {
+        for (uint8_t i = 0; i < CHAMBERS; i++)
+        {
+            _heaterPin[i] = chambers[i].heaterPin;
+            _setpoint[i] = chambers[i].setpoint;
+        }
+    }
+
+    /**
+     * @brief Configures the outputs, starts the sampler and the siren, and resets every
+     *        chamber to STANDBY.
+     * @details Blocks until every analog input has a first sample. The heater window and
+     *          the gas trip level are taken from `parameters` here.
+     */
+    void begin()
+    {
+        Hal::pinMode(_greenLedPin, OUTPUT);
+        Hal::pinMode(_redLedPin, OUTPUT);
+        _greenLed = Hal::fastPin(_greenLedPin);
+        _redLed = Hal::fastPin(_redLedPin);
+        Hal::fastWrite(_greenLed, false);
+        Hal::fastWrite(_redLed, false);
+        _ledsShown = 0;
+        _siren.begin();
+
+        for (uint8_t i = 0; i < CHAMBERS; i++)
+        {
+            Hal::pinMode(_heaterPin[i], OUTPUT);
+            _heater[i] = Hal::fastPin(_heaterPin[i]);
+            Hal::fastWrite(_heater[i], false);
+        }
+        uint16_t windowTicks = HeaterWindow::windowTicks(parameters.heaterWindowMs);
+        {
+            Hal::InterruptLock lock;
+            _windowTicks = windowTicks;
+            for (uint8_t i = 0; i < CHAMBERS; i++)
+            {
+                _requestedOnTicks[i] = 0;
+                // Chamber i opens its first window i/CHAMBERS of a window after chamber 0
+                _window[i].reset(windowTicks, static_cast<uint16_t>(static_cast<uint32_t>(windowTicks) * i / CHAMBERS));
+            }
+            _heatersOn = 0;
+            _switches = 0;
+            _stopRequested = false;
+            _gasTripped = false;
+        }
+
+        _sampler.begin();
+        _sampler.watch(GAS_CHANNEL, parameters.gasHighThreshold, &MultiChamberController::onGasTrip, this);
+        while (!_sampler.isPrimed())
+        {
+            Hal::delayMicroseconds(PRIMING_POLL_US);
+        }
+        for (uint8_t i = 0; i < CHAMBERS; i++)
+        {
+            _state[i] = States::Type::STANDBY;
+            _dutyIntegral[i] = 0;
+            _duty[i] = 0;
+            _estimator[i].reset(Calibration::temperatureFromSample(_sampler.read(i)));
+        }
+        _stopped = false;
+        _gasAlarm = false;
+    }
+
+    /**
+     * @brief Adds the batched FSM, estimator and heater control tasks and the heater
+     *        tick hook to the scheduler.
+     */
+    void registerTasks(Scheduler &scheduler)
+    {
+        scheduler.add<MultiChamberController, &MultiChamberController::update>(
+            "fsm", *this, MULTICHAMBER_FSM_PERIOD_MS, MULTICHAMBER_FSM_PHASE_MS, MULTICHAMBER_FSM_DEADLINE_MS);
+        scheduler.add<MultiChamberController, &MultiChamberController::updateEstimates>(
+            "estimate", *this, ESTIMATOR_PERIOD_MS, MULTICHAMBER_ESTIMATOR_PHASE_MS, MULTICHAMBER_ESTIMATOR_DEADLINE_MS);
+        scheduler.add<MultiChamberController, &MultiChamberController::updateHeaterDuties>(
+            "heater", *this, HEATER_CONTROL_PERIOD_MS, MULTICHAMBER_HEATER_PHASE_MS, MULTICHAMBER_HEATER_DEADLINE_MS);
+        scheduler.addTickHook<MultiChamberController, &MultiChamberController::onTick>(*this);
+    }
+
+    /**
+     * @brief The FSM pass over every chamber, then one commit of the shared outputs and
+     *        the LCD. Runs as a scheduler task.
+     */
+    void update()
+    {
+        unsigned long start = Hal::micros();
+        uint8_t allOutputs = 0xFF; // Outputs every chamber asks for
+        uint8_t anyOutputs = 0;    // Outputs at least one chamber asks for
+        SirenPattern pattern = SirenPattern::GAS_WARNING;
+
+        if (_stopRequested)
+        {
+            // The tick hook has already opened the relays; latch the stop.
+            if (!_stopped)
+            {
+                _stopped = true;
+                for (uint8_t i = 0; i < CHAMBERS; i++)
+                {
+                    _state[i] = States::Type::EMERGENCY_STOP;
+                    setDuty(i, 0);
+                }
+                _display.displayEmergency(States::EMERGENCY_MESSAGE);
+            }
+            const States::Descriptor *descriptor = States::descriptor(States::Type::EMERGENCY_STOP);
+            allOutputs = anyOutputs = pgm_read_byte(&descriptor->outputs);
+            pattern = static_cast<SirenPattern>(pgm_read_byte(&descriptor->sirenPattern));
+        }
+        else
+        {
+            _gasValue = _sampler.read(GAS_CHANNEL) >> ADC_EXTRA_BITS;
+            updateGasAlarm();
+            if (_gasAlarm)
+            {
+                // Every chamber keeps its state; the heaters stay off until the gas clears.
+                for (uint8_t i = 0; i < CHAMBERS; i++)
+                {
+                    setDuty(i, 0);
+                }
+                allOutputs = anyOutputs = pgm_read_byte(&States::GAS_WARNING.outputs);
+            }
+            else
+            {
+                for (uint8_t i = 0; i < CHAMBERS; i++)
+                {
+                    States::Type state = States::nextState(_state[i], _estimator[i].temperature(), _setpoint[i]);
+                    _state[i] = state;
+                    uint8_t outputs = pgm_read_byte(&States::descriptor(state)->outputs);
+                    if (!(outputs & States::OUTPUT_HEATER_CONTROL))
+                    {
+                        setDuty(i, 0);
+                    }
+                    allOutputs &= outputs;
+                    anyOutputs |= outputs;
+                }
+            }
+        }
+
+        commitLeds(allOutputs & States::OUTPUT_GREEN_LED, anyOutputs & States::OUTPUT_RED_LED);
+        if (anyOutputs & States::OUTPUT_SIREN)
+        {
+            _siren.play(pattern);
+        }
+        else
+        {
+            _siren.stop();
+        }
+        if (!_stopped)
+        {
+            updateDisplay();
+        }
+        _cost.add(ChamberCost::FSM, static_cast<uint16_t>(Hal::micros() - start));
+    }
+
+    /**
+     * @brief Feeds every chamber's latest reading and relay state to its estimator.
+     *        Runs as a scheduler task every ESTIMATOR_PERIOD_MS.
+     */
+    void updateEstimates()
+    {
+        unsigned long start = Hal::micros();
+        uint16_t heatersOn;
+        {
+            Hal::InterruptLock lock;
+            heatersOn = _heatersOn;
+        }
+        for (uint8_t i = 0; i < CHAMBERS; i++)
+        {
+            _estimator[i].update(Calibration::temperatureFromSample(_sampler.read(i)), heatersOn & chamberBit(i));
+        }
+        _cost.add(ChamberCost::ESTIMATE, static_cast<uint16_t>(Hal::micros() - start));
+    }
+
+    /**
+     * @brief The heater control step of every chamber that is heating up or maintaining.
+     *        Runs as a scheduler task every HEATER_CONTROL_PERIOD_MS.
+     * @details Always HeaterControl::duty(): `parameters.heaterControlMode` is not read.
+     */
+    void updateHeaterDuties()
+    {
+        unsigned long start = Hal::micros();
+        if (!_stopped && !_gasAlarm)
+        {
+            for (uint8_t i = 0; i < CHAMBERS; i++)
+            {
+                if (_state[i] == States::Type::PREHEATING || _state[i] == States::Type::MAINTAINING)
+                {
+                    Temperature error = _setpoint[i] - _estimator[i].temperature();
+                    setDuty(i, HeaterControl::duty(error, _estimator[i].rate(), _dutyIntegral[i]));
+                }
+            }
+        }
+        _cost.add(ChamberCost::HEATER, static_cast<uint16_t>(Hal::micros() - start));
+    }
+
+    /**
+     * @brief The tick hook: advances every heater window, then writes the heater pins
+     *        that changed. Interrupt context.
+     * @details An emergency stop or a gas trip opens every relay on the next tick,
+     *          without waiting for the FSM task.
+     */
+    void onTick()
+    {
+        unsigned long start = Hal::micros();
+        uint16_t on = 0;
+        if (!_stopRequested && !_gasTripped)
+        {
+            uint16_t windowTicks = _windowTicks;
+            uint16_t heatersOn = _heatersOn;
+            for (uint8_t i = 0; i < CHAMBERS; i++)
+            {
+                if (_window[i].tick(windowTicks, _requestedOnTicks[i], heatersOn & chamberBit(i)))
+                {
+                    on |= chamberBit(i);
+                }
+            }
+        }
+
+        uint16_t changed = on ^ _heatersOn;
+        if (changed)
+        {
+            for (uint8_t i = 0; i < CHAMBERS; i++)
+            {
+                if (changed & chamberBit(i))
+                {
+                    Hal::fastWrite(_heater[i], on & chamberBit(i));
+                    _switches++;
+                }
+            }
+            _heatersOn = on;
+        }
+        _cost.add(ChamberCost::TICK, static_cast<uint16_t>(Hal::micros() - start));
+    }
+
+    /**
+     * @brief An ISR-safe method to trigger the hardware emergency stop of every chamber.
+     * @details Opens every relay and lights the red LED before returning; the tick hook
+     *          then keeps the relays open.
+     */
+    void triggerEmergencyStop()
+    {
+        LATENCY_INPUT_EDGE();
+        Hal::InterruptLock lock;
+        _stopRequested = true;
+        openRelays();
+        Hal::fastWrite(_redLed, true);
+        _ledsShown |= States::OUTPUT_RED_LED;
+        LATENCY_OUTPUT_EDGE();
+    }
+
+    /**
+     * @brief The sampler's gas trip: opens every relay at once and holds them open
+     *        until the FSM clears the alarm. Interrupt context.
+     */
+    static void onGasTrip(void *context)
+    {
+        MultiChamberController &self = *static_cast<MultiChamberController *>(context);
+        self._gasTripped = true;
+        self.openRelays();
+    }
+
+    /**
+     * @brief Changes the setpoint of a chamber, from the next FSM pass.
+     */
+    void setSetpoint(uint8_t chamber, Temperature setpoint) { _setpoint[chamber] = setpoint; }
+
+    // --- Read-only access, for diagnostics and simulation ---
+    States::Type getState(uint8_t chamber) const { return _state[chamber]; }
+    Temperature getSetpoint(uint8_t chamber) const { return _setpoint[chamber]; }
+    const TemperatureEstimator &getEstimator(uint8_t chamber) const { return _estimator[chamber]; }
+    uint8_t getHeaterDuty(uint8_t chamber) const { return _duty[chamber]; }
+    bool isGasAlarm() const { return _gasAlarm; }
+
+    bool isHeaterOn(uint8_t chamber) const
+    {
+        Hal::InterruptLock lock;
+        return _heatersOn & chamberBit(chamber);
+    }
+
+    /**
+     * @brief Returns the number of heater relay transitions, over all chambers.
+     */
+    uint32_t getHeaterSwitchCount() const
+    {
+        Hal::InterruptLock lock;
+        return _switches;
+    }
+
+    /**
+     * @brief Writes the per-chamber cost of the batched steps as CSV (see ChamberCost::report()).
+     */
+    void reportCost(Hal::SerialPort &port) const
+    {
+        static const uint16_t periodMs[ChamberCost::STEP_COUNT] = {
+            MULTICHAMBER_FSM_PERIOD_MS, ESTIMATOR_PERIOD_MS, HEATER_CONTROL_PERIOD_MS, SCHEDULER_TICK_MS};
+        _cost.report(port, CHAMBERS, bytesPerChamber(), periodMs);
+    }
+
+    /**
+     * @brief Returns the RAM one more chamber takes.
+     */
+    static constexpr uint16_t bytesPerChamber()
+    {
+        return sizeof(MultiChamberController<2>) - sizeof(MultiChamberController<1>);
+    }
+
+private:
+    static constexpr uint8_t GAS_CHANNEL = CHAMBERS; // The sampler scans the TMP36 inputs first
+    static constexpr uint16_t PRIMING_POLL_US = 100;
+    static constexpr uint16_t ROTATION_PASSES = MULTICHAMBER_ROTATION_MS / MULTICHAMBER_FSM_PERIOD_MS;
+
+    struct SamplerPins
+    {
+        uint8_t pins[CHAMBERS + 1];
+    };
+
+    static SamplerPins samplerPins(const MultiChamberPins &pins, const ChamberConfig (&chambers)[CHAMBERS])
+    {
+        SamplerPins result{};
+        for (uint8_t i = 0; i < CHAMBERS; i++)
+        {
+            result.pins[i] = chambers[i].temperaturePin;
+        }
+        result.pins[GAS_CHANNEL] = pins.gasSensor;
+        return result;
+    }
+
+    static uint16_t chamberBit(uint8_t chamber) { return static_cast<uint16_t>(1U << chamber); }
+
+    // --- Shared hardware ---
+    DisplayManager &_display;
+    BasicAdcSampler<CHAMBERS + 1> _sampler; // Every TMP36, then the gas sensor
+    Siren _siren;
+    uint8_t _greenLedPin;
+    uint8_t _redLedPin;
+    Hal::FastPin _greenLed; // Resolved by begin()
+    Hal::FastPin _redLed;
+    uint8_t _ledsShown;     // OUTPUT_GREEN_LED and OUTPUT_RED_LED as the pins show them
+
+    // --- Per-chamber state, one array per field ---
+    uint8_t _heaterPin[CHAMBERS];
+    Hal::FastPin _heater[CHAMBERS];
+    States::Type _state[CHAMBERS];
+    Temperature _setpoint[CHAMBERS];
+    TemperatureEstimator _estimator[CHAMBERS];
+    int32_t _dutyIntegral[CHAMBERS]; // See HeaterControl::duty()
+    uint8_t _duty[CHAMBERS];         // Percent
+
+    // Heater PWM: written with interrupts off, read by the tick hook
+    volatile uint16_t _windowTicks; // Shared by every chamber
+    volatile uint16_t _requestedOnTicks[CHAMBERS];
+
+    // Heater PWM: owned by the tick hook
+    HeaterWindow _window[CHAMBERS];
+    volatile uint16_t _heatersOn; // Bit i set while chamber i's relay is closed
+    volatile uint32_t _switches;
+
+    // --- Shared state ---
+    volatile bool _stopRequested; // Set by the emergency button interrupt
+    volatile bool _gasTripped;    // Set by onGasTrip(), cleared with the alarm
+    bool _stopped;                // The emergency screen is up
+    bool _gasAlarm;
+    unsigned long _gasAlarmMs;    // millis() of the last trip
+    int _gasValue;
+
+    // --- Display rotation ---
+    uint8_t _shownChamber;
+    uint16_t _rotationPasses;
+    uint8_t _previousChamberPrinted;
+    const char *_previousLabelPrinted;
+    Temperature _previousTemperaturePrinted;
+    Temperature _previousSetpointPrinted;
+    int _previousGasValuePrinted;
+
+    ChamberCost _cost;
+
+    /**
+     * @brief Sets the gas alarm with hysteresis: on at a trip or at the gas_high parameter,
+     *        off below gas_low once gas_hold_ms have passed. Clearing it releases the
+     *        heaters and re-arms the trip.
+     */
+    void updateGasAlarm()
+    {
+        bool tripped = _gasTripped;
+        if (tripped && !_gasAlarm)
+        {
+            _gasAlarmMs = Hal::millis();
+        }
+        if (!_gasAlarm)
+        {
+            _gasAlarm = tripped || _gasValue >= parameters.gasHighThreshold;
+        }
+        else if (_gasValue < parameters.gasLowThreshold && Hal::millis() - _gasAlarmMs >= parameters.gasTripHoldMs)
+        {
+            _gasAlarm = false;
+            _gasTripped = false;
+            _sampler.rearm();
+        }
+    }
+
+    /**
+     * @brief Opens every closed relay now. Interrupts must be off.
+     */
+    void openRelays()
+    {
+        uint16_t on = _heatersOn;
+        for (uint8_t i = 0; i < CHAMBERS; i++)
+        {
+            if (on & chamberBit(i))
+            {
+                Hal::fastWrite(_heater[i], false);
+                _switches++;
+            }
+        }
+        _heatersOn = 0;
+    }
+
+    void setDuty(uint8_t chamber, uint8_t percent)
+    {
+        _duty[chamber] = percent;
+        // The division happens here, never in the tick hook. Only begin() writes the window.
+        uint16_t onTicks = HeaterWindow::onTicks(_windowTicks, percent);
+        Hal::InterruptLock lock;
+        _requestedOnTicks[chamber] = onTicks;
+    }
+
+    /**
+     * @brief Writes the LED outputs that changed to their pins.
+     */
+    void commitLeds(bool green, bool red)
+    {
+        uint8_t leds = (green ? States::OUTPUT_GREEN_LED : 0) | (red ? States::OUTPUT_RED_LED : 0);
+        Hal::InterruptLock lock; // triggerEmergencyStop() writes the red LED too
+        if (_stopRequested)
+        {
+            leds |= States::OUTPUT_RED_LED;
+        }
+        uint8_t changed = leds ^ _ledsShown;
+        if (changed & States::OUTPUT_GREEN_LED)
+        {
+            Hal::fastWrite(_greenLed, green);
+        }
+        if (changed & States::OUTPUT_RED_LED)
+        {
+            Hal::fastWrite(_redLed, red);
+        }
+        _ledsShown = leds;
+    }
+
+    /**
+     * @brief Moves to the next chamber every ROTATION_PASSES passes, and redraws the
+     *        status screen when the chamber shown or one of its readings changed.
+     */
+    void updateDisplay()
+    {
+        if (++_rotationPasses >= ROTATION_PASSES)
+        {
+            _rotationPasses = 0;
+            _shownChamber = _shownChamber + 1 < CHAMBERS ? _shownChamber + 1 : 0;
+        }
+        uint8_t chamber = _shownChamber;
+        const char *label = _gasAlarm ? States::GAS_WARNING.label : States::label(_state[chamber]);
+        Temperature temperature = _estimator[chamber].temperature();
+        if (_previousChamberPrinted != chamber ||
+            _previousLabelPrinted != label ||
+            _previousTemperaturePrinted != temperature ||
+            _previousSetpointPrinted != _setpoint[chamber] ||
+            _previousGasValuePrinted != _gasValue)
+        {
+            _previousChamberPrinted = chamber;
+            _previousLabelPrinted = label;
+            _previousTemperaturePrinted = temperature;
+            _previousSetpointPrinted = _setpoint[chamber];
+            _previousGasValuePrinted = _gasValue;
+            _display.displayChamberStatus(chamber, label, temperature, _setpoint[chamber], _gasValue);
+        }
+    }
+};
@@ -0,0 +1,290 @@
+//=================================================================================
+// MultiChamberMain.cpp
+// Entry point of the multi-chamber builds (env:uno_multichamber, env:native_multichamber).
+// Responsibilities:
+// - Wire MULTICHAMBER_CHAMBERS chambers (3 by default, -DBIOLOGIC_CHAMBERS=<n> to change)
+//   to one MultiChamberController, sharing the gas sensor, LEDs, siren and LCD.
+// - Run it on the scheduler, as main.cpp runs the single-chamber firmware.
+// - Report what one chamber costs, to size a board.
+//
+// On the board, send 'c' over Serial for the cost report, 't' for the task statistics.
+// On the host the chambers run on a MultiChamberBoard and both reports are printed at
+// the end of the run:
+//   program [hours=6] [seed=1] [gas=<start_s>:<duration_s>:<raw>]... [estop=<s>]
+// Host timings count the simulated hardware accesses only; the CPU cost of the code
+// itself is measured on the board.
+// ============================================================================================
+
+#include "MultiChamberController.h"
+#include "../display/DisplayManager.h"
+#include "../core/Scheduler.h"
+#include "../diagnostics/Telemetry.h"
+
+#ifndef ARDUINO
+#include "MultiChamberBoard.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#endif
+
+#ifdef BIOLOGIC_CHAMBERS
+constexpr uint8_t MULTICHAMBER_CHAMBERS = BIOLOGIC_CHAMBERS;
+#else
+constexpr uint8_t MULTICHAMBER_CHAMBERS = 3;
+#endif
+
+// PIN DEFINITIONS (shared wiring as in main.cpp)
+constexpr byte EMERGENCY_BUTTON_PIN = 3;
+constexpr byte GREEN_LED_PIN = 10;
+constexpr byte RED_LED_PIN = 12;
+constexpr byte PIEZO_PIN = 13;
+constexpr byte GAS_SENSOR_PIN = A2;
+constexpr byte I2C_ADDRESS = 0x27;
+
+// Chamber i reads its TMP36 on TEMPERATURE_PINS[i] and drives its heater on HEATER_PINS[i]
+#if defined(ARDUINO) && NUM_ANALOG_INPUTS <= 6
+// Uno: A4 and A5 carry the LCD's I2C bus
+constexpr byte TEMPERATURE_PINS[] = {A0, A1, A3};
+constexpr byte HEATER_PINS[] = {2, 4, 5};
+#else
+// Mega (I2C is on pins 20 and 21) and the host
+constexpr byte TEMPERATURE_PINS[] = {A0, A0 + 1, A0 + 3, A0 + 4, A0 + 5, A0 + 6, A0 + 7, A0 + 8,
+                                     A0 + 9, A0 + 10, A0 + 11, A0 + 12, A0 + 13, A0 + 14, A0 + 15};
+constexpr byte HEATER_PINS[] = {2, 4, 5, 6, 7, 8, 9, 11, 22, 23, 24, 25, 26, 27, 28};
+#endif
+static_assert(MULTICHAMBER_CHAMBERS <= sizeof(TEMPERATURE_PINS), "Not enough analog inputs on this board");
+
+// Initial setpoints, cycled over the chambers
+constexpr Temperature SETPOINTS[] = {celsius(30.0), celsius(25.0), celsius(35.0)};
+
+// SERIAL COMMANDS
+constexpr char TASK_REPORT_COMMAND = 't';
+constexpr char COST_REPORT_COMMAND = 'c'; // Dump the per-chamber cost and how many chambers fit
+constexpr uint16_t SERIAL_TASK_PERIOD_MS = 50;
+constexpr uint16_t SERIAL_TASK_PHASE_MS = 4;
+constexpr uint16_t SERIAL_TASK_DEADLINE_MS = 10;
+
+struct ChamberWiring
+{
+    ChamberConfig chambers[MULTICHAMBER_CHAMBERS];
+};
+
+constexpr ChamberWiring wiring()
+{
+    ChamberWiring result{};
+    for (uint8_t i = 0; i < MULTICHAMBER_CHAMBERS; i++)
+    {
+        result.chambers[i] = {TEMPERATURE_PINS[i], HEATER_PINS[i], SETPOINTS[i % (sizeof(SETPOINTS) / sizeof(SETPOINTS[0]))]};
+    }
+    return result;
+}
+
+constexpr ChamberWiring WIRING = wiring();
+constexpr MultiChamberPins SHARED_PINS{GAS_SENSOR_PIN, GREEN_LED_PIN, RED_LED_PIN, PIEZO_PIN};
+
+using Controller = MultiChamberController<MULTICHAMBER_CHAMBERS>;
+
+#ifdef ARDUINO
+
+// OBJECT DEFINITIONS
+DisplayManager lcd(I2C_ADDRESS);
+Controller controller(SHARED_PINS, WIRING.chambers, lcd);
+Scheduler scheduler;
+
+void emergencyStopISR() {
+  controller.triggerEmergencyStop();
+}
+
+/**
+ * @brief Scheduler task answering the diagnostic commands received over Serial.
+ */
+void serialCommandTask(void *) {
+  int command = Serial.read();
+  if (command == TASK_REPORT_COMMAND) {
+    scheduler.report(Serial);
+  }
+  if (command == COST_REPORT_COMMAND) {
+    controller.reportCost(Serial);
+  }
+}
+
+void setup() {
+  Serial.begin(TELEMETRY_BAUD);
+  lcd.begin();
+  controller.begin();
+  pinMode(EMERGENCY_BUTTON_PIN, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(EMERGENCY_BUTTON_PIN), emergencyStopISR, FALLING);
+
+  // Task table, in priority order within a tick
+  controller.registerTasks(scheduler);
+  lcd.registerTasks(scheduler);
+  scheduler.add("serial", serialCommandTask, nullptr, SERIAL_TASK_PERIOD_MS, SERIAL_TASK_PHASE_MS, SERIAL_TASK_DEADLINE_MS);
+  scheduler.begin();
+}
+
+void loop() {
+  scheduler.idle();
+  scheduler.dispatch();
+}
+
+#else
+
+// RUN DEFAULTS
+constexpr double DEFAULT_HOURS = 6.0;
+constexpr uint64_t LOOP_OVERHEAD_US = 20;       // CPU time of a pass that touches no hardware (as SimMain)
+constexpr uint32_t SAMPLE_PERIOD_S = 1;         // Control-quality sampling period
+constexpr uint32_t SETTLE_AFTER_START_S = 3600; // Errors are measured from then on
+constexpr float PLANT_SPREAD = 0.15f;           // Chamber i's losses and thermal mass differ by i x 15 %
+
+struct RunOptions
+{
+    double hours = DEFAULT_HOURS;
+    int32_t emergencyStopS = -1;
+    std::vector<GasEvent> gasEvents;
+};
+
+static bool parseOption(const char *arg, RunOptions &options, ChamberModel &model)
+{
+    const char *eq = strchr(arg, '=');
+    if (eq == nullptr)
+    {
+        return false;
+    }
+    size_t keyLength = eq - arg;
+    const char *value = eq + 1;
+    auto is = [&](const char *key) { return strlen(key) == keyLength && strncmp(arg, key, keyLength) == 0; };
+
+    if (is("hours")) options.hours = atof(value);
+    else if (is("seed")) model.seed = static_cast<uint32_t>(atol(value));
+    else if (is("estop")) options.emergencyStopS = static_cast<int32_t>(atol(value));
+    else if (is("gas"))
+    {
+        GasEvent event{};
+        if (sscanf(value, "%u:%u:%d", &event.startS, &event.durationS, &event.raw) != 3)
+        {
+            return false;
+        }
+        options.gasEvents.push_back(event);
+    }
+    else return false;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    RunOptions options;
+    ChamberModel model;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!parseOption(argv[i], options, model))
+        {
+            fprintf(stderr, "Unknown or malformed option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    // Chamber 0 is the simulator's own plant; the potentiometer is not wired.
+    const ChamberPins pins{HEATER_PINS[0], GREEN_LED_PIN, RED_LED_PIN, PIEZO_PIN,
+                           TEMPERATURE_PINS[0], GAS_SENSOR_PIN, A5};
+    static MultiChamberBoard board(pins, model);
+    for (const GasEvent &event : options.gasEvents)
+    {
+        board.addGasEvent(event);
+    }
+    for (uint8_t i = 1; i < MULTICHAMBER_CHAMBERS; i++)
+    {
+        ChamberModel plant = model;
+        plant.seed = model.seed + i;
+        plant.chamberLossWPerK *= 1.0f + PLANT_SPREAD * i;
+        plant.chamberCapacityJPerK *= 1.0f + PLANT_SPREAD * i;
+        board.addChamber(TEMPERATURE_PINS[i], HEATER_PINS[i], plant);
+    }
+    NativeBoard::install(board);
+
+    // OBJECT DEFINITIONS (same graph as on the board)
+    static DisplayManager lcd(I2C_ADDRESS);
+    static Controller controller(SHARED_PINS, WIRING.chambers, lcd);
+    static Scheduler scheduler;
+
+    // setup()
+    Hal::serial().begin(TELEMETRY_BAUD);
+    lcd.begin();
+    controller.begin();
+    controller.registerTasks(scheduler);
+    lcd.registerTasks(scheduler);
+    scheduler.begin();
+
+    const uint64_t endUs = static_cast<uint64_t>(options.hours * 3600.0 * 1e6);
+    uint64_t loops = 0;
+    uint64_t busyUs = 0;
+    uint64_t worstLoopUs = 0;
+    uint64_t nextSampleUs = 0;
+    bool emergencyTriggered = false;
+    double sumAbsErrorC[MULTICHAMBER_CHAMBERS] = {};
+    uint32_t settledSamples = 0;
+
+    while (board.nowMicros() < endUs)
+    {
+        // loop()
+        scheduler.idle();
+        if (!emergencyTriggered && options.emergencyStopS >= 0 &&
+            board.nowMicros() >= static_cast<uint64_t>(options.emergencyStopS) * 1000000)
+        {
+            controller.triggerEmergencyStop(); // What emergencyStopISR() does on the board
+            emergencyTriggered = true;
+        }
+        uint64_t passStartUs = board.nowMicros();
+        scheduler.dispatch();
+        board.advance(LOOP_OVERHEAD_US);
+        uint64_t passUs = board.nowMicros() - passStartUs;
+        loops++;
+        busyUs += passUs;
+        worstLoopUs = passUs > worstLoopUs ? passUs : worstLoopUs;
+
+        uint64_t now = board.nowMicros();
+        if (now >= nextSampleUs)
+        {
+            nextSampleUs += SAMPLE_PERIOD_S * 1000000ULL;
+            if (now >= SETTLE_AFTER_START_S * 1000000ULL)
+            {
+                settledSamples++;
+                for (uint8_t i = 0; i < MULTICHAMBER_CHAMBERS; i++)
+                {
+                    sumAbsErrorC[i] += fabs(board.plantTemperature(i) - TemperatureMath::toFloat(controller.getSetpoint(i)));
+                }
+            }
+        }
+    }
+
+    double virtualS = board.nowMicros() / 1e6;
+    double virtualHours = virtualS / 3600.0;
+    printf("# Bio-Logic Controller multi-chamber simulation\n");
+    printf("chambers               %u\n", MULTICHAMBER_CHAMBERS);
+    printf("virtual_hours          %.2f\n", virtualHours);
+    printf("loops                  %llu\n", static_cast<unsigned long long>(loops));
+    printf("loop_mean_virtual_us   %.1f\n", loops > 0 ? static_cast<double>(busyUs) / loops : 0.0);
+    printf("loop_worst_virtual_us  %llu\n", static_cast<unsigned long long>(worstLoopUs));
+    printf("cpu_busy_pct           %.2f\n", virtualS > 0 ? 100.0 * busyUs / 1e6 / virtualS : 0.0);
+    printf("relay_switches_per_h   %.1f\n", virtualHours > 0 ? controller.getHeaterSwitchCount() / virtualHours : 0.0);
+    printf("chamber,setpoint_c,final_c,mean_abs_error_c,state,heater_duty_pct,heater_energy_wh\n");
+    for (uint8_t i = 0; i < MULTICHAMBER_CHAMBERS; i++)
+    {
+        const ChamberStats &stats = board.plantStats(i);
+        printf("%u,%.2f,%.2f,%.3f,%s,%.1f,%.2f\n", i, TemperatureMath::toFloat(controller.getSetpoint(i)),
+               board.plantTemperature(i), settledSamples > 0 ? sumAbsErrorC[i] / settledSamples : 0.0,
+               States::label(controller.getState(i)), virtualS > 0 ? 100.0 * stats.heaterOnUs / 1e6 / virtualS : 0.0,
+               stats.heaterEnergyJ / 3600.0);
+    }
+    printf("lcd                    [%s] [%s]\n", board.lcdLine(0), board.lcdLine(1));
+
+    // The board's own reports, as sent over Serial
+    fflush(stdout);
+    board.setSerialOutput(stdout);
+    scheduler.report(Hal::serial());
+    controller.reportCost(Hal::serial());
+    return 0;
+}
+
+#endif
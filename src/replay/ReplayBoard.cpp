@@ -0,0 +1,62 @@
+#include "ReplayBoard.h"
+#include "../sensors/SensorManager.h"
+
+namespace
+{
+    constexpr uint8_t PATTERN_LENGTH = 1 << ADC_EXTRA_BITS;          // A result sums 4 patterns
+    constexpr uint16_t MAX_SAMPLE = 1023 << ADC_EXTRA_BITS;          // 16 conversions of 1023
+    constexpr uint8_t NO_PIN = 0xFF;                                 // No emergency stop pin set
+}
+
+ReplayBoard::ReplayBoard(const ChamberPins &pins, const ChamberModel &model)
+    : ChamberSimulator(pins, model),
+      _replayPins(pins),
+      _samples{},
+      _conversions{},
+      _primed(false),
+      _emergencyStopPin(NO_PIN),
+      _emergencyStopHeld(false)
+{
+}
+
+void ReplayBoard::setInputs(const ReplayInputs &inputs)
+{
+    const uint16_t samples[ADC_CHANNEL_COUNT] = {inputs.temperatureSample, inputs.gasSample, inputs.setpointSample};
+    bool changed = !_primed;
+    for (uint8_t channel = 0; channel < ADC_CHANNEL_COUNT; channel++)
+    {
+        uint16_t sample = samples[channel] < MAX_SAMPLE ? samples[channel] : MAX_SAMPLE;
+        changed |= sample != _samples[channel];
+        _samples[channel] = sample;
+    }
+    _primed = true;
+    _emergencyStopHeld = inputs.emergencyStopHeld;
+    if (changed)
+    {
+        flushAdc(REPLAY_FLUSH_CONVERSIONS);
+    }
+}
+
+bool ReplayBoard::digitalRead(uint8_t pin)
+{
+    return pin == _emergencyStopPin ? !_emergencyStopHeld : ChamberSimulator::digitalRead(pin);
+}
+
+int ReplayBoard::sampleAnalog(uint8_t pin)
+{
+    uint8_t channel;
+    if (pin == _replayPins.temperatureSensor)
+        channel = TEMPERATURE_CHANNEL;
+    else if (pin == _replayPins.gasSensor)
+        channel = GAS_CHANNEL;
+    else if (pin == _replayPins.potentiometer)
+        channel = POTENTIOMETER_CHANNEL;
+    else
+        return 0;
+
+    uint16_t sample = _samples[channel];
+    uint8_t position = _conversions[channel];
+    _conversions[channel] = (position + 1) % PATTERN_LENGTH;
+    uint8_t remainder = sample & (PATTERN_LENGTH - 1);
+    return (sample >> ADC_EXTRA_BITS) + (position < remainder ? 1 : 0);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../sim/ChamberSimulator.h"
+#include "../sensors/AdcSampler.h"
+#include "ReplayTrace.h"
+
+// Conversions that push a reading through the whole sampler: the visit in progress,
+// then enough visits of every channel to refill its averaging ring.
+constexpr uint16_t REPLAY_FLUSH_CONVERSIONS =
+    ((1 << ADC_HISTORY_SHIFT) + 1) * ADC_CHANNEL_COUNT * ((1 << ADC_OVERSAMPLE_SHIFT) + 1);
+
+/**
+ * @class ReplayBoard
+ * @brief A chamber whose analog inputs come from a recorded trace instead of the plant.
+ *
+ * @details Everything else (clock, tick and tone interrupts, LCD decoding, EEPROM,
+ *          UART) is the simulator's, so the firmware runs exactly as in a simulated
+ *          run and its decisions can be compared with the recorded ones.
+ *
+ *          The trace holds the sampler's 12-bit readings, not raw conversions. Each
+ *          reading `4 * base + r` is served as a repeating pattern of 10-bit conversions
+ *          in which `r` out of every 4 are `base + 1`: any 16 consecutive conversions
+ *          then sum to exactly 16 times the reading, so every oversampled result equals
+ *          it. When a reading changes, the sampler's pipeline is flushed at once with
+ *          REPLAY_FLUSH_CONVERSIONS conversions, so the firmware sees the new value
+ *          from the very next read, as it did on the recorded run.
+ */
+class ReplayBoard : public ChamberSimulator
+{
+public:
+    ReplayBoard(const ChamberPins &pins, const ChamberModel &model);
+
+    /**
+     * @brief Makes the sampler read the given values from now on.
+     */
+    void setInputs(const ReplayInputs &inputs);
+
+    /**
+     * @brief Sets the input that reads the recorded emergency button level.
+     */
+    void setEmergencyStopPin(uint8_t pin) { _emergencyStopPin = pin; }
+
+    bool digitalRead(uint8_t pin) override;
+
+protected:
+    int sampleAnalog(uint8_t pin) override;
+
+private:
+    ChamberPins _replayPins;
+    uint16_t _samples[ADC_CHANNEL_COUNT];     // By sampler channel
+    uint8_t _conversions[ADC_CHANNEL_COUNT]; // Position in each channel's pattern
+    bool _primed;                             // At least one setInputs() call so far
+    uint8_t _emergencyStopPin;
+    bool _emergencyStopHeld;
+};
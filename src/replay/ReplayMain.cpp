@@ -0,0 +1,290 @@
+//=================================================================================
+// ReplayMain.cpp
+// Entry point of the trace replay harness (native build, env:native_replay).
+// Responsibilities:
+// - Build the same object graph as main.cpp on top of a ReplayBoard.
+// - Feed the recorded sampler readings to the firmware at the recorded millis().
+// - Compare the firmware's decisions with the recorded ones, pass by pass.
+// - Report divergence and throughput.
+//
+// Usage: program <trace.csv> [window=<heater window ms>] [log=<run log interval s>]
+//                [telemetry=<period ms, 0 = off>] [param=<name>:<value>]... [diff=<file.csv>]
+//
+// Record a trace with the simulator (record=<file.csv>) and replay it with the same
+// options. The exit status is 0 when every decision matched, so a trace of a field
+// incident doubles as a regression test.
+// ============================================================================================
+
+#include "ReplayBoard.h"
+#include "ReplayTrace.h"
+#include "../controllers/ActuatorController.h"
+#include "../sensors/SensorManager.h"
+#include "../sensors/DebouncedButton.h"
+#include "../display/DisplayManager.h"
+#include "../core/SystemState.h"
+#include "../core/Scheduler.h"
+#include "../storage/RunLog.h"
+#include "../storage/ParameterStore.h"
+#include "../diagnostics/Telemetry.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// PIN DEFINITIONS (same wiring as main.cpp)
+constexpr byte TRANSISTOR_PIN = 2;
+constexpr byte EMERGENCY_BUTTON_PIN = 3;
+constexpr byte GREEN_LED_PIN = 10;
+constexpr byte ACKNOWLEDGE_BUTTON_PIN = 11;
+constexpr byte RED_LED_PIN = 12;
+constexpr byte PIEZO_PIN = 13;
+constexpr byte TEMPERATURE_SENSOR_PIN = A0;
+constexpr byte GAS_SENSOR_PIN = A2;
+constexpr byte POTENTIOMETER_PIN = A3;
+constexpr byte I2C_ADDRESS = 0x27;
+
+constexpr uint64_t LOOP_OVERHEAD_US = 20; // Same as the simulator, so passes fall on the same ticks
+
+struct ReplayOptions
+{
+    const char *tracePath = nullptr;
+    const char *diffPath = nullptr;
+    std::vector<std::pair<std::string, uint16_t>> parameterSettings; // Name and value, in order
+    uint16_t telemetryPeriodMs = TELEMETRY_DEFAULT_PERIOD_MS;
+};
+
+struct DivergenceStats
+{
+    uint32_t steps = 0;
+    uint32_t divergedSteps = 0;
+    uint32_t state = 0;
+    uint32_t duty = 0;
+    uint32_t outputs = 0;
+    uint32_t lcd = 0;
+    int64_t firstMs = -1;
+};
+
+static bool parseOption(const char *arg, ReplayOptions &options)
+{
+    const char *eq = strchr(arg, '=');
+    if (eq == nullptr)
+    {
+        options.tracePath = arg;
+        return true;
+    }
+    size_t keyLength = eq - arg;
+    const char *value = eq + 1;
+    auto is = [&](const char *key) { return strlen(key) == keyLength && strncmp(arg, key, keyLength) == 0; };
+
+    if (is("window")) options.parameterSettings.emplace_back("window_ms", static_cast<uint16_t>(atol(value)));
+    else if (is("log")) options.parameterSettings.emplace_back("log_s", static_cast<uint16_t>(atol(value)));
+    else if (is("telemetry"))
+    {
+        options.telemetryPeriodMs = static_cast<uint16_t>(atol(value));
+        if (options.telemetryPeriodMs != 0)
+        {
+            options.parameterSettings.emplace_back("telem_ms", options.telemetryPeriodMs);
+        }
+    }
+    else if (is("param"))
+    {
+        const char *colon = strchr(value, ':');
+        if (colon == nullptr)
+        {
+            return false;
+        }
+        options.parameterSettings.emplace_back(std::string(value, colon), static_cast<uint16_t>(atol(colon + 1)));
+    }
+    else if (is("diff")) options.diffPath = value;
+    else return false;
+    return true;
+}
+
+static void check(const ReplayStep &step, const ReplayDecisions &actual, DivergenceStats &stats, FILE *diff)
+{
+    stats.steps++;
+    uint8_t differs = Replay::compare(step.decisions, actual);
+    if (differs == 0)
+    {
+        return;
+    }
+    stats.divergedSteps++;
+    stats.state += (differs & REPLAY_STATE_DIFFERS) ? 1 : 0;
+    stats.duty += (differs & REPLAY_DUTY_DIFFERS) ? 1 : 0;
+    stats.outputs += (differs & REPLAY_OUTPUTS_DIFFERS) ? 1 : 0;
+    stats.lcd += (differs & REPLAY_LCD_DIFFERS) ? 1 : 0;
+    if (stats.firstMs < 0)
+    {
+        stats.firstMs = step.timeMs;
+    }
+    if (diff != nullptr)
+    {
+        const ReplayDecisions &expected = step.decisions;
+        fprintf(diff, "%lu,%u,%u,%u,%u,%u,%u,%u,\"%s|%s\",\"%s|%s\"\n", static_cast<unsigned long>(step.timeMs),
+                differs, expected.state, actual.state, expected.heaterDuty, actual.heaterDuty, expected.outputs,
+                actual.outputs, expected.lcd[0], expected.lcd[1], actual.lcd[0], actual.lcd[1]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ReplayOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!parseOption(argv[i], options))
+        {
+            fprintf(stderr, "Unknown or malformed option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (options.tracePath == nullptr)
+    {
+        fprintf(stderr, "Usage: %s <trace.csv> [window=<ms>] [log=<s>] [telemetry=<ms>] [param=<name>:<value>] [diff=<file.csv>]\n", argv[0]);
+        return 2;
+    }
+
+    ReplayTraceReader reader;
+    ReplayStep setupStep;
+    if (!reader.open(options.tracePath) || !reader.next(setupStep))
+    {
+        fprintf(stderr, "Cannot read replay trace %s\n", options.tracePath);
+        return 2;
+    }
+    FILE *diff = nullptr;
+    if (options.diffPath != nullptr)
+    {
+        diff = fopen(options.diffPath, "w");
+        if (diff == nullptr)
+        {
+            fprintf(stderr, "Cannot open diff file %s\n", options.diffPath);
+            return 2;
+        }
+        fprintf(diff, "time_ms,differs,state,replay_state,heater_duty,replay_heater_duty,outputs,replay_outputs,lcd,replay_lcd\n");
+    }
+
+    const ChamberPins pins{TRANSISTOR_PIN, GREEN_LED_PIN, RED_LED_PIN, PIEZO_PIN,
+                           TEMPERATURE_SENSOR_PIN, GAS_SENSOR_PIN, POTENTIOMETER_PIN};
+    static ReplayBoard board(pins, ChamberModel());
+    board.setEmergencyStopPin(EMERGENCY_BUTTON_PIN);
+    board.setInputs(setupStep.inputs);
+    NativeBoard::install(board);
+
+    // OBJECT DEFINITIONS (same graph as main.cpp)
+    static ActuatorController actuatorController(TRANSISTOR_PIN, GREEN_LED_PIN, RED_LED_PIN, PIEZO_PIN);
+    static SensorManager sensorManager(TEMPERATURE_SENSOR_PIN, GAS_SENSOR_PIN, POTENTIOMETER_PIN);
+    static DisplayManager lcd(I2C_ADDRESS);
+    static DebouncedButton acknowledgeButton(ACKNOWLEDGE_BUTTON_PIN);
+    static SystemState systemState(sensorManager, actuatorController, lcd, acknowledgeButton, EMERGENCY_BUTTON_PIN);
+    static RunLog runLog(systemState, sensorManager, actuatorController);
+    static ParameterStore parameterStore;
+    static Scheduler scheduler;
+    static Telemetry telemetry(systemState, sensorManager, actuatorController, scheduler);
+
+    // setup(), as in the simulator
+    Hal::serial().begin(TELEMETRY_BAUD);
+    parameterStore.begin([] {
+        actuatorController.setHeaterWindow(parameters.heaterWindowMs);
+        runLog.setInterval(parameters.logIntervalS);
+        telemetry.setPeriod(parameters.telemetryPeriodMs);
+        sensorManager.setGasTripLevel(parameters.gasHighThreshold);
+    });
+    for (const auto &setting : options.parameterSettings)
+    {
+        if (!parameterStore.set(setting.first.c_str(), setting.second))
+        {
+            fprintf(stderr, "Unknown parameter, or value out of range or order: %s=%u\n", setting.first.c_str(), setting.second);
+            return 2;
+        }
+    }
+    actuatorController.begin();
+    sensorManager.begin();
+    lcd.begin();
+    acknowledgeButton.begin();
+    systemState.begin();
+    runLog.begin();
+    telemetry.setEnabled(options.telemetryPeriodMs != 0);
+    telemetry.begin(Hal::serial());
+    actuatorController.registerTasks(scheduler);
+    systemState.registerTasks(scheduler);
+    sensorManager.registerTasks(scheduler);
+    lcd.registerTasks(scheduler);
+    runLog.registerTasks(scheduler);
+    telemetry.registerTasks(scheduler);
+    scheduler.begin();
+
+    DivergenceStats stats;
+    check(setupStep, Replay::captureDecisions(systemState, actuatorController, board), stats, diff);
+
+    ReplayStep next;
+    bool haveNext = reader.next(next);
+    uint64_t loops = 0;
+    auto wallStart = std::chrono::steady_clock::now();
+    while (haveNext)
+    {
+        // loop(), with the rows whose time has come applied before the dispatch
+        scheduler.idle();
+        uint32_t nowMs = Hal::millis();
+        bool due = false;
+        bool gasTrip = false;
+        ReplayStep step;
+        while (haveNext && next.timeMs <= nowMs)
+        {
+            step = next;
+            due = true;
+            gasTrip = gasTrip || next.inputs.gasTrip;
+            // The recorded events, not the edges: the FSM takes them as it did in the run.
+            Replay::injectButtonEvents(acknowledgeButton, next.inputs.button);
+            haveNext = reader.next(next);
+        }
+        if (due)
+        {
+            board.setInputs(step.inputs);
+            if (step.inputs.emergencyStop)
+            {
+                systemState.triggerEmergencyStop();
+            }
+            if (gasTrip)
+            {
+                // The sampler's trip is not armed here: it fires on raw conversions the
+                // trace does not hold, so the recorded one is replayed instead.
+                systemState.triggerGasTrip();
+            }
+        }
+        scheduler.dispatch();
+        board.advance(LOOP_OVERHEAD_US);
+        loops++;
+        if (due)
+        {
+            check(step, Replay::captureDecisions(systemState, actuatorController, board), stats, diff);
+        }
+    }
+    double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    if (diff != nullptr)
+    {
+        fclose(diff);
+    }
+    if (reader.error() != 0)
+    {
+        fprintf(stderr, "Malformed row at line %lu of %s\n", static_cast<unsigned long>(reader.error()), options.tracePath);
+        return 2;
+    }
+
+    double virtualS = board.nowMicros() / 1e6;
+    printf("# Bio-Logic Controller trace replay\n");
+    printf("trace                  %s\n", options.tracePath);
+    printf("virtual_hours          %.2f\n", virtualS / 3600.0);
+    printf("wall_seconds           %.3f\n", wallS);
+    printf("speedup                %.0f\n", wallS > 0 ? virtualS / wallS : 0.0);
+    printf("loops                  %llu\n", static_cast<unsigned long long>(loops));
+    printf("steps                  %lu\n", static_cast<unsigned long>(stats.steps));
+    printf("steps_per_second       %.0f\n", wallS > 0 ? stats.steps / wallS : 0.0);
+    printf("diverged_steps         %lu\n", static_cast<unsigned long>(stats.divergedSteps));
+    printf("diverged_state         %lu\n", static_cast<unsigned long>(stats.state));
+    printf("diverged_duty          %lu\n", static_cast<unsigned long>(stats.duty));
+    printf("diverged_outputs       %lu\n", static_cast<unsigned long>(stats.outputs));
+    printf("diverged_lcd           %lu\n", static_cast<unsigned long>(stats.lcd));
+    printf("first_divergence_ms    %lld\n", static_cast<long long>(stats.firstMs));
+    return stats.divergedSteps == 0 ? 0 : 1;
+}
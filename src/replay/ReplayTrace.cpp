@@ -0,0 +1,228 @@
+#include "ReplayTrace.h"
+#include "../sim/ChamberSimulator.h"
+#include "../core/SystemState.h"
+#include "../sensors/SensorManager.h"
+#include "../sensors/DebouncedButton.h"
+#include "../controllers/ActuatorController.h"
+#include "../diagnostics/Telemetry.h"
+
+#include <cstring>
+
+namespace
+{
+    const char TRACE_HEADER[] =
+        "time_ms,temperature_sample,gas_sample,setpoint_sample,estop,estop_held,gas_trip,button,state,heater_duty,outputs,lcd_line1,lcd_line2";
+    constexpr size_t LINE_CAPACITY = 256;
+    constexpr size_t WRITE_BUFFER_BYTES = 1 << 16;
+    constexpr uint8_t BUTTON_EVENT_BITS = 2; // Per event in the button field
+
+    // Copies a quoted field, returns the position after its closing quote or null.
+    const char *readQuoted(const char *in, char *out, size_t capacity)
+    {
+        if (*in != '"')
+        {
+            return nullptr;
+        }
+        in++;
+        size_t length = 0;
+        while (*in != '"' && *in != '\0')
+        {
+            if (length + 1 < capacity)
+            {
+                out[length++] = *in;
+            }
+            in++;
+        }
+        out[length] = '\0';
+        return *in == '"' ? in + 1 : nullptr;
+    }
+}
+
+// === CAPTURE ===
+ReplayInputs Replay::captureInputs(const SensorManager &sensorManager, bool emergencyStop, bool gasTrip)
+{
+    ReplayInputs inputs;
+    inputs.temperatureSample = sensorManager.getSample(TEMPERATURE_CHANNEL);
+    inputs.gasSample = sensorManager.getSample(GAS_CHANNEL);
+    inputs.setpointSample = sensorManager.getSample(POTENTIOMETER_CHANNEL);
+    inputs.emergencyStop = emergencyStop;
+    inputs.emergencyStopHeld = false;
+    inputs.gasTrip = gasTrip;
+    inputs.button = 0;
+    return inputs;
+}
+
+ReplayDecisions Replay::captureDecisions(const SystemState &systemState, const ActuatorController &actuatorController,
+                                         const ChamberSimulator &board)
+{
+    ReplayDecisions decisions;
+    decisions.state = static_cast<uint8_t>(systemState.getState());
+    decisions.heaterDuty = actuatorController.getHeaterDuty();
+    decisions.outputs = (actuatorController.isHeaterOn() ? TELEMETRY_HEATER_ON : 0) |
+                        (actuatorController.isGreenLedOn() ? TELEMETRY_GREEN_LED_ON : 0) |
+                        (actuatorController.isRedLedOn() ? TELEMETRY_RED_LED_ON : 0) |
+                        (actuatorController.isSirenOn() ? TELEMETRY_SIREN_ON : 0);
+    for (uint8_t row = 0; row < REPLAY_LCD_ROWS; row++)
+    {
+        const char *line = board.lcdLine(row);
+        size_t length = strnlen(line, REPLAY_LCD_COLS);
+        memcpy(decisions.lcd[row], line, length);
+        decisions.lcd[row][length] = '\0';
+    }
+    return decisions;
+}
+
+void Replay::injectButtonEvents(DebouncedButton &button, uint16_t events)
+{
+    // The events taken are never NONE: the zero pairs are the unused high ones.
+    for (int8_t shift = 16 - BUTTON_EVENT_BITS; shift >= 0; shift -= BUTTON_EVENT_BITS)
+    {
+        ButtonEvent event = static_cast<ButtonEvent>((events >> shift) & ((1 << BUTTON_EVENT_BITS) - 1));
+        if (event != ButtonEvent::NONE)
+        {
+            button.inject(event);
+        }
+    }
+}
+
+bool Replay::sameInputs(const ReplayInputs &a, const ReplayInputs &b)
+{
+    return a.temperatureSample == b.temperatureSample && a.gasSample == b.gasSample &&
+           a.setpointSample == b.setpointSample && a.emergencyStop == b.emergencyStop &&
+           a.emergencyStopHeld == b.emergencyStopHeld && a.gasTrip == b.gasTrip && a.button == b.button;
+}
+
+uint8_t Replay::compare(const ReplayDecisions &expected, const ReplayDecisions &actual)
+{
+    uint8_t differs = 0;
+    differs |= expected.state != actual.state ? REPLAY_STATE_DIFFERS : 0;
+    differs |= expected.heaterDuty != actual.heaterDuty ? REPLAY_DUTY_DIFFERS : 0;
+    differs |= expected.outputs != actual.outputs ? REPLAY_OUTPUTS_DIFFERS : 0;
+    for (uint8_t row = 0; row < REPLAY_LCD_ROWS; row++)
+    {
+        differs |= strcmp(expected.lcd[row], actual.lcd[row]) != 0 ? REPLAY_LCD_DIFFERS : 0;
+    }
+    return differs;
+}
+
+// === WRITER ===
+ReplayTraceWriter::ReplayTraceWriter()
+    : _file(nullptr),
+      _rows(0),
+      _last{}
+{
+}
+
+ReplayTraceWriter::~ReplayTraceWriter()
+{
+    close();
+}
+
+bool ReplayTraceWriter::open(const char *path)
+{
+    _file = fopen(path, "w");
+    if (_file == nullptr)
+    {
+        return false;
+    }
+    setvbuf(_file, nullptr, _IOFBF, WRITE_BUFFER_BYTES);
+    fprintf(_file, "%s\n", TRACE_HEADER);
+    _rows = 0;
+    return true;
+}
+
+void ReplayTraceWriter::write(const ReplayStep &step)
+{
+    if (_file == nullptr)
+    {
+        return;
+    }
+    if (_rows > 0 && Replay::sameInputs(step.inputs, _last.inputs) &&
+        Replay::compare(step.decisions, _last.decisions) == 0)
+    {
+        return;
+    }
+    fprintf(_file, "%lu,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,\"%s\",\"%s\"\n", static_cast<unsigned long>(step.timeMs),
+            step.inputs.temperatureSample, step.inputs.gasSample, step.inputs.setpointSample,
+            step.inputs.emergencyStop ? 1u : 0u, step.inputs.emergencyStopHeld ? 1u : 0u, step.inputs.gasTrip ? 1u : 0u, step.inputs.button, step.decisions.state,
+            step.decisions.heaterDuty, step.decisions.outputs, step.decisions.lcd[0], step.decisions.lcd[1]);
+    _last = step;
+    _rows++;
+}
+
+void ReplayTraceWriter::close()
+{
+    if (_file != nullptr)
+    {
+        fclose(_file);
+        _file = nullptr;
+    }
+}
+
+// === READER ===
+ReplayTraceReader::ReplayTraceReader()
+    : _file(nullptr),
+      _line(0),
+      _errorLine(0)
+{
+}
+
+ReplayTraceReader::~ReplayTraceReader()
+{
+    if (_file != nullptr)
+    {
+        fclose(_file);
+    }
+}
+
+bool ReplayTraceReader::open(const char *path)
+{
+    _file = fopen(path, "r");
+    if (_file == nullptr)
+    {
+        return false;
+    }
+    char line[LINE_CAPACITY];
+    _line = 1;
+    return fgets(line, sizeof(line), _file) != nullptr && strncmp(line, TRACE_HEADER, strlen(TRACE_HEADER)) == 0;
+}
+
+bool ReplayTraceReader::next(ReplayStep &step)
+{
+    char line[LINE_CAPACITY];
+    if (_file == nullptr || fgets(line, sizeof(line), _file) == nullptr)
+    {
+        return false;
+    }
+    _line++;
+
+    unsigned long timeMs;
+    unsigned int temperature, gas, setpoint, estop, estopHeld, gasTrip, button, state, duty, outputs;
+    int consumed = 0;
+    if (sscanf(line, "%lu,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%n", &timeMs, &temperature, &gas, &setpoint, &estop, &estopHeld,
+               &gasTrip, &button, &state, &duty, &outputs, &consumed) != 11 || consumed == 0)
+    {
+        _errorLine = _line;
+        return false;
+    }
+    const char *field = readQuoted(line + consumed, step.decisions.lcd[0], sizeof(step.decisions.lcd[0]));
+    if (field == nullptr || *field != ',' ||
+        readQuoted(field + 1, step.decisions.lcd[1], sizeof(step.decisions.lcd[1])) == nullptr)
+    {
+        _errorLine = _line;
+        return false;
+    }
+
+    step.timeMs = static_cast<uint32_t>(timeMs);
+    step.inputs.temperatureSample = static_cast<uint16_t>(temperature);
+    step.inputs.gasSample = static_cast<uint16_t>(gas);
+    step.inputs.setpointSample = static_cast<uint16_t>(setpoint);
+    step.inputs.emergencyStop = estop != 0;
+    step.inputs.emergencyStopHeld = estopHeld != 0;
+    step.inputs.gasTrip = gasTrip != 0;
+    step.inputs.button = static_cast<uint16_t>(button);
+    step.decisions.state = static_cast<uint8_t>(state);
+    step.decisions.heaterDuty = static_cast<uint8_t>(duty);
+    step.decisions.outputs = static_cast<uint8_t>(outputs);
+    return true;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "../hal/Hal.h"
+
+#include <cstdio>
+
+/**
+ * @file ReplayTrace.h
+ * @brief The replay trace format, its reader and writer, and the capture helpers.
+ *
+ * @details A trace is a CSV file with one row per loop pass in which an input or a
+ *          decision changed:
+ *
+ *          `time_ms,temperature_sample,gas_sample,setpoint_sample,estop,estop_held,gas_trip,button,state,heater_duty,outputs,lcd_line1,lcd_line2`
+ *
+ *          The samples are the 12-bit sampler readings, before calibration: every
+ *          value the control path computes derives from them, so holding them from
+ *          row to row reproduces the inputs of the run bit for bit. The first row holds
+ *          the readings `SystemState::begin()` started from and the decisions at the
+ *          end of setup(). The LCD lines are quoted.
+ *
+ *          The two interrupts that act on the firmware directly are inputs of their own:
+ *          `estop` (the button) and `gas_trip` (the sampler's gas trip, which fires on raw
+ *          conversions the samples do not carry). `estop_held` is the level of the
+ *          emergency button at the start of the pass, which the FSM checks before it
+ *          takes an acknowledge. `button` holds the events the FSM took
+ *          from the acknowledge button during the pass, as packed by
+ *          `DebouncedButton::takeHistory()`: the debouncing itself is not replayed.
+ *
+ *          Rows are read and written one at a time, so traces of any length stream
+ *          from and to disk.
+ */
+
+class SensorManager;
+class DebouncedButton;
+class SystemState;
+class ActuatorController;
+class ChamberSimulator;
+
+constexpr uint8_t REPLAY_LCD_ROWS = 2;
+constexpr uint8_t REPLAY_LCD_COLS = 16;
+
+// --- Fields of ReplayDecisions, as returned by Replay::compare() ---
+constexpr uint8_t REPLAY_STATE_DIFFERS = 0x01;
+constexpr uint8_t REPLAY_DUTY_DIFFERS = 0x02;
+constexpr uint8_t REPLAY_OUTPUTS_DIFFERS = 0x04;
+constexpr uint8_t REPLAY_LCD_DIFFERS = 0x08;
+
+/**
+ * @brief What the firmware read during one loop pass.
+ */
+struct ReplayInputs
+{
+    uint16_t temperatureSample; // 12-bit sampler readings (SensorManager::getSample())
+    uint16_t gasSample;
+    uint16_t setpointSample;
+    bool emergencyStop;         // The emergency button fired before the pass
+    bool emergencyStopHeld;     // The emergency button was down at the start of the pass
+    bool gasTrip;               // The gas trip fired before the end of the pass
+    uint16_t button;            // Acknowledge button events taken in the pass (DebouncedButton::takeHistory())
+};
+
+/**
+ * @brief What the firmware did by the end of one loop pass.
+ */
+struct ReplayDecisions
+{
+    uint8_t state;      // States::Type
+    uint8_t heaterDuty; // Percent
+    uint8_t outputs;    // TELEMETRY_*_ON bits (see Telemetry.h)
+    char lcd[REPLAY_LCD_ROWS][REPLAY_LCD_COLS + 1];
+};
+
+/**
+ * @brief One row of a replay trace.
+ */
+struct ReplayStep
+{
+    uint32_t timeMs; // millis() at the start of the pass
+    ReplayInputs inputs;
+    ReplayDecisions decisions;
+};
+
+namespace Replay
+{
+    /**
+     * @brief Reads the inputs of the coming pass.
+     */
+    ReplayInputs captureInputs(const SensorManager &sensorManager, bool emergencyStop, bool gasTrip);
+
+    /**
+     * @brief Reads the decisions at the end of a pass, including what the LCD shows.
+     */
+    ReplayDecisions captureDecisions(const SystemState &systemState, const ActuatorController &actuatorController,
+                                     const ChamberSimulator &board);
+
+    /**
+     * @brief Queues the button events of a recorded pass, oldest first, for the FSM to take.
+     */
+    void injectButtonEvents(DebouncedButton &button, uint16_t events);
+
+    bool sameInputs(const ReplayInputs &a, const ReplayInputs &b);
+
+    /**
+     * @brief Returns the REPLAY_*_DIFFERS bits of the fields that differ (0 if none).
+     */
+    uint8_t compare(const ReplayDecisions &expected, const ReplayDecisions &actual);
+}
+
+/**
+ * @class ReplayTraceWriter
+ * @brief Appends rows to a trace file.
+ */
+class ReplayTraceWriter
+{
+public:
+    ReplayTraceWriter();
+    ~ReplayTraceWriter();
+
+    /**
+     * @brief Creates the file and writes the header line.
+     * @return False if the file cannot be created.
+     */
+    bool open(const char *path);
+
+    /**
+     * @brief Writes a row when it differs from the previous one (always for the first).
+     */
+    void write(const ReplayStep &step);
+
+    void close();
+    uint32_t rows() const { return _rows; }
+
+private:
+    FILE *_file;
+    uint32_t _rows;
+    ReplayStep _last;
+};
+
+/**
+ * @class ReplayTraceReader
+ * @brief Reads a trace file row by row.
+ */
+class ReplayTraceReader
+{
+public:
+    ReplayTraceReader();
+    ~ReplayTraceReader();
+
+    /**
+     * @brief Opens the file and skips the header line.
+     * @return False if the file cannot be read or is not a replay trace.
+     */
+    bool open(const char *path);
+
+    /**
+     * @brief Reads the next row.
+     * @return False at the end of the file or on a malformed row (see `error()`).
+     */
+    bool next(ReplayStep &step);
+
+    /**
+     * @brief Returns the line number of a malformed row, or 0.
+     */
+    uint32_t error() const { return _errorLine; }
+
+private:
+    FILE *_file;
+    uint32_t _line;
+    uint32_t _errorLine;
+};
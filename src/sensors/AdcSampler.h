@@ -0,0 +1,260 @@
+#pragma once
+
+#include "../hal/Hal.h"
+
+constexpr uint8_t ADC_CHANNEL_COUNT = 3;       // Temperature, gas, potentiometer
+constexpr uint8_t ADC_MAX_CHANNELS = 16;       // Analog inputs of the largest AVR boards (Mega)
+constexpr uint8_t ADC_OVERSAMPLE_SHIFT = 4;    // 2^4 = 16 conversions per result
+constexpr uint8_t ADC_EXTRA_BITS = ADC_OVERSAMPLE_SHIFT / 2; // Oversampling by 4^n adds n bits
+constexpr uint8_t ADC_RESULT_BITS = 10 + ADC_EXTRA_BITS;     // 12-bit results
+constexpr uint8_t ADC_HISTORY_SHIFT = 2;       // 2^2 = 4 decimated results averaged per channel
+constexpr uint8_t ADC_WATCH_CONVERSIONS = 4;   // Consecutive conversions over the level that trip a watch
+constexpr uint8_t ADC_NO_CHANNEL = 0xFF;
+
+/**
+ * @class BasicAdcSampler
+ * @brief Interrupt-driven, oversampling reader of the analog inputs.
+ * @tparam CHANNELS The number of analog pins scanned (1 to ADC_MAX_CHANNELS).
+ *
+ * @details The ADC conversion-complete interrupt walks the channels round-robin. Each
+ *          visit to a channel takes one throw-away conversion (the input needs to settle
+ *          after a multiplexer switch) followed by 16 conversions that are summed and
+ *          decimated by 2 bits, yielding a 12-bit result: the TMP36's own noise dithers
+ *          the extra bits. Results go into a small per-channel ring whose running mean
+ *          is the value returned by `read()`.
+ *
+ *          A full round over the three channels of the single-chamber firmware
+ *          (`AdcSampler`) takes 3 x 17 x 104 us = 5.3 ms and needs no CPU time from the
+ *          main loop; `read()` is a plain O(1) load. Each extra channel adds 1.8 ms.
+ *
+ *          One channel can also be watched against a level (`watch()`): the interrupt
+ *          compares every raw conversion of that channel, and the ADC_WATCH_CONVERSIONS-th
+ *          consecutive one at or above the level calls a handler, still in interrupt
+ *          context. That is 4 x 104 us after the input crosses the level, once the
+ *          multiplexer is on the channel, instead of waiting for the filtered value.
+ *          The watch then stays tripped until `rearm()`.
+ */
+template <uint8_t CHANNELS>
+class BasicAdcSampler
+{
+    static_assert(CHANNELS > 0 && CHANNELS <= ADC_MAX_CHANNELS, "The ADC multiplexer has at most 16 inputs");
+
+public:
+    /**
+     * @brief Constructs the sampler.
+     * @param pins The analog pins to scan, in channel order.
+     */
+    BasicAdcSampler(const uint8_t (&pins)[CHANNELS])
+        : _channel(0),
+          _sampleIndex(0),
+          _accumulator(0),
+          _historySum{},
+          _historyIndex{},
+          _filtered{},
+          _primedMask(0),
+          _watchChannel(ADC_NO_CHANNEL),
+          _watchLevel(0),
+          _watchCount(0),
+          _onTrip(nullptr),
+          _tripContext(nullptr),
+          _tripped(false)
+    {
+        for (uint8_t i = 0; i < CHANNELS; i++)
+        {
+            _pins[i] = pins[i];
+        }
+    }
+
+    /**
+     * @brief Starts the interrupt-driven conversion chain.
+     * @attention Only one sampler may be active, since it owns the ADC interrupt.
+     */
+    void begin()
+    {
+        _instance = this;
+        _channel = 0;
+        _sampleIndex = 0;
+        _accumulator = 0;
+        _primedMask = 0;
+        Hal::adcBegin(&BasicAdcSampler::onConversionComplete);
+        Hal::adcStart(_pins[_channel]);
+    }
+
+    /**
+     * @brief Returns true once every channel has produced at least one result.
+     */
+    bool isPrimed() const
+    {
+        Hal::InterruptLock lock;
+        return _primedMask == ALL_CHANNELS_MASK;
+    }
+
+    /**
+     * @brief A handler called when a watched channel trips. Interrupt context.
+     */
+    using TripHandler = void (*)(void *context);
+
+    /**
+     * @brief Watches a channel against a level, replacing any previous watch.
+     * @param channel The channel index, in the order given to the constructor.
+     * @param level A raw 10-bit level (0-1023), on the scale of the conversions.
+     * @param onTrip Called once when the watch trips; must be short and ISR-safe.
+     * @param context Passed to `onTrip`.
+     */
+    void watch(uint8_t channel, uint16_t level, TripHandler onTrip, void *context)
+    {
+        Hal::InterruptLock lock;
+        _watchChannel = channel;
+        _watchLevel = level;
+        _onTrip = onTrip;
+        _tripContext = context;
+        _watchCount = 0;
+        _tripped = false;
+    }
+
+    /**
+     * @brief Changes the level of the watch, keeping its channel and handler.
+     */
+    void setWatchLevel(uint16_t level)
+    {
+        Hal::InterruptLock lock;
+        _watchLevel = level;
+        _watchCount = 0;
+    }
+
+    /**
+     * @brief Lets the watch trip again after it tripped.
+     */
+    void rearm()
+    {
+        Hal::InterruptLock lock;
+        _watchCount = 0;
+        _tripped = false;
+    }
+
+    /**
+     * @brief Returns true if the watch tripped and was not re-armed since.
+     */
+    bool isTripped() const { return _tripped; }
+
+    /**
+     * @brief Returns the latest filtered value of a channel.
+     * @param channel The channel index, in the order given to the constructor.
+     * @return A 12-bit value (0-4095) proportional to the pin voltage.
+     */
+    uint16_t read(uint8_t channel) const
+    {
+        // A 16-bit load is two instructions on the AVR: keep the ISR out of the middle.
+        Hal::InterruptLock lock;
+        return _filtered[channel];
+    }
+
+private:
+    static constexpr uint8_t HISTORY_LENGTH = 1 << ADC_HISTORY_SHIFT;
+    static constexpr uint8_t SAMPLES_PER_RESULT = 1 << ADC_OVERSAMPLE_SHIFT;
+    static constexpr uint16_t ALL_CHANNELS_MASK = static_cast<uint16_t>((1UL << CHANNELS) - 1);
+
+    static BasicAdcSampler *_instance; // The sampler served by the ADC interrupt
+
+    uint8_t _pins[CHANNELS];
+
+    // Owned by the interrupt handler
+    uint8_t _channel;       // Channel being converted
+    uint8_t _sampleIndex;   // 0 = settling conversion, 1..16 = accumulated ones
+    uint16_t _accumulator;  // Sum of the conversions of the current visit
+    uint16_t _history[CHANNELS][HISTORY_LENGTH];
+    uint16_t _historySum[CHANNELS];
+    uint8_t _historyIndex[CHANNELS];
+
+    // Shared with the main loop
+    volatile uint16_t _filtered[CHANNELS];
+    volatile uint16_t _primedMask; // Bit n set once channel n has a result
+
+    // Level watch, set with interrupts off and run by the interrupt handler
+    uint8_t _watchChannel; // ADC_NO_CHANNEL when nothing is watched
+    uint16_t _watchLevel;
+    uint8_t _watchCount;   // Consecutive conversions at or above the level
+    TripHandler _onTrip;
+    void *_tripContext;
+    volatile bool _tripped;
+
+    /**
+     * @brief The body of the conversion-complete interrupt.
+     */
+    static void onConversionComplete(uint16_t raw);
+
+    void storeResult(uint16_t result);
+};
+
+/**
+ * @brief The sampler of the single-chamber firmware (see SensorManager).
+ */
+using AdcSampler = BasicAdcSampler<ADC_CHANNEL_COUNT>;
+
+template <uint8_t CHANNELS>
+BasicAdcSampler<CHANNELS> *BasicAdcSampler<CHANNELS>::_instance = nullptr;
+
+// === INTERRUPT CONTEXT ===
+template <uint8_t CHANNELS>
+void BasicAdcSampler<CHANNELS>::onConversionComplete(uint16_t raw)
+{
+    BasicAdcSampler &self = *_instance;
+
+    // The first conversion after a multiplexer switch is discarded.
+    if (self._sampleIndex > 0)
+    {
+        self._accumulator += raw;
+
+        if (self._channel == self._watchChannel && !self._tripped)
+        {
+            if (raw < self._watchLevel)
+            {
+                self._watchCount = 0;
+            }
+            else if (++self._watchCount >= ADC_WATCH_CONVERSIONS)
+            {
+                self._tripped = true;
+                self._onTrip(self._tripContext);
+            }
+        }
+    }
+
+    if (++self._sampleIndex > SAMPLES_PER_RESULT)
+    {
+        // 16 x 10-bit conversions sum to 14 bits; dropping 2 keeps the 2 extra bits.
+        self.storeResult(self._accumulator >> (ADC_OVERSAMPLE_SHIFT - ADC_EXTRA_BITS));
+        self._accumulator = 0;
+        self._sampleIndex = 0;
+        self._watchCount = 0; // Only conversions of one visit count as consecutive
+        self._channel = (self._channel + 1) % CHANNELS;
+    }
+
+    Hal::adcStart(self._pins[self._channel]);
+}
+
+template <uint8_t CHANNELS>
+void BasicAdcSampler<CHANNELS>::storeResult(uint16_t result)
+{
+    uint8_t channel = _channel;
+    uint16_t *history = _history[channel];
+
+    uint16_t channelBit = static_cast<uint16_t>(1U << channel);
+    if (!(_primedMask & channelBit))
+    {
+        // First result on this channel: seed the whole ring so the mean is valid at once.
+        for (uint8_t i = 0; i < HISTORY_LENGTH; i++)
+        {
+            history[i] = result;
+        }
+        _historySum[channel] = result << ADC_HISTORY_SHIFT;
+        _primedMask |= channelBit;
+    }
+    else
+    {
+        uint8_t index = _historyIndex[channel];
+        _historySum[channel] = _historySum[channel] - history[index] + result;
+        history[index] = result;
+        _historyIndex[channel] = (index + 1) & (HISTORY_LENGTH - 1);
+    }
+    _filtered[channel] = _historySum[channel] >> ADC_HISTORY_SHIFT;
+}
@@ -0,0 +1,156 @@
+#include "DebouncedButton.h"
+
+namespace
+{
+    constexpr uint8_t HISTORY_BITS = 2; // Per event in takeHistory()
+    constexpr uint8_t HISTORY_MASK = (1 << HISTORY_BITS) - 1;
+
+    inline uint16_t nowMs()
+    {
+        return static_cast<uint16_t>(Hal::millis());
+    }
+}
+
+// === CONSTRUCTOR ===
+DebouncedButton *DebouncedButton::_instance = nullptr;
+
+DebouncedButton::DebouncedButton(uint8_t pin)
+    : _pin(pin),
+      _pressed(false),
+      _unsettled(false),
+      _longSent(false),
+      _acceptedMs(0),
+      _edgeMs(0),
+      _pressedMs(0),
+      _queue{},
+      _head(0),
+      _count(0),
+      _dropped(0),
+      _history(0)
+{
+}
+
+void DebouncedButton::begin()
+{
+    _instance = this;
+    {
+        Hal::InterruptLock lock;
+        _pressed = false;
+        _unsettled = false;
+        _head = 0;
+        _count = 0;
+        _acceptedMs = nowMs() - BUTTON_DEBOUNCE_MS; // The first edge is not in a lockout
+    }
+    Hal::pinChangeBegin(_pin, &DebouncedButton::onChange);
+
+    // Held down through the reset: the press counts from now.
+    if (!Hal::digitalRead(_pin))
+    {
+        Hal::InterruptLock lock;
+        accept(true, nowMs());
+    }
+}
+
+// === EVENTS ===
+ButtonEvent DebouncedButton::poll()
+{
+    Hal::InterruptLock lock;
+    uint16_t now = nowMs();
+
+    // The bounce has died out: the pin now reads what the contact settled at.
+    if (_unsettled && static_cast<uint16_t>(now - _edgeMs) >= BUTTON_DEBOUNCE_MS)
+    {
+        _unsettled = false;
+        bool pressed = !Hal::digitalRead(_pin);
+        if (pressed != _pressed)
+        {
+            accept(pressed, now);
+        }
+    }
+    if (_pressed && !_longSent && static_cast<uint16_t>(now - _pressedMs) >= BUTTON_LONG_PRESS_MS)
+    {
+        _longSent = true;
+        push(ButtonEvent::LONG_PRESS);
+    }
+
+    if (_count == 0)
+    {
+        return ButtonEvent::NONE;
+    }
+    ButtonEvent event = _queue[_head];
+    _head = (_head + 1) & (BUTTON_QUEUE_CAPACITY - 1);
+    _count--;
+    _history = (_history << HISTORY_BITS) | static_cast<uint8_t>(event);
+    return event;
+}
+
+void DebouncedButton::clear()
+{
+    Hal::InterruptLock lock;
+    _head = 0;
+    _count = 0;
+}
+
+void DebouncedButton::inject(ButtonEvent event)
+{
+    Hal::InterruptLock lock;
+    push(event);
+}
+
+uint16_t DebouncedButton::takeHistory()
+{
+    uint16_t history = _history;
+    _history = 0;
+    return history;
+}
+
+void DebouncedButton::accept(bool pressed, uint16_t now)
+{
+    _pressed = pressed;
+    _acceptedMs = now;
+    if (pressed)
+    {
+        _pressedMs = now;
+        _longSent = false;
+        push(ButtonEvent::PRESS);
+        return;
+    }
+    // Let go before the loop raised it: the long press is still owed, ahead of the release.
+    if (!_longSent && static_cast<uint16_t>(now - _pressedMs) >= BUTTON_LONG_PRESS_MS)
+    {
+        _longSent = true;
+        push(ButtonEvent::LONG_PRESS);
+    }
+    push(ButtonEvent::RELEASE);
+}
+
+void DebouncedButton::push(ButtonEvent event)
+{
+    if (_count == BUTTON_QUEUE_CAPACITY)
+    {
+        _dropped++;
+        return;
+    }
+    _queue[(_head + _count) & (BUTTON_QUEUE_CAPACITY - 1)] = event;
+    _count++;
+}
+
+// === INTERRUPT CONTEXT ===
+void DebouncedButton::onChange(bool level)
+{
+    DebouncedButton &self = *_instance;
+    uint16_t now = nowMs();
+    self._edgeMs = now;
+
+    // Pulled to ground when pressed
+    bool pressed = !level;
+    if (static_cast<uint16_t>(now - self._acceptedMs) < BUTTON_DEBOUNCE_MS)
+    {
+        self._unsettled = true;
+        return;
+    }
+    if (pressed != self._pressed)
+    {
+        self.accept(pressed, now);
+    }
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../hal/Hal.h"
+
+// --- Timing (in milliseconds) ---
+constexpr uint16_t BUTTON_DEBOUNCE_MS = 20;     // Edges this soon after an accepted one are contact bounce
+constexpr uint16_t BUTTON_LONG_PRESS_MS = 1500; // Held this long, a press is also a long press
+
+constexpr uint8_t BUTTON_QUEUE_CAPACITY = 8;    // Events waiting for the FSM (power of two)
+static_assert((BUTTON_QUEUE_CAPACITY & (BUTTON_QUEUE_CAPACITY - 1)) == 0, "Queue capacity must be a power of two");
+
+/**
+ * @brief What the user did with the button, in the order it happened.
+ */
+enum class ButtonEvent : uint8_t
+{
+    NONE,       // The queue is empty
+    PRESS,      // Pushed down
+    LONG_PRESS, // Still down BUTTON_LONG_PRESS_MS after the press
+    RELEASE,    // Let go
+};
+
+/**
+ * @class DebouncedButton
+ * @brief A push button to ground, read through the pin-change interrupt and debounced
+ *        in it, that queues its events for the FSM.
+ *
+ * @details Each edge is timestamped by the interrupt as it happens. The first edge to
+ *          the other level is accepted at once and queues its event; the edges within
+ *          BUTTON_DEBOUNCE_MS of it are its bounce, and are only noted. The press is
+ *          therefore registered on its first edge, and the queue keeps it however long
+ *          the main loop is busy: a slow LCD transfer or an EEPROM write cannot lose it.
+ *
+ *          A bounce may end at a level the interrupt did not accept (e.g. a tap shorter
+ *          than the lockout). `next()` then reads the pin once the contact has been
+ *          quiet for BUTTON_DEBOUNCE_MS and queues the change it finds. It also raises
+ *          LONG_PRESS while the button is held. With the button released, settled and
+ *          the queue empty, `next()` is three byte loads: an idle button costs the loop
+ *          nothing else, and no task polls it.
+ *
+ *          Events past BUTTON_QUEUE_CAPACITY are dropped and counted.
+ */
+class DebouncedButton
+{
+public:
+    /**
+     * @brief Constructs the button.
+     * @param pin The digital pin the button pulls to ground.
+     */
+    explicit DebouncedButton(uint8_t pin);
+
+    /**
+     * @brief Enables the pull-up and the pin-change interrupt. The button starts released.
+     * @attention Only one button may be active, since it owns the pin-change interrupt.
+     */
+    void begin();
+
+    /**
+     * @brief Returns the oldest event not yet taken, or ButtonEvent::NONE.
+     */
+    ButtonEvent next()
+    {
+        if (_count == 0 && !_pressed && !_unsettled)
+        {
+            return ButtonEvent::NONE;
+        }
+        return poll();
+    }
+
+    /**
+     * @brief Discards the events not yet taken, e.g. those queued before an emergency stop.
+     */
+    void clear();
+
+    /**
+     * @brief Queues an event as if the interrupt had, e.g. to replay a recorded run.
+     */
+    void inject(ButtonEvent event);
+
+    /**
+     * @brief Returns the events `next()` returned since the last call, 2 bits each
+     *        (ButtonEvent values), the oldest in the highest non-zero pair.
+     * @details For the replay trace: at most BUTTON_QUEUE_CAPACITY events are kept.
+     */
+    uint16_t takeHistory();
+
+    /**
+     * @brief Returns the number of events dropped with the queue full.
+     */
+    uint16_t getDroppedCount() const { return _dropped; }
+
+private:
+    static DebouncedButton *_instance; // The button served by the pin-change interrupt
+
+    uint8_t _pin;
+
+    // Written by the interrupt handler
+    volatile bool _pressed;      // The accepted level
+    volatile bool _unsettled;    // Edges came during the lockout: the level is to be read again
+    volatile bool _longSent;     // LONG_PRESS was queued for the current press
+    uint16_t _acceptedMs;        // millis() of the last accepted edge (low 16 bits)
+    uint16_t _edgeMs;            // millis() of the last edge, bounce included
+    uint16_t _pressedMs;         // millis() of the current press
+    ButtonEvent _queue[BUTTON_QUEUE_CAPACITY];
+    uint8_t _head;
+    volatile uint8_t _count;
+    uint16_t _dropped;
+
+    uint16_t _history; // The events taken, for takeHistory()
+
+    /**
+     * @brief The body of the pin-change interrupt.
+     */
+    static void onChange(bool level);
+
+    /**
+     * @brief `next()` once the button is not idle: settles the level, raises the long
+     *        press, and takes the oldest event.
+     */
+    ButtonEvent poll();
+
+    /**
+     * @brief Accepts a level change and queues its events. Interrupts must be off.
+     */
+    void accept(bool pressed, uint16_t nowMs);
+
+    /**
+     * @brief Queues an event, or counts it dropped. Interrupts must be off.
+     */
+    void push(ButtonEvent event);
+};
@@ -1,42 +1,67 @@
 #include "SensorManager.h"
+#include "../diagnostics/LoopProfiler.h"
+#include "../storage/ParameterStore.h"
+
+constexpr unsigned int ADC_PRIMING_POLL_US = 100;
 
 SensorManager::SensorManager(byte tempPin, byte gasPin, byte potPin)
-    : _tempPin(tempPin), _gasPin(gasPin), _potPin(potPin) {}
+    : _tempPin(tempPin), _gasPin(gasPin), _potPin(potPin),
+      _sampler({tempPin, gasPin, potPin}) {}
 
 void SensorManager::begin()
 {
+    // Start the background sampler and wait (about 5 ms) for a first value per channel
+    _sampler.begin();
+    while (!_sampler.isPrimed())
+    {
+        Hal::delayMicroseconds(ADC_PRIMING_POLL_US);
+    }
+
     // Initialize the lastSetpoint value
-    _lastPotReadTime = millis();
-    _lastSetpoint = getSetpoint();
+    _lastSetpoint = readSetpoint();
+}
+
+void SensorManager::registerTasks(Scheduler &scheduler)
+{
+    scheduler.add<SensorManager, &SensorManager::pollSetpoint>(
+        "setpoint", *this, POT_READ_INTERVAL_MS, POT_TASK_PHASE_MS, POT_TASK_DEADLINE_MS);
 }
 
-float SensorManager::getTemperature()
+Temperature SensorManager::getTemperature()
 {
-    int sensorVal = analogRead(_tempPin);
-    float voltage = (sensorVal / 1024.0) * 5.0;
-    float temperature = (voltage - 0.5) * 100.0;
-    return temperature;
+    PROFILE_PHASE(SENSORS);
+    return Calibration::temperatureFromSample(_sampler.read(TEMPERATURE_CHANNEL));
 }
 int SensorManager::getGasValue()
 {
-    return analogRead(_gasPin);
+    PROFILE_PHASE(SENSORS);
+    // Thresholds are expressed on the classic 0-1023 scale
+    return _sampler.read(GAS_CHANNEL) >> ADC_EXTRA_BITS;
 }
 
-float SensorManager::getSetpoint()
+void SensorManager::watchGas(AdcSampler::TripHandler onTrip, void *context)
 {
-    // Check if enough time has passed since the last read
-    if (millis() - _lastPotReadTime >= POT_READ_INTERVAL_MS)
-    {
-        // It's time  to read the potentiometer again
-        _lastPotReadTime = millis();
+    _sampler.watch(GAS_CHANNEL, parameters.gasHighThreshold, onTrip, context);
+}
 
-        // Read the physical value and update our cache
-        int potVal = analogRead(_potPin);
-        _lastSetpoint = map(potVal, 0, 1023, MIN_SETTABLE_TEMPERATURE, MAX_SETTABLE_TEMPERATURE);
-    }
+void SensorManager::setGasTripLevel(int level)
+{
+    _sampler.setWatchLevel(level);
+}
 
-    // ALWAYS return the cached value.
-    // This value will be fresh only if the interval has expired,
-    // otherwise it will be the last valid value read.
+Temperature SensorManager::getSetpoint()
+{
+    // ALWAYS return the cached value, refreshed by pollSetpoint().
     return _lastSetpoint;
+}
+
+void SensorManager::pollSetpoint()
+{
+    PROFILE_PHASE(SENSORS);
+    _lastSetpoint = readSetpoint();
+}
+
+Temperature SensorManager::readSetpoint()
+{
+    return Calibration::setpointFromSample(_sampler.read(POTENTIOMETER_CHANNEL));
 }
\ No newline at end of file
@@ -1,16 +1,36 @@
 #pragma once
 
-#include <Arduino.h>
+#include "../hal/Hal.h"
+#include "AdcSampler.h"
+#include "calibration/SensorCalibration.h"
+#include "../core/Temperature.h"
+#include "../core/Scheduler.h"
 
-constexpr int MAX_SETTABLE_TEMPERATURE = 40;        // Maximum temperature setpoint in Celsius
-constexpr int MIN_SETTABLE_TEMPERATURE = 20;        // Minimum temperature setpoint in Celsius
 constexpr unsigned long POT_READ_INTERVAL_MS = 500; // Interval for reading the potentiometer in ms
+constexpr uint16_t POT_TASK_PHASE_MS = 3;           // Offset of the setpoint task within its period
+constexpr uint16_t POT_TASK_DEADLINE_MS = 5;
+
+// Default gas alarm levels (gas_low, gas_high), on the 0-1023 scale of getGasValue():
+// the alarm trips at the high level and clears below the low one
+constexpr int LOW_EMERGENCY_GAS_THRESHOLD = 400;
+constexpr int HIGH_EMERGENCY_GAS_THRESHOLD = 700;
+constexpr uint16_t GAS_TRIP_HOLD_MS = 100; // Default least time a trip (see watchGas()) holds the alarm
+
+// Sampler channel of each sensor, in the order the pins are handed to AdcSampler
+constexpr uint8_t TEMPERATURE_CHANNEL = 0;
+constexpr uint8_t GAS_CHANNEL = 1;
+constexpr uint8_t POTENTIOMETER_CHANNEL = 2;
 
 /**
  * @brief Manages all sensor readings for the fermentation chamber.
  * @details This class centralizes all sensor-related code. It is responsible
  *          for reading raw values and converting them into meaningful data,
  *          such as temperature in Celsius and the desired setpoint.
+ *
+ *          Conversions run in the background (see AdcSampler), so every getter is
+ *          an O(1) read of the latest oversampled value and never waits on the ADC.
+ *          Conversions to Celsius go through the per-unit calibration tables in flash
+ *          (see calibration/SensorCalibration.h).
  */
 class SensorManager
 {
@@ -24,47 +44,85 @@ public:
     SensorManager(byte tempPin, byte gasPin, byte potPin);
 
     /**
-     * @brief Initializes the sensor pins.
-     * @details Sets the pinMode for all sensor pins to INPUT.
+     * @brief Starts the background ADC sampler.
+     * @details Blocks for the few milliseconds needed to get a first sample per channel.
      */
     void begin();
 
     /**
-     * @brief Reads the temperature sensor and converts the value to Celsius.
-     * @return The current temperature in degrees Celsius (float).
+     * @brief Adds the setpoint polling task to the scheduler.
      */
-    float getTemperature();
+    void registerTasks(Scheduler &scheduler);
 
     /**
-     * @brief Reads the raw analog value from the gas sensor.
+     * @brief Converts the latest oversampled TMP36 value to Celsius using the calibration table.
+     * @return The current temperature in degrees Celsius.
+     */
+    Temperature getTemperature();
+
+    /**
+     * @brief Returns the latest filtered value of the gas sensor.
      * @return An integer value from 0 to 1023 representing gas concentration.
      */
     int getGasValue();
 
+    /**
+     * @brief Calls a handler from the ADC interrupt as soon as the raw gas conversions
+     *        reach the gas_high parameter (see AdcSampler::watch()).
+     * @details The trip fires once, then waits for `rearmGasTrip()`.
+     * @param onTrip Runs in interrupt context.
+     * @param context Passed to `onTrip`.
+     */
+    void watchGas(AdcSampler::TripHandler onTrip, void *context);
+
+    /**
+     * @brief Moves the gas trip to a new level, keeping its handler.
+     * @param level On the 0-1023 scale of getGasValue().
+     */
+    void setGasTripLevel(int level);
+
+    /**
+     * @brief Lets the gas trip fire again.
+     */
+    void rearmGasTrip() { _sampler.rearm(); }
+
     /**
      * @brief Returns the current setpoint value based on the potentiometer reading.
      *
-     * This method implements a time-based polling logic.
-     * The potentiometer's value is read from the hardware only if enough
-     * time (defined by POT_READ_INTERVAL_MS) has passed since the last read.
-     * Otherwise, the last valid cached value is returned.
-     *
-     * The internal logic performs the following steps:
-     * 1. Checks if `millis() - _lastPotReadTime >= POT_READ_INTERVAL_MS`.
-     * 2. If true, it reads the raw analog value (0-1023), maps it to the
-     *    desired range (20-40), and updates both `_lastSetpoint` and `_lastPotReadTime`.
-     * 3. It always returns the value of `_lastSetpoint`, whether it was just updated
-     *    or is from a previous read.
+     * The potentiometer is polled by a scheduler task every POT_READ_INTERVAL_MS
+     * (see `pollSetpoint()`); this getter always returns the cached value, so the
+     * setpoint stays stable between two polls.
      *
-     * @return float The setpoint value, which is only updated if the read interval has expired.
+     * @return The setpoint value, as of the last poll.
+     */
+    Temperature getSetpoint();
+
+    /**
+     * @brief Returns the latest oversampled reading of a channel, before calibration.
+     * @details These 12-bit values are the only inputs of the control path, which is
+     *          what makes a recorded run replayable (see src/replay/).
+     * @param channel TEMPERATURE_CHANNEL, GAS_CHANNEL or POTENTIOMETER_CHANNEL.
+     */
+    uint16_t getSample(uint8_t channel) const { return _sampler.read(channel); }
+
+    /**
+     * @brief Reads the potentiometer and updates the cached setpoint.
+     * @details Maps the latest sample to the desired range (20.0-40.0 in 0.1 steps)
+     *          through the calibration table. Runs as a scheduler task.
      */
-    float getSetpoint();
+    void pollSetpoint();
 
 private:
     byte _tempPin; // Pin for the temperature
     byte _gasPin;  // Pin for the gas sensor
     byte _potPin;  // Pin for the potentiometer
 
-    unsigned long _lastPotReadTime; // Timestamp of the last potentiometer read
-    float _lastSetpoint;            // Last setpoint value read from the potentiometer
+    Temperature _lastSetpoint; // Last setpoint value read from the potentiometer
+
+    AdcSampler _sampler; // Interrupt-driven reader of the three analog inputs
+
+    /**
+     * @brief Maps the latest potentiometer sample to a setpoint in Celsius.
+     */
+    Temperature readSetpoint();
 };
\ No newline at end of file
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "../../hal/Hal.h"
+#include "../AdcSampler.h"
+
+/**
+ * @file CalibrationTable.h
+ * @brief Compile-time generation and PROGMEM lookup of sensor calibration tables.
+ *
+ * @details A table maps a 12-bit AdcSampler result to a Q8.8 temperature. It is built by
+ *          the compiler from a handful of measured calibration points (piecewise linear
+ *          between them), so no float code or construction time reaches the firmware:
+ *          the table lands in flash as plain data and each conversion costs a table
+ *          index and a shift.
+ */
+
+constexpr uint8_t CALIBRATION_FRACTION_BITS = 8; // Table entries are Q8.8 degrees Celsius
+
+/**
+ * @brief One measured calibration point: an ADC reading and the reference temperature.
+ */
+struct CalibrationPoint
+{
+    uint16_t sample; // 12-bit AdcSampler result
+    float celsius;   // Temperature measured by the reference thermometer (or wanted setpoint)
+};
+
+/**
+ * @brief How a table is sampled and looked up.
+ */
+enum class CalibrationMode : uint8_t
+{
+    INTERPOLATED, // Entries at bucket edges, linear interpolation inside a bucket, ends extrapolated
+    STEPPED       // Entries at bucket centres, no interpolation, ends clamped, values quantized
+};
+
+/**
+ * @brief A lookup table of 2^INDEX_BITS buckets over the 12-bit sample range.
+ * @details One extra entry closes the last bucket for interpolation.
+ */
+template <uint8_t INDEX_BITS>
+struct CalibrationTable
+{
+    static constexpr uint8_t SHIFT = ADC_RESULT_BITS - INDEX_BITS;
+    static constexpr uint16_t SIZE = (1 << INDEX_BITS) + 1;
+
+    int16_t values[SIZE]; // Q8.8 degrees Celsius
+};
+
+namespace Calibration
+{
+    // === COMPILE-TIME GENERATION ===
+
+    /**
+     * @brief Returns true if the points are sorted by strictly increasing sample.
+     */
+    template <size_t N>
+    constexpr bool isAscending(const CalibrationPoint (&points)[N])
+    {
+        for (size_t i = 1; i < N; i++)
+        {
+            if (points[i].sample <= points[i - 1].sample)
+            {
+                return false;
+            }
+        }
+        return N >= 2;
+    }
+
+    /**
+     * @brief Evaluates the piecewise linear curve through the points at a given sample.
+     * @param clampEnds If true the curve is flat outside the points, otherwise the end
+     *                  segments are extended.
+     */
+    template <size_t N>
+    constexpr float evaluate(const CalibrationPoint (&points)[N], float sample, bool clampEnds)
+    {
+        if (clampEnds && sample <= points[0].sample)
+        {
+            return points[0].celsius;
+        }
+        if (clampEnds && sample >= points[N - 1].sample)
+        {
+            return points[N - 1].celsius;
+        }
+
+        size_t segment = 0;
+        while (segment < N - 2 && sample > points[segment + 1].sample)
+        {
+            segment++;
+        }
+        const CalibrationPoint &a = points[segment];
+        const CalibrationPoint &b = points[segment + 1];
+        return a.celsius + (b.celsius - a.celsius) * (sample - a.sample) / (b.sample - a.sample);
+    }
+
+    constexpr long roundToLong(float value)
+    {
+        return static_cast<long>(value >= 0 ? value + 0.5f : value - 0.5f);
+    }
+
+    /**
+     * @brief Builds a table from calibration points.
+     * @param points The calibration points, sorted by sample (see isAscending()).
+     * @param mode Interpolated (sensors) or stepped (setpoint knob).
+     * @param quantum For stepped tables, the resolution values are rounded to (e.g. 0.1 °C).
+     */
+    template <uint8_t INDEX_BITS, size_t N>
+    constexpr CalibrationTable<INDEX_BITS> build(const CalibrationPoint (&points)[N],
+                                                 CalibrationMode mode, float quantum = 0)
+    {
+        using Table = CalibrationTable<INDEX_BITS>;
+        const bool stepped = mode == CalibrationMode::STEPPED;
+        const float bucketCentre = stepped ? ((1 << Table::SHIFT) - 1) / 2.0f : 0;
+
+        Table table{};
+        for (uint16_t i = 0; i < Table::SIZE; i++)
+        {
+            float celsius = evaluate(points, (static_cast<long>(i) << Table::SHIFT) + bucketCentre, stepped);
+            if (quantum > 0)
+            {
+                celsius = roundToLong(celsius / quantum) * quantum;
+            }
+
+            // Q8.8 covers -128 to +128 °C: far outside the chamber, so saturating is harmless.
+            long fixed = roundToLong(celsius * (1 << CALIBRATION_FRACTION_BITS));
+            table.values[i] = static_cast<int16_t>(fixed < INT16_MIN ? INT16_MIN : (fixed > INT16_MAX ? INT16_MAX : fixed));
+        }
+        return table;
+    }
+
+    // === RUNTIME LOOKUP ===
+
+    /**
+     * @brief Converts a sample with an interpolated table stored in PROGMEM.
+     * @return Q8.8 degrees Celsius.
+     */
+    template <uint8_t INDEX_BITS>
+    inline int16_t interpolate(const CalibrationTable<INDEX_BITS> &table, uint16_t sample)
+    {
+        using Table = CalibrationTable<INDEX_BITS>;
+        uint8_t index = sample >> Table::SHIFT;
+        uint8_t fraction = sample & ((1 << Table::SHIFT) - 1);
+        int16_t low = pgm_read_word(&table.values[index]);
+        int16_t high = pgm_read_word(&table.values[index + 1]);
+        return low + static_cast<int16_t>((static_cast<int32_t>(high - low) * fraction) >> Table::SHIFT);
+    }
+
+    /**
+     * @brief Converts a sample with a stepped table stored in PROGMEM.
+     * @return Q8.8 degrees Celsius.
+     */
+    template <uint8_t INDEX_BITS>
+    inline int16_t step(const CalibrationTable<INDEX_BITS> &table, uint16_t sample)
+    {
+        return pgm_read_word(&table.values[sample >> CalibrationTable<INDEX_BITS>::SHIFT]);
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "CalibrationTable.h"
+
+/**
+ * @file DefaultCalibration.h
+ * @brief Calibration data of an uncalibrated chamber: the TMP36 datasheet curve and a
+ *        potentiometer that reaches both rails.
+ *
+ * @details To calibrate a chamber, copy this file (e.g. to `Chamber07Calibration.h`),
+ *          replace the values with the ones measured on that unit and build with
+ *          `-DBIOLOGIC_CALIBRATION_FILE='"Chamber07Calibration.h"'`. Samples are the 12-bit
+ *          values of the AdcSampler (0-4095); at least two points are needed, sorted by
+ *          sample, and more points give a piecewise linear correction.
+ */
+
+// TMP36: 10 mV/°C with 500 mV at 0 °C on a 5 V reference, i.e. sample = (T + 50) * 4096 / 500.
+constexpr CalibrationPoint TMP36_CALIBRATION_POINTS[] = {
+    {0, -50.0f},
+    {4096, 450.0f},
+};
+
+// Readings of the setpoint potentiometer at its two end stops.
+constexpr uint16_t SETPOINT_KNOB_MIN_SAMPLE = 0;
+constexpr uint16_t SETPOINT_KNOB_MAX_SAMPLE = 4095;
@@ -0,0 +1,14 @@
+#include "SensorCalibration.h"
+
+// The knob maps linearly between its end stops and saturates beyond them.
+constexpr CalibrationPoint SETPOINT_CALIBRATION_POINTS[] = {
+    {SETPOINT_KNOB_MIN_SAMPLE, MIN_SETTABLE_TEMPERATURE},
+    {SETPOINT_KNOB_MAX_SAMPLE, MAX_SETTABLE_TEMPERATURE},
+};
+
+// Both tables are evaluated by the compiler and stored in flash as plain data.
+const CalibrationTable<TEMPERATURE_TABLE_INDEX_BITS> TEMPERATURE_TABLE PROGMEM =
+    Calibration::build<TEMPERATURE_TABLE_INDEX_BITS>(TMP36_CALIBRATION_POINTS, CalibrationMode::INTERPOLATED);
+
+const CalibrationTable<SETPOINT_TABLE_INDEX_BITS> SETPOINT_TABLE PROGMEM =
+    Calibration::build<SETPOINT_TABLE_INDEX_BITS>(SETPOINT_CALIBRATION_POINTS, CalibrationMode::STEPPED, SETPOINT_RESOLUTION);
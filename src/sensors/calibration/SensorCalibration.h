@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CalibrationTable.h"
+#include "../../core/Temperature.h"
+
+#ifdef BIOLOGIC_CALIBRATION_FILE
+#include BIOLOGIC_CALIBRATION_FILE
+#else
+#include "DefaultCalibration.h"
+#endif
+
+constexpr float MIN_SETTABLE_TEMPERATURE = 20.0f; // Minimum temperature setpoint in Celsius
+constexpr float MAX_SETTABLE_TEMPERATURE = 40.0f; // Maximum temperature setpoint in Celsius
+constexpr float SETPOINT_RESOLUTION = 0.1f;       // Setpoint step in Celsius
+
+constexpr uint8_t TEMPERATURE_TABLE_INDEX_BITS = 6; // 64 buckets of 64 samples, interpolated
+constexpr uint8_t SETPOINT_TABLE_INDEX_BITS = 8;    // 256 buckets for 201 setpoint steps
+
+static_assert(Calibration::isAscending(TMP36_CALIBRATION_POINTS),
+              "TMP36 calibration points must be sorted by increasing sample");
+static_assert(SETPOINT_KNOB_MIN_SAMPLE < SETPOINT_KNOB_MAX_SAMPLE,
+              "The setpoint knob end stops must be increasing");
+static_assert((MAX_SETTABLE_TEMPERATURE - MIN_SETTABLE_TEMPERATURE) / SETPOINT_RESOLUTION < (1 << SETPOINT_TABLE_INDEX_BITS),
+              "The setpoint table needs at least one bucket per setpoint step");
+
+extern const CalibrationTable<TEMPERATURE_TABLE_INDEX_BITS> TEMPERATURE_TABLE PROGMEM;
+extern const CalibrationTable<SETPOINT_TABLE_INDEX_BITS> SETPOINT_TABLE PROGMEM;
+
+namespace Calibration
+{
+    /**
+     * @brief Converts a 12-bit TMP36 sample to a calibrated temperature.
+     */
+    inline Temperature temperatureFromSample(uint16_t sample)
+    {
+        return TemperatureMath::fromFixed(interpolate(TEMPERATURE_TABLE, sample));
+    }
+
+    /**
+     * @brief Converts a 12-bit potentiometer sample to a setpoint, in 0.1 °C steps.
+     */
+    inline Temperature setpointFromSample(uint16_t sample)
+    {
+        return TemperatureMath::fromFixed(step(SETPOINT_TABLE, sample));
+    }
+}
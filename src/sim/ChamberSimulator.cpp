@@ -0,0 +1,744 @@
+#include "ChamberSimulator.h"
+#include "../hal/Hal.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// === COST MODEL (virtual time charged per hardware access on an Uno @ 16 MHz) ===
+constexpr uint64_t ANALOG_READ_COST_US = 112;  // 13 ADC clocks @ 125 kHz plus call overhead
+constexpr uint64_t DIGITAL_WRITE_COST_US = 5;  // Pin table lookups of the Arduino core
+constexpr uint64_t PORT_WRITE_COST_US = 1;     // Masked read-modify-write of a PORT register (rounded up)
+constexpr uint64_t TONE_TIMER_SETUP_COST_US = 2; // Timer2 register writes
+constexpr uint64_t TONE_ISR_COST_US = 3;       // Pin toggle and siren step in the Timer2 interrupt
+constexpr uint64_t ADC_CONVERSION_US = 104;    // 13 ADC clocks @ 125 kHz
+constexpr uint64_t ADC_ISR_COST_US = 4;        // Entry, handler and exit of the ADC interrupt
+constexpr uint64_t EXTERNAL_ISR_ENTRY_US = 2;  // Vector, register saves and attachInterrupt()'s dispatch
+constexpr uint64_t EXTERNAL_ISR_EXIT_US = 1;
+constexpr uint64_t PIN_CHANGE_ISR_COST_US = 4; // Entry, the debounce in the handler, exit
+constexpr uint64_t WATCHDOG_ISR_COST_US = 3;   // Entry and exit of the watchdog interrupt, around the handler
+constexpr uint64_t ADC_CATCHUP_US = 17 * ADC_CONVERSION_US; // Conversions delivered per idle span
+constexpr uint32_t I2C_DEFAULT_CLOCK_HZ = 100000;
+constexpr uint32_t I2C_BITS_PER_BYTE = 9;      // 8 data bits plus ACK
+constexpr uint64_t I2C_TRANSACTION_COST_US = 10; // Start/stop conditions and Wire call overhead
+constexpr uint32_t I2C_STALL_SLICE_US = 100;   // Granularity of a stalled transfer's busy wait
+constexpr uint32_t I2C_BYTES_PER_LCD_BYTE = 12; // LiquidCrystal_I2C: 2 nibbles x 3 expander writes x (addr + data)
+constexpr uint64_t LCD_ENABLE_PULSE_US = 100;  // delayMicroseconds() after the two enable pulses
+constexpr uint64_t LCD_CLEAR_DELAY_US = 2000;  // delayMicroseconds(2000) after clear()
+constexpr uint64_t EEPROM_READ_COST_US = 1;    // EEAR/EECR register access
+constexpr uint64_t EEPROM_WRITE_COST_US = 2;   // Starting a write; the CPU does not wait for it
+constexpr uint64_t EEPROM_WRITE_US = 3400;     // Erase and write of one cell, in the background
+constexpr uint64_t SERIAL_WRITE_COST_US = 3;   // Buffer insert plus the UDRE interrupt sending the byte
+constexpr uint32_t SERIAL_DEFAULT_BAUD = 9600;
+constexpr uint32_t SERIAL_BITS_PER_BYTE = 10;  // 8N1: start, 8 data bits, stop
+constexpr int SERIAL_TX_BUFFER_BYTES = 63;     // HardwareSerial's 64-byte ring keeps one slot free
+constexpr int SERIAL_RX_BUFFER_BYTES = 63;
+
+// === BUTTON ===
+// Edges of one contact closure or opening, alternating from the new level: it ends there.
+constexpr uint32_t BUTTON_BOUNCE_US[] = {0, 250, 600, 1100, 1800};
+static_assert(sizeof(BUTTON_BOUNCE_US) / sizeof(BUTTON_BOUNCE_US[0]) % 2 == 1, "A bounce ends at the new level");
+
+// === PLANT ===
+constexpr float MAX_INTEGRATION_STEP_S = 0.1f; // Well below the element's time constant
+constexpr uint64_t PLANT_UPDATE_US = 10000;    // The plant is integrated in slices of at least 10 ms
+
+// === PCF8574 WIRING OF THE LCD BACKPACK ===
+constexpr uint8_t EXPANDER_RS = 0x01;
+constexpr uint8_t EXPANDER_EN = 0x04;
+
+// === TMP36 AND ADC ===
+constexpr float ADC_REFERENCE_V = 5.0f;
+constexpr float ADC_COUNTS = 1024.0f;
+constexpr float TMP36_OFFSET_V = 0.5f;
+constexpr float TMP36_V_PER_C = 0.01f;
+constexpr float GAS_NOISE_LSB = 2.0f;
+
+// === CONSTRUCTOR ===
+ChamberSimulator::ChamberSimulator(const ChamberPins &pins, const ChamberModel &model)
+    : _pins(pins),
+      _model(model),
+      _rngState(model.seed != 0 ? model.seed : 1),
+      _nowUs(0),
+      _chamberC(model.initialC),
+      _heaterC(model.initialC),
+      _heaterOn(false),
+      _toneHandler(nullptr),
+      _tonePin(0),
+      _toneCompare(0),
+      _toneRunning(false),
+      _nextToggleUs(0),
+      _tickHandler(nullptr),
+      _tickPeriodUs(0),
+      _nextTickUs(0),
+      _externalHandler(nullptr),
+      _externalAtUs(0),
+      _externalPin(PIN_COUNT),
+      _externalLowUntilUs(0),
+      _pinChangeHandler(nullptr),
+      _buttonPin(PIN_COUNT),
+      _buttonLevel(true),
+      _nextButtonEdge(0),
+      _watchdogHandler(nullptr),
+      _watchdogTimeoutUs(0),
+      _watchdogDueUs(0),
+      _watchdogRunning(false),
+      _watchdogInterruptArmed(false),
+      _halted(false),
+      _resetUs(0),
+      _adcHandler(nullptr),
+      _adcBusy(false),
+      _adcPin(0),
+      _adcDoneUs(0),
+      _inInterrupt(false),
+      _unintegratedUs(0),
+      _i2cClockHz(I2C_DEFAULT_CLOCK_HZ),
+      _i2cStallAtUs(0),
+      _i2cStallUs(0),
+      _expanderPins(0),
+      _pendingNibble(-1),
+      _lcdAddress(0),
+      _eeprom(EEPROM_SIZE, 0xFF),
+      _eepromCellWrites(EEPROM_SIZE, 0),
+      _eepromBusyUntilUs(0),
+      _serialBaud(SERIAL_DEFAULT_BAUD),
+      _serialIdleUs(0),
+      _serialOutput(nullptr),
+      _serialInputLine(0),
+      _serialInputOffset(0)
+{
+    std::fill(std::begin(_pinLevels), std::end(_pinLevels), false);
+    std::fill(std::begin(_pinChangeUs), std::end(_pinChangeUs), 0);
+    for (auto &line : _lcdLines)
+    {
+        memset(line, ' ', LCD_COLS);
+        line[LCD_COLS] = '\0';
+    }
+}
+
+// === DIGITAL AND ANALOG I/O ===
+void ChamberSimulator::digitalWrite(uint8_t pin, bool level)
+{
+    _stats.digitalWrites++;
+    if (!_halted)
+    {
+        drivePin(pin, level);
+    }
+    advance(DIGITAL_WRITE_COST_US);
+}
+
+void ChamberSimulator::fastWrite(uint8_t pin, bool level)
+{
+    _stats.portWrites++;
+    if (!_halted)
+    {
+        drivePin(pin, level);
+    }
+    advance(PORT_WRITE_COST_US);
+}
+
+void ChamberSimulator::drivePin(uint8_t pin, bool level)
+{
+    if (pin < PIN_COUNT)
+    {
+        if (_pinLevels[pin] != level)
+        {
+            _pinChangeUs[pin] = _nowUs;
+        }
+        _pinLevels[pin] = level;
+    }
+    if (pin == _pins.heater && level != _heaterOn)
+    {
+        settlePlant();
+        _heaterOn = level;
+        _stats.heaterSwitches++;
+    }
+}
+
+int ChamberSimulator::analogRead(uint8_t pin)
+{
+    _stats.analogReads++;
+    advance(ANALOG_READ_COST_US);
+    return sampleAnalog(pin);
+}
+
+void ChamberSimulator::adcStart(uint8_t pin)
+{
+    _adcPin = pin;
+    _adcBusy = true;
+    _adcDoneUs = _nowUs + ADC_CONVERSION_US;
+}
+
+void ChamberSimulator::flushAdc(uint16_t conversions)
+{
+    if (_inInterrupt || !_adcBusy || _adcHandler == nullptr)
+    {
+        return;
+    }
+    uint64_t doneUs = _adcDoneUs;
+    _inInterrupt = true;
+    for (uint16_t i = 0; i < conversions; i++)
+    {
+        _adcHandler(static_cast<uint16_t>(sampleAnalog(_adcPin)));
+    }
+    _inInterrupt = false;
+    _adcDoneUs = doneUs;
+}
+
+// === EEPROM ===
+uint8_t ChamberSimulator::eepromRead(uint16_t address)
+{
+    advance(EEPROM_READ_COST_US);
+    return address < EEPROM_SIZE ? _eeprom[address] : 0xFF;
+}
+
+void ChamberSimulator::eepromWrite(uint16_t address, uint8_t value)
+{
+    if (!eepromReady())
+    {
+        // eeprom_write_byte() spins until the previous write is done.
+        _stats.eepromBlockedUs += _eepromBusyUntilUs - _nowUs;
+        advance(_eepromBusyUntilUs - _nowUs);
+    }
+    if (address < EEPROM_SIZE)
+    {
+        _eeprom[address] = value;
+        _eepromCellWrites[address]++;
+        _stats.eepromWrites++;
+        _stats.eepromMaxCellWrites = std::max(_stats.eepromMaxCellWrites, _eepromCellWrites[address]);
+    }
+    _eepromBusyUntilUs = _nowUs + EEPROM_WRITE_US;
+    advance(EEPROM_WRITE_COST_US);
+}
+
+void ChamberSimulator::loadEeprom(const uint8_t *image, size_t size)
+{
+    std::copy(image, image + std::min(size, _eeprom.size()), _eeprom.begin());
+}
+
+// === TICK AND SLEEP ===
+void ChamberSimulator::tickBegin(void (*onTick)(), uint32_t periodUs)
+{
+    _tickHandler = onTick;
+    _tickPeriodUs = periodUs;
+    _nextTickUs = _nowUs + periodUs;
+}
+
+void ChamberSimulator::scheduleExternalInterrupt(uint64_t atUs, void (*handler)(), uint8_t pin, uint32_t holdUs)
+{
+    _externalHandler = handler;
+    _externalAtUs = atUs;
+    _externalPin = pin;
+    _externalLowUntilUs = atUs + holdUs;
+}
+
+// === BUTTON ===
+bool ChamberSimulator::digitalRead(uint8_t pin)
+{
+    // An input register read, a fraction of a microsecond: no time is charged. Unwired
+    // inputs read high, as with their pull-up.
+    if (pin == _externalPin)
+    {
+        return _nowUs < _externalAtUs || _nowUs >= _externalLowUntilUs;
+    }
+    return pin == _buttonPin ? _buttonLevel : true;
+}
+
+void ChamberSimulator::pinChangeBegin(uint8_t pin, void (*onChange)(bool level))
+{
+    _buttonPin = pin;
+    _pinChangeHandler = onChange;
+}
+
+void ChamberSimulator::addButtonPress(uint64_t atUs, uint32_t holdUs)
+{
+    for (bool level : {false, true})
+    {
+        uint64_t startUs = level ? atUs + holdUs : atUs;
+        for (size_t i = 0; i < sizeof(BUTTON_BOUNCE_US) / sizeof(BUTTON_BOUNCE_US[0]); i++)
+        {
+            _buttonEdges.push_back({startUs + BUTTON_BOUNCE_US[i], i % 2 == 0 ? level : !level});
+        }
+    }
+    std::stable_sort(_buttonEdges.begin() + _nextButtonEdge, _buttonEdges.end(),
+                     [](const ButtonEdge &a, const ButtonEdge &b) { return a.atUs < b.atUs; });
+}
+
+// === WATCHDOG ===
+void ChamberSimulator::watchdogBegin(void (*onTimeout)(), uint32_t timeoutUs)
+{
+    _watchdogHandler = onTimeout;
+    _watchdogTimeoutUs = timeoutUs;
+    _watchdogDueUs = _nowUs + timeoutUs;
+    _watchdogRunning = true;
+    _watchdogInterruptArmed = true;
+}
+
+void ChamberSimulator::watchdogReset()
+{
+    if (_watchdogRunning && !_halted)
+    {
+        _watchdogDueUs = _nowUs + _watchdogTimeoutUs;
+    }
+}
+
+void ChamberSimulator::watchdogExpire(uint32_t expireUs)
+{
+    // On the board the CPU spins with interrupts off until the reset.
+    _halted = true;
+    _watchdogRunning = true;
+    _watchdogInterruptArmed = false;
+    _watchdogDueUs = _nowUs + expireUs;
+}
+
+void ChamberSimulator::resetBoard()
+{
+    // Every pin becomes a high-impedance input: the heater transistor's base is pulled down.
+    for (uint8_t pin = 0; pin < PIN_COUNT; pin++)
+    {
+        drivePin(pin, false);
+    }
+    _toneRunning = false;
+    _watchdogRunning = false;
+    _halted = true;
+    _resetUs = _nowUs;
+}
+
+void ChamberSimulator::idle(uint32_t maxUs)
+{
+    if (_tickHandler == nullptr || _halted || maxUs < _tickPeriodUs)
+    {
+        advance(maxUs);
+        return;
+    }
+    // Wake exactly on the tick that ends the sleep, as the timer interrupt would.
+    uint64_t wakeUs = _nextTickUs + (maxUs / _tickPeriodUs - 1) * static_cast<uint64_t>(_tickPeriodUs);
+    advance(wakeUs - _nowUs);
+}
+
+int ChamberSimulator::sampleAnalog(uint8_t pin)
+{
+    if (pin == _pins.temperatureSensor)
+    {
+        return readTemperatureRaw();
+    }
+    if (pin == _pins.gasSensor)
+    {
+        return readGasRaw();
+    }
+    if (pin == _pins.potentiometer)
+    {
+        return _model.potentiometerRaw;
+    }
+    return 0;
+}
+
+// === TONE TIMER ===
+void ChamberSimulator::toneTimerBegin(uint8_t pin, void (*onToggle)())
+{
+    _toneHandler = onToggle;
+    _tonePin = pin;
+    _toneRunning = false;
+}
+
+void ChamberSimulator::toneTimerStart(uint8_t compare)
+{
+    _toneCompare = compare;
+    _toneRunning = true;
+    _pinLevels[_tonePin] = false;
+    _nextToggleUs = _nowUs + toneTogglePeriodUs();
+    advance(TONE_TIMER_SETUP_COST_US);
+}
+
+void ChamberSimulator::toneTimerStop()
+{
+    _toneRunning = false;
+    _pinLevels[_tonePin] = false;
+    advance(TONE_TIMER_SETUP_COST_US);
+}
+
+uint64_t ChamberSimulator::toneTogglePeriodUs() const
+{
+    return (_toneCompare + 1ULL) * 1000000ULL / Hal::TONE_TIMER_CLOCK_HZ;
+}
+
+unsigned int ChamberSimulator::sirenFrequency() const
+{
+    return _toneRunning ? Hal::TONE_TIMER_CLOCK_HZ / (2 * (_toneCompare + 1U)) : 0;
+}
+
+// === LCD ===
+void ChamberSimulator::lcdTransfer(bool isData, uint8_t value)
+{
+    // The blocking LiquidCrystal_I2C path: six single-byte expander transactions.
+    _stats.i2cBytes += I2C_BYTES_PER_LCD_BYTE;
+    advance(I2C_BYTES_PER_LCD_BYTE * i2cByteCostUs() + LCD_ENABLE_PULSE_US);
+    applyLcdByte(isData, value);
+    if (!isData && value == 0x01)
+    {
+        advance(LCD_CLEAR_DELAY_US);
+    }
+}
+
+void ChamberSimulator::i2cWrite(uint8_t address, const uint8_t *data, uint8_t length)
+{
+    (void)address;
+    if (_i2cStallUs > 0 && _nowUs >= _i2cStallAtUs)
+    {
+        // Wire spins on the TWI flags: the interrupts keep coming, in time order.
+        uint32_t stallUs = _i2cStallUs;
+        _i2cStallUs = 0;
+        _i2cStallAtUs = _nowUs;
+        for (uint32_t spunUs = 0; spunUs < stallUs; spunUs += I2C_STALL_SLICE_US)
+        {
+            advance(std::min(I2C_STALL_SLICE_US, stallUs - spunUs));
+        }
+    }
+    _stats.i2cBytes += length + 1u;
+    advance(I2C_TRANSACTION_COST_US + (length + 1u) * i2cByteCostUs());
+
+    // Decode the HD44780 4-bit protocol: a nibble is latched on the falling edge of EN.
+    for (uint8_t i = 0; i < length; i++)
+    {
+        uint8_t pins = data[i];
+        if ((_expanderPins & EXPANDER_EN) && !(pins & EXPANDER_EN))
+        {
+            uint8_t nibble = _expanderPins >> 4;
+            if (_pendingNibble < 0)
+            {
+                _pendingNibble = nibble;
+            }
+            else
+            {
+                applyLcdByte(_expanderPins & EXPANDER_RS, static_cast<uint8_t>((_pendingNibble << 4) | nibble));
+                _pendingNibble = -1;
+            }
+        }
+        _expanderPins = pins;
+    }
+}
+
+uint64_t ChamberSimulator::i2cByteCostUs() const
+{
+    return (I2C_BITS_PER_BYTE * 1000000ULL + _i2cClockHz - 1) / _i2cClockHz;
+}
+
+void ChamberSimulator::applyLcdByte(bool isData, uint8_t value)
+{
+    _stats.lcdBytes++;
+    if (isData)
+    {
+        uint8_t row = (_lcdAddress & 0x40) ? 1 : 0;
+        uint8_t col = _lcdAddress & 0x3F;
+        if (col < LCD_COLS)
+        {
+            _lcdLines[row][col] = static_cast<char>(value);
+        }
+        _lcdAddress++;
+    }
+    else if (value == 0x01)
+    {
+        _stats.lcdClears++;
+        for (auto &line : _lcdLines)
+        {
+            memset(line, ' ', LCD_COLS);
+        }
+        _lcdAddress = 0;
+    }
+    else if (value & 0x80)
+    {
+        _lcdAddress = value & 0x7F;
+    }
+}
+
+// === UART ===
+uint64_t ChamberSimulator::serialByteUs() const
+{
+    return (SERIAL_BITS_PER_BYTE * 1000000ULL + _serialBaud - 1) / _serialBaud;
+}
+
+int ChamberSimulator::serialQueued() const
+{
+    if (_serialIdleUs <= _nowUs)
+    {
+        return 0;
+    }
+    uint64_t byteUs = serialByteUs();
+    return static_cast<int>((_serialIdleUs - _nowUs + byteUs - 1) / byteUs);
+}
+
+void ChamberSimulator::serialBegin(unsigned long baud)
+{
+    _serialBaud = baud > 0 ? static_cast<uint32_t>(baud) : SERIAL_DEFAULT_BAUD;
+}
+
+void ChamberSimulator::addSerialInput(uint64_t atUs, const char *text)
+{
+    auto later = std::upper_bound(_serialInput.begin(), _serialInput.end(), atUs,
+                                  [](uint64_t us, const SerialLine &line) { return us < line.atUs; });
+    _serialInput.insert(later, SerialLine{atUs, std::string(text) + "\n"});
+}
+
+int ChamberSimulator::serialAvailable()
+{
+    // Byte i of a line is in the receive buffer once its stop bit is in.
+    uint64_t byteUs = serialByteUs();
+    int count = 0;
+    size_t offset = _serialInputOffset;
+    for (size_t line = _serialInputLine; line < _serialInput.size() && count < SERIAL_RX_BUFFER_BYTES; line++, offset = 0)
+    {
+        const SerialLine &input = _serialInput[line];
+        for (; offset < input.text.size() && count < SERIAL_RX_BUFFER_BYTES; offset++, count++)
+        {
+            if (input.atUs + (offset + 1) * byteUs > _nowUs)
+            {
+                return count;
+            }
+        }
+    }
+    return count;
+}
+
+int ChamberSimulator::serialRead()
+{
+    if (serialAvailable() == 0)
+    {
+        return -1;
+    }
+    uint8_t value = static_cast<uint8_t>(_serialInput[_serialInputLine].text[_serialInputOffset]);
+    if (++_serialInputOffset == _serialInput[_serialInputLine].text.size())
+    {
+        _serialInputLine++;
+        _serialInputOffset = 0;
+    }
+    return value;
+}
+
+int ChamberSimulator::serialAvailableForWrite()
+{
+    return SERIAL_TX_BUFFER_BYTES - serialQueued();
+}
+
+size_t ChamberSimulator::serialWrite(const uint8_t *buffer, size_t size)
+{
+    uint64_t byteUs = serialByteUs();
+    for (size_t i = 0; i < size; i++)
+    {
+        if (serialQueued() >= SERIAL_TX_BUFFER_BYTES)
+        {
+            // HardwareSerial::write() spins until the interrupt frees a slot.
+            uint64_t waitUs = _serialIdleUs - _nowUs - (SERIAL_TX_BUFFER_BYTES - 1) * byteUs;
+            _stats.serialBlockedUs += waitUs;
+            advance(waitUs);
+        }
+        _serialIdleUs = std::max(_serialIdleUs, _nowUs) + byteUs;
+        _stats.serialBytes++;
+        advance(SERIAL_WRITE_COST_US);
+    }
+    if (_serialOutput != nullptr)
+    {
+        fwrite(buffer, 1, size, _serialOutput);
+    }
+    return size;
+}
+
+// === PLANT ===
+void ChamberSimulator::advance(uint64_t us)
+{
+    uint64_t targetUs = _nowUs + us;
+
+    // The watchdog timeout splits the span, so the interrupts due before it come first.
+    if (!_inInterrupt && _watchdogRunning && _watchdogDueUs > _nowUs && _watchdogDueUs < targetUs)
+    {
+        advance(_watchdogDueUs - _nowUs);
+        if (targetUs > _nowUs)
+        {
+            advance(targetUs - _nowUs);
+        }
+        return;
+    }
+    if (_halted)
+    {
+        if (_watchdogRunning && _watchdogDueUs <= targetUs)
+        {
+            integrateTo(_watchdogDueUs);
+            resetBoard();
+        }
+        integrateTo(targetUs);
+        return;
+    }
+
+    // Interrupt handlers may themselves call the HAL; they are not re-entered.
+    if (!_inInterrupt && _externalHandler != nullptr && _externalAtUs <= targetUs)
+    {
+        void (*handler)() = _externalHandler;
+        _externalHandler = nullptr;
+        integrateTo(_externalAtUs + EXTERNAL_ISR_ENTRY_US);
+        _inInterrupt = true;
+        handler();
+        integrateTo(_nowUs + EXTERNAL_ISR_EXIT_US);
+        _inInterrupt = false;
+        targetUs = targetUs > _nowUs ? targetUs : _nowUs;
+    }
+    while (!_inInterrupt && _nextButtonEdge < _buttonEdges.size() && _buttonEdges[_nextButtonEdge].atUs <= targetUs)
+    {
+        const ButtonEdge &edge = _buttonEdges[_nextButtonEdge++];
+        integrateTo(edge.atUs);
+        _buttonLevel = edge.level;
+        _stats.buttonEdges++;
+        if (_pinChangeHandler != nullptr)
+        {
+            _inInterrupt = true;
+            _pinChangeHandler(edge.level);
+            integrateTo(_nowUs + PIN_CHANGE_ISR_COST_US);
+            _inInterrupt = false;
+        }
+        targetUs = targetUs > _nowUs ? targetUs : _nowUs;
+    }
+    if (!_inInterrupt && _adcBusy && _adcHandler != nullptr)
+    {
+        if (_adcDoneUs + ADC_CATCHUP_US < targetUs)
+        {
+            uint64_t skipped = (targetUs - ADC_CATCHUP_US - _adcDoneUs) / ADC_CONVERSION_US;
+            _adcDoneUs += skipped * ADC_CONVERSION_US;
+        }
+        while (_adcBusy && _adcDoneUs <= targetUs)
+        {
+            integrateTo(_adcDoneUs);
+            _adcBusy = false;
+            _inInterrupt = true;
+            _adcHandler(static_cast<uint16_t>(sampleAnalog(_adcPin)));
+            integrateTo(_nowUs + ADC_ISR_COST_US);
+            _inInterrupt = false;
+        }
+        // Time spent in the handlers is stolen from the interrupted code.
+        targetUs = targetUs > _nowUs ? targetUs : _nowUs;
+    }
+    if (!_inInterrupt && _toneRunning && _toneHandler != nullptr)
+    {
+        while (_toneRunning && _nextToggleUs <= targetUs)
+        {
+            integrateTo(_nextToggleUs);
+            _pinLevels[_tonePin] = !_pinLevels[_tonePin];
+            _stats.sirenToggles++;
+            _inInterrupt = true;
+            _toneHandler();
+            _inInterrupt = false;
+            _nextToggleUs += toneTogglePeriodUs();
+            integrateTo(_nowUs + TONE_ISR_COST_US);
+        }
+        targetUs = targetUs > _nowUs ? targetUs : _nowUs;
+    }
+    if (!_inInterrupt && _tickHandler != nullptr)
+    {
+        while (!_halted && _nextTickUs <= targetUs)
+        {
+            integrateTo(_nextTickUs);
+            _nextTickUs += _tickPeriodUs;
+            _inInterrupt = true;
+            _tickHandler();
+            _inInterrupt = false;
+        }
+    }
+    if (!_inInterrupt && _watchdogRunning && _watchdogInterruptArmed && _watchdogDueUs <= targetUs)
+    {
+        integrateTo(_watchdogDueUs);
+        _watchdogInterruptArmed = false; // The hardware clears WDIE: the next timeout resets
+        _watchdogDueUs += _watchdogTimeoutUs;
+        _stats.watchdogInterrupts++;
+        _inInterrupt = true;
+        if (_watchdogHandler != nullptr)
+        {
+            _watchdogHandler();
+        }
+        integrateTo(_nowUs + WATCHDOG_ISR_COST_US);
+        _inInterrupt = false;
+        targetUs = targetUs > _nowUs ? targetUs : _nowUs;
+    }
+    if (_watchdogRunning && !_watchdogInterruptArmed && _watchdogDueUs <= targetUs)
+    {
+        integrateTo(_watchdogDueUs);
+        resetBoard();
+    }
+    integrateTo(targetUs);
+}
+
+void ChamberSimulator::integrateTo(uint64_t targetUs)
+{
+    if (targetUs <= _nowUs)
+    {
+        return;
+    }
+    uint64_t us = targetUs - _nowUs;
+    if (_heaterOn)
+    {
+        _stats.heaterOnUs += us;
+    }
+    _nowUs = targetUs;
+    _unintegratedUs += us;
+    if (_unintegratedUs >= PLANT_UPDATE_US)
+    {
+        settlePlant();
+    }
+}
+
+void ChamberSimulator::settlePlant()
+{
+    float remainingS = _unintegratedUs * 1e-6f;
+    _unintegratedUs = 0;
+    while (remainingS > 0.0f)
+    {
+        float dtS = std::min(remainingS, MAX_INTEGRATION_STEP_S);
+        integrate(dtS);
+        remainingS -= dtS;
+    }
+}
+
+void ChamberSimulator::integrate(float dtS)
+{
+    float heaterPowerW = _heaterOn ? _model.heaterPowerW : 0.0f;
+    float elementToAirW = _model.heaterCouplingWPerK * (_heaterC - _chamberC);
+    float airToAmbientW = _model.chamberLossWPerK * (_chamberC - _model.ambientC);
+
+    _heaterC += (heaterPowerW - elementToAirW) / _model.heaterCapacityJPerK * dtS;
+    _chamberC += (elementToAirW - airToAmbientW) / _model.chamberCapacityJPerK * dtS;
+    _stats.heaterEnergyJ += heaterPowerW * dtS;
+}
+
+int ChamberSimulator::readTemperatureRaw()
+{
+    float volts = TMP36_OFFSET_V + _chamberC * TMP36_V_PER_C;
+    float counts = volts / ADC_REFERENCE_V * ADC_COUNTS + gaussianNoise() * _model.sensorNoiseLsb;
+    return std::clamp(static_cast<int>(std::lround(counts)), 0, 1023);
+}
+
+int ChamberSimulator::readGasRaw()
+{
+    uint32_t nowS = static_cast<uint32_t>(_nowUs / 1000000);
+    int raw = _model.gasBaselineRaw;
+    for (const GasEvent &event : _gasEvents)
+    {
+        if (nowS >= event.startS && nowS < event.startS + event.durationS)
+        {
+            raw = std::max(raw, event.raw);
+        }
+    }
+    float counts = raw + gaussianNoise() * GAS_NOISE_LSB;
+    return std::clamp(static_cast<int>(std::lround(counts)), 0, 1023);
+}
+
+float ChamberSimulator::gaussianNoise()
+{
+    // Sum of four uniforms (Irwin-Hall), scaled to unit variance: close enough to a
+    // normal distribution for sensor noise and far cheaper than std::normal_distribution.
+    float sum = 0.0f;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        _rngState ^= _rngState << 13;
+        _rngState ^= _rngState >> 17;
+        _rngState ^= _rngState << 5;
+        sum += (_rngState >> 8) * (1.0f / 16777216.0f);
+    }
+    return (sum - 2.0f) * 1.7320508f;
+}
@@ -0,0 +1,325 @@
+#pragma once
+
+#include "../hal/native/NativeBoard.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The pins the firmware uses, so the simulator knows what each access means.
+ */
+struct ChamberPins
+{
+    uint8_t heater;
+    uint8_t greenLed;
+    uint8_t redLed;
+    uint8_t piezo;
+    uint8_t temperatureSensor;
+    uint8_t gasSensor;
+    uint8_t potentiometer;
+};
+
+/**
+ * @brief Physical parameters of the simulated chamber.
+ *
+ * @details The plant is a two-node lumped thermal model: the heating element has its
+ *          own small thermal mass coupled to the chamber air, which in turn loses heat
+ *          to the ambient. The element's lag is what makes a naive controller overshoot.
+ */
+struct ChamberModel
+{
+    float ambientC = 20.0f;               // Temperature outside the chamber
+    float initialC = 20.0f;               // Chamber and element temperature at t = 0
+    float chamberCapacityJPerK = 2000.0f; // Thermal mass of air and contents
+    float chamberLossWPerK = 1.5f;        // Conductance from chamber to ambient
+    float heaterPowerW = 60.0f;           // Electrical power when the relay is closed
+    float heaterCapacityJPerK = 150.0f;   // Thermal mass of the heating element
+    float heaterCouplingWPerK = 3.0f;     // Conductance from element to chamber air
+    float sensorNoiseLsb = 0.5f;          // Standard deviation of the TMP36 reading, in ADC counts
+    int gasBaselineRaw = 150;             // MQ-3 reading with clean air
+    int potentiometerRaw = 512;           // Setpoint knob position (0-1023)
+    uint32_t seed = 1;                    // Seed of the noise generator, for reproducible runs
+};
+
+/**
+ * @brief A period during which the gas sensor reads a given raw value.
+ */
+struct GasEvent
+{
+    uint32_t startS;
+    uint32_t durationS;
+    int raw;
+};
+
+/**
+ * @brief Counters accumulated by the simulator over a run.
+ */
+struct ChamberStats
+{
+    uint64_t heaterOnUs = 0;
+    uint32_t heaterSwitches = 0;
+    double heaterEnergyJ = 0.0;
+    uint32_t analogReads = 0;
+    uint32_t digitalWrites = 0;
+    uint32_t buttonEdges = 0;
+    uint32_t portWrites = 0;          // Direct PORT writes (Hal::fastWrite())
+    uint64_t sirenToggles = 0;
+    uint32_t lcdBytes = 0;
+    uint32_t lcdClears = 0;
+    uint64_t i2cBytes = 0;
+    uint32_t eepromWrites = 0;
+    uint32_t eepromMaxCellWrites = 0; // Wear of the most written cell
+    uint64_t eepromBlockedUs = 0;     // CPU time spent waiting for a previous write
+    uint64_t serialBytes = 0;
+    uint64_t serialBlockedUs = 0;     // CPU time spent waiting for room in the TX buffer
+    uint32_t watchdogInterrupts = 0;
+};
+
+/**
+ * @class ChamberSimulator
+ * @brief A virtual fermentation chamber wired to the firmware through the native HAL.
+ *
+ * @details Simulates the heater, the ambient heat loss, the TMP36, the MQ-3 gas source,
+ *          the setpoint potentiometer, the I2C LCD, the EEPROM and the UART transmitter.
+ *          Time is virtual: every hardware access advances the clock by what it would
+ *          cost on an Uno, and the caller advances it further to model idle time, so
+ *          days of operation run in seconds.
+ *
+ *          Interrupts (ADC conversion-complete, tone timer, scheduler tick, watchdog) fire while the clock advances, so
+ *          firmware code observes them between two HAL calls, as it would on the board.
+ *          Over long idle spans only the last conversions are delivered: the sampler
+ *          keeps nothing older, and the plant changes far slower than that window.
+ *
+ *          A watchdog reset halts the board: every pin is released (the heater falls
+ *          off), and from then on firmware calls neither drive outputs nor see
+ *          interrupts. The harness ends the run there.
+ */
+class ChamberSimulator : public NativeBoard
+{
+public:
+    ChamberSimulator(const ChamberPins &pins, const ChamberModel &model);
+
+    // --- NativeBoard ---
+    uint64_t nowMicros() const override { return _nowUs; }
+    void delayMicroseconds(uint32_t us) override { advance(us); }
+    void digitalWrite(uint8_t pin, bool level) override;
+    void fastWrite(uint8_t pin, bool level) override;
+    int analogRead(uint8_t pin) override;
+    bool digitalRead(uint8_t pin) override;
+    void pinChangeBegin(uint8_t pin, void (*onChange)(bool level)) override;
+    void adcBegin(void (*onComplete)(uint16_t raw)) override { _adcHandler = onComplete; }
+    void adcStart(uint8_t pin) override;
+    void tickBegin(void (*onTick)(), uint32_t periodUs) override;
+    void idle(uint32_t maxUs) override;
+    void toneTimerBegin(uint8_t pin, void (*onToggle)()) override;
+    void toneTimerStart(uint8_t compare) override;
+    void toneTimerSetCompare(uint8_t compare) override { _toneCompare = compare; }
+    void toneTimerStop() override;
+    void lcdTransfer(bool isData, uint8_t value) override;
+    void i2cWrite(uint8_t address, const uint8_t *data, uint8_t length) override;
+    void i2cSetClock(uint32_t hz) override { _i2cClockHz = hz; }
+    void serialBegin(unsigned long baud) override;
+    int serialAvailable() override;
+    int serialRead() override;
+    int serialAvailableForWrite() override;
+    size_t serialWrite(const uint8_t *buffer, size_t size) override;
+    uint8_t eepromRead(uint16_t address) override;
+    bool eepromReady() override { return _nowUs >= _eepromBusyUntilUs; }
+    void eepromWrite(uint16_t address, uint8_t value) override;
+    void watchdogBegin(void (*onTimeout)(), uint32_t timeoutUs) override;
+    void watchdogReset() override;
+    void watchdogExpire(uint32_t expireUs) override;
+
+    /**
+     * @brief Moves the virtual clock forward, integrating the thermal plant.
+     * @param us The amount of time to advance, in microseconds.
+     */
+    void advance(uint64_t us);
+
+    /**
+     * @brief Schedules a gas release.
+     */
+    void addGasEvent(const GasEvent &event) { _gasEvents.push_back(event); }
+
+    /**
+     * @brief Fires an external interrupt (e.g. the emergency button on INT1) at a
+     *        virtual time, from the middle of whatever the firmware is doing then.
+     * @param atUs The time of the input edge.
+     * @param handler The interrupt service routine, run once.
+     * @param pin The input, which reads low from the edge for `holdUs`.
+     */
+    void scheduleExternalInterrupt(uint64_t atUs, void (*handler)(), uint8_t pin = PIN_COUNT, uint32_t holdUs = 0);
+
+    /**
+     * @brief Presses the button on the pin-change pin at a virtual time and lets it go
+     *        `holdUs` later. Both edges bounce for about 2 ms, each bounce firing the
+     *        pin-change interrupt.
+     */
+    void addButtonPress(uint64_t atUs, uint32_t holdUs);
+
+    /**
+     * @brief Makes the first I2C transaction at or after `atUs` hold the bus for
+     *        `durationUs`, as a slave stretching SCL would. Wire has no timeout, so the
+     *        firmware blocks for all of it.
+     */
+    void addI2cStall(uint64_t atUs, uint32_t durationUs)
+    {
+        _i2cStallAtUs = atUs;
+        _i2cStallUs = durationUs;
+    }
+
+    /**
+     * @brief Replaces the EEPROM contents, e.g. with the image saved by a previous run.
+     */
+    void loadEeprom(const uint8_t *image, size_t size);
+
+    /**
+     * @brief Types a line on the UART: its bytes arrive one after the other from `atUs`,
+     *        at the line rate, followed by a line feed.
+     */
+    void addSerialInput(uint64_t atUs, const char *text);
+
+    /**
+     * @brief Sends the bytes transmitted on the UART to a file (none by default).
+     */
+    void setSerialOutput(FILE *output) { _serialOutput = output; }
+
+    /**
+     * @brief Moves the setpoint knob.
+     */
+    void setPotentiometerRaw(int raw) { _model.potentiometerRaw = raw; }
+
+    // --- Observables ---
+    float chamberTemperature() const { return _chamberC; }
+    float heaterTemperature() const { return _heaterC; }
+    bool heaterOn() const { return _heaterOn; }
+    bool pinLevel(uint8_t pin) const { return pin < PIN_COUNT && _pinLevels[pin]; }
+    uint64_t pinChangeMicros(uint8_t pin) const { return pin < PIN_COUNT ? _pinChangeUs[pin] : 0; } // Last level change
+    unsigned int sirenFrequency() const;
+    const char *lcdLine(uint8_t row) const { return _lcdLines[row < LCD_ROWS ? row : 0]; }
+    const ChamberStats &stats() const { return _stats; }
+    bool halted() const { return _halted; }         // From Hal::watchdogExpire() or a watchdog reset on
+    uint64_t resetMicros() const { return _resetUs; } // Time of the watchdog reset, 0 if none
+    uint64_t i2cStallMicros() const { return _i2cStallAtUs; } // Start of the I2C stall, once it has begun
+    const std::vector<uint8_t> &eeprom() const { return _eeprom; }
+
+protected:
+    /**
+     * @brief Returns the 10-bit conversion result of an analog pin, from the plant by
+     *        default. Subclasses may serve recorded values instead (see ReplayBoard).
+     */
+    virtual int sampleAnalog(uint8_t pin);
+
+    /**
+     * @brief Completes conversions back to back, without advancing the clock, e.g. to
+     *        push a new input through the sampler's filter at once.
+     * @details The conversion in progress keeps its completion time, so the timing of
+     *          the interrupt chain is unchanged.
+     */
+    void flushAdc(uint16_t conversions);
+
+private:
+    static constexpr uint8_t PIN_COUNT = 20;
+    static constexpr uint8_t LCD_ROWS = 2;
+    static constexpr uint8_t LCD_COLS = 16;
+    static constexpr uint16_t EEPROM_SIZE = 1024;
+
+    ChamberPins _pins;
+    ChamberModel _model;
+    std::vector<GasEvent> _gasEvents;
+    uint32_t _rngState; // xorshift32 state of the noise generator
+
+    uint64_t _nowUs;
+    float _chamberC;
+    float _heaterC;
+    bool _heaterOn;
+
+    // Tone timer
+    void (*_toneHandler)();
+    uint8_t _tonePin;
+    uint8_t _toneCompare;
+    bool _toneRunning;
+    uint64_t _nextToggleUs;
+
+    // Tick interrupt
+    void (*_tickHandler)();
+    uint32_t _tickPeriodUs;
+    uint64_t _nextTickUs;
+    bool _pinLevels[PIN_COUNT];
+    uint64_t _pinChangeUs[PIN_COUNT];
+
+    // External interrupt
+    void (*_externalHandler)();
+    uint64_t _externalAtUs;
+    uint8_t _externalPin;
+    uint64_t _externalLowUntilUs; // The input is held low from _externalAtUs until then
+
+    // Pin-change interrupt (the button, pulled up: low while pressed)
+    struct ButtonEdge
+    {
+        uint64_t atUs;
+        bool level;
+    };
+    void (*_pinChangeHandler)(bool level);
+    uint8_t _buttonPin;
+    bool _buttonLevel;
+    std::vector<ButtonEdge> _buttonEdges; // In time order
+    size_t _nextButtonEdge;
+
+    // Watchdog
+    void (*_watchdogHandler)();
+    uint32_t _watchdogTimeoutUs;
+    uint64_t _watchdogDueUs;      // Next timeout: interrupt or reset
+    bool _watchdogRunning;
+    bool _watchdogInterruptArmed; // Otherwise the next timeout resets
+    bool _halted;
+    uint64_t _resetUs;
+
+    void (*_adcHandler)(uint16_t raw);
+    bool _adcBusy;
+    uint8_t _adcPin;
+    uint64_t _adcDoneUs;
+    bool _inInterrupt;
+    uint64_t _unintegratedUs; // Elapsed time not yet applied to the thermal plant
+
+    uint32_t _i2cClockHz;
+    uint64_t _i2cStallAtUs;
+    uint32_t _i2cStallUs;
+    uint8_t _expanderPins;  // Last byte written to the PCF8574
+    int16_t _pendingNibble; // High nibble received in 4-bit mode, -1 if none
+    uint8_t _lcdAddress;
+    char _lcdLines[LCD_ROWS][LCD_COLS + 1];
+
+    std::vector<uint8_t> _eeprom;
+    std::vector<uint32_t> _eepromCellWrites;
+    uint64_t _eepromBusyUntilUs;
+
+    uint32_t _serialBaud;
+    uint64_t _serialIdleUs; // When the last queued byte has left the shift register
+    FILE *_serialOutput;
+    struct SerialLine
+    {
+        uint64_t atUs;
+        std::string text; // With its line feed
+    };
+    std::vector<SerialLine> _serialInput; // In time order
+    size_t _serialInputLine;              // Line being received
+    size_t _serialInputOffset;            // Next byte of it to read
+
+    ChamberStats _stats;
+
+    uint64_t i2cByteCostUs() const;
+    uint64_t serialByteUs() const;
+    int serialQueued() const;
+    void applyLcdByte(bool isData, uint8_t value);
+    uint64_t toneTogglePeriodUs() const;
+    void integrateTo(uint64_t us);
+    void settlePlant();
+    void drivePin(uint8_t pin, bool level);
+    void resetBoard();
+    void integrate(float dtS);
+    float gaussianNoise();
+    int readTemperatureRaw();
+    int readGasRaw();
+};
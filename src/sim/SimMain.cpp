@@ -0,0 +1,686 @@
+//=================================================================================
+// SimMain.cpp
+// Entry point of the native (host) build.
+// Responsibilities:
+// - Build the same object graph as main.cpp on top of a ChamberSimulator.
+// - Run setup() and loop() on the virtual clock as fast as the CPU allows.
+// - Report loop throughput and control quality at the end of the run.
+//
+// Usage: program [hours=24] [setpoint=30] [ambient=20] [initial=20]
+//                [seed=1] [gas=<start_s>:<duration_s>:<raw>]... [estop=<s>[:<hold ms>]]
+//                [window=<heater window ms>] [log=<run log interval s>]
+//                [eeprom=<file.bin>] [telemetry=<period ms, 0 = off>]
+//                [serial=<file.bin>] [record=<file.csv>] [trace=<file.csv>]
+//                [stall=<s>:<ms>] [param=<name>:<value>]... [console=<s>:<line>]...
+//                [button=<s>:<hold ms>]...
+//
+// With eeprom=, the EEPROM image is loaded from the file when it exists and saved
+// back at the end, so consecutive runs behave like power cycles of the same board.
+// With serial=, the bytes sent on the UART (the telemetry frames) are saved to the file.
+// With record=, the sampler readings and the firmware's decisions are saved as a replay
+// trace (see src/replay/), which env:native_replay feeds back through the firmware.
+// With stall=, the first I2C transfer from then on hangs the bus for that long, as a stuck
+// LCD backpack would; the run ends at the supervisor's restart.
+// With param=, a parameter (see src/storage/ParameterStore.h) is set after the EEPROM
+// block is loaded; window= and log= are shorthands for window_ms and log_s. With
+// console=, the line is typed on the UART at that time, e.g. console=60::kp=60 then
+// console=61::save; the replies go to the serial= file. console=<s>:a starts an autotune
+// experiment, whose gains and end time are reported at the end. With button=, the
+// acknowledge button is pressed at that time and held that long, bouncing on both edges:
+// a short press pages the LCD or silences a gas warning, a hold of 1.5 s or more
+// acknowledges an emergency stop. With estop=, the stop button is pressed at that time
+// and held that long (200 ms if not given); the acknowledge only counts once it has been
+// let go.
+// ============================================================================================
+
+#include "ChamberSimulator.h"
+#include "../controllers/ActuatorController.h"
+#include "../sensors/SensorManager.h"
+#include "../sensors/DebouncedButton.h"
+#include "../display/DisplayManager.h"
+#include "../core/SystemState.h"
+#include "../core/Scheduler.h"
+#include "../core/Supervisor.h"
+#include "../storage/RunLog.h"
+#include "../storage/ParameterStore.h"
+#include "../diagnostics/LoopProfiler.h"
+#include "../diagnostics/LatencyProbe.h"
+#include "../diagnostics/Telemetry.h"
+#include "../replay/ReplayTrace.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// PIN DEFINITIONS (same wiring as main.cpp)
+constexpr byte TRANSISTOR_PIN = 2;
+constexpr byte EMERGENCY_BUTTON_PIN = 3;
+constexpr byte GREEN_LED_PIN = 10;
+constexpr byte ACKNOWLEDGE_BUTTON_PIN = 11;
+constexpr byte RED_LED_PIN = 12;
+constexpr byte PIEZO_PIN = 13;
+constexpr byte TEMPERATURE_SENSOR_PIN = A0;
+constexpr byte GAS_SENSOR_PIN = A2;
+constexpr byte POTENTIOMETER_PIN = A3;
+constexpr byte I2C_ADDRESS = 0x27;
+
+// RUN DEFAULTS
+constexpr double DEFAULT_HOURS = 24.0;
+constexpr float DEFAULT_SETPOINT_C = 30.0f;
+constexpr uint32_t DEFAULT_ESTOP_HOLD_MS = 200; // How long estop= holds the stop button down
+constexpr uint64_t LOOP_OVERHEAD_US = 20;    // CPU time of a pass that touches no hardware
+constexpr uint32_t SAMPLE_PERIOD_S = 1;      // Control-quality sampling period
+constexpr char PARAMETER_COMMAND = ':';       // As in main.cpp
+constexpr char AUTOTUNE_COMMAND = 'a';
+constexpr uint16_t CONSOLE_TASK_PERIOD_MS = 50; // The timing of main.cpp's serial task
+constexpr uint16_t CONSOLE_TASK_PHASE_MS = 4;
+constexpr uint16_t CONSOLE_TASK_DEADLINE_MS = 10;
+constexpr uint32_t TRACE_PERIOD_S = 10;      // Trace file sampling period
+constexpr uint32_t SETTLE_AFTER_FIRST_REACH_S = 600;
+constexpr float STABILITY_BAND_C = 0.5f;
+constexpr int64_t ESTIMATOR_WARMUP_S = 60;  // Estimator errors are measured from then on
+
+struct RunOptions
+{
+    double hours = DEFAULT_HOURS;
+    float setpointC = DEFAULT_SETPOINT_C;
+    int32_t emergencyStopS = -1;
+    uint32_t emergencyStopHoldMs = DEFAULT_ESTOP_HOLD_MS;
+    int32_t stallS = -1;
+    uint32_t stallMs = 0;
+    std::vector<std::pair<std::string, uint16_t>> parameterSettings; // Name and value, in order
+    std::vector<std::pair<uint32_t, std::string>> consoleLines;      // Time (s) and text
+    std::vector<std::pair<uint32_t, uint32_t>> buttonPresses;         // Time (s) and hold (ms)
+    const char *eepromPath = nullptr;
+    uint16_t telemetryPeriodMs = TELEMETRY_DEFAULT_PERIOD_MS;
+    const char *serialPath = nullptr;
+    const char *recordPath = nullptr;
+    const char *tracePath = nullptr;
+    std::vector<GasEvent> gasEvents;
+};
+
+struct QualityStats
+{
+    int64_t firstReachS = -1;
+    int64_t settledS = -1; // From then on the temperature stayed within STABILITY_BAND_C
+    float maxOvershootC = 0.0f;
+    double sumAbsErrorC = 0.0;
+    double sumSquaredErrorC = 0.0;
+    uint32_t settledSamples = 0;
+    uint32_t inBandSamples = 0;
+    double sumSquaredEstimateErrorC = 0.0;
+    double sumSquaredRateErrorC = 0.0;
+    uint32_t estimateSamples = 0;
+};
+
+// The interrupt service routines are plain functions, as on the board.
+static SystemState *isrTarget = nullptr;
+static const ChamberSimulator *isrBoard = nullptr;
+static bool emergencyStopFired = false;
+static bool heaterOnAtStop = false;  // Output levels the button edge found
+static bool redLedOffAtStop = false;
+
+static void gasTripISR(void *)
+{
+    isrTarget->triggerGasTrip();
+}
+
+static void emergencyStopISR()
+{
+    heaterOnAtStop = isrBoard->pinLevel(TRANSISTOR_PIN);
+    redLedOffAtStop = !isrBoard->pinLevel(RED_LED_PIN);
+    isrTarget->triggerEmergencyStop();
+    emergencyStopFired = true;
+}
+
+// The parameter console and the autotune command of main.cpp's serial task; the sim
+// has no other commands.
+static SystemState *consoleTarget = nullptr;
+
+static void consoleTask(void *context)
+{
+    ParameterStore &store = *static_cast<ParameterStore *>(context);
+    if (store.serviceCommand(Hal::serial()))
+    {
+        return;
+    }
+    int command = Hal::serial().read();
+    if (command == PARAMETER_COMMAND)
+    {
+        store.openCommand();
+        store.serviceCommand(Hal::serial());
+    }
+    if (command == AUTOTUNE_COMMAND)
+    {
+        consoleTarget->requestAutotune();
+    }
+}
+
+static bool parseOption(const char *arg, RunOptions &options, ChamberModel &model)
+{
+    const char *eq = strchr(arg, '=');
+    if (eq == nullptr)
+    {
+        return false;
+    }
+    size_t keyLength = eq - arg;
+    const char *value = eq + 1;
+    auto is = [&](const char *key) { return strlen(key) == keyLength && strncmp(arg, key, keyLength) == 0; };
+
+    if (is("hours")) options.hours = atof(value);
+    else if (is("setpoint")) options.setpointC = static_cast<float>(atof(value));
+    else if (is("ambient")) model.ambientC = static_cast<float>(atof(value));
+    else if (is("initial")) model.initialC = static_cast<float>(atof(value));
+    else if (is("seed")) model.seed = static_cast<uint32_t>(atol(value));
+    else if (is("estop"))
+    {
+        options.emergencyStopS = static_cast<int32_t>(atol(value));
+        const char *colon = strchr(value, ':');
+        if (colon != nullptr)
+        {
+            options.emergencyStopHoldMs = static_cast<uint32_t>(atol(colon + 1));
+        }
+    }
+    else if (is("window")) options.parameterSettings.emplace_back("window_ms", static_cast<uint16_t>(atol(value)));
+    else if (is("log")) options.parameterSettings.emplace_back("log_s", static_cast<uint16_t>(atol(value)));
+    else if (is("eeprom")) options.eepromPath = value;
+    else if (is("telemetry"))
+    {
+        options.telemetryPeriodMs = static_cast<uint16_t>(atol(value));
+        if (options.telemetryPeriodMs != 0)
+        {
+            options.parameterSettings.emplace_back("telem_ms", options.telemetryPeriodMs);
+        }
+    }
+    else if (is("serial")) options.serialPath = value;
+    else if (is("record")) options.recordPath = value;
+    else if (is("trace")) options.tracePath = value;
+    else if (is("stall"))
+    {
+        if (sscanf(value, "%d:%u", &options.stallS, &options.stallMs) != 2)
+        {
+            return false;
+        }
+    }
+    else if (is("param"))
+    {
+        const char *colon = strchr(value, ':');
+        if (colon == nullptr)
+        {
+            return false;
+        }
+        options.parameterSettings.emplace_back(std::string(value, colon), static_cast<uint16_t>(atol(colon + 1)));
+    }
+    else if (is("console"))
+    {
+        const char *colon = strchr(value, ':');
+        if (colon == nullptr)
+        {
+            return false;
+        }
+        options.consoleLines.emplace_back(static_cast<uint32_t>(atol(value)), colon + 1);
+    }
+    else if (is("button"))
+    {
+        unsigned int atS, holdMs;
+        if (sscanf(value, "%u:%u", &atS, &holdMs) != 2)
+        {
+            return false;
+        }
+        options.buttonPresses.emplace_back(atS, holdMs);
+    }
+    else if (is("gas"))
+    {
+        GasEvent event{};
+        if (sscanf(value, "%u:%u:%d", &event.startS, &event.durationS, &event.raw) != 3)
+        {
+            return false;
+        }
+        options.gasEvents.push_back(event);
+    }
+    else return false;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    RunOptions options;
+    ChamberModel model;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!parseOption(argv[i], options, model))
+        {
+            fprintf(stderr, "Unknown or malformed option: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    // The knob position the firmware's calibration table maps closest to the requested setpoint.
+    float bestError = INFINITY;
+    for (int raw = 0; raw <= 1023; raw++)
+    {
+        float error = fabsf(TemperatureMath::toFloat(Calibration::setpointFromSample(raw << ADC_EXTRA_BITS)) - options.setpointC);
+        if (error < bestError)
+        {
+            bestError = error;
+            model.potentiometerRaw = raw;
+        }
+    }
+    const float setpointC = TemperatureMath::toFloat(Calibration::setpointFromSample(model.potentiometerRaw << ADC_EXTRA_BITS));
+
+    ChamberPins pins{TRANSISTOR_PIN, GREEN_LED_PIN, RED_LED_PIN, PIEZO_PIN,
+                     TEMPERATURE_SENSOR_PIN, GAS_SENSOR_PIN, POTENTIOMETER_PIN};
+    ChamberSimulator sim(pins, model);
+    for (const GasEvent &event : options.gasEvents)
+    {
+        sim.addGasEvent(event);
+    }
+    if (options.stallS >= 0)
+    {
+        sim.addI2cStall(static_cast<uint64_t>(options.stallS) * 1000000, options.stallMs * 1000);
+    }
+    for (const auto &line : options.consoleLines)
+    {
+        sim.addSerialInput(static_cast<uint64_t>(line.first) * 1000000, line.second.c_str());
+    }
+    for (const auto &press : options.buttonPresses)
+    {
+        sim.addButtonPress(static_cast<uint64_t>(press.first) * 1000000, press.second * 1000);
+    }
+    if (options.eepromPath != nullptr)
+    {
+        FILE *image = fopen(options.eepromPath, "rb");
+        if (image != nullptr)
+        {
+            uint8_t buffer[Hal::EEPROM_SIZE];
+            size_t size = fread(buffer, 1, sizeof(buffer), image);
+            fclose(image);
+            sim.loadEeprom(buffer, size);
+        }
+    }
+    NativeBoard::install(sim);
+
+    // OBJECT DEFINITIONS (same graph as main.cpp)
+    static ActuatorController actuatorController(TRANSISTOR_PIN, GREEN_LED_PIN, RED_LED_PIN, PIEZO_PIN);
+    static SensorManager sensorManager(TEMPERATURE_SENSOR_PIN, GAS_SENSOR_PIN, POTENTIOMETER_PIN);
+    static DisplayManager lcd(I2C_ADDRESS);
+    static DebouncedButton acknowledgeButton(ACKNOWLEDGE_BUTTON_PIN);
+    static SystemState systemState(sensorManager, actuatorController, lcd, acknowledgeButton, EMERGENCY_BUTTON_PIN);
+    static RunLog runLog(systemState, sensorManager, actuatorController);
+    static ParameterStore parameterStore;
+    static Scheduler scheduler;
+    static Supervisor supervisor(scheduler, actuatorController);
+    static Telemetry telemetry(systemState, sensorManager, actuatorController, scheduler);
+    static uint32_t autotunedMs = 0; // When the autotune handler ran
+
+    FILE *trace = nullptr;
+    if (options.tracePath != nullptr)
+    {
+        trace = fopen(options.tracePath, "w");
+        if (trace == nullptr)
+        {
+            fprintf(stderr, "Cannot open trace file %s\n", options.tracePath);
+            return 1;
+        }
+        fprintf(trace, "time_s,chamber_c,estimate_c,rate_c_per_s,element_c,heater,duty_pct,state,lcd_line1,lcd_line2\n");
+    }
+
+    FILE *serialOutput = nullptr;
+    if (options.serialPath != nullptr)
+    {
+        serialOutput = fopen(options.serialPath, "wb");
+        if (serialOutput == nullptr)
+        {
+            fprintf(stderr, "Cannot open serial output %s\n", options.serialPath);
+            return 1;
+        }
+        sim.setSerialOutput(serialOutput);
+    }
+
+    ReplayTraceWriter recorder;
+    if (options.recordPath != nullptr && !recorder.open(options.recordPath))
+    {
+        fprintf(stderr, "Cannot open replay trace %s\n", options.recordPath);
+        return 1;
+    }
+
+    // setup()
+    Hal::serial().begin(TELEMETRY_BAUD);
+    parameterStore.begin([] {
+        actuatorController.setHeaterWindow(parameters.heaterWindowMs);
+        runLog.setInterval(parameters.logIntervalS);
+        telemetry.setPeriod(parameters.telemetryPeriodMs);
+        sensorManager.setGasTripLevel(parameters.gasHighThreshold);
+    });
+    for (const auto &setting : options.parameterSettings)
+    {
+        if (!parameterStore.set(setting.first.c_str(), setting.second))
+        {
+            fprintf(stderr, "Unknown parameter, or value out of range or order: %s=%u\n", setting.first.c_str(), setting.second);
+            return 2;
+        }
+    }
+    actuatorController.begin();
+    sensorManager.begin();
+    lcd.begin();
+    acknowledgeButton.begin();
+    ReplayStep step{static_cast<uint32_t>(Hal::millis()), Replay::captureInputs(sensorManager, false, false), {}};
+    systemState.begin();
+    systemState.setAutotuneHandler([](const AutotuneResult &result) {
+        parameterStore.set(ParameterId::PROPORTIONAL_GAIN, result.proportionalGain);
+        parameterStore.set(ParameterId::DERIVATIVE_GAIN, result.derivativeGain);
+        parameterStore.set(ParameterId::INTEGRAL_GAIN, result.integralGain);
+        parameterStore.save();
+        autotunedMs = static_cast<uint32_t>(Hal::millis());
+    });
+    isrTarget = &systemState;
+    consoleTarget = &systemState;
+    isrBoard = &sim;
+    sensorManager.watchGas(gasTripISR, nullptr);
+    runLog.begin();
+    telemetry.setEnabled(options.telemetryPeriodMs != 0);
+    telemetry.begin(Hal::serial());
+    actuatorController.registerTasks(scheduler);
+    systemState.registerTasks(scheduler);
+    sensorManager.registerTasks(scheduler);
+    lcd.registerTasks(scheduler);
+    runLog.registerTasks(scheduler);
+    parameterStore.registerTasks(scheduler);
+    telemetry.registerTasks(scheduler);
+    scheduler.add("serial", consoleTask, &parameterStore, CONSOLE_TASK_PERIOD_MS, CONSOLE_TASK_PHASE_MS, CONSOLE_TASK_DEADLINE_MS);
+    supervisor.registerTasks(scheduler);
+    scheduler.begin();
+    supervisor.begin();
+    step.decisions = Replay::captureDecisions(systemState, actuatorController, sim);
+    recorder.write(step);
+
+    const uint64_t endUs = static_cast<uint64_t>(options.hours * 3600.0 * 1e6);
+    uint64_t loops = 0;
+    uint64_t busyUs = 0;
+    uint64_t worstLoopUs = 0;
+    uint64_t nextSampleUs = 0;
+    uint64_t nextTraceUs = 0;
+    if (options.emergencyStopS >= 0)
+    {
+        // The button edge lands wherever the firmware happens to be, mid-pass or asleep.
+        sim.scheduleExternalInterrupt(static_cast<uint64_t>(options.emergencyStopS) * 1000000, emergencyStopISR,
+                                      EMERGENCY_BUTTON_PIN, options.emergencyStopHoldMs * 1000);
+    }
+    bool emergencyTriggered = false;
+    uint64_t heaterOffAtStopUs = 0; // Pin edges of the stop, before an acknowledge moves them again
+    uint64_t redLedAtStopUs = 0;
+    uint16_t gasTrips = 0;
+    bool heaterOnAtRestart = false;
+    uint64_t maxGasDetectUs = 0; // From the onset of a gas event to the trip
+    uint32_t buttonEvents[4] = {};  // Taken by the FSM, indexed by ButtonEvent
+    QualityStats quality;
+    float previousTemperatureC = sim.chamberTemperature();
+
+    auto wallStart = std::chrono::steady_clock::now();
+    while (sim.nowMicros() < endUs)
+    {
+        // loop()
+        scheduler.idle();
+        step.timeMs = static_cast<uint32_t>(Hal::millis());
+        step.inputs = Replay::captureInputs(sensorManager, false, false);
+        step.inputs.emergencyStopHeld = !Hal::digitalRead(EMERGENCY_BUTTON_PIN);
+
+        uint64_t passStartUs = sim.nowMicros();
+        PROFILE_PASS_BEGIN();
+        scheduler.dispatch();
+        sim.advance(LOOP_OVERHEAD_US);
+        PROFILE_PASS_END();
+        supervisor.pet();
+        uint64_t passUs = sim.nowMicros() - passStartUs;
+
+        // The trip fires from the ADC interrupt, while idle or in the middle of the pass.
+        GasTripStats gasTrip = systemState.getGasTripStats();
+        bool gasTripNow = gasTrip.trips != gasTrips;
+        if (gasTripNow)
+        {
+            gasTrips = gasTrip.trips;
+            // micros() wraps at 32 bits, as on the board
+            uint64_t now = sim.nowMicros();
+            uint64_t tripUs = now - static_cast<uint32_t>(static_cast<uint32_t>(now) - gasTrip.lastTripUs);
+            for (const GasEvent &event : options.gasEvents)
+            {
+                uint64_t onsetUs = static_cast<uint64_t>(event.startS) * 1000000;
+                if (tripUs >= onsetUs && tripUs < onsetUs + static_cast<uint64_t>(event.durationS) * 1000000)
+                {
+                    maxGasDetectUs = tripUs - onsetUs > maxGasDetectUs ? tripUs - onsetUs : maxGasDetectUs;
+                }
+            }
+        }
+        step.inputs.gasTrip = gasTripNow;
+        step.inputs.button = acknowledgeButton.takeHistory();
+        for (uint16_t events = step.inputs.button; events != 0; events >>= 2)
+        {
+            buttonEvents[events & 3]++;
+        }
+        step.inputs.emergencyStop = emergencyStopFired && !emergencyTriggered;
+        if (step.inputs.emergencyStop)
+        {
+            heaterOffAtStopUs = sim.pinChangeMicros(TRANSISTOR_PIN);
+            redLedAtStopUs = sim.pinChangeMicros(RED_LED_PIN);
+        }
+        emergencyTriggered = emergencyStopFired;
+        if (options.recordPath != nullptr)
+        {
+            step.decisions = Replay::captureDecisions(systemState, actuatorController, sim);
+            recorder.write(step);
+        }
+
+        loops++;
+        busyUs += passUs;
+        worstLoopUs = passUs > worstLoopUs ? passUs : worstLoopUs;
+
+        uint64_t now = sim.nowMicros();
+        if (now >= nextSampleUs)
+        {
+            nextSampleUs += SAMPLE_PERIOD_S * 1000000ULL;
+            float temperature = sim.chamberTemperature();
+            float error = temperature - setpointC;
+            int64_t nowS = static_cast<int64_t>(now / 1000000);
+            if (nowS >= ESTIMATOR_WARMUP_S)
+            {
+                const TemperatureEstimator &estimator = systemState.getEstimator();
+                double estimateError = TemperatureMath::toFloat(estimator.temperature()) - temperature;
+                double rateError = TemperatureMath::toFloat(estimator.rate()) - (temperature - previousTemperatureC) / SAMPLE_PERIOD_S;
+                quality.sumSquaredEstimateErrorC += estimateError * estimateError;
+                quality.sumSquaredRateErrorC += rateError * rateError;
+                quality.estimateSamples++;
+            }
+            previousTemperatureC = temperature;
+            if (quality.firstReachS < 0 && error >= 0.0f)
+            {
+                quality.firstReachS = nowS;
+            }
+            if (quality.firstReachS >= 0)
+            {
+                quality.maxOvershootC = error > quality.maxOvershootC ? error : quality.maxOvershootC;
+                if (fabs(error) > STABILITY_BAND_C || quality.settledS < 0)
+                {
+                    quality.settledS = fabs(error) > STABILITY_BAND_C ? -1 : nowS;
+                }
+                if (nowS >= quality.firstReachS + SETTLE_AFTER_FIRST_REACH_S)
+                {
+                    quality.settledSamples++;
+                    quality.sumAbsErrorC += fabs(error);
+                    quality.sumSquaredErrorC += static_cast<double>(error) * error;
+                    quality.inBandSamples += fabs(error) <= STABILITY_BAND_C ? 1 : 0;
+                }
+            }
+        }
+        if (trace != nullptr && now >= nextTraceUs)
+        {
+            nextTraceUs += TRACE_PERIOD_S * 1000000ULL;
+            fprintf(trace, "%llu,%.3f,%.3f,%.5f,%.3f,%d,%u,%s,\"%s\",\"%s\"\n",
+                    static_cast<unsigned long long>(now / 1000000), sim.chamberTemperature(),
+                    TemperatureMath::toFloat(systemState.getEstimator().temperature()),
+                    TemperatureMath::toFloat(systemState.getEstimator().rate()), sim.heaterTemperature(),
+                    sim.heaterOn() ? 1 : 0, actuatorController.getHeaterDuty(), States::label(systemState.getState()),
+                    sim.lcdLine(0), sim.lcdLine(1));
+        }
+        if (sim.halted())
+        {
+            // The supervisor restarted the board: let the watchdog reset happen, then stop.
+            heaterOnAtRestart = sim.pinLevel(TRANSISTOR_PIN);
+            sim.advance(Hal::WATCHDOG_EXPIRE_MS * 1000UL);
+            break;
+        }
+    }
+    double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    if (trace != nullptr)
+    {
+        fclose(trace);
+    }
+    if (serialOutput != nullptr)
+    {
+        fclose(serialOutput);
+    }
+    recorder.close();
+    if (options.eepromPath != nullptr)
+    {
+        FILE *image = fopen(options.eepromPath, "wb");
+        if (image == nullptr)
+        {
+            fprintf(stderr, "Cannot write EEPROM image %s\n", options.eepromPath);
+            return 1;
+        }
+        fwrite(sim.eeprom().data(), 1, sim.eeprom().size(), image);
+        fclose(image);
+    }
+
+    const ChamberStats &stats = sim.stats();
+    double virtualS = sim.nowMicros() / 1e6;
+    double virtualHours = virtualS / 3600.0;
+    double settled = quality.settledSamples > 0 ? quality.settledSamples : 1;
+
+    printf("# Bio-Logic Controller native simulation\n");
+    printf("virtual_hours          %.2f\n", virtualHours);
+    printf("wall_seconds           %.3f\n", wallS);
+    printf("speedup                %.0f\n", wallS > 0 ? virtualS / wallS : 0.0);
+    printf("loops                  %llu\n", static_cast<unsigned long long>(loops));
+    printf("loops_per_wall_second  %.0f\n", wallS > 0 ? loops / wallS : 0.0);
+    printf("loop_mean_virtual_us   %.1f\n", loops > 0 ? static_cast<double>(busyUs) / loops : 0.0);
+    printf("loop_worst_virtual_us  %llu\n", static_cast<unsigned long long>(worstLoopUs));
+    printf("cpu_busy_pct           %.2f\n", virtualS > 0 ? 100.0 * busyUs / 1e6 / virtualS : 0.0);
+    for (TaskId id = 0; id < scheduler.taskCount(); id++)
+    {
+        const TaskStats &task = scheduler.taskStats(id);
+        printf("task_%-8s runs %lu overruns %u max_lateness_ms %u max_run_us %u\n", scheduler.taskName(id),
+               static_cast<unsigned long>(task.runs), task.overruns, task.maxLatenessTicks * SCHEDULER_TICK_MS, task.maxRunUs);
+    }
+    printf("final_state            %s\n", States::label(systemState.getState()));
+    printf("setpoint_c             %.2f\n", setpointC);
+    printf("first_reach_s          %lld\n", static_cast<long long>(quality.firstReachS));
+    printf("max_overshoot_c        %.3f\n", quality.maxOvershootC);
+    printf("settling_s             %lld\n", static_cast<long long>(quality.settledS));
+    printf("mean_abs_error_c       %.3f\n", quality.sumAbsErrorC / settled);
+    printf("rms_error_c            %.3f\n", sqrt(quality.sumSquaredErrorC / settled));
+    printf("time_in_band_pct       %.1f\n", 100.0 * quality.inBandSamples / settled);
+    printf("estimate_rms_error_c   %.4f\n", quality.estimateSamples > 0 ? sqrt(quality.sumSquaredEstimateErrorC / quality.estimateSamples) : 0.0);
+    printf("rate_rms_error_mc_s    %.3f\n", quality.estimateSamples > 0 ? 1000.0 * sqrt(quality.sumSquaredRateErrorC / quality.estimateSamples) : 0.0);
+    printf("heater_duty_pct        %.1f\n", virtualS > 0 ? 100.0 * stats.heaterOnUs / 1e6 / virtualS : 0.0);
+    printf("heater_switches_per_h  %.1f\n", virtualHours > 0 ? stats.heaterSwitches / virtualHours : 0.0);
+    printf("heater_window_ms       %u\n", parameters.heaterWindowMs);
+    const PredictiveControl &predictive = systemState.getPredictiveControl();
+    printf("heater_control         %s\n", parameters.heaterControlMode == HeaterControlMode::PREDICTIVE ? "predictive" : "pid");
+    printf("model_identified       %d\n", predictive.isIdentified() ? 1 : 0);
+    printf("model_dead_time_s      %u\n", predictive.model().deadSteps * HEATER_CONTROL_PERIOD_MS / 1000);
+    printf("model_time_constant_s  %lu\n", static_cast<unsigned long>(predictive.model().timeConstantSteps) * HEATER_CONTROL_PERIOD_MS / 1000);
+    printf("model_rate_mc_s        %.2f\n", predictive.model().fullPowerRate / 16777216.0 * 1e6 / HEATER_CONTROL_PERIOD_MS);
+    const Autotuner &autotuner = systemState.getAutotuner();
+    static const char *const AUTOTUNE_STATUS_NAMES[] = {"idle", "running", "done", "failed"};
+    printf("autotune_status        %s\n", AUTOTUNE_STATUS_NAMES[static_cast<uint8_t>(autotuner.status())]);
+    if (autotuner.status() == Autotuner::Status::DONE)
+    {
+        const AutotuneResult &result = autotuner.result();
+        printf("autotune_period_s      %u\n", result.ultimatePeriodS);
+        printf("autotune_amplitude_c   %.3f\n", static_cast<double>(TemperatureMath::toFloat(result.amplitude)));
+        printf("autotune_ultimate_gain %u\n", result.ultimateGain);
+        printf("autotune_bias_pct      %u\n", result.bias);
+        printf("autotune_clamped       %d\n", result.clamped ? 1 : 0);
+        printf("autotune_done_s        %lu\n", static_cast<unsigned long>(autotunedMs / 1000));
+    }
+    printf("gains_kp_kd_ki         %d %d %d\n", parameters.heaterProportionalGain, parameters.heaterDerivativeGain,
+           parameters.heaterIntegralGain);
+    printf("relay_switches_per_h   %.1f\n", virtualHours > 0 ? actuatorController.getHeaterSwitchCount() / virtualHours : 0.0);
+    printf("heater_energy_wh       %.2f\n", stats.heaterEnergyJ / 3600.0);
+    printf("analog_reads           %u\n", stats.analogReads);
+    printf("digital_writes         %u\n", stats.digitalWrites);
+    printf("port_writes            %u\n", stats.portWrites);
+    printf("led_writes             %lu\n", static_cast<unsigned long>(actuatorController.getLedWriteCount()));
+    printf("led_writes_avoided     %lu\n", static_cast<unsigned long>(actuatorController.getLedWritesAvoided()));
+    printf("siren_toggles          %llu\n", static_cast<unsigned long long>(stats.sirenToggles));
+    printf("telemetry_records      %lu\n", static_cast<unsigned long>(telemetry.getRecordCount()));
+    printf("telemetry_dropped      %lu\n", static_cast<unsigned long>(telemetry.getDroppedCount()));
+    printf("serial_tx_bytes        %llu\n", static_cast<unsigned long long>(stats.serialBytes));
+    printf("serial_blocked_us      %llu\n", static_cast<unsigned long long>(stats.serialBlockedUs));
+    printf("runlog_session         %u\n", runLog.getSession());
+    printf("runlog_samples         %lu\n", static_cast<unsigned long>(runLog.getSampleCount()));
+    GasTripStats gasTrip = systemState.getGasTripStats();
+    printf("gas_trips              %u\n", gasTrip.trips);
+    printf("gas_trip_detect_us     %llu\n", static_cast<unsigned long long>(maxGasDetectUs));
+    printf("gas_trip_heater_off_us %u\n", gasTrip.maxHeaterOffUs);
+    printf("gas_trip_response_us   %lu\n", static_cast<unsigned long>(gasTrip.maxResponseUs));
+    if (emergencyTriggered)
+    {
+        // From the button edge to the pin edges; -1 when the pin was already at its emergency level
+        uint64_t edgeUs = static_cast<uint64_t>(options.emergencyStopS) * 1000000;
+        printf("estop_heater_off_us    %lld\n", heaterOnAtStop ? static_cast<long long>(heaterOffAtStopUs - edgeUs) : -1LL);
+        printf("estop_red_led_us       %lld\n", redLedOffAtStop ? static_cast<long long>(redLedAtStopUs - edgeUs) : -1LL);
+        printf("estop_bound_us         %u\n", LATENCY_BOUND_US);
+    }
+    if (!options.buttonPresses.empty())
+    {
+        printf("button_edges           %u\n", stats.buttonEdges);
+        printf("button_presses         %u\n", buttonEvents[static_cast<uint8_t>(ButtonEvent::PRESS)]);
+        printf("button_long_presses    %u\n", buttonEvents[static_cast<uint8_t>(ButtonEvent::LONG_PRESS)]);
+        printf("button_releases        %u\n", buttonEvents[static_cast<uint8_t>(ButtonEvent::RELEASE)]);
+        printf("button_dropped         %u\n", acknowledgeButton.getDroppedCount());
+    }
+    SupervisorRecord record;
+    Supervisor::loadPersisted(record); // As the next start-up will find it
+    auto taskName = [&](TaskId id) { return id < scheduler.taskCount() ? scheduler.taskName(id) : "-"; };
+    printf("last_overrun_task      %s\n", taskName(record.lastOverrunTask));
+    printf("last_overrun_ms        %u\n", record.lastOverrunMs);
+    if (sim.halted())
+    {
+        printf("restart_cause          %s\n", Supervisor::causeName(record.cause));
+        printf("restart_task           %s\n", taskName(record.task));
+        printf("restart_overrun_ms     %u\n", record.overrunMs);
+        printf("restart_uptime_ms      %lu\n", static_cast<unsigned long>(record.uptimeMs));
+        printf("restart_heater_on      %d\n", heaterOnAtRestart ? 1 : 0);
+        printf("watchdog_interrupts    %u\n", stats.watchdogInterrupts);
+        printf("watchdog_reset_ms      %.3f\n", sim.resetMicros() / 1e3);
+        if (options.stallS >= 0)
+        {
+            printf("stall_to_reset_ms      %.3f\n", (sim.resetMicros() - sim.i2cStallMicros()) / 1e3);
+        }
+    }
+    printf("parameters_loaded      %d\n", parameterStore.isLoaded() ? 1 : 0);
+    printf("eeprom_writes          %u\n", stats.eepromWrites);
+    printf("eeprom_max_cell_writes %u\n", stats.eepromMaxCellWrites);
+    printf("eeprom_blocked_us      %llu\n", static_cast<unsigned long long>(stats.eepromBlockedUs));
+    if (options.recordPath != nullptr)
+    {
+        printf("replay_rows            %lu\n", static_cast<unsigned long>(recorder.rows()));
+    }
+    printf("lcd_bytes              %u\n", stats.lcdBytes);
+    printf("lcd_clears             %u\n", stats.lcdClears);
+    printf("i2c_bytes              %llu\n", static_cast<unsigned long long>(stats.i2cBytes));
+    printf("lcd                    [%s] [%s]\n", sim.lcdLine(0), sim.lcdLine(1));
+    fflush(stdout);
+    sim.setSerialOutput(stdout); // The diagnostic dumps go to the console
+#ifdef BIOLOGIC_PROFILING
+    LoopProfiler::dump(Hal::serial());
+#endif
+#ifdef BIOLOGIC_LATENCY_PROBE
+    LatencyProbe::dump(Hal::serial());
+#endif
+    return 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Adds one byte to a CRC-8, polynomial 0x07 (as in SMBus). Start from 0.
+ * @details Shared by the EEPROM records (`RunLog` blocks, the `ParameterStore` block).
+ */
+inline uint8_t crc8(uint8_t crc, uint8_t value)
+{
+    crc ^= value;
+    for (uint8_t bit = 0; bit < 8; bit++)
+    {
+        crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+    }
+    return crc;
+}
@@ -0,0 +1,399 @@
+#include "ParameterStore.h"
+#include "Crc8.h"
+#include "RunLog.h"
+#include "../core/HeaterControl.h"
+#include "../core/StateType.h"
+#include "../controllers/HeaterDriver.h"
+#include "../diagnostics/Telemetry.h"
+#include "../sensors/SensorManager.h"
+
+#include <string.h>
+
+// === TABLE ===
+namespace
+{
+    // Header layout
+    constexpr uint8_t HEADER_MAGIC = 0;
+    constexpr uint8_t HEADER_VERSION = 1;
+    constexpr uint8_t HEADER_COUNT = 2;
+
+    // The most values a block may hold and still end below the run log
+    constexpr uint8_t MAX_STORED_COUNT = (RUN_LOG_START - PARAMETER_BLOCK_START - PARAMETER_HEADER_SIZE - 1) / 2;
+
+    static_assert(PARAMETER_BLOCK_START + PARAMETER_BLOCK_SIZE <= RUN_LOG_START,
+                  "The parameter block must fit in the settings area");
+    static_assert(static_cast<uint8_t>(ParameterId::HEATER_CONTROL_MODE) + 1 == PARAMETER_COUNT,
+                  "PARAMETER_COUNT must match ParameterId");
+
+    struct ParameterInfo
+    {
+        char name[PARAMETER_NAME_CAPACITY];
+        uint16_t defaultValue;
+        uint16_t min;
+        uint16_t max;
+    };
+
+    // In ParameterId order.
+    const ParameterInfo PARAMETER_TABLE[PARAMETER_COUNT] PROGMEM = {
+        {"gas_low", LOW_EMERGENCY_GAS_THRESHOLD, 1, 1023}, // The alarm clears below it: 0 never would
+        {"gas_high", HIGH_EMERGENCY_GAS_THRESHOLD, 0, 1023},
+        {"gas_hold_ms", GAS_TRIP_HOLD_MS, 0, 10000},
+        {"hyst_c10", TemperatureMath::toTenths(States::TEMPERATURE_HYSTERESIS), 1, 50},
+        {"kp", HEATER_PROPORTIONAL_GAIN, 0, HEATER_MAX_PROPORTIONAL_GAIN},
+        {"kd", HEATER_DERIVATIVE_GAIN, 0, HEATER_MAX_DERIVATIVE_GAIN},
+        {"ki", HEATER_INTEGRAL_GAIN, 0, HEATER_MAX_INTEGRAL_GAIN},
+        {"ilook_s", HEATER_INTEGRAL_LOOKAHEAD_S, 0, HEATER_MAX_INTEGRAL_LOOKAHEAD_S},
+        {"window_ms", HEATER_DEFAULT_WINDOW_MS, HEATER_MIN_WINDOW_MS, HEATER_MAX_WINDOW_MS},
+        {"log_s", RUN_LOG_DEFAULT_INTERVAL_S, RUN_LOG_MIN_INTERVAL_S, UINT16_MAX},
+        {"telem_ms", TELEMETRY_DEFAULT_PERIOD_MS, TELEMETRY_MIN_PERIOD_MS, 60000},
+        {"ctl_mode", static_cast<uint8_t>(HEATER_DEFAULT_CONTROL_MODE), 0, static_cast<uint8_t>(HeaterControlMode::PREDICTIVE)},
+    };
+
+    uint16_t defaultValue(uint8_t index)
+    {
+        return pgm_read_word(&PARAMETER_TABLE[index].defaultValue);
+    }
+
+    bool inRange(uint8_t index, uint16_t value)
+    {
+        return value >= pgm_read_word(&PARAMETER_TABLE[index].min) && value <= pgm_read_word(&PARAMETER_TABLE[index].max);
+    }
+
+    // The rules between parameters: the gas alarm clears below where it starts.
+    bool consistent(const uint16_t *values)
+    {
+        return values[static_cast<uint8_t>(ParameterId::GAS_LOW)] < values[static_cast<uint8_t>(ParameterId::GAS_HIGH)];
+    }
+
+    // Decimal, 0..65535, nothing else.
+    bool parseValue(const char *text, uint16_t &value)
+    {
+        if (*text == '\0')
+        {
+            return false;
+        }
+        uint32_t parsed = 0;
+        for (; *text != '\0'; text++)
+        {
+            if (*text < '0' || *text > '9')
+            {
+                return false;
+            }
+            parsed = parsed * 10 + (*text - '0');
+            if (parsed > UINT16_MAX)
+            {
+                return false;
+            }
+        }
+        value = static_cast<uint16_t>(parsed);
+        return true;
+    }
+}
+
+Parameters parameters = {
+    LOW_EMERGENCY_GAS_THRESHOLD,
+    HIGH_EMERGENCY_GAS_THRESHOLD,
+    GAS_TRIP_HOLD_MS,
+    States::TEMPERATURE_HYSTERESIS,
+    HEATER_PROPORTIONAL_GAIN,
+    HEATER_DERIVATIVE_GAIN,
+    HEATER_INTEGRAL_GAIN,
+    HEATER_INTEGRAL_LOOKAHEAD_S,
+    HEATER_DEFAULT_WINDOW_MS,
+    RUN_LOG_DEFAULT_INTERVAL_S,
+    TELEMETRY_DEFAULT_PERIOD_MS,
+    HEATER_DEFAULT_CONTROL_MODE,
+};
+
+// === CONSTRUCTOR ===
+ParameterStore::ParameterStore()
+    : _values{},
+      _onChange(nullptr),
+      _loaded(false),
+      _image{},
+      _saveIndex(PARAMETER_BLOCK_SIZE),
+      _line{},
+      _lineLength(0),
+      _commandOpen(false),
+      _listIndex(0),
+      _listEnd(0),
+      _reply(nullptr)
+{
+}
+
+// === BEGIN ===
+void ParameterStore::begin(ChangeHandler onChange)
+{
+    _onChange = onChange;
+    for (uint8_t i = 0; i < PARAMETER_COUNT; i++)
+    {
+        _values[i] = defaultValue(i);
+    }
+    _loaded = load();
+    apply();
+}
+
+void ParameterStore::registerTasks(Scheduler &scheduler)
+{
+    scheduler.add<ParameterStore, &ParameterStore::service>(
+        "params", *this, PARAMETER_TASK_PERIOD_MS, PARAMETER_TASK_PHASE_MS, PARAMETER_TASK_DEADLINE_MS);
+}
+
+bool ParameterStore::load()
+{
+    uint8_t header[PARAMETER_HEADER_SIZE];
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < PARAMETER_HEADER_SIZE; i++)
+    {
+        header[i] = Hal::eepromRead(PARAMETER_BLOCK_START + i);
+        crc = crc8(crc, header[i]);
+    }
+    uint8_t count = header[HEADER_COUNT];
+    if (header[HEADER_MAGIC] != PARAMETER_MAGIC || header[HEADER_VERSION] != PARAMETER_VERSION ||
+        count == 0 || count > MAX_STORED_COUNT)
+    {
+        return false;
+    }
+
+    // Checked in full before anything is taken; values past ours (a newer firmware's) are skipped.
+    uint16_t stored[PARAMETER_COUNT];
+    uint16_t address = PARAMETER_BLOCK_START + PARAMETER_HEADER_SIZE;
+    for (uint8_t i = 0; i < count; i++, address += 2)
+    {
+        uint8_t low = Hal::eepromRead(address);
+        uint8_t high = Hal::eepromRead(address + 1);
+        crc = crc8(crc8(crc, low), high);
+        if (i < PARAMETER_COUNT)
+        {
+            stored[i] = low | (static_cast<uint16_t>(high) << 8);
+        }
+    }
+    if (crc != Hal::eepromRead(address))
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < count && i < PARAMETER_COUNT; i++)
+    {
+        if (inRange(i, stored[i]))
+        {
+            _values[i] = stored[i];
+        }
+    }
+    if (!consistent(_values))
+    {
+        _values[static_cast<uint8_t>(ParameterId::GAS_LOW)] = defaultValue(static_cast<uint8_t>(ParameterId::GAS_LOW));
+        _values[static_cast<uint8_t>(ParameterId::GAS_HIGH)] = defaultValue(static_cast<uint8_t>(ParameterId::GAS_HIGH));
+    }
+    return true;
+}
+
+void ParameterStore::apply()
+{
+    auto value = [this](ParameterId id) { return _values[static_cast<uint8_t>(id)]; };
+    parameters.gasLowThreshold = value(ParameterId::GAS_LOW);
+    parameters.gasHighThreshold = value(ParameterId::GAS_HIGH);
+    parameters.gasTripHoldMs = value(ParameterId::GAS_HOLD_MS);
+    parameters.temperatureHysteresis = TemperatureMath::fromTenths(value(ParameterId::HYSTERESIS));
+    parameters.heaterProportionalGain = value(ParameterId::PROPORTIONAL_GAIN);
+    parameters.heaterDerivativeGain = value(ParameterId::DERIVATIVE_GAIN);
+    parameters.heaterIntegralGain = value(ParameterId::INTEGRAL_GAIN);
+    parameters.heaterIntegralLookaheadS = value(ParameterId::INTEGRAL_LOOKAHEAD);
+    parameters.heaterWindowMs = value(ParameterId::HEATER_WINDOW_MS);
+    parameters.logIntervalS = value(ParameterId::LOG_INTERVAL_S);
+    parameters.telemetryPeriodMs = value(ParameterId::TELEMETRY_PERIOD_MS);
+    parameters.heaterControlMode = static_cast<HeaterControlMode>(value(ParameterId::HEATER_CONTROL_MODE));
+    if (_onChange != nullptr)
+    {
+        _onChange();
+    }
+}
+
+// === VALUES ===
+int8_t ParameterStore::find(const char *name)
+{
+    for (uint8_t i = 0; i < PARAMETER_COUNT; i++)
+    {
+        const char *entry = PARAMETER_TABLE[i].name;
+        uint8_t c = 0;
+        while (c < PARAMETER_NAME_CAPACITY && name[c] == static_cast<char>(pgm_read_byte(&entry[c])) && name[c] != '\0')
+        {
+            c++;
+        }
+        if (c < PARAMETER_NAME_CAPACITY && name[c] == '\0' && pgm_read_byte(&entry[c]) == '\0')
+        {
+            return static_cast<int8_t>(i);
+        }
+    }
+    return -1;
+}
+
+bool ParameterStore::set(const char *name, uint16_t value)
+{
+    int8_t index = find(name);
+    return index >= 0 && set(static_cast<ParameterId>(index), value);
+}
+
+bool ParameterStore::set(ParameterId id, uint16_t value)
+{
+    uint8_t index = static_cast<uint8_t>(id);
+    if (!inRange(index, value))
+    {
+        return false;
+    }
+    uint16_t previous = _values[index];
+    _values[index] = value;
+    if (!consistent(_values))
+    {
+        _values[index] = previous;
+        return false;
+    }
+    apply();
+    return true;
+}
+
+void ParameterStore::restoreDefaults()
+{
+    for (uint8_t i = 0; i < PARAMETER_COUNT; i++)
+    {
+        _values[i] = defaultValue(i);
+    }
+    apply();
+}
+
+// === SAVE ===
+void ParameterStore::save()
+{
+    _image[HEADER_MAGIC] = PARAMETER_MAGIC;
+    _image[HEADER_VERSION] = PARAMETER_VERSION;
+    _image[HEADER_COUNT] = PARAMETER_COUNT;
+    for (uint8_t i = 0; i < PARAMETER_COUNT; i++)
+    {
+        _image[PARAMETER_HEADER_SIZE + 2 * i] = static_cast<uint8_t>(_values[i]);
+        _image[PARAMETER_HEADER_SIZE + 2 * i + 1] = static_cast<uint8_t>(_values[i] >> 8);
+    }
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < PARAMETER_BLOCK_SIZE - 1; i++)
+    {
+        crc = crc8(crc, _image[i]);
+    }
+    _image[PARAMETER_BLOCK_SIZE - 1] = crc;
+    _saveIndex = 0;
+}
+
+void ParameterStore::service()
+{
+    // The CRC is written last: a save cut short leaves a block that fails it, hence the defaults.
+    while (_saveIndex < PARAMETER_BLOCK_SIZE && Hal::eepromReady())
+    {
+        // A save usually changes one or two values: the bytes already in place are skipped.
+        if (Hal::eepromRead(PARAMETER_BLOCK_START + _saveIndex) != _image[_saveIndex])
+        {
+            Hal::eepromWrite(PARAMETER_BLOCK_START + _saveIndex, _image[_saveIndex]);
+        }
+        _saveIndex++;
+    }
+}
+
+// === CONSOLE ===
+void ParameterStore::openCommand()
+{
+    _commandOpen = true;
+    _lineLength = 0;
+}
+
+bool ParameterStore::serviceCommand(Hal::SerialPort &port)
+{
+    while (_commandOpen && port.available() > 0)
+    {
+        char c = static_cast<char>(port.read());
+        if (c == '\n' || c == '\r')
+        {
+            _commandOpen = false;
+            runCommand();
+        }
+        else if (_lineLength < PARAMETER_LINE_CAPACITY - 1)
+        {
+            _line[_lineLength++] = c;
+        }
+        else
+        {
+            _lineLength = PARAMETER_LINE_CAPACITY;
+        }
+    }
+
+    // The replies are queued by runCommand() and leave one line at a time, each once
+    // the transmit buffer has room for the longest one.
+    if (_reply != nullptr && port.availableForWrite() >= PARAMETER_REPLY_LENGTH)
+    {
+        port.println(_reply);
+        _reply = nullptr;
+    }
+    while (_listIndex < _listEnd && port.availableForWrite() >= PARAMETER_REPLY_LENGTH)
+    {
+        printValue(port, _listIndex++);
+    }
+    return _commandOpen || _reply != nullptr || _listIndex < _listEnd;
+}
+
+void ParameterStore::runCommand()
+{
+    _listIndex = 0;
+    _listEnd = 0;
+    if (_lineLength >= PARAMETER_LINE_CAPACITY)
+    {
+        _reply = "error";
+        return;
+    }
+    _line[_lineLength] = '\0';
+
+    if (_lineLength == 0)
+    {
+        _listEnd = PARAMETER_COUNT;
+        return;
+    }
+    if (strcmp(_line, "save") == 0)
+    {
+        save();
+        _reply = "ok";
+        return;
+    }
+    if (strcmp(_line, "defaults") == 0)
+    {
+        restoreDefaults();
+        _listEnd = PARAMETER_COUNT;
+        return;
+    }
+
+    char *equals = strchr(_line, '=');
+    uint16_t value = 0;
+    if (equals != nullptr)
+    {
+        *equals = '\0';
+        if (!parseValue(equals + 1, value) || !set(_line, value))
+        {
+            _reply = "error";
+            return;
+        }
+    }
+    int8_t index = find(_line);
+    if (index < 0)
+    {
+        _reply = "error";
+        return;
+    }
+    _listIndex = index;
+    _listEnd = index + 1;
+}
+
+void ParameterStore::printValue(Hal::SerialPort &port, uint8_t index) const
+{
+    char name[PARAMETER_NAME_CAPACITY];
+    for (uint8_t i = 0; i < PARAMETER_NAME_CAPACITY; i++)
+    {
+        name[i] = static_cast<char>(pgm_read_byte(&PARAMETER_TABLE[index].name[i]));
+    }
+    port.print(name);
+    port.print("=");
+    port.println(static_cast<unsigned int>(_values[index]));
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "../hal/Hal.h"
+#include "../core/Scheduler.h"
+#include "../core/Temperature.h"
+#include "../core/HeaterControl.h"
+
+// --- EEPROM layout ---
+constexpr uint16_t PARAMETER_BLOCK_START = 0; // In the settings area, below RUN_LOG_START
+constexpr uint8_t PARAMETER_MAGIC = 0xB1;
+constexpr uint8_t PARAMETER_VERSION = 2;      // Bumped when a parameter changes meaning
+constexpr uint8_t PARAMETER_HEADER_SIZE = 3;  // Magic, version, count; a CRC-8 follows the values
+
+// --- Console ---
+constexpr uint8_t PARAMETER_NAME_CAPACITY = 12;  // Longest name plus its terminator
+constexpr uint8_t PARAMETER_LINE_CAPACITY = 24;  // Longest command line
+constexpr uint8_t PARAMETER_REPLY_LENGTH = 20;   // Longest reply line, `name=value` and CR LF
+
+// --- Task (period, phase, deadline in ms) ---
+constexpr uint16_t PARAMETER_TASK_PERIOD_MS = 10; // At most one EEPROM write is started per run
+constexpr uint16_t PARAMETER_TASK_PHASE_MS = 6;
+constexpr uint16_t PARAMETER_TASK_DEADLINE_MS = 5;
+
+/**
+ * @brief The tunable parameters, in the order of the table and of the EEPROM block.
+ *        New parameters are only ever appended.
+ */
+enum class ParameterId : uint8_t
+{
+    GAS_LOW,             // gas_low: the gas alarm clears below (0-1023)
+    GAS_HIGH,            // gas_high: the gas alarm and trip level (0-1023)
+    GAS_HOLD_MS,         // gas_hold_ms: least time a trip holds the alarm
+    HYSTERESIS,          // hyst_c10: maintaining falls back to preheating this far below the setpoint, in 0.1 °C
+    PROPORTIONAL_GAIN,   // kp: percent per °C
+    DERIVATIVE_GAIN,     // kd: percent per °C/s
+    INTEGRAL_GAIN,       // ki: 1/256 percent per °C, every control period
+    INTEGRAL_LOOKAHEAD,  // ilook_s: the integral pauses while the rate would reach the setpoint within this time
+    HEATER_WINDOW_MS,    // window_ms: heater PWM window
+    LOG_INTERVAL_S,      // log_s: run log sample interval
+    TELEMETRY_PERIOD_MS, // telem_ms: telemetry record period
+    HEATER_CONTROL_MODE, // ctl_mode: heater control law, 0 PID, 1 predictive (see HeaterControlMode)
+};
+
+constexpr uint8_t PARAMETER_COUNT = 12;
+constexpr uint8_t PARAMETER_BLOCK_SIZE = PARAMETER_HEADER_SIZE + 2 * PARAMETER_COUNT + 1;
+
+/**
+ * @brief The parameter values in use, in the types the code works with.
+ * @details The hot paths read the fields of the `parameters` global directly: a load
+ *          from RAM, as for any global. They only change between two tasks, from the
+ *          parameter console.
+ */
+struct Parameters
+{
+    int gasLowThreshold;
+    int gasHighThreshold;
+    uint16_t gasTripHoldMs;
+    Temperature temperatureHysteresis;
+    int16_t heaterProportionalGain;
+    int16_t heaterDerivativeGain;
+    int16_t heaterIntegralGain;
+    uint16_t heaterIntegralLookaheadS;
+    uint16_t heaterWindowMs;
+    uint16_t logIntervalS;
+    uint16_t telemetryPeriodMs;
+    HeaterControlMode heaterControlMode;
+};
+
+/**
+ * @brief The values in use. Holds the defaults until `ParameterStore::begin()`.
+ */
+extern Parameters parameters;
+
+/**
+ * @class ParameterStore
+ * @brief Loads the tunable parameters from EEPROM at boot, and reads and writes them
+ *        over Serial.
+ *
+ * @details Every parameter is a 16-bit unsigned value with a name, a default and a
+ *          range, in a PROGMEM table. The EEPROM block holds a magic byte, the version,
+ *          the number of values, the values (little endian) and a CRC-8 of all of it.
+ *
+ *          At boot a block with the right magic, version and CRC is loaded. A block with
+ *          fewer values, written by an older firmware, loads too: the new parameters keep
+ *          their defaults. Anything else, and any value out of its range, falls back to
+ *          the defaults, as do both gas levels if gas_low is not below gas_high. The
+ *          values are then converted once into `parameters`.
+ *
+ *          Parameter commands are text lines after a `:` received on Serial:
+ *
+ *          - `:` lists every parameter as `name=value`;
+ *          - `:name` prints one;
+ *          - `:name=value` sets one, from now on, and prints it back; gas_low must stay
+ *            below gas_high;
+ *          - `:save` writes the values to EEPROM;
+ *          - `:defaults` goes back to the defaults (`:save` makes it stick).
+ *
+ *          Errors print `error`. The line is consumed as its bytes arrive and every reply,
+ *          the list included, is printed as the transmit buffer frees up, so no command
+ *          ever waits. The EEPROM writes are started from the task, one at a time and
+ *          only when the EEPROM is ready, and only for the bytes that changed.
+ */
+class ParameterStore
+{
+public:
+    /**
+     * @brief Called after the values in `parameters` change, to refresh the copies
+     *        other objects keep (e.g. the heater window).
+     */
+    using ChangeHandler = void (*)();
+
+    ParameterStore();
+
+    /**
+     * @brief Loads the EEPROM block, then calls `onChange`.
+     */
+    void begin(ChangeHandler onChange);
+
+    /**
+     * @brief Adds the EEPROM writing task to the scheduler.
+     */
+    void registerTasks(Scheduler &scheduler);
+
+    /**
+     * @brief Returns true if the values came from EEPROM rather than the defaults.
+     */
+    bool isLoaded() const { return _loaded; }
+
+    /**
+     * @brief Sets a parameter by name.
+     * @return False if the name is unknown, the value out of range, or the values would
+     *         break gas_low < gas_high. Nothing changes then.
+     */
+    bool set(const char *name, uint16_t value);
+    bool set(ParameterId id, uint16_t value);
+
+    /**
+     * @brief Returns the value of a parameter, as stored.
+     */
+    uint16_t get(ParameterId id) const { return _values[static_cast<uint8_t>(id)]; }
+
+    /**
+     * @brief Goes back to the default values. Does not touch the EEPROM.
+     */
+    void restoreDefaults();
+
+    /**
+     * @brief Starts writing the values to EEPROM, in the background.
+     */
+    void save();
+
+    bool isSaving() const { return _saveIndex < PARAMETER_BLOCK_SIZE; }
+
+    /**
+     * @brief Starts receiving a command line, once its `:` has been read.
+     */
+    void openCommand();
+
+    /**
+     * @brief Consumes the bytes received for an open command line and runs it at the end
+     *        of the line, then continues a list in progress. Never waits.
+     * @return True while the console holds the port: the caller must not read it.
+     */
+    bool serviceCommand(Hal::SerialPort &port);
+
+    /**
+     * @brief The EEPROM task: starts the next write of a save in progress.
+     */
+    void service();
+
+private:
+    uint16_t _values[PARAMETER_COUNT];
+    ChangeHandler _onChange;
+    bool _loaded;
+
+    // --- Save state machine ---
+    uint8_t _image[PARAMETER_BLOCK_SIZE]; // The block being written
+    uint8_t _saveIndex;                   // Next byte to compare and write, in order: the CRC goes last
+
+    // --- Console ---
+    char _line[PARAMETER_LINE_CAPACITY];
+    uint8_t _lineLength; // PARAMETER_LINE_CAPACITY once it overflowed
+    bool _commandOpen;
+    uint8_t _listIndex;  // Next parameter to print
+    uint8_t _listEnd;    // One past the last parameter to print, _listIndex when done
+    const char *_reply;  // "ok" or "error" still to print, or null
+
+    bool load();
+    void apply();
+    void runCommand();
+    void printValue(Hal::SerialPort &port, uint8_t index) const;
+    static int8_t find(const char *name);
+};
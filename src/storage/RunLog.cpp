@@ -0,0 +1,384 @@
+#include "RunLog.h"
+#include "Crc8.h"
+#include "../core/SystemState.h"
+
+#include <string.h>
+
+// === ENCODING ===
+namespace
+{
+    // Header layout
+    constexpr uint8_t HEADER_SEQUENCE = 0; // Two bytes, little endian
+    constexpr uint8_t HEADER_SESSION = 2;
+    constexpr uint8_t HEADER_LENGTH = 3;
+    constexpr uint8_t HEADER_CRC = 4;
+    constexpr uint16_t ERASED_SEQUENCE = 0xFFFF; // Never used, so an erased block is never valid
+
+    // Flag byte of a delta sample
+    constexpr uint8_t TEMPERATURE_NIBBLE_MASK = 0x0F;
+    constexpr uint8_t TEMPERATURE_ESCAPE = 0x08; // -8: a zigzag varint delta follows
+    constexpr int8_t TEMPERATURE_NIBBLE_MAX = 7;
+    constexpr uint8_t SETPOINT_CHANGED = 0x10;
+    constexpr uint8_t GAS_CHANGED = 0x20;
+    constexpr uint8_t DUTY_CHANGED = 0x40;
+    constexpr uint8_t STATE_CHANGED = 0x80;
+
+    constexpr uint8_t MAX_ENCODED_SAMPLE = 20; // Keyframe: 5 + 3 + 3 + 3 + 3 + 1 + 1 bytes
+    constexpr uint8_t DUMP_BYTES_PER_LINE = 16;
+    constexpr uint8_t DUMP_LINE_LENGTH = 2 * DUMP_BYTES_PER_LINE + 2; // Hex digits and CR LF
+
+    static_assert(RUN_LOG_BLOCK_COUNT >= 2, "The log region needs at least two blocks");
+    static_assert(RUN_LOG_PAYLOAD_SIZE >= MAX_ENCODED_SAMPLE, "A block must hold at least a keyframe");
+
+    // Maps small signed values to small unsigned ones: 0, -1, 1, -2... -> 0, 1, 2, 3...
+    uint16_t zigzag(int16_t value)
+    {
+        return static_cast<uint16_t>((static_cast<uint16_t>(value) << 1) ^ static_cast<uint16_t>(value >> 15));
+    }
+
+    // LEB128: 7 bits per byte, least significant first, high bit set on all but the last.
+    uint8_t putVarint(uint8_t *out, uint32_t value)
+    {
+        uint8_t count = 0;
+        while (value >= 0x80)
+        {
+            out[count++] = static_cast<uint8_t>(value) | 0x80;
+            value >>= 7;
+        }
+        out[count++] = static_cast<uint8_t>(value);
+        return count;
+    }
+
+    uint16_t blockAddress(uint8_t slot)
+    {
+        return RUN_LOG_START + static_cast<uint16_t>(slot) * RUN_LOG_BLOCK_SIZE;
+    }
+
+    char hexDigit(uint8_t value)
+    {
+        return static_cast<char>(value < 10 ? '0' + value : 'A' + value - 10);
+    }
+}
+
+// === CONSTRUCTOR ===
+RunLog::RunLog(SystemState &ss, SensorManager &sm, ActuatorController &ac)
+    : systemState(ss),
+      sensorManager(sm),
+      actuatorController(ac),
+      _intervalS(RUN_LOG_DEFAULT_INTERVAL_S),
+      _requestedIntervalS(RUN_LOG_DEFAULT_INTERVAL_S),
+      _nextSampleMs(0),
+      _nextSampleS(0),
+      _sampleCount(0),
+      _block{},
+      _slot(0),
+      _sequence(0),
+      _session(0),
+      _length(0),
+      _unflushedSamples(0),
+      _previous{},
+      _pending{},
+      _pendingTimeS(0),
+      _hasPending(false),
+      _flushing(false),
+      _flushIndex(0),
+      _dumpPort(nullptr),
+      _dumpOffset(0)
+{
+}
+
+// === BEGIN ===
+void RunLog::begin()
+{
+    // The newest valid block is where the previous session stopped.
+    bool found = false;
+    uint8_t newestSlot = RUN_LOG_BLOCK_COUNT - 1;
+    uint16_t newestSequence = ERASED_SEQUENCE;
+    uint8_t newestSession = 0;
+    for (uint8_t slot = 0; slot < RUN_LOG_BLOCK_COUNT; slot++)
+    {
+        uint16_t sequence;
+        uint8_t session;
+        if (readHeader(slot, sequence, session) &&
+            (!found || static_cast<int16_t>(sequence - newestSequence) > 0))
+        {
+            found = true;
+            newestSlot = slot;
+            newestSequence = sequence;
+            newestSession = session;
+        }
+    }
+
+    _slot = newestSlot;
+    _sequence = newestSequence;
+    _session = found ? newestSession + 1 : 0;
+    _nextSampleMs = Hal::millis();
+    _nextSampleS = _nextSampleMs / 1000;
+    openBlock();
+}
+
+void RunLog::registerTasks(Scheduler &scheduler)
+{
+    scheduler.add<RunLog, &RunLog::service>(
+        "runlog", *this, RUN_LOG_TASK_PERIOD_MS, RUN_LOG_TASK_PHASE_MS, RUN_LOG_TASK_DEADLINE_MS);
+}
+
+void RunLog::setInterval(uint16_t seconds)
+{
+    _requestedIntervalS = seconds < RUN_LOG_MIN_INTERVAL_S ? RUN_LOG_MIN_INTERVAL_S : seconds;
+}
+
+bool RunLog::readHeader(uint8_t slot, uint16_t &sequence, uint8_t &session)
+{
+    uint16_t address = blockAddress(slot);
+    uint8_t header[RUN_LOG_HEADER_SIZE];
+    for (uint8_t i = 0; i < RUN_LOG_HEADER_SIZE; i++)
+    {
+        header[i] = Hal::eepromRead(address + i);
+    }
+    sequence = header[HEADER_SEQUENCE] | (static_cast<uint16_t>(header[HEADER_SEQUENCE + 1]) << 8);
+    session = header[HEADER_SESSION];
+    uint8_t length = header[HEADER_LENGTH];
+    if (sequence == ERASED_SEQUENCE || length == 0 || length > RUN_LOG_PAYLOAD_SIZE)
+    {
+        return false;
+    }
+
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < HEADER_CRC; i++)
+    {
+        crc = crc8(crc, header[i]);
+    }
+    for (uint8_t i = 0; i < length; i++)
+    {
+        crc = crc8(crc, Hal::eepromRead(address + RUN_LOG_HEADER_SIZE + i));
+    }
+    return crc == header[HEADER_CRC];
+}
+
+// === SAMPLING ===
+void RunLog::service()
+{
+    if (_dumpPort != nullptr)
+    {
+        dumpStep();
+    }
+    if (_flushing)
+    {
+        flushStep();
+        return;
+    }
+
+    // A sample that did not fit waited for its predecessor block to reach the EEPROM.
+    if (_hasPending)
+    {
+        _hasPending = false;
+        openBlock();
+        append(_pending, _pendingTimeS);
+        return;
+    }
+
+    if (static_cast<int32_t>(Hal::millis() - _nextSampleMs) < 0)
+    {
+        return;
+    }
+    uint32_t timeS = _nextSampleS;
+    _nextSampleMs += _requestedIntervalS * 1000UL;
+    _nextSampleS += _requestedIntervalS;
+
+    RunLogSample sample = takeSample();
+    if (_length == 0)
+    {
+        _intervalS = _requestedIntervalS; // Nothing logged yet at the old cadence
+    }
+    // A new cadence needs a new keyframe, hence a new block.
+    if (_requestedIntervalS == _intervalS && append(sample, timeS))
+    {
+        if (_unflushedSamples >= RUN_LOG_FLUSH_SAMPLES)
+        {
+            startFlush();
+        }
+        return;
+    }
+    _pending = sample;
+    _pendingTimeS = timeS;
+    _hasPending = true;
+    startFlush();
+}
+
+RunLogSample RunLog::takeSample()
+{
+    RunLogSample sample;
+    sample.temperatureTenths = TemperatureMath::toTenths(systemState.getEstimator().temperature());
+    sample.setpointTenths = TemperatureMath::toTenths(sensorManager.getSetpoint());
+    sample.gas = static_cast<uint16_t>(sensorManager.getGasValue());
+    sample.heaterDuty = actuatorController.getHeaterDuty();
+    sample.state = static_cast<uint8_t>(systemState.getState());
+    return sample;
+}
+
+bool RunLog::append(const RunLogSample &sample, uint32_t timeS)
+{
+    uint8_t encoded[MAX_ENCODED_SAMPLE];
+    uint8_t *out = encoded;
+
+    if (_length == 0)
+    {
+        // Keyframe: timing, then every field in full
+        out += putVarint(out, timeS);
+        out += putVarint(out, _intervalS);
+        out += putVarint(out, zigzag(sample.temperatureTenths));
+        out += putVarint(out, zigzag(sample.setpointTenths));
+        out += putVarint(out, sample.gas);
+        *out++ = sample.heaterDuty;
+        *out++ = sample.state;
+    }
+    else
+    {
+        uint8_t *flags = out++;
+        int16_t temperatureDelta = sample.temperatureTenths - _previous.temperatureTenths;
+        if (temperatureDelta >= -TEMPERATURE_NIBBLE_MAX && temperatureDelta <= TEMPERATURE_NIBBLE_MAX)
+        {
+            *flags = static_cast<uint8_t>(temperatureDelta) & TEMPERATURE_NIBBLE_MASK;
+        }
+        else
+        {
+            *flags = TEMPERATURE_ESCAPE;
+            out += putVarint(out, zigzag(temperatureDelta));
+        }
+        if (sample.setpointTenths != _previous.setpointTenths)
+        {
+            *flags |= SETPOINT_CHANGED;
+            out += putVarint(out, zigzag(sample.setpointTenths - _previous.setpointTenths));
+        }
+        if (sample.gas != _previous.gas)
+        {
+            *flags |= GAS_CHANGED;
+            out += putVarint(out, zigzag(static_cast<int16_t>(sample.gas - _previous.gas)));
+        }
+        if (sample.heaterDuty != _previous.heaterDuty)
+        {
+            *flags |= DUTY_CHANGED;
+            *out++ = sample.heaterDuty;
+        }
+        if (sample.state != _previous.state)
+        {
+            *flags |= STATE_CHANGED;
+            *out++ = sample.state;
+        }
+    }
+
+    uint8_t size = static_cast<uint8_t>(out - encoded);
+    if (_length + size > RUN_LOG_PAYLOAD_SIZE)
+    {
+        return false;
+    }
+    memcpy(&_block[RUN_LOG_HEADER_SIZE + _length], encoded, size);
+    _length += size;
+    _previous = sample;
+    _unflushedSamples++;
+    _sampleCount++;
+    return true;
+}
+
+void RunLog::openBlock()
+{
+    _slot = (_slot + 1) % RUN_LOG_BLOCK_COUNT;
+    _sequence = (_sequence + 1 == ERASED_SEQUENCE) ? 0 : _sequence + 1;
+    _intervalS = _requestedIntervalS;
+    _length = 0;
+    _unflushedSamples = 0;
+}
+
+// === FLUSH ===
+void RunLog::sealHeader()
+{
+    _block[HEADER_SEQUENCE] = static_cast<uint8_t>(_sequence);
+    _block[HEADER_SEQUENCE + 1] = static_cast<uint8_t>(_sequence >> 8);
+    _block[HEADER_SESSION] = _session;
+    _block[HEADER_LENGTH] = _length;
+
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < HEADER_CRC; i++)
+    {
+        crc = crc8(crc, _block[i]);
+    }
+    for (uint8_t i = 0; i < _length; i++)
+    {
+        crc = crc8(crc, _block[RUN_LOG_HEADER_SIZE + i]);
+    }
+    _block[HEADER_CRC] = crc;
+}
+
+void RunLog::startFlush()
+{
+    if (_length == 0)
+    {
+        return;
+    }
+    sealHeader();
+    _flushing = true;
+    _flushIndex = 0;
+    _unflushedSamples = 0;
+}
+
+void RunLog::flushStep()
+{
+    // Payload first, header last: the old header stays valid until the new payload is in place.
+    uint8_t total = RUN_LOG_HEADER_SIZE + _length;
+    uint16_t address = blockAddress(_slot);
+    while (_flushIndex < total && Hal::eepromReady())
+    {
+        uint8_t offset = _flushIndex < _length ? RUN_LOG_HEADER_SIZE + _flushIndex : _flushIndex - _length;
+        // Only the bytes that changed are written, which spares the cells and the time.
+        if (Hal::eepromRead(address + offset) != _block[offset])
+        {
+            Hal::eepromWrite(address + offset, _block[offset]);
+        }
+        _flushIndex++;
+    }
+    if (_flushIndex >= total)
+    {
+        _flushing = false;
+    }
+}
+
+// === DUMP ===
+void RunLog::startDump(Hal::SerialPort &port)
+{
+    port.print("runlog,");
+    port.print(static_cast<unsigned int>(RUN_LOG_START));
+    port.print(",");
+    port.print(static_cast<unsigned int>(RUN_LOG_BLOCK_SIZE));
+    port.print(",");
+    port.println(static_cast<unsigned int>(RUN_LOG_BLOCK_COUNT));
+    _dumpPort = &port;
+    _dumpOffset = 0;
+}
+
+void RunLog::dumpStep()
+{
+    // Never wait on the UART: print a line only when it fits in the transmit buffer.
+    if (_dumpPort->availableForWrite() < DUMP_LINE_LENGTH)
+    {
+        return;
+    }
+    const uint16_t size = static_cast<uint16_t>(RUN_LOG_BLOCK_COUNT) * RUN_LOG_BLOCK_SIZE;
+    if (_dumpOffset >= size)
+    {
+        _dumpPort->println("end");
+        _dumpPort = nullptr;
+        return;
+    }
+
+    char line[2 * DUMP_BYTES_PER_LINE + 1];
+    for (uint8_t i = 0; i < DUMP_BYTES_PER_LINE; i++)
+    {
+        uint8_t value = Hal::eepromRead(RUN_LOG_START + _dumpOffset + i);
+        line[2 * i] = hexDigit(value >> 4);
+        line[2 * i + 1] = hexDigit(value & 0x0F);
+    }
+    line[2 * DUMP_BYTES_PER_LINE] = '\0';
+    _dumpPort->println(line);
+    _dumpOffset += DUMP_BYTES_PER_LINE;
+}
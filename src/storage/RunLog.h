@@ -0,0 +1,152 @@
+#pragma once
+
+#include "../hal/Hal.h"
+#include "../core/Scheduler.h"
+
+class SystemState;
+class SensorManager;
+class ActuatorController;
+
+// --- EEPROM layout ---
+constexpr uint16_t RUN_LOG_START = 64;                  // The first bytes are kept for settings
+constexpr uint16_t RUN_LOG_BLOCK_SIZE = 64;             // Header plus encoded samples
+constexpr uint8_t RUN_LOG_HEADER_SIZE = 5;              // Sequence (2), session, length, CRC-8
+constexpr uint8_t RUN_LOG_PAYLOAD_SIZE = RUN_LOG_BLOCK_SIZE - RUN_LOG_HEADER_SIZE;
+constexpr uint8_t RUN_LOG_BLOCK_COUNT = (Hal::EEPROM_SIZE - RUN_LOG_START) / RUN_LOG_BLOCK_SIZE;
+
+// --- Cadence ---
+constexpr uint16_t RUN_LOG_DEFAULT_INTERVAL_S = 600; // About two days of history in 1 KB
+constexpr uint16_t RUN_LOG_MIN_INTERVAL_S = 10;      // Leaves time to flush a block between samples
+constexpr uint8_t RUN_LOG_FLUSH_SAMPLES = 4;         // Samples staged in RAM between two flushes
+
+// --- Task (period, phase, deadline in ms) ---
+constexpr uint16_t RUN_LOG_TASK_PERIOD_MS = 10; // At most one EEPROM write is started per run
+constexpr uint16_t RUN_LOG_TASK_PHASE_MS = 9;
+constexpr uint16_t RUN_LOG_TASK_DEADLINE_MS = 5;
+
+/**
+ * @brief One logged sample, in the units stored in the log.
+ */
+struct RunLogSample
+{
+    int16_t temperatureTenths; // Estimated chamber temperature
+    int16_t setpointTenths;
+    uint16_t gas;              // 0-1023
+    uint8_t heaterDuty;        // Percent
+    uint8_t state;             // States::Type
+};
+
+/**
+ * @class RunLog
+ * @brief Persistent record of a fermentation run in a circular EEPROM region.
+ *
+ * @details The region is split into fixed-size blocks written round-robin, so every
+ *          cell sees the same wear. A block holds:
+ *
+ *          - a header: sequence number (little endian), session (boot counter),
+ *            payload length and a CRC-8 of the rest;
+ *          - a keyframe: varints of the start time (seconds since boot), the interval
+ *            and the absolute values of the first sample;
+ *          - delta samples: one flag byte each, holding the temperature change in
+ *            tenths as a signed nibble (-8 escapes to a zigzag varint) and one bit per
+ *            other field that changed, followed by the changed values (zigzag varint
+ *            deltas for setpoint and gas, plain bytes for duty and state).
+ *
+ *          A steady sample takes one to three bytes instead of eight. Samples are staged
+ *          in a RAM image of the current block and flushed every RUN_LOG_FLUSH_SAMPLES
+ *          samples or when the block is full: payload bytes first, header last, and only
+ *          the bytes that differ from the EEPROM. Since blocks are append-only, a power
+ *          cut mid-flush leaves the previous header valid for the previous samples.
+ *
+ *          All EEPROM writes are started from the scheduler task, one at a time and only
+ *          when the EEPROM is ready, so logging never blocks the control loop. At boot
+ *          the newest valid block is found by sequence number and the new session starts
+ *          in the next block. `tools/runlog_decode.py` turns a dump into CSV.
+ */
+class RunLog
+{
+public:
+    /**
+     * @brief Constructs the log.
+     * @param ss The FSM, for the state and the estimated temperature.
+     * @param sm The sensors, for the setpoint and the gas reading.
+     * @param ac The actuators, for the heater duty.
+     */
+    RunLog(SystemState &ss, SensorManager &sm, ActuatorController &ac);
+
+    /**
+     * @brief Finds the end of the existing log and opens a new session.
+     */
+    void begin();
+
+    /**
+     * @brief Adds the logging task to the scheduler.
+     */
+    void registerTasks(Scheduler &scheduler);
+
+    /**
+     * @brief Sets the time between two samples. The next sample opens a block with the
+     *        new cadence.
+     * @param seconds At least RUN_LOG_MIN_INTERVAL_S.
+     */
+    void setInterval(uint16_t seconds);
+    uint16_t getInterval() const { return _intervalS; }
+
+    /**
+     * @brief Starts dumping the log region as hex over the given port, one line per task
+     *        run whenever the transmit buffer has room.
+     * @details Format: a `runlog,<start>,<block_size>,<block_count>` line, one line of 32
+     *          hex digits per 16 bytes, then `end`.
+     */
+    void startDump(Hal::SerialPort &port);
+
+    uint8_t getSession() const { return _session; }
+    uint32_t getSampleCount() const { return _sampleCount; }
+
+    /**
+     * @brief The logging task: takes due samples, advances the flush and the dump.
+     */
+    void service();
+
+private:
+    // --- Component References ---
+    SystemState &systemState;
+    SensorManager &sensorManager;
+    ActuatorController &actuatorController;
+
+    // --- Cadence ---
+    uint16_t _intervalS;          // Of the current block
+    uint16_t _requestedIntervalS; // Applied from the next block
+    uint32_t _nextSampleMs;
+    uint32_t _nextSampleS; // Nominal time of the next sample, since boot
+    uint32_t _sampleCount;
+
+    // --- Staging block ---
+    uint8_t _block[RUN_LOG_BLOCK_SIZE]; // RAM image of the block being filled
+    uint8_t _slot;                      // Its index in the region
+    uint16_t _sequence;
+    uint8_t _session;
+    uint8_t _length;                    // Payload bytes used
+    uint8_t _unflushedSamples;
+    RunLogSample _previous;             // Last sample, the base of the next delta
+    RunLogSample _pending;              // Sample opening the next block, once this one is flushed
+    uint32_t _pendingTimeS;
+    bool _hasPending;
+
+    // --- Flush state machine ---
+    bool _flushing;
+    uint8_t _flushIndex; // Payload bytes first, then the header
+
+    // --- Dump state machine ---
+    Hal::SerialPort *_dumpPort; // Null when no dump is running
+    uint16_t _dumpOffset;
+
+    RunLogSample takeSample();
+    bool append(const RunLogSample &sample, uint32_t timeS);
+    void openBlock();
+    void sealHeader();
+    void startFlush();
+    void flushStep();
+    void dumpStep();
+    bool readHeader(uint8_t slot, uint16_t &sequence, uint8_t &session);
+};
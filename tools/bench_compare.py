@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""Compare two Bio-Logic benchmark reports.
+
+Input is the CSV printed by the benchmark builds (env:native_bench on stdout,
+env:uno_bench over Serial); comment lines and anything that is not a report row,
+such as boot noise in a serial capture, are ignored:
+
+    # Bio-Logic Controller benchmarks
+    name,unit,iterations,min,mean,max
+    sensor_temperature,cycles,256,412,415,431
+    ...
+
+Usage: bench_compare.py <before.csv> <after.csv> [max_regression_pct]
+
+Prints one CSV row per case with the change of the min and of the mean. With a
+threshold, the exit status is 1 when any mean grew by more than that many percent.
+"""
+
+import sys
+
+HEADER = "name,unit,before_min,after_min,min_change_pct,before_mean,after_mean,mean_change_pct"
+
+
+def load(path):
+    results = {}
+    with open(path, errors="replace") as report:
+        for line in report:
+            fields = line.strip().split(",")
+            if len(fields) != 6 or line.startswith("#"):
+                continue
+            name, unit, _, low, mean, _ = fields
+            try:
+                results[name] = (unit, float(low), float(mean))
+            except ValueError:
+                continue  # The column header
+    return results
+
+
+def change(before, after):
+    return (after - before) / before * 100 if before else 0.0
+
+
+def main():
+    if len(sys.argv) not in (3, 4):
+        sys.exit(__doc__)
+    before = load(sys.argv[1])
+    after = load(sys.argv[2])
+    threshold = float(sys.argv[3]) if len(sys.argv) == 4 else None
+
+    print(HEADER)
+    regressions = 0
+    for name, (unit, after_min, after_mean) in after.items():
+        if name not in before:
+            print(f"{name},{unit},,{after_min:g},,,{after_mean:g},")
+            continue
+        before_unit, before_min, before_mean = before[name]
+        if before_unit != unit:
+            print(f"{name}: {before_unit} before, {unit} after; not comparable", file=sys.stderr)
+            continue
+        mean_change = change(before_mean, after_mean)
+        print(f"{name},{unit},{before_min:g},{after_min:g},{change(before_min, after_min):+.1f},"
+              f"{before_mean:g},{after_mean:g},{mean_change:+.1f}")
+        if threshold is not None and mean_change > threshold:
+            regressions += 1
+    for name in before.keys() - after.keys():
+        print(f"{name}: missing from {sys.argv[2]}", file=sys.stderr)
+
+    if regressions:
+        print(f"{regressions} case(s) regressed by more than {threshold:g} %", file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+"""Decode the Bio-Logic EEPROM run log into CSV.
+
+Input is either the raw 1 KB EEPROM image (the simulator's eeprom=<file>) or the
+text dump printed by the firmware after the `d` serial command:
+
+    runlog,<start>,<block_size>,<block_count>
+    <32 hex digits>
+    ...
+    end
+
+Usage: runlog_decode.py <image.bin | dump.txt> > run.csv
+
+The block format is documented in src/storage/RunLog.h.
+"""
+
+import sys
+
+# Mirrors src/storage/RunLog.h
+RUN_LOG_START = 64
+RUN_LOG_BLOCK_SIZE = 64
+RUN_LOG_HEADER_SIZE = 5
+ERASED_SEQUENCE = 0xFFFF
+
+TEMPERATURE_NIBBLE_MASK = 0x0F
+TEMPERATURE_ESCAPE = 0x08
+SETPOINT_CHANGED = 0x10
+GAS_CHANGED = 0x20
+DUTY_CHANGED = 0x40
+STATE_CHANGED = 0x80
+
+# Mirrors States::Type in src/core/StateType.h
+STATE_NAMES = ["STANDBY", "PREHEATING", "MAINTAINING", "EMERGENCY_STOP", "AUTOTUNE"]
+
+
+def crc8(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.offset = 0
+
+    def byte(self):
+        value = self.data[self.offset]
+        self.offset += 1
+        return value
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            byte = self.byte()
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    def done(self):
+        return self.offset >= len(self.data)
+
+
+def load(path):
+    """Returns (region bytes, start, block size, block count)."""
+    with open(path, "rb") as handle:
+        raw = handle.read()
+    if raw.startswith(b"runlog,"):
+        lines = raw.decode("ascii").split()
+        _, start, block_size, block_count = lines[0].split(",")
+        hex_digits = "".join(line for line in lines[1:] if line != "end")
+        return bytes.fromhex(hex_digits), int(start), int(block_size), int(block_count)
+    block_count = (len(raw) - RUN_LOG_START) // RUN_LOG_BLOCK_SIZE
+    return raw[RUN_LOG_START:], RUN_LOG_START, RUN_LOG_BLOCK_SIZE, block_count
+
+
+def valid_blocks(region, block_size, block_count):
+    """Yields (sequence, session, payload) for every block with a good header and CRC."""
+    for slot in range(block_count):
+        block = region[slot * block_size:(slot + 1) * block_size]
+        if len(block) < block_size:
+            break
+        sequence = block[0] | (block[1] << 8)
+        session, length, crc = block[2], block[3], block[4]
+        if sequence == ERASED_SEQUENCE or length == 0 or length > block_size - RUN_LOG_HEADER_SIZE:
+            continue
+        payload = block[RUN_LOG_HEADER_SIZE:RUN_LOG_HEADER_SIZE + length]
+        if crc8(block[:4] + payload) != crc:
+            print(f"# slot {slot}: CRC mismatch, skipped", file=sys.stderr)
+            continue
+        yield sequence, session, payload
+
+
+def decode_block(session, payload):
+    reader = Reader(payload)
+    time_s = reader.varint()
+    interval_s = reader.varint()
+    temperature = unzigzag(reader.varint())
+    setpoint = unzigzag(reader.varint())
+    gas = reader.varint()
+    duty = reader.byte()
+    state = reader.byte()
+    while True:
+        yield session, time_s, temperature, setpoint, gas, duty, state
+        if reader.done():
+            return
+        flags = reader.byte()
+        nibble = flags & TEMPERATURE_NIBBLE_MASK
+        if nibble == TEMPERATURE_ESCAPE:
+            temperature += unzigzag(reader.varint())
+        else:
+            temperature += nibble - 16 if nibble & 0x08 else nibble
+        if flags & SETPOINT_CHANGED:
+            setpoint += unzigzag(reader.varint())
+        if flags & GAS_CHANGED:
+            gas += unzigzag(reader.varint())
+        if flags & DUTY_CHANGED:
+            duty = reader.byte()
+        if flags & STATE_CHANGED:
+            state = reader.byte()
+        time_s += interval_s
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__)
+    region, _, block_size, block_count = load(sys.argv[1])
+    blocks = list(valid_blocks(region, block_size, block_count))
+    if not blocks:
+        sys.exit("No valid run log blocks")
+
+    # Oldest first: order by distance behind the newest block, in 16-bit serial arithmetic
+    def behind_newest(sequence):
+        return ((sequence - newest + 0x8000) & 0xFFFF) - 0x8000
+
+    newest = blocks[0][0]
+    for sequence, _, _ in blocks:
+        if behind_newest(sequence) > 0:
+            newest = sequence
+    blocks.sort(key=lambda block: behind_newest(block[0]))
+
+    print("session,time_s,temperature_c,setpoint_c,gas,heater_duty_pct,state")
+    for _, session, payload in blocks:
+        for session, time_s, temperature, setpoint, gas, duty, state in decode_block(session, payload):
+            name = STATE_NAMES[state] if state < len(STATE_NAMES) else str(state)
+            print(f"{session},{time_s},{temperature / 10:.1f},{setpoint / 10:.1f},{gas},{duty},{name}")
+
+
+if __name__ == "__main__":
+    main()
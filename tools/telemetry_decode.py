@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""Decode the Bio-Logic binary telemetry stream into CSV.
+
+Input is a capture file (e.g. the simulator's serial=<file>) or a serial device,
+read with pyserial at the firmware's baud rate (BIOLOGIC_SERIAL_BAUD, 115200 by
+default):
+
+    telemetry_decode.py run.bin > run.csv
+    telemetry_decode.py /dev/ttyACM0 115200
+
+Frames are COBS-encoded and zero-terminated; frames with a bad CRC (including any
+text printed by the diagnostic commands) are counted and skipped. The record layout
+is documented in src/diagnostics/Telemetry.h.
+"""
+
+import os
+import stat
+import struct
+import sys
+
+# Mirrors src/diagnostics/Telemetry.h
+TELEMETRY_RECORD_STATUS = 1
+RECORD = struct.Struct("<BBIBhhhhHBBHHHH")
+CRC_SIZE = 2
+HEATER_ON = 0x01
+GREEN_LED_ON = 0x02
+RED_LED_ON = 0x04
+SIREN_ON = 0x08
+
+# Mirrors States::Type in src/core/StateType.h
+STATE_NAMES = ["STANDBY", "PREHEATING", "MAINTAINING", "EMERGENCY_STOP", "AUTOTUNE"]
+
+HEADER = ("time_ms,sequence,state,temperature_c,estimate_c,setpoint_c,rate_c_per_s,gas,"
+          "heater_duty_pct,heater,green_led,red_led,siren,overruns,max_lateness_ms,max_run_us,dropped")
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    index = 0
+    while index < len(frame):
+        code = frame[index]
+        if code == 0 or index + code > len(frame) + 1:
+            return None
+        out += frame[index + 1:index + code]
+        index += code
+        if code < 0xFF and index < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def chunks(path, baud):
+    """Yields the input in blocks, from a file or a serial device."""
+    if stat.S_ISCHR(os.stat(path).st_mode):
+        import serial  # pyserial, only needed for live capture
+        with serial.Serial(path, baud, timeout=1) as port:
+            while True:
+                yield port.read(256)
+    else:
+        with open(path, "rb") as handle:
+            while True:
+                block = handle.read(65536)
+                if not block:
+                    return
+                yield block
+
+
+def decode(packet):
+    if len(packet) != RECORD.size + CRC_SIZE:
+        return None
+    body, crc = packet[:RECORD.size], packet[RECORD.size:]
+    if crc16(body) != struct.unpack("<H", crc)[0]:
+        return None
+    fields = RECORD.unpack(body)
+    if fields[0] != TELEMETRY_RECORD_STATUS:
+        return None
+    return fields
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit(__doc__)
+    baud = int(sys.argv[2]) if len(sys.argv) == 3 else 115200
+
+    print(HEADER)
+    pending = bytearray()
+    records = rejected = lost = 0
+    previous_sequence = None
+    for block in chunks(sys.argv[1], baud):
+        pending += block
+        *frames, pending = pending.split(b"\x00")
+        pending = bytearray(pending)
+        for frame in frames:
+            packet = cobs_decode(frame) if frame else None
+            fields = decode(packet) if packet else None
+            if fields is None:
+                rejected += frame != b""
+                continue
+            (_, sequence, time_ms, state, temperature, estimate, setpoint, rate, gas,
+             duty, outputs, overruns, lateness, run_us, dropped) = fields
+            if previous_sequence is not None:
+                lost += (sequence - previous_sequence - 1) & 0xFF
+            previous_sequence = sequence
+            records += 1
+            name = STATE_NAMES[state] if state < len(STATE_NAMES) else str(state)
+            print(f"{time_ms},{sequence},{name},{temperature / 100:.2f},{estimate / 100:.2f},"
+                  f"{setpoint / 100:.2f},{rate / 1000:.3f},{gas},{duty},"
+                  f"{int(bool(outputs & HEATER_ON))},{int(bool(outputs & GREEN_LED_ON))},"
+                  f"{int(bool(outputs & RED_LED_ON))},{int(bool(outputs & SIREN_ON))},"
+                  f"{overruns},{lateness},{run_us},{dropped}")
+    print(f"# {records} records, {rejected} bad frames, {lost} sequence gaps", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()